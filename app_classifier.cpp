@@ -1,10 +1,22 @@
 #include "app_classifier.h"
+#include "case_fold.h"
+#include "learned_app_store.h"
+#include "metrics.h"
+#include "thread_pool.h"
 #include <algorithm>
 #include <cctype>
 #include <fstream>
 #include <sstream>
 
-AppClassifier::AppClassifier() {
+namespace {
+
+std::string_view ExecutablePathOf(const WindowInfo& window_info) {
+    return window_info.executable_path.has_value() ? std::string_view(*window_info.executable_path) : std::string_view();
+}
+
+}  // namespace
+
+AppClassifier::AppClassifier() : learned_store_(nullptr) {
     InitializeKeywords();
     // 尝试从配置文件加载，如果失败则使用默认映射
     if (!InitializeProcessNameMapping("app_category_config.txt")) {
@@ -80,6 +92,7 @@ bool AppClassifier::InitializeProcessNameMapping(const std::string& config_file_
 bool AppClassifier::LoadConfigFile(const std::string& config_file_path) {
     // 清空现有映射
     process_name_mapping_.clear();
+    path_prefix_mapping_.Clear();
     
     // 尝试从配置文件加载
     if (LoadFromConfigFile(config_file_path)) {
@@ -113,8 +126,9 @@ bool AppClassifier::LoadFromConfigFile(const std::string& config_file_path) {
             continue;
         }
         
-        // 解析格式：进程名=类别名
-        size_t equal_pos = line.find('=');
+        // 解析格式：进程名=类别名 或 目录前缀=类别名
+        // 类别名中不会有'='，从右边找，目录中可以包含'='
+        size_t equal_pos = line.rfind('=');
         if (equal_pos == std::string::npos) {
             // 格式错误，跳过这一行
             continue;
@@ -133,33 +147,26 @@ bool AppClassifier::LoadFromConfigFile(const std::string& config_file_path) {
             continue;
         }
         
-        // 转换为小写
-        process_name = ToLower(process_name);
-        category_name = ToLower(category_name);
-        
         // 解析类别名
-        AppCategory category;
-        if (category_name == "game") {
-            category = AppCategory::GAME;
-        } else if (category_name == "video") {
-            category = AppCategory::VIDEO;
-        } else if (category_name == "music") {
-            category = AppCategory::MUSIC;
-        } else if (category_name == "document") {
-            category = AppCategory::DOCUMENT;
-        } else if (category_name == "browser") {
-            category = AppCategory::BROWSER;
-        } else if (category_name == "development") {
-            category = AppCategory::DEVELOPMENT;
-        } else if (category_name == "creative") {
-            category = AppCategory::CREATIVE;
-        } else {
+        std::optional<AppCategory> category = ParseCategoryName(category_name);
+        if (!category.has_value()) {
             // 未知类别，跳过
             continue;
         }
         
+        // 含路径分隔符的是目录前缀（进程名中不会出现分隔符），由前缀树自行规范化
+        if (process_name.find_first_of("\\/") != std::string::npos) {
+            if (path_prefix_mapping_.Insert(process_name, category.value())) {
+                loaded_count++;
+            }
+            continue;
+        }
+        
+        // 转换为小写
+        process_name = ToLower(process_name);
+        
         // 添加到映射表
-        process_name_mapping_[process_name] = category;
+        process_name_mapping_[process_name] = category.value();
         loaded_count++;
     }
     
@@ -226,28 +233,117 @@ void AppClassifier::InitializeDefaultMapping() {
     process_name_mapping_["afterfx.exe"] = AppCategory::CREATIVE;
     process_name_mapping_["davinci resolve.exe"] = AppCategory::CREATIVE;
     process_name_mapping_["blender.exe"] = AppCategory::CREATIVE;
+    
+    // 安装目录
+    path_prefix_mapping_.Insert("steamapps/common/", AppCategory::GAME);
+    path_prefix_mapping_.Insert("C:\\Program Files\\JetBrains\\", AppCategory::DEVELOPMENT);
 }
 
 AppCategory AppClassifier::Classify(const WindowInfo& window_info) {
+    METRICS_SCOPE(MetricStage::CLASSIFY);
+    
     // 提取纯进程名（去除路径，只保留文件名）
+    std::string_view process_name = window_info.process_name;
+    size_t last_slash = process_name.find_last_of("\\/");
+    if (last_slash != std::string_view::npos) {
+        process_name = process_name.substr(last_slash + 1);
+    }
+    
+    // 匹配文本 "进程名 标题" 直接折叠到同一个缓冲区
+    std::string combined_text;
+    combined_text.reserve(process_name.size() + 1 + window_info.window_title.size());
+    AppendFoldedCase(process_name, combined_text);
+    std::string process_name_lower = combined_text;
+    combined_text.push_back(' ');
+    AppendFoldedCase(window_info.window_title, combined_text);
+    
+    return ClassifyLowered(process_name_lower, combined_text, ExecutablePathOf(window_info),
+                           &window_info.ancestor_names, true, true);
+}
+
+AppCategory AppClassifier::ClassifyWithoutKeywords(const WindowInfo& window_info) {
+    METRICS_SCOPE(MetricStage::CLASSIFY);
+    
     std::string process_name = window_info.process_name;
     size_t last_slash = process_name.find_last_of("\\/");
     if (last_slash != std::string::npos) {
         process_name = process_name.substr(last_slash + 1);
     }
     
-    std::string process_name_lower = ToLower(process_name);
-    std::string window_title_lower = ToLower(window_info.window_title);
+    return ClassifyLowered(ToLower(process_name), std::string_view(), ExecutablePathOf(window_info),
+                           &window_info.ancestor_names, true, false);
+}
+
+void AppClassifier::ClassifyBatch(const AppBatch& batch, std::vector<AppCategory>& categories, ThreadPool* pool) {
+    categories.resize(batch.Size());
+    
+    auto classify_range = [&](size_t begin, size_t end) {
+        std::string name_key;  // 每个线程复用，避免逐项分配
+        for (size_t i = begin; i < end; i++) {
+            name_key.assign(batch.GetName(i));
+            categories[i] = ClassifyLowered(name_key, batch.GetCombinedText(i), std::string_view(), nullptr, false, true);
+        }
+    };
     
+    // 每块256项：足够摊薄领取开销，又能在线程间均衡负载
+    const size_t grain = 256;
+    if (pool != nullptr) {
+        pool->ParallelFor(batch.Size(), grain, classify_range);
+    } else {
+        classify_range(0, batch.Size());
+    }
+}
+
+AppCategory AppClassifier::ClassifyLowered(const std::string& process_name_lower, std::string_view combined_text,
+                                           std::string_view executable_path,
+                                           const std::vector<std::string>* ancestor_names, bool touch_learned,
+                                           bool scan_keywords) {
     // 首先检查精确的进程名映射
     auto it = process_name_mapping_.find(process_name_lower);
     if (it != process_name_mapping_.end()) {
         return it->second;
     }
     
-    // 检查进程名和窗口标题中的关键词
-    std::string combined_text = process_name_lower + " " + window_title_lower;
+    // 用户为该进程指定或确认过的类别
+    if (learned_store_ != nullptr) {
+        std::optional<AppCategory> learned = touch_learned
+            ? learned_store_->LookupCategory(process_name_lower)
+            : learned_store_->PeekCategory(process_name_lower);
+        if (learned.has_value()) {
+            return learned.value();
+        }
+    }
+    
+    // 按安装目录分类（如Steam游戏库中的游戏、JetBrains安装目录下的IDE及其工具）
+    // 放在祖先进程之前：进程自己的位置比启动它的进程更能说明它是什么
+    if (!executable_path.empty()) {
+        std::optional<AppCategory> by_path = path_prefix_mapping_.Find(executable_path);
+        if (by_path.has_value()) {
+            return by_path.value();
+        }
+    }
+    
+    // 进程名无法识别时，继承最近的已知祖先进程的类别
+    // （例如由steam.exe启动的游戏、由IDE启动的终端）
+    if (ancestor_names != nullptr) {
+        for (const auto& ancestor_name : *ancestor_names) {
+            std::string ancestor = ancestor_name;
+            size_t ancestor_slash = ancestor.find_last_of("\\/");
+            if (ancestor_slash != std::string::npos) {
+                ancestor = ancestor.substr(ancestor_slash + 1);
+            }
+            auto ancestor_it = process_name_mapping_.find(ToLower(ancestor));
+            if (ancestor_it != process_name_mapping_.end()) {
+                return ancestor_it->second;
+            }
+        }
+    }
+    
+    if (!scan_keywords) {
+        return AppCategory::UNKNOWN;
+    }
     
+    // 检查进程名和窗口标题中的关键词
     // 按优先级检查各类别
     if (ContainsKeywords(combined_text, game_keywords_)) {
         return AppCategory::GAME;
@@ -302,7 +398,58 @@ std::string AppClassifier::GetCategoryName(AppCategory category) {
     }
 }
 
-bool AppClassifier::ContainsKeywords(const std::string& text, const std::unordered_set<std::string>& keywords) {
+std::optional<AppCategory> AppClassifier::ParseCategoryName(const std::string& category_name) {
+    std::string name;
+    name.reserve(category_name.size());
+    for (unsigned char c : category_name) {
+        name.push_back(static_cast<char>(std::tolower(c)));
+    }
+    
+    if (name == "game") {
+        return AppCategory::GAME;
+    } else if (name == "video") {
+        return AppCategory::VIDEO;
+    } else if (name == "music") {
+        return AppCategory::MUSIC;
+    } else if (name == "document") {
+        return AppCategory::DOCUMENT;
+    } else if (name == "browser") {
+        return AppCategory::BROWSER;
+    } else if (name == "development") {
+        return AppCategory::DEVELOPMENT;
+    } else if (name == "creative") {
+        return AppCategory::CREATIVE;
+    }
+    return std::nullopt;
+}
+
+void AppBatch::Add(std::string_view process_name, std::string_view window_title) {
+    size_t begin = process_name.find_last_of("\\/");
+    begin = (begin == std::string_view::npos) ? 0 : begin + 1;
+    
+    name_offsets.push_back(static_cast<uint32_t>(arena.size()));
+    AppendFoldedCase(process_name.substr(begin), arena);
+    arena.push_back(' ');
+    title_offsets.push_back(static_cast<uint32_t>(arena.size()));
+    AppendFoldedCase(window_title, arena);
+    end_offsets.push_back(static_cast<uint32_t>(arena.size()));
+}
+
+void AppBatch::Reserve(size_t count, size_t arena_bytes) {
+    arena.reserve(arena_bytes);
+    name_offsets.reserve(count);
+    title_offsets.reserve(count);
+    end_offsets.reserve(count);
+}
+
+void AppBatch::Clear() {
+    arena.clear();
+    name_offsets.clear();
+    title_offsets.clear();
+    end_offsets.clear();
+}
+
+bool AppClassifier::ContainsKeywords(std::string_view text, const std::unordered_set<std::string>& keywords) {
     for (const auto& keyword : keywords) {
         if (text.find(keyword) != std::string::npos) {
             return true;
@@ -312,9 +459,6 @@ bool AppClassifier::ContainsKeywords(const std::string& text, const std::unorder
 }
 
 std::string AppClassifier::ToLower(const std::string& str) {
-    std::string result = str;
-    std::transform(result.begin(), result.end(), result.begin(),
-                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-    return result;
+    return FoldCase(str);
 }
 
@@ -1,11 +1,19 @@
 #pragma once
 
-#include "window_monitor.h"
+#include "path_prefix_trie.h"
+#include "window_info.h"
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <optional>
 #include <unordered_map>
 #include <unordered_set>
 
+class LearnedAppStore;
+class ThreadPool;
+
 /**
  * 应用类别枚举
  */
@@ -20,6 +28,42 @@ enum class AppCategory {
     UNKNOWN         // 未知
 };
 
+const size_t kAppCategoryCount = static_cast<size_t>(AppCategory::UNKNOWN) + 1;
+
+/**
+ * 批量分类的输入（结构数组布局）
+ * 所有进程名和窗口标题在添加时去除路径并转为小写，依次写入同一块字节区，
+ * 每项布局为 "进程名 标题"，因此关键词匹配可以直接在字节区上进行，不再逐项拼接字符串。
+ */
+struct AppBatch {
+    std::string arena;                      // 共享字节区
+    std::vector<uint32_t> name_offsets;     // 进程名起始位置
+    std::vector<uint32_t> title_offsets;    // 标题起始位置（进程名结束位置 + 1）
+    std::vector<uint32_t> end_offsets;      // 标题结束位置
+
+    /**
+     * 添加一项
+     * @param process_name 进程名（可包含路径）
+     * @param window_title 窗口标题（后台进程可为空）
+     */
+    void Add(std::string_view process_name, std::string_view window_title);
+
+    void Reserve(size_t count, size_t arena_bytes);
+    void Clear();
+    size_t Size() const { return name_offsets.size(); }
+
+    std::string_view GetName(size_t index) const {
+        return std::string_view(arena).substr(name_offsets[index], title_offsets[index] - 1 - name_offsets[index]);
+    }
+
+    /**
+     * 关键词匹配文本（"进程名 标题"）
+     */
+    std::string_view GetCombinedText(size_t index) const {
+        return std::string_view(arena).substr(name_offsets[index], end_offsets[index] - name_offsets[index]);
+    }
+};
+
 /**
  * 应用分类器类
  * 根据进程名和窗口标题对应用进行分类
@@ -30,11 +74,31 @@ public:
     
     /**
      * 对应用进行分类
+     * 匹配顺序：进程名精确映射 -> 用户学习记录 -> 可执行文件路径前缀（安装目录） ->
+     * 祖先进程名精确映射（如游戏启动器、IDE） -> 关键词
      * @param window_info 窗口信息
      * @return AppCategory枚举值
      */
     AppCategory Classify(const WindowInfo& window_info);
     
+    /**
+     * 不扫描关键词的快速分类（tick预算不足时使用）
+     * 只匹配进程名精确映射、用户学习记录、路径前缀和祖先进程，都无法识别时返回UNKNOWN
+     * @param window_info 窗口信息
+     * @return AppCategory枚举值
+     */
+    AppCategory ClassifyWithoutKeywords(const WindowInfo& window_info);
+    
+    /**
+     * 批量分类（如所有可见窗口、所有后台进程）
+     * 匹配顺序与Classify相同，但不包含路径前缀和祖先进程匹配；查询学习记录时不更新其使用时间。
+     * 分类期间不得修改映射、关键词或学习记录。
+     * @param batch 输入
+     * @param categories 输出，大小会被调整为batch.Size()
+     * @param pool 线程池，传入nullptr时在调用线程中执行
+     */
+    void ClassifyBatch(const AppBatch& batch, std::vector<AppCategory>& categories, ThreadPool* pool = nullptr);
+    
     /**
      * 获取类别的中文名称
      * @param category 应用类别
@@ -43,7 +107,20 @@ public:
     static std::string GetCategoryName(AppCategory category);
     
     /**
-     * 从配置文件重新加载进程名映射
+     * 解析类别名（GAME、VIDEO等，不区分大小写）
+     * @param category_name 类别名
+     * @return 应用类别，无法识别时返回std::nullopt
+     */
+    static std::optional<AppCategory> ParseCategoryName(const std::string& category_name);
+    
+    /**
+     * 设置学习型分类存储（在关键词匹配之前查询）
+     * @param store 存储对象，传入nullptr表示不使用；由调用方管理生命周期
+     */
+    void SetLearnedStore(LearnedAppStore* store) { learned_store_ = store; }
+    
+    /**
+     * 从配置文件重新加载进程名映射和路径前缀映射
      * @param config_file_path 配置文件路径，如果为空则使用默认路径
      * @return 是否成功加载（如果配置文件不存在，返回false但会保留现有映射）
      */
@@ -59,6 +136,8 @@ private:
     std::unordered_set<std::string> creative_keywords_;
     
     std::unordered_map<std::string, AppCategory> process_name_mapping_;
+    PathPrefixTrie path_prefix_mapping_;  // 可执行文件所在目录 -> 类别（配置中含路径分隔符的行）
+    LearnedAppStore* learned_store_;  // 用户学习记录（可选）
     
     /**
      * 初始化关键词集合
@@ -84,16 +163,29 @@ private:
      */
     void InitializeDefaultMapping();
     
+    /**
+     * 对已转为小写的进程名和匹配文本进行分类（Classify和ClassifyBatch共用）
+     * @param name_lower 小写的纯进程名
+     * @param combined_text 小写的 "进程名 标题"
+     * @param executable_path 可执行文件路径（未知时为空）
+     * @param ancestor_names 祖先进程名（可为nullptr）
+     * @param touch_learned 查询学习记录时是否更新其使用时间
+     * @param scan_keywords 前面的匹配都失败时是否扫描关键词
+     */
+    AppCategory ClassifyLowered(const std::string& name_lower, std::string_view combined_text,
+                                std::string_view executable_path, const std::vector<std::string>* ancestor_names,
+                                bool touch_learned, bool scan_keywords);
+    
     /**
      * 检查文本中是否包含关键词集合中的任何关键词
      * @param text 要检查的文本
      * @param keywords 关键词集合
      * @return 如果包含任何关键词则返回true
      */
-    bool ContainsKeywords(const std::string& text, const std::unordered_set<std::string>& keywords);
+    bool ContainsKeywords(std::string_view text, const std::unordered_set<std::string>& keywords);
     
     /**
-     * 将字符串转换为小写
+     * 将字符串转换为小写（UTF-8大小写折叠，见case_fold.h）
      */
     std::string ToLower(const std::string& str);
 };
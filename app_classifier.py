@@ -1,9 +1,16 @@
 """
 应用分类器模块 - 根据应用信息进行分类
+
+能加载 app_state_core 共享库时使用与C++程序相同的分类实现，否则使用本文件中的纯Python实现。
 """
-from typing import Dict, Set
+from typing import TYPE_CHECKING, Dict, Iterable, List, Set, Tuple
 from enum import Enum
-from window_monitor import WindowInfo
+
+from app_state_core import NativeClassifier, load_library
+
+if TYPE_CHECKING:
+    # 只用于类型标注；window_monitor依赖pywin32，离线分析时不需要导入
+    from window_monitor import WindowInfo
 
 
 class AppCategory(Enum):
@@ -18,10 +25,20 @@ class AppCategory(Enum):
     UNKNOWN = "未知"
 
 
+# 按C++ AppCategory的枚举顺序，用于转换共享库返回的类别编号
+_CATEGORIES_BY_INDEX = list(AppCategory)
+
+
 class AppClassifier:
     """应用分类器 - 根据进程名和窗口标题对应用进行分类"""
     
-    def __init__(self):
+    def __init__(self, use_native: bool = True):
+        """
+        Args:
+            use_native: 是否优先使用共享库（找不到共享库时自动退回纯Python实现）
+        """
+        self._native = NativeClassifier() if use_native and load_library() is not None else None
+        
         # 游戏类关键词
         self._game_keywords: Set[str] = {
             'steam', 'epic', 'origin', 'battle.net', 'riot', 'valorant',
@@ -132,7 +149,12 @@ class AppClassifier:
             'blender.exe': AppCategory.CREATIVE,
         }
     
-    def classify(self, window_info: WindowInfo) -> AppCategory:
+    @property
+    def is_native(self) -> bool:
+        """是否使用共享库"""
+        return self._native is not None
+    
+    def classify(self, window_info: "WindowInfo") -> AppCategory:
         """
         对应用进行分类
         
@@ -145,8 +167,29 @@ class AppClassifier:
         if not window_info:
             return AppCategory.UNKNOWN
         
-        process_name_lower = window_info.process_name.lower()
-        window_title_lower = window_info.window_title.lower()
+        if self._native is not None:
+            return _CATEGORIES_BY_INDEX[self._native.classify(window_info.process_name, window_info.window_title)]
+        
+        return self._classify_python(window_info.process_name, window_info.window_title)
+    
+    def classify_batch(self, rows: Iterable[Tuple[str, str]]) -> List[AppCategory]:
+        """
+        批量分类（如离线分析日志）
+        
+        Args:
+            rows: (进程名, 窗口标题) 序列
+            
+        Returns:
+            每项的AppCategory
+        """
+        if self._native is not None:
+            return [_CATEGORIES_BY_INDEX[index] for index in self._native.classify_batch(rows)]
+        return [self._classify_python(name, title) for name, title in rows]
+    
+    def _classify_python(self, process_name: str, window_title: str) -> AppCategory:
+        """纯Python实现的分类"""
+        process_name_lower = process_name.lower()
+        window_title_lower = window_title.lower()
         
         # 首先检查精确的进程名映射
         if process_name_lower in self._process_name_mapping:
@@ -0,0 +1,226 @@
+#include "app_state_api.h"
+#include "app_classifier.h"
+#include "default_rules.h"
+#include "rule_engine.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static_assert(sizeof(AppStateSystemState) == 64, "AppStateSystemState的布局属于稳定接口，不能改变");
+static_assert(static_cast<int>(AppCategory::UNKNOWN) == 7, "类别取值属于稳定接口，只能在末尾追加");
+static_assert(static_cast<int>(LightMode::DEFAULT) == 6, "灯光模式取值属于稳定接口，只能在末尾追加");
+
+struct AppStateClassifier {
+    AppClassifier classifier;
+    AppBatch batch;                         // 批量分类时按块复用
+    std::vector<AppCategory> categories;
+};
+
+struct AppStateEngine {
+    RuleEngine engine;
+};
+
+namespace {
+
+// 批量分类每块的行数：块内字节区和结果留在缓存中，内存占用与输入大小无关
+const size_t kBatchChunkRows = 65536;
+
+/**
+ * 按snprintf的约定复制名称
+ */
+size_t CopyName(const std::string& name, char* buffer, size_t capacity) {
+    if (buffer != nullptr && capacity > 0) {
+        size_t length = std::min(name.size(), capacity - 1);
+        std::memcpy(buffer, name.data(), length);
+        buffer[length] = '\0';
+    }
+    return name.size();
+}
+
+/**
+ * 分类当前块并写出结果
+ */
+void FlushChunk(AppStateClassifier* classifier, uint8_t* categories, size_t& written) {
+    classifier->classifier.ClassifyBatch(classifier->batch, classifier->categories);
+    for (AppCategory category : classifier->categories) {
+        categories[written++] = static_cast<uint8_t>(category);
+    }
+    classifier->batch.Clear();
+}
+
+SystemState ToSystemState(const AppStateSystemState& input) {
+    SystemState state;
+    state.current_app_category = static_cast<AppCategory>(input.category);
+    state.current_hour = input.hour;
+    state.current_minute = input.minute;
+    state.is_weekday = input.is_weekday != 0;
+    state.has_audio_activity = input.has_audio != 0;
+    state.cpu_usage = input.cpu_usage;
+    state.idle_minutes = input.idle_minutes;
+    state.cpu_temperature = input.cpu_temperature;
+    state.gpu_temperature = input.gpu_temperature;
+    state.monotonic_seconds = input.monotonic_seconds;
+    return state;
+}
+
+bool IsValidState(const AppStateSystemState& state) {
+    return state.category >= 0 && state.category <= static_cast<int32_t>(AppCategory::UNKNOWN) &&
+           state.hour >= 0 && state.hour < 24 && state.minute >= 0 && state.minute < 60;
+}
+
+}  // namespace
+
+extern "C" {
+
+uint32_t app_state_api_version(void) {
+    return APP_STATE_API_VERSION;
+}
+
+AppStateClassifier* app_state_classifier_create(void) {
+    try {
+        return new AppStateClassifier();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void app_state_classifier_destroy(AppStateClassifier* classifier) {
+    delete classifier;
+}
+
+int32_t app_state_classifier_load_config(AppStateClassifier* classifier, const char* config_path) {
+    if (classifier == nullptr || config_path == nullptr) {
+        return APP_STATE_ERROR_INVALID_ARGUMENT;
+    }
+    try {
+        return classifier->classifier.LoadConfigFile(config_path) ? APP_STATE_OK : APP_STATE_ERROR_IO;
+    } catch (...) {
+        return APP_STATE_ERROR_INTERNAL;
+    }
+}
+
+int32_t app_state_classify(AppStateClassifier* classifier, const char* process_name, const char* window_title) {
+    if (classifier == nullptr || process_name == nullptr) {
+        return APP_STATE_ERROR_INVALID_ARGUMENT;
+    }
+    try {
+        WindowInfo window_info = {};
+        window_info.process_name = process_name;
+        if (window_title != nullptr) {
+            window_info.window_title = window_title;
+        }
+        return static_cast<int32_t>(classifier->classifier.Classify(window_info));
+    } catch (...) {
+        return APP_STATE_ERROR_INTERNAL;
+    }
+}
+
+int32_t app_state_classify_batch(AppStateClassifier* classifier, const char* records, size_t length,
+                                 uint8_t* categories, size_t capacity, size_t* count) {
+    if (classifier == nullptr || count == nullptr || (records == nullptr && length > 0)) {
+        return APP_STATE_ERROR_INVALID_ARGUMENT;
+    }
+
+    // 先数行数，容量不足时不做任何分类
+    size_t rows = 0;
+    for (const char* p = records; p != nullptr && p < records + length; rows++) {
+        const void* newline = std::memchr(p, '\n', static_cast<size_t>(records + length - p));
+        p = newline != nullptr ? static_cast<const char*>(newline) + 1 : records + length;
+    }
+    *count = rows;
+    if (rows > capacity) {
+        return APP_STATE_ERROR_BUFFER_TOO_SMALL;
+    }
+    if (rows > 0 && categories == nullptr) {
+        return APP_STATE_ERROR_INVALID_ARGUMENT;
+    }
+
+    try {
+        size_t written = 0;
+        classifier->batch.Clear();
+        const char* end = records + length;
+        for (const char* line = records; line != nullptr && line < end;) {
+            const char* newline = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+            const char* line_end = newline != nullptr ? newline : end;
+            std::string_view text(line, static_cast<size_t>(line_end - line));
+            if (!text.empty() && text.back() == '\r') {
+                text.remove_suffix(1);
+            }
+            size_t tab = text.find('\t');
+            if (tab == std::string_view::npos) {
+                classifier->batch.Add(text, std::string_view());
+            } else {
+                classifier->batch.Add(text.substr(0, tab), text.substr(tab + 1));
+            }
+            if (classifier->batch.Size() == kBatchChunkRows) {
+                FlushChunk(classifier, categories, written);
+            }
+            line = newline != nullptr ? newline + 1 : end;
+        }
+        if (classifier->batch.Size() > 0) {
+            FlushChunk(classifier, categories, written);
+        }
+        return APP_STATE_OK;
+    } catch (...) {
+        classifier->batch.Clear();
+        return APP_STATE_ERROR_INTERNAL;
+    }
+}
+
+size_t app_state_category_name(int32_t category, char* buffer, size_t capacity) {
+    if (category < 0 || category > static_cast<int32_t>(AppCategory::UNKNOWN)) {
+        return CopyName(std::string(), buffer, capacity);
+    }
+    return CopyName(AppClassifier::GetCategoryName(static_cast<AppCategory>(category)), buffer, capacity);
+}
+
+AppStateEngine* app_state_engine_create(void) {
+    try {
+        AppStateEngine* engine = new AppStateEngine();
+        InitializeRules(engine->engine);
+        return engine;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void app_state_engine_destroy(AppStateEngine* engine) {
+    delete engine;
+}
+
+int32_t app_state_decide(AppStateEngine* engine, const AppStateSystemState* state) {
+    if (engine == nullptr || state == nullptr || !IsValidState(*state)) {
+        return APP_STATE_ERROR_INVALID_ARGUMENT;
+    }
+    SystemState system_state = ToSystemState(*state);
+    return static_cast<int32_t>(engine->engine.DecideLightMode(system_state));
+}
+
+int32_t app_state_decide_batch(AppStateEngine* engine, const AppStateSystemState* states, size_t count,
+                               uint8_t* modes) {
+    if (engine == nullptr || (count > 0 && (states == nullptr || modes == nullptr))) {
+        return APP_STATE_ERROR_INVALID_ARGUMENT;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!IsValidState(states[i])) {
+            return APP_STATE_ERROR_INVALID_ARGUMENT;
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        SystemState system_state = ToSystemState(states[i]);
+        modes[i] = static_cast<uint8_t>(engine->engine.DecideLightMode(system_state));
+    }
+    return APP_STATE_OK;
+}
+
+size_t app_state_mode_name(int32_t mode, char* buffer, size_t capacity) {
+    if (mode < 0 || mode > static_cast<int32_t>(LightMode::DEFAULT)) {
+        return CopyName(std::string(), buffer, capacity);
+    }
+    return CopyName(RuleEngine::GetLightModeName(static_cast<LightMode>(mode)), buffer, capacity);
+}
+
+}  // extern "C"
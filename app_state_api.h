@@ -0,0 +1,141 @@
+#pragma once
+
+/**
+ * 应用分类器与规则引擎的C接口（app_state_core共享库）
+ *
+ * 供Python工具（ctypes）等非C++调用方使用，与C++实现共用同一份分类逻辑和默认规则。
+ * 接口约定：
+ * - 只使用C类型；对象通过不透明句柄访问，由create/destroy管理生命周期
+ * - 所有输出写入调用方提供的缓冲区，库不分配需要调用方释放的内存
+ * - 返回int32_t的函数出错时返回负的错误码（APP_STATE_ERROR_*），不会抛出异常
+ * - 同一个句柄不能被多个线程同时使用；不同句柄之间互不影响
+ * - 已发布的函数签名和结构体布局不再修改，新增功能只追加新函数，并增加APP_STATE_API_VERSION
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(APP_STATE_API_EXPORTS)
+#define APP_STATE_API __declspec(dllexport)
+#else
+#define APP_STATE_API __declspec(dllimport)
+#endif
+#else
+#define APP_STATE_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_STATE_API_VERSION 1
+
+/* 错误码 */
+#define APP_STATE_OK 0
+#define APP_STATE_ERROR_INVALID_ARGUMENT (-1)   /* 空句柄、空指针或取值超出范围 */
+#define APP_STATE_ERROR_IO (-2)                 /* 无法读取文件 */
+#define APP_STATE_ERROR_BUFFER_TOO_SMALL (-3)   /* 输出缓冲区不足 */
+#define APP_STATE_ERROR_INTERNAL (-4)           /* 内部错误（如内存不足） */
+
+typedef struct AppStateClassifier AppStateClassifier;
+typedef struct AppStateEngine AppStateEngine;
+
+/**
+ * 规则引擎的输入状态（固定布局，共64字节）
+ * category、模式的取值与C++中AppCategory、LightMode的枚举顺序相同
+ */
+typedef struct AppStateSystemState {
+    int32_t category;           /* 前台应用类别（0=GAME ... 7=UNKNOWN） */
+    int32_t hour;               /* 当前小时（0-23） */
+    int32_t minute;             /* 当前分钟（0-59） */
+    int32_t is_weekday;         /* 是否是工作日（0/1） */
+    int32_t has_audio;          /* 是否有音频活动（0/1） */
+    int32_t reserved;           /* 保留，置0 */
+    double cpu_usage;           /* CPU使用率（0-100） */
+    double idle_minutes;        /* 空闲时间（分钟） */
+    double cpu_temperature;     /* CPU温度（摄氏度），没有读数时为NaN */
+    double gpu_temperature;     /* GPU温度（摄氏度），没有读数时为NaN */
+    double monotonic_seconds;   /* 单调时钟（秒），滑动窗口条件用它按时间分桶；回放日志时应递增 */
+} AppStateSystemState;
+
+/**
+ * 接口版本（APP_STATE_API_VERSION），调用方据此检查加载的库是否兼容
+ */
+APP_STATE_API uint32_t app_state_api_version(void);
+
+/**
+ * 创建分类器（与主程序相同：当前目录下有app_category_config.txt时从中加载进程名映射和目录前缀，否则使用内置映射）
+ * @return 句柄，失败时返回NULL
+ */
+APP_STATE_API AppStateClassifier* app_state_classifier_create(void);
+
+APP_STATE_API void app_state_classifier_destroy(AppStateClassifier* classifier);
+
+/**
+ * 从配置文件加载进程名映射和目录前缀（格式同 app_category_config.txt；本接口不传入路径，目录前缀不参与分类）
+ * @return APP_STATE_OK，或文件无法读取、没有有效映射时返回APP_STATE_ERROR_IO（改用内置映射）
+ */
+APP_STATE_API int32_t app_state_classifier_load_config(AppStateClassifier* classifier, const char* config_path);
+
+/**
+ * 分类单个应用
+ * @param process_name 进程名（UTF-8，可包含路径）
+ * @param window_title 窗口标题（UTF-8，可为NULL）
+ * @return 类别（>= 0），或负的错误码
+ */
+APP_STATE_API int32_t app_state_classify(AppStateClassifier* classifier, const char* process_name,
+                                         const char* window_title);
+
+/**
+ * 批量分类
+ * records为UTF-8文本，每行一项，格式为 "进程名\t窗口标题"（没有制表符时标题为空），
+ * 行以'\n'分隔，行尾的'\r'会被忽略，最后一行可以没有换行符。
+ * @param records 输入文本（不要求以'\0'结尾）
+ * @param length 输入字节数
+ * @param categories 输出，每行一个类别
+ * @param capacity categories的容量
+ * @param count 输出行数；容量不足时为需要的容量
+ * @return APP_STATE_OK，容量不足时返回APP_STATE_ERROR_BUFFER_TOO_SMALL（不写入categories）
+ */
+APP_STATE_API int32_t app_state_classify_batch(AppStateClassifier* classifier, const char* records, size_t length,
+                                               uint8_t* categories, size_t capacity, size_t* count);
+
+/**
+ * 类别的中文名称（UTF-8）
+ * 与snprintf相同：最多写入capacity-1个字节并以'\0'结尾
+ * @return 完整名称的字节数（不含'\0'），类别无效时返回0
+ */
+APP_STATE_API size_t app_state_category_name(int32_t category, char* buffer, size_t capacity);
+
+/**
+ * 创建规则引擎（加载默认规则集，与主程序相同）
+ * @return 句柄，失败时返回NULL
+ */
+APP_STATE_API AppStateEngine* app_state_engine_create(void);
+
+APP_STATE_API void app_state_engine_destroy(AppStateEngine* engine);
+
+/**
+ * 决定灯光模式
+ * @return 灯光模式（>= 0），或负的错误码
+ */
+APP_STATE_API int32_t app_state_decide(AppStateEngine* engine, const AppStateSystemState* state);
+
+/**
+ * 按顺序对一组状态决定灯光模式（如回放日志）
+ * 与依次调用app_state_decide相同，滑动窗口条件会累积之前的状态
+ * @param modes 输出，至少count项
+ * @return APP_STATE_OK，或负的错误码
+ */
+APP_STATE_API int32_t app_state_decide_batch(AppStateEngine* engine, const AppStateSystemState* states, size_t count,
+                                             uint8_t* modes);
+
+/**
+ * 灯光模式的中文名称（UTF-8），约定同app_state_category_name
+ */
+APP_STATE_API size_t app_state_mode_name(int32_t mode, char* buffer, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,251 @@
+"""
+app_state_core 共享库的 ctypes 绑定 - 与C++程序共用分类逻辑和默认规则
+
+查找顺序：环境变量 APP_STATE_CORE_LIB 指定的路径，然后是本文件所在目录、
+build/bin、build/bin/Release 下的 app_state_core.dll / libapp_state_core.so / libapp_state_core.dylib。
+找不到或接口版本不兼容时 load_library() 返回 None，调用方可以退回纯Python实现。
+"""
+import ctypes
+import os
+import sys
+from typing import Iterable, List, Optional, Sequence, Tuple
+
+API_VERSION = 1
+
+OK = 0
+ERROR_INVALID_ARGUMENT = -1
+ERROR_IO = -2
+ERROR_BUFFER_TOO_SMALL = -3
+ERROR_INTERNAL = -4
+
+
+class SystemState(ctypes.Structure):
+    """规则引擎的输入状态（与 app_state_api.h 中的 AppStateSystemState 布局相同）"""
+    _fields_ = [
+        ("category", ctypes.c_int32),
+        ("hour", ctypes.c_int32),
+        ("minute", ctypes.c_int32),
+        ("is_weekday", ctypes.c_int32),
+        ("has_audio", ctypes.c_int32),
+        ("reserved", ctypes.c_int32),
+        ("cpu_usage", ctypes.c_double),
+        ("idle_minutes", ctypes.c_double),
+        ("cpu_temperature", ctypes.c_double),
+        ("gpu_temperature", ctypes.c_double),
+        ("monotonic_seconds", ctypes.c_double),
+    ]
+
+    def __init__(self, **kwargs):
+        # 温度默认没有读数
+        kwargs.setdefault("cpu_temperature", float("nan"))
+        kwargs.setdefault("gpu_temperature", float("nan"))
+        super().__init__(**kwargs)
+
+
+_library: Optional[ctypes.CDLL] = None
+_library_loaded = False
+
+
+def _library_names() -> List[str]:
+    if sys.platform == "win32":
+        return ["app_state_core.dll"]
+    if sys.platform == "darwin":
+        return ["libapp_state_core.dylib"]
+    return ["libapp_state_core.so"]
+
+
+def _candidate_paths() -> List[str]:
+    paths = []
+    env_path = os.environ.get("APP_STATE_CORE_LIB")
+    if env_path:
+        paths.append(env_path)
+    base_dir = os.path.dirname(os.path.abspath(__file__))
+    for directory in (base_dir,
+                      os.path.join(base_dir, "build", "bin"),
+                      os.path.join(base_dir, "build", "bin", "Release")):
+        for name in _library_names():
+            paths.append(os.path.join(directory, name))
+    return paths
+
+
+def _declare(lib: ctypes.CDLL):
+    """声明各函数的参数和返回类型"""
+    c_size_p = ctypes.POINTER(ctypes.c_size_t)
+    c_uint8_p = ctypes.POINTER(ctypes.c_uint8)
+
+    lib.app_state_api_version.argtypes = []
+    lib.app_state_api_version.restype = ctypes.c_uint32
+
+    lib.app_state_classifier_create.argtypes = []
+    lib.app_state_classifier_create.restype = ctypes.c_void_p
+    lib.app_state_classifier_destroy.argtypes = [ctypes.c_void_p]
+    lib.app_state_classifier_destroy.restype = None
+    lib.app_state_classifier_load_config.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+    lib.app_state_classifier_load_config.restype = ctypes.c_int32
+    lib.app_state_classify.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p]
+    lib.app_state_classify.restype = ctypes.c_int32
+    lib.app_state_classify_batch.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t,
+                                             c_uint8_p, ctypes.c_size_t, c_size_p]
+    lib.app_state_classify_batch.restype = ctypes.c_int32
+    lib.app_state_category_name.argtypes = [ctypes.c_int32, ctypes.c_char_p, ctypes.c_size_t]
+    lib.app_state_category_name.restype = ctypes.c_size_t
+
+    lib.app_state_engine_create.argtypes = []
+    lib.app_state_engine_create.restype = ctypes.c_void_p
+    lib.app_state_engine_destroy.argtypes = [ctypes.c_void_p]
+    lib.app_state_engine_destroy.restype = None
+    lib.app_state_decide.argtypes = [ctypes.c_void_p, ctypes.POINTER(SystemState)]
+    lib.app_state_decide.restype = ctypes.c_int32
+    lib.app_state_decide_batch.argtypes = [ctypes.c_void_p, ctypes.POINTER(SystemState), ctypes.c_size_t, c_uint8_p]
+    lib.app_state_decide_batch.restype = ctypes.c_int32
+    lib.app_state_mode_name.argtypes = [ctypes.c_int32, ctypes.c_char_p, ctypes.c_size_t]
+    lib.app_state_mode_name.restype = ctypes.c_size_t
+
+
+def load_library(path: Optional[str] = None) -> Optional[ctypes.CDLL]:
+    """
+    加载共享库（只加载一次）
+
+    Args:
+        path: 库文件路径，为None时按默认顺序查找
+
+    Returns:
+        库对象，找不到或接口版本不兼容时返回None
+    """
+    global _library, _library_loaded
+    if path is None and _library_loaded:
+        return _library
+
+    for candidate in ([path] if path else _candidate_paths()):
+        if not os.path.exists(candidate):
+            continue
+        try:
+            lib = ctypes.CDLL(candidate)
+            _declare(lib)
+        except (OSError, AttributeError):
+            continue
+        if lib.app_state_api_version() != API_VERSION:
+            continue
+        if path is None:
+            _library, _library_loaded = lib, True
+        return lib
+
+    if path is None:
+        _library_loaded = True
+    return None
+
+
+def _read_name(function, value: int) -> str:
+    buffer = ctypes.create_string_buffer(64)
+    length = function(value, buffer, len(buffer))
+    if length >= len(buffer):
+        buffer = ctypes.create_string_buffer(length + 1)
+        function(value, buffer, len(buffer))
+    return buffer.value.decode("utf-8")
+
+
+def _sanitize(text: str) -> str:
+    # 制表符和换行符是批量输入的分隔符
+    return text.replace("\t", " ").replace("\r", " ").replace("\n", " ")
+
+
+class NativeClassifier:
+    """基于共享库的应用分类器（类别取值为C++ AppCategory的枚举顺序）"""
+
+    def __init__(self, lib: Optional[ctypes.CDLL] = None):
+        self._lib = lib or load_library()
+        if self._lib is None:
+            raise OSError("找不到 app_state_core 共享库")
+        self._handle = self._lib.app_state_classifier_create()
+        if not self._handle:
+            raise MemoryError("无法创建分类器")
+
+    def close(self):
+        if self._handle:
+            self._lib.app_state_classifier_destroy(self._handle)
+            self._handle = None
+
+    def __del__(self):
+        self.close()
+
+    def load_config(self, config_path: str) -> bool:
+        """从配置文件加载进程名映射，失败时改用内置映射"""
+        return self._lib.app_state_classifier_load_config(self._handle, config_path.encode("utf-8")) == OK
+
+    def classify(self, process_name: str, window_title: str = "") -> int:
+        """分类单个应用，返回类别编号"""
+        result = self._lib.app_state_classify(self._handle, process_name.encode("utf-8"),
+                                              window_title.encode("utf-8"))
+        if result < 0:
+            raise ValueError(f"分类失败（错误码 {result}）")
+        return result
+
+    def classify_records(self, records: bytes) -> bytearray:
+        """
+        批量分类UTF-8文本，每行 "进程名\\t窗口标题"
+
+        Returns:
+            每行一个类别编号
+        """
+        capacity = records.count(b"\n") + 1
+        categories = bytearray(capacity)
+        out = (ctypes.c_uint8 * capacity).from_buffer(categories)
+        count = ctypes.c_size_t(0)
+        result = self._lib.app_state_classify_batch(self._handle, records, len(records), out, capacity,
+                                                    ctypes.byref(count))
+        del out  # 释放对categories的缓冲区引用，之后才能调整其大小
+        if result != OK:
+            raise ValueError(f"批量分类失败（错误码 {result}）")
+        del categories[count.value:]
+        return categories
+
+    def classify_batch(self, rows: Iterable[Tuple[str, str]]) -> bytearray:
+        """批量分类 (进程名, 窗口标题) 序列，返回每项的类别编号"""
+        text = "\n".join(f"{_sanitize(name)}\t{_sanitize(title or '')}" for name, title in rows)
+        return self.classify_records(text.encode("utf-8")) if text else bytearray()
+
+    def category_name(self, category: int) -> str:
+        """类别的中文名称"""
+        return _read_name(self._lib.app_state_category_name, category)
+
+
+class NativeRuleEngine:
+    """基于共享库的规则引擎（加载与C++主程序相同的默认规则）"""
+
+    def __init__(self, lib: Optional[ctypes.CDLL] = None):
+        self._lib = lib or load_library()
+        if self._lib is None:
+            raise OSError("找不到 app_state_core 共享库")
+        self._handle = self._lib.app_state_engine_create()
+        if not self._handle:
+            raise MemoryError("无法创建规则引擎")
+
+    def close(self):
+        if self._handle:
+            self._lib.app_state_engine_destroy(self._handle)
+            self._handle = None
+
+    def __del__(self):
+        self.close()
+
+    def decide(self, state: SystemState) -> int:
+        """决定灯光模式，返回模式编号"""
+        result = self._lib.app_state_decide(self._handle, ctypes.byref(state))
+        if result < 0:
+            raise ValueError(f"无效的状态（错误码 {result}）")
+        return result
+
+    def decide_batch(self, states: Sequence[SystemState]) -> bytearray:
+        """按顺序决定一组状态的灯光模式（如回放日志）"""
+        count = len(states)
+        array = states if isinstance(states, ctypes.Array) else (SystemState * count)(*states)
+        modes = bytearray(count)
+        out = (ctypes.c_uint8 * count).from_buffer(modes) if count else None
+        result = self._lib.app_state_decide_batch(self._handle, array, count, out)
+        if result != OK:
+            raise ValueError(f"批量决策失败（错误码 {result}）")
+        return modes
+
+    def mode_name(self, mode: int) -> str:
+        """灯光模式的中文名称"""
+        return _read_name(self._lib.app_state_mode_name, mode)
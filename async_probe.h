@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+/**
+ * 一次异步采样的结果
+ */
+template <typename T>
+struct ProbeResult {
+    T value{};              // 采样值（超时时为上一次成功的值）
+    bool has_value = false; // 是否有值（第一次采样就超时时为false）
+    bool stale = false;     // 是否超时（value来自之前的采样）
+};
+
+/**
+ * 带截止时间的异步采样
+ * 采样函数在专属的后台线程中执行，调用方Start后可以先做其他事情，再用Wait等待结果。
+ * 采样在截止时间前没有完成时，Wait不再等待，直接返回上一次的值并标记为过期；
+ * 这次采样仍在后台继续，完成后它的结果成为新的"上一次的值"。上一次采样还没完成时，
+ * Start不会重复提交，因此卡住的系统调用最多占用一个线程，不会堆积。
+ *
+ * 后台线程与对象共享一份状态，对象析构时如果采样仍然卡住，线程被分离而不是无限等待
+ * （只会在程序退出时发生；此时采样函数引用的对象可能已析构，但卡住的调用返回前进程已结束）。
+ *
+ * Start/Wait/Get只应在同一个线程中调用。
+ * @tparam T 采样值类型（可复制）
+ */
+template <typename T>
+class AsyncProbe {
+public:
+    /**
+     * @param task 采样函数（在后台线程中调用）
+     * @param timeout 每次采样的时限（从Start起计算）
+     */
+    AsyncProbe(std::function<T()> task, std::chrono::milliseconds timeout)
+        : shared_(std::make_shared<Shared>()), timeout_(timeout), deadline_(), timeouts_(0) {
+        shared_->task = std::move(task);
+        thread_ = std::thread(&AsyncProbe::WorkerLoop, shared_);
+    }
+
+    ~AsyncProbe() {
+        bool busy;
+        {
+            std::lock_guard<std::mutex> lock(shared_->mutex);
+            shared_->stopping = true;
+            busy = shared_->completed != shared_->requested;
+        }
+        shared_->request_cv.notify_one();
+        if (busy) {
+            thread_.detach();
+        } else {
+            thread_.join();
+        }
+    }
+
+    AsyncProbe(const AsyncProbe&) = delete;
+    AsyncProbe& operator=(const AsyncProbe&) = delete;
+
+    /**
+     * 开始一次采样，截止时间为现在加上时限
+     * 上一次采样还在进行时不再提交新的采样，也不更新截止时间：那次采样已经超时，Wait不再等待它
+     */
+    void Start() {
+        {
+            std::lock_guard<std::mutex> lock(shared_->mutex);
+            if (shared_->completed != shared_->requested) {
+                return;
+            }
+            shared_->requested++;
+        }
+        deadline_ = std::chrono::steady_clock::now() + timeout_;
+        shared_->request_cv.notify_one();
+    }
+
+    /**
+     * 等待Start提交的采样，最多到截止时间
+     */
+    ProbeResult<T> Wait() {
+        return Wait(deadline_);
+    }
+
+    /**
+     * 等待Start提交的采样，最多到截止时间和limit中较早的一个（如tick预算的截止时间）
+     */
+    ProbeResult<T> Wait(std::chrono::steady_clock::time_point limit) {
+        ProbeResult<T> result;
+        std::unique_lock<std::mutex> lock(shared_->mutex);
+        bool done = shared_->done_cv.wait_until(lock, std::min(deadline_, limit), [this] {
+            return shared_->completed == shared_->requested;
+        });
+        if (!done) {
+            result.stale = true;
+            timeouts_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (shared_->last.has_value()) {
+            result.value = shared_->last.value();
+            result.has_value = true;
+        }
+        return result;
+    }
+
+    /**
+     * 采样并等待结果（Start + Wait）
+     */
+    ProbeResult<T> Get() {
+        Start();
+        return Wait();
+    }
+
+    void SetTimeout(std::chrono::milliseconds timeout) { timeout_ = timeout; }
+    std::chrono::milliseconds GetTimeout() const { return timeout_; }
+
+    /**
+     * 累计的超时次数
+     */
+    uint64_t GetTimeoutCount() const { return timeouts_.load(std::memory_order_relaxed); }
+
+private:
+    /**
+     * 对象与后台线程共享的状态（线程被分离后由线程持有）
+     */
+    struct Shared {
+        std::function<T()> task;
+        std::mutex mutex;
+        std::condition_variable request_cv;
+        std::condition_variable done_cv;
+        uint64_t requested = 0;     // 已提交的采样序号
+        uint64_t completed = 0;     // 已完成的采样序号
+        bool stopping = false;
+        std::optional<T> last;      // 最近一次完成的采样值
+    };
+
+    std::shared_ptr<Shared> shared_;
+    std::thread thread_;
+    std::chrono::milliseconds timeout_;
+    std::chrono::steady_clock::time_point deadline_;
+    std::atomic<uint64_t> timeouts_;
+
+    static void WorkerLoop(std::shared_ptr<Shared> shared) {
+        std::unique_lock<std::mutex> lock(shared->mutex);
+        while (true) {
+            shared->request_cv.wait(lock, [&shared] {
+                return shared->stopping || shared->completed != shared->requested;
+            });
+            if (shared->stopping) {
+                return;
+            }
+            uint64_t request = shared->requested;
+            lock.unlock();
+            T value = shared->task();
+            lock.lock();
+            shared->last = std::move(value);
+            shared->completed = request;
+            shared->done_cv.notify_all();
+        }
+    }
+};
@@ -1,4 +1,5 @@
 #include "audio_monitor.h"
+#include "metrics.h"
 #include <mmdeviceapi.h>
 #include <endpointvolume.h>
 #include <functiondiscoverykeys_devpkey.h>
@@ -41,6 +42,7 @@ bool AudioMonitor::HasAudioActivity() {
 }
 
 bool AudioMonitor::GetAudioActivity() {
+    METRICS_SCOPE(MetricStage::AUDIO_PROBE);
     DWORD current_time = GetTickCount();
     
     // 使用缓存，避免频繁检测
@@ -0,0 +1,364 @@
+#include "batch_rule_evaluator.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+namespace {
+
+// 窗口历史不足时的统计值（任何比较都为false）
+const double kNoWindowValue = std::numeric_limits<double>::quiet_NaN();
+
+}  // namespace
+
+void StateBatch::Resize(size_t count) {
+    category.resize(count);
+    cpu_usage.resize(count);
+    idle_minutes.resize(count);
+    minute_of_day.resize(count);
+    audio.resize(count);
+    weekday.resize(count);
+    for (auto& column : cpu_average) {
+        column.resize(count, kNoWindowValue);
+    }
+    for (auto& column : audio_ratio) {
+        column.resize(count, kNoWindowValue);
+    }
+}
+
+void StateBatch::SetWindowCounts(size_t cpu_window_count, size_t audio_window_count) {
+    cpu_average.resize(cpu_window_count, std::vector<double>(Size(), kNoWindowValue));
+    audio_ratio.resize(audio_window_count, std::vector<double>(Size(), kNoWindowValue));
+}
+
+void StateBatch::Set(size_t index, const SystemState& state) {
+    category[index] = static_cast<uint8_t>(state.current_app_category);
+    cpu_usage[index] = static_cast<float>(state.cpu_usage);
+    idle_minutes[index] = static_cast<float>(state.idle_minutes);
+    minute_of_day[index] = static_cast<uint16_t>(state.current_hour * 60 + state.current_minute);
+    audio[index] = state.has_audio_activity ? 1 : 0;
+    weekday[index] = state.is_weekday ? 1 : 0;
+    for (auto& column : cpu_average) {
+        column[index] = kNoWindowValue;
+    }
+    for (auto& column : audio_ratio) {
+        column[index] = kNoWindowValue;
+    }
+}
+
+BatchRuleEvaluator::BatchRuleEvaluator() : unsupported_conditions_(0) {
+}
+
+void BatchRuleEvaluator::Compile(const std::vector<Rule>& rules) {
+    conditions_.clear();
+    rules_.clear();
+    cpu_windows_.clear();
+    audio_windows_.clear();
+    unsupported_conditions_ = 0;
+    rules_.reserve(rules.size());
+
+    for (const auto& rule : rules) {
+        CompiledRule compiled_rule;
+        compiled_rule.first_condition = static_cast<uint32_t>(conditions_.size());
+        compiled_rule.condition_count = static_cast<uint32_t>(rule.conditions.size());
+        compiled_rule.mode = rule.target_mode;
+        rules_.push_back(compiled_rule);
+
+        for (const auto& condition : rule.conditions) {
+            CompiledCondition compiled = {};
+            compiled.type = condition.type;
+            switch (condition.type) {
+                case ConditionType::APP_CATEGORY:
+                    compiled.valid = condition.app_category.has_value();
+                    if (compiled.valid) {
+                        compiled.category = static_cast<uint8_t>(condition.app_category.value());
+                    }
+                    break;
+                case ConditionType::TIME_RANGE:
+                    compiled.valid = condition.time_range.has_value();
+                    if (compiled.valid) {
+                        const TimeRange& range = condition.time_range.value();
+                        compiled.weekday_type = range.weekday_type;
+                        compiled.start_minute = static_cast<uint16_t>(range.start_hour * 60 + range.start_minute);
+                        compiled.end_minute = static_cast<uint16_t>(range.end_hour * 60 + range.end_minute);
+                    }
+                    break;
+                case ConditionType::CPU_THRESHOLD:
+                    compiled.valid = condition.cpu_threshold.has_value();
+                    if (compiled.valid) {
+                        compiled.threshold = static_cast<float>(condition.cpu_threshold.value());
+                        compiled.greater = condition.cpu_greater_than;
+                    }
+                    break;
+                case ConditionType::IDLE_THRESHOLD:
+                    compiled.valid = condition.idle_threshold.has_value();
+                    if (compiled.valid) {
+                        compiled.threshold = static_cast<float>(condition.idle_threshold.value());
+                        compiled.greater = condition.idle_greater_than;
+                    }
+                    break;
+                case ConditionType::AUDIO_ACTIVITY:
+                    compiled.valid = condition.audio_activity.has_value();
+                    if (compiled.valid) {
+                        compiled.audio = condition.audio_activity.value() ? 1 : 0;
+                    }
+                    break;
+                case ConditionType::CPU_AVERAGE:
+                    compiled.valid = condition.cpu_threshold.has_value() && RuleEngine::GetWindowSeconds(condition) > 0;
+                    if (compiled.valid) {
+                        compiled.window_threshold = condition.cpu_threshold.value();
+                        compiled.greater = condition.cpu_greater_than;
+                        compiled.column = WindowColumn(cpu_windows_, RuleEngine::GetWindowSeconds(condition));
+                    }
+                    break;
+                case ConditionType::AUDIO_RATIO:
+                    compiled.valid = condition.audio_ratio.has_value() && RuleEngine::GetWindowSeconds(condition) > 0;
+                    if (compiled.valid) {
+                        compiled.window_threshold = condition.audio_ratio.value();
+                        compiled.column = WindowColumn(audio_windows_, RuleEngine::GetWindowSeconds(condition));
+                    }
+                    break;
+                default:
+                    // 温度、持续类别等不在批量状态中的条件：与没有读数或历史不足时一样，永不满足
+                    compiled.valid = false;
+                    unsupported_conditions_++;
+                    break;
+            }
+            conditions_.push_back(compiled);
+        }
+    }
+}
+
+uint32_t BatchRuleEvaluator::WindowColumn(std::vector<size_t>& windows, size_t window_seconds) {
+    auto it = std::find(windows.begin(), windows.end(), window_seconds);
+    if (it == windows.end()) {
+        windows.push_back(window_seconds);
+        return static_cast<uint32_t>(windows.size() - 1);
+    }
+    return static_cast<uint32_t>(it - windows.begin());
+}
+
+void BatchRuleEvaluator::Evaluate(const StateBatch& batch, std::vector<LightMode>& modes, ThreadPool* pool) {
+    size_t count = batch.Size();
+    modes.resize(count);
+    assigned_.resize(count);
+    match_.resize(count);
+
+    LightMode* out = modes.data();
+    // 每块4096项：掩码和各列在块内可以留在L1/L2缓存中
+    const size_t grain = 4096;
+    if (pool != nullptr) {
+        pool->ParallelFor(count, grain, [&](size_t begin, size_t end) {
+            EvaluateRange<false>(batch, out, begin, end, nullptr);
+        });
+    } else {
+        for (size_t begin = 0; begin < count; begin += grain) {
+            EvaluateRange<false>(batch, out, begin, std::min(begin + grain, count), nullptr);
+        }
+    }
+}
+
+void BatchRuleEvaluator::Analyze(const StateBatch& batch, std::vector<LightMode>& modes,
+                                 std::vector<RuleCoverage>& coverage, ThreadPool* pool) {
+    size_t count = batch.Size();
+    modes.resize(count);
+    assigned_.resize(count);
+    match_.resize(count);
+    coverage.assign(rules_.size(), RuleCoverage());
+
+    LightMode* out = modes.data();
+    const size_t grain = 4096;
+    if (pool != nullptr) {
+        // 每块先统计到局部数组，再在锁内合并
+        std::mutex merge_mutex;
+        pool->ParallelFor(count, grain, [&](size_t begin, size_t end) {
+            std::vector<RuleCoverage> local(rules_.size());
+            EvaluateRange<true>(batch, out, begin, end, local.data());
+            std::lock_guard<std::mutex> lock(merge_mutex);
+            for (size_t r = 0; r < local.size(); r++) {
+                coverage[r].decided += local[r].decided;
+                coverage[r].shadowed += local[r].shadowed;
+            }
+        });
+    } else {
+        for (size_t begin = 0; begin < count; begin += grain) {
+            EvaluateRange<true>(batch, out, begin, std::min(begin + grain, count), coverage.data());
+        }
+    }
+}
+
+template <bool kAnalyze>
+void BatchRuleEvaluator::EvaluateRange(const StateBatch& batch, LightMode* modes, size_t begin, size_t end,
+                                       RuleCoverage* coverage) {
+    uint8_t* assigned = assigned_.data();
+    uint8_t* match = match_.data();
+
+    // assigned: 0表示尚未命中任何规则，否则为命中规则的模式+1
+    std::fill(assigned + begin, assigned + end, static_cast<uint8_t>(0));
+
+    size_t remaining = end - begin;
+    for (size_t r = 0; r < rules_.size(); r++) {
+        const CompiledRule& rule = rules_[r];
+        const uint8_t tag = static_cast<uint8_t>(static_cast<uint8_t>(rule.mode) + 1);
+
+        if (kAnalyze) {
+            // 统计模式：每条规则都在所有项上评估，再区分"决定"和"被遮蔽"
+            std::fill(match + begin, match + end, static_cast<uint8_t>(1));
+            for (uint32_t c = 0; c < rule.condition_count; c++) {
+                ApplyCondition(conditions_[rule.first_condition + c], batch, begin, end);
+            }
+            size_t satisfied = 0;
+            size_t decided = 0;
+            for (size_t i = begin; i < end; i++) {
+                uint8_t take = static_cast<uint8_t>(match[i] & static_cast<uint8_t>(assigned[i] == 0));
+                assigned[i] = static_cast<uint8_t>(assigned[i] | (take * tag));
+                satisfied += match[i];
+                decided += take;
+            }
+            coverage[r].decided += decided;
+            coverage[r].shadowed += satisfied - decided;
+            continue;
+        }
+
+        // 匹配掩码从"尚未命中任何规则"开始，每个条件（AND）逐列收窄
+        for (size_t i = begin; i < end; i++) {
+            match[i] = static_cast<uint8_t>(assigned[i] == 0);
+        }
+        for (uint32_t c = 0; c < rule.condition_count; c++) {
+            ApplyCondition(conditions_[rule.first_condition + c], batch, begin, end);
+        }
+
+        // 每项最多命中一条规则，直接用乘法合并，无分支
+        size_t matched = 0;
+        for (size_t i = begin; i < end; i++) {
+            assigned[i] = static_cast<uint8_t>(assigned[i] | (match[i] * tag));
+            matched += match[i];
+        }
+
+        remaining -= matched;
+        if (remaining == 0) {
+            break;
+        }
+    }
+
+    for (size_t i = begin; i < end; i++) {
+        modes[i] = assigned[i] != 0 ? static_cast<LightMode>(assigned[i] - 1) : LightMode::DEFAULT;
+    }
+}
+
+void BatchRuleEvaluator::ApplyCondition(const CompiledCondition& condition, const StateBatch& batch,
+                                        size_t begin, size_t end) {
+    uint8_t* match = match_.data();
+
+    if (!condition.valid) {
+        std::fill(match + begin, match + end, static_cast<uint8_t>(0));
+        return;
+    }
+
+    // 分支只在整列之外做一次，列内循环无分支
+    switch (condition.type) {
+        case ConditionType::APP_CATEGORY: {
+            const uint8_t* category = batch.category.data();
+            const uint8_t expected = condition.category;
+            for (size_t i = begin; i < end; i++) {
+                match[i] &= static_cast<uint8_t>(category[i] == expected);
+            }
+            break;
+        }
+        case ConditionType::TIME_RANGE: {
+            const uint16_t* minute = batch.minute_of_day.data();
+            const uint8_t* weekday = batch.weekday.data();
+            if (condition.weekday_type == WeekdayType::WEEKDAY) {
+                for (size_t i = begin; i < end; i++) {
+                    match[i] &= weekday[i];
+                }
+            } else if (condition.weekday_type == WeekdayType::WEEKEND) {
+                for (size_t i = begin; i < end; i++) {
+                    match[i] &= static_cast<uint8_t>(weekday[i] ^ 1);
+                }
+            }
+            uint16_t start = condition.start_minute;
+            uint16_t stop = condition.end_minute;
+            if (start > stop) {
+                // 跨天（如 23:00-07:00）
+                for (size_t i = begin; i < end; i++) {
+                    match[i] &= static_cast<uint8_t>((minute[i] >= start) | (minute[i] <= stop));
+                }
+            } else {
+                for (size_t i = begin; i < end; i++) {
+                    match[i] &= static_cast<uint8_t>((minute[i] >= start) & (minute[i] <= stop));
+                }
+            }
+            break;
+        }
+        case ConditionType::CPU_THRESHOLD: {
+            const float* cpu = batch.cpu_usage.data();
+            float threshold = condition.threshold;
+            if (condition.greater) {
+                for (size_t i = begin; i < end; i++) {
+                    match[i] &= static_cast<uint8_t>(cpu[i] > threshold);
+                }
+            } else {
+                for (size_t i = begin; i < end; i++) {
+                    match[i] &= static_cast<uint8_t>(cpu[i] <= threshold);
+                }
+            }
+            break;
+        }
+        case ConditionType::IDLE_THRESHOLD: {
+            const float* idle = batch.idle_minutes.data();
+            float threshold = condition.threshold;
+            if (condition.greater) {
+                for (size_t i = begin; i < end; i++) {
+                    match[i] &= static_cast<uint8_t>(idle[i] >= threshold);
+                }
+            } else {
+                for (size_t i = begin; i < end; i++) {
+                    match[i] &= static_cast<uint8_t>(idle[i] < threshold);
+                }
+            }
+            break;
+        }
+        case ConditionType::AUDIO_ACTIVITY: {
+            const uint8_t* audio = batch.audio.data();
+            const uint8_t expected = condition.audio;
+            for (size_t i = begin; i < end; i++) {
+                match[i] &= static_cast<uint8_t>(audio[i] == expected);
+            }
+            break;
+        }
+        case ConditionType::CPU_AVERAGE: {
+            if (condition.column >= batch.cpu_average.size()) {
+                std::fill(match + begin, match + end, static_cast<uint8_t>(0));   // 调用方没有提供窗口统计
+                break;
+            }
+            const double* average = batch.cpu_average[condition.column].data();
+            double threshold = condition.window_threshold;
+            if (condition.greater) {
+                for (size_t i = begin; i < end; i++) {
+                    match[i] &= static_cast<uint8_t>(average[i] > threshold);
+                }
+            } else {
+                for (size_t i = begin; i < end; i++) {
+                    match[i] &= static_cast<uint8_t>(average[i] <= threshold);
+                }
+            }
+            break;
+        }
+        case ConditionType::AUDIO_RATIO: {
+            if (condition.column >= batch.audio_ratio.size()) {
+                std::fill(match + begin, match + end, static_cast<uint8_t>(0));
+                break;
+            }
+            const double* ratio = batch.audio_ratio[condition.column].data();
+            double threshold = condition.window_threshold;
+            for (size_t i = begin; i < end; i++) {
+                match[i] &= static_cast<uint8_t>(ratio[i] >= threshold);
+            }
+            break;
+        }
+        default:
+            std::fill(match + begin, match + end, static_cast<uint8_t>(0));
+            break;
+    }
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "rule_engine.h"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+/**
+ * 批量系统状态（结构数组布局）
+ * 每个字段一列，规则评估时每个条件只扫描它需要的那一列
+ */
+struct StateBatch {
+    std::vector<uint8_t> category;          // AppCategory
+    std::vector<float> cpu_usage;           // CPU使用率 (0-100)
+    std::vector<float> idle_minutes;        // 空闲时间（分钟）
+    std::vector<uint16_t> minute_of_day;    // 当前时间（自0点起的分钟数）
+    std::vector<uint8_t> audio;             // 是否有音频活动（0/1）
+    std::vector<uint8_t> weekday;           // 是否是工作日（0/1）
+
+    // 滑动窗口统计列，顺序与 BatchRuleEvaluator::GetCpuWindows / GetAudioWindows 的窗口长度相同；
+    // 历史不足一个窗口时填NaN（与RuleEngine一样，两种比较方向都不满足）；
+    // 窗口统计与RuleEngine一样按double比较，阈值附近的均值不会因舍入得到不同的结果
+    std::vector<std::vector<double>> cpu_average;   // 窗口内CPU平均使用率
+    std::vector<std::vector<double>> audio_ratio;   // 窗口内有音频活动的采样占比 (0-1)
+
+    void Resize(size_t count);
+    size_t Size() const { return category.size(); }
+
+    /**
+     * 设置窗口统计列的数量（各列大小与当前批大小相同，新增的列填NaN）
+     */
+    void SetWindowCounts(size_t cpu_window_count, size_t audio_window_count);
+
+    /**
+     * 写入第index项（SystemState中没有窗口统计，窗口列填NaN）
+     */
+    void Set(size_t index, const SystemState& state);
+};
+
+/**
+ * 单条规则在一批状态上的命中情况
+ */
+struct RuleCoverage {
+    uint64_t decided = 0;       // 由该规则决定灯光模式的项数
+    uint64_t shadowed = 0;      // 条件满足、但已被更高优先级规则决定的项数
+};
+
+/**
+ * 数据并行的规则评估器
+ * 把规则编译为扁平的条件数组，按"规则 -> 条件 -> 整列"的顺序评估：
+ * 每个条件在整列上执行一个无分支的循环（可被编译器自动向量化），
+ * 结果用逐项掩码合并，已经命中的项不再参与后续规则。
+ * 结果与对每一项调用 RuleEngine::DecideLightMode 相同（瞬时值的阈值按float比较，窗口统计按double比较）。
+ */
+class BatchRuleEvaluator {
+public:
+    BatchRuleEvaluator();
+
+    /**
+     * 编译规则（规则已按优先级从高到低排序，如 RuleEngine::GetRules 的返回值）
+     */
+    void Compile(const std::vector<Rule>& rules);
+
+    /**
+     * 评估整批状态
+     * @param batch 状态
+     * @param modes 输出，大小会被调整为batch.Size()
+     * @param pool 线程池，传入nullptr时在调用线程中执行
+     */
+    void Evaluate(const StateBatch& batch, std::vector<LightMode>& modes, ThreadPool* pool = nullptr);
+
+    /**
+     * 评估整批状态，并统计每条规则的命中情况（用于规则模拟）
+     * 结果与Evaluate相同，但每条规则都在整批上评估（不因全部命中而提前结束），
+     * 因此能统计出被更高优先级规则遮蔽的项数
+     * @param coverage 输出，大小为规则数，顺序与Compile时的规则相同
+     */
+    void Analyze(const StateBatch& batch, std::vector<LightMode>& modes, std::vector<RuleCoverage>& coverage,
+                 ThreadPool* pool = nullptr);
+
+    size_t GetRuleCount() const { return rules_.size(); }
+
+    /**
+     * CPU_AVERAGE条件用到的各个窗口长度（整秒，互不相同），对应 StateBatch::cpu_average 的各列
+     */
+    const std::vector<size_t>& GetCpuWindows() const { return cpu_windows_; }
+
+    /**
+     * AUDIO_RATIO条件用到的各个窗口长度（整秒，互不相同），对应 StateBatch::audio_ratio 的各列
+     */
+    const std::vector<size_t>& GetAudioWindows() const { return audio_windows_; }
+
+    /**
+     * 批量状态中没有对应字段的条件数（温度、持续类别等，评估时视为不满足）
+     */
+    size_t GetUnsupportedConditionCount() const { return unsupported_conditions_; }
+
+private:
+    /**
+     * 编译后的条件（所有字段预先换算好，评估时不再检查optional）
+     */
+    struct CompiledCondition {
+        ConditionType type;
+        bool valid;                 // 条件字段缺失时为false（永不满足）
+        bool greater;               // CPU/IDLE：比较方向
+        uint8_t category;           // APP_CATEGORY
+        uint8_t audio;              // AUDIO_ACTIVITY
+        WeekdayType weekday_type;   // TIME_RANGE
+        uint16_t start_minute;      // TIME_RANGE
+        uint16_t end_minute;        // TIME_RANGE
+        uint32_t column;            // CPU_AVERAGE / AUDIO_RATIO：窗口统计列的下标
+        float threshold;            // CPU_THRESHOLD / IDLE_THRESHOLD
+        double window_threshold;    // CPU_AVERAGE / AUDIO_RATIO
+    };
+
+    struct CompiledRule {
+        uint32_t first_condition;
+        uint32_t condition_count;
+        LightMode mode;
+    };
+
+    std::vector<CompiledCondition> conditions_;
+    std::vector<CompiledRule> rules_;
+    std::vector<size_t> cpu_windows_;
+    std::vector<size_t> audio_windows_;
+    size_t unsupported_conditions_;
+
+    // 评估时的逐项掩码（按批大小复用）
+    std::vector<uint8_t> assigned_;     // 命中规则的模式+1（0表示尚未命中）
+    std::vector<uint8_t> match_;        // 当前规则的匹配掩码
+
+    /**
+     * 评估[begin, end)区间（各区间互不重叠，可并行）
+     * @param coverage kAnalyze为true时累加每条规则的命中情况
+     */
+    template <bool kAnalyze>
+    void EvaluateRange(const StateBatch& batch, LightMode* modes, size_t begin, size_t end, RuleCoverage* coverage);
+
+    /**
+     * 用一个条件更新区间内的匹配掩码
+     */
+    void ApplyCondition(const CompiledCondition& condition, const StateBatch& batch, size_t begin, size_t end);
+
+    /**
+     * 窗口长度对应的统计列下标（没有时追加一列）
+     */
+    static uint32_t WindowColumn(std::vector<size_t>& windows, size_t window_seconds);
+};
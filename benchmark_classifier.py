@@ -0,0 +1,96 @@
+"""
+分类基准 - 比较纯Python实现与 app_state_core 共享库对大量日志行的分类耗时
+
+用法：
+    python benchmark_classifier.py                   # 生成100万行模拟日志
+    python benchmark_classifier.py --rows 200000
+    python benchmark_classifier.py --log apps.tsv    # 使用已有日志（每行 "进程名\\t窗口标题"）
+"""
+import argparse
+import random
+import sys
+import time
+from typing import List, Tuple
+
+from app_classifier import AppClassifier
+from app_state_core import load_library
+
+# 模拟日志的组成：已知进程、只能靠关键词识别的进程和无法识别的进程
+_SAMPLE_ROWS = [
+    ("chrome.exe", "GitHub - Pull requests - Google Chrome"),
+    ("Code.exe", "rule_engine.cpp - Skydimo-Lights - Visual Studio Code"),
+    ("C:\\Program Files\\Steam\\steam.exe", "Steam"),
+    ("vlc.exe", "movie.mkv - VLC media player"),
+    ("spotify.exe", "Spotify Premium"),
+    ("WINWORD.EXE", "季度报告.docx - Word"),
+    ("WindowsTerminal.exe", "PowerShell"),
+    ("explorer.exe", "文件资源管理器"),
+    ("unknown_tool.exe", "Untitled"),
+    ("game_client.exe", "Launcher - Play"),
+    ("Photoshop.exe", "poster.psd @ 66.7%"),
+    ("foo.exe", ""),
+]
+
+
+def generate_rows(count: int) -> List[Tuple[str, str]]:
+    rng = random.Random(12345)
+    rows = []
+    for _ in range(count):
+        name, title = rng.choice(_SAMPLE_ROWS)
+        # 加上变化的标题后缀，避免所有行完全相同
+        rows.append((name, f"{title} ({rng.randrange(1000)})" if title else title))
+    return rows
+
+
+def read_rows(path: str) -> List[Tuple[str, str]]:
+    rows = []
+    with open(path, encoding="utf-8", errors="replace") as file:
+        for line in file:
+            name, _, title = line.rstrip("\r\n").partition("\t")
+            rows.append((name, title))
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description="比较纯Python与共享库的分类耗时")
+    parser.add_argument("--rows", type=int, default=1000000, help="模拟日志行数，默认100万")
+    parser.add_argument("--log", help="日志文件（每行 \"进程名\\t窗口标题\"），指定后忽略--rows")
+    args = parser.parse_args()
+
+    rows = read_rows(args.log) if args.log else generate_rows(args.rows)
+    print(f"日志行数: {len(rows)}")
+
+    python_classifier = AppClassifier(use_native=False)
+    begin = time.perf_counter()
+    python_result = python_classifier.classify_batch(rows)
+    python_seconds = time.perf_counter() - begin
+    print(f"纯Python:            {python_seconds:8.3f} s  ({len(rows) / python_seconds:12.0f} 行/秒)")
+
+    if load_library() is None:
+        print("找不到 app_state_core 共享库，跳过共享库基准（可设置环境变量 APP_STATE_CORE_LIB）")
+        return 1
+
+    native_classifier = AppClassifier()
+    begin = time.perf_counter()
+    native_result = native_classifier.classify_batch(rows)
+    native_seconds = time.perf_counter() - begin
+    print(f"共享库（含编码）:    {native_seconds:8.3f} s  ({len(rows) / native_seconds:12.0f} 行/秒)"
+          f"  加速 {python_seconds / native_seconds:.1f}x")
+
+    # 日志本身就是UTF-8文本时，可以直接把文件内容交给共享库，省去逐行构造字符串
+    records = "\n".join(f"{name}\t{title}" for name, title in rows).encode("utf-8")
+    begin = time.perf_counter()
+    native_classifier._native.classify_records(records)
+    records_seconds = time.perf_counter() - begin
+    print(f"共享库（原始字节）:  {records_seconds:8.3f} s  ({len(rows) / records_seconds:12.0f} 行/秒)"
+          f"  加速 {python_seconds / records_seconds:.1f}x")
+
+    differences = sum(1 for a, b in zip(python_result, native_result) if a != b)
+    print(f"两种实现分类结果不同的行数: {differences}")
+    if differences > 0:
+        print("（纯Python实现的映射和关键词与C++实现不完全一致，使用共享库时以C++实现为准）")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
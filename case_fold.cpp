@@ -0,0 +1,192 @@
+#include "case_fold.h"
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CASE_FOLD_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CASE_FOLD_SSE2 1
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+/**
+ * 最低的置位位置（mask必须非0）
+ */
+inline unsigned LowestBit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+inline char FoldAscii(unsigned char c) {
+    return static_cast<char>(static_cast<unsigned>(c - 'A') < 26u ? c + ('a' - 'A') : c);
+}
+
+inline bool IsContinuation(unsigned char c) {
+    return (c & 0xC0) == 0x80;
+}
+
+/**
+ * 两字节UTF-8范围内（U+0080-U+07FF）的小写映射，结果仍在同一范围内（U+0130除外，映射为ASCII的i）
+ */
+uint32_t FoldTwoByte(uint32_t cp) {
+    // 拉丁字母补充：À-Þ（×除外）
+    if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) {
+        return cp + 0x20;
+    }
+    // 拉丁字母扩展A：大小写成对相邻
+    if (cp >= 0x100 && cp <= 0x17F) {
+        if (cp == 0x130) {
+            return 'i';
+        }
+        if (cp == 0x178) {
+            return 0xFF;
+        }
+        bool even_upper = (cp <= 0x137 && cp != 0x131) || (cp >= 0x14A && cp <= 0x177);
+        bool odd_upper = (cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17E);
+        if ((even_upper && (cp & 1) == 0) || (odd_upper && (cp & 1) == 1)) {
+            return cp + 1;
+        }
+        return cp;
+    }
+    // 希腊字母：Α-Ω（U+03A2未分配）
+    if (cp >= 0x391 && cp <= 0x3A9 && cp != 0x3A2) {
+        return cp + 0x20;
+    }
+    // 西里尔字母：Ѐ-Џ、А-Я
+    if (cp >= 0x400 && cp <= 0x40F) {
+        return cp + 0x50;
+    }
+    if (cp >= 0x410 && cp <= 0x42F) {
+        return cp + 0x20;
+    }
+    return cp;
+}
+
+/**
+ * 折叠一个以非ASCII字节开头的UTF-8字符
+ * @return 消耗的输入字节数
+ */
+size_t FoldMultiByte(const unsigned char* src, size_t remaining, char*& dst) {
+    unsigned char lead = src[0];
+    if (lead >= 0xC2 && lead <= 0xDF && remaining >= 2 && IsContinuation(src[1])) {
+        uint32_t cp = FoldTwoByte(((lead & 0x1Fu) << 6) | (src[1] & 0x3Fu));
+        if (cp < 0x80) {
+            *dst++ = static_cast<char>(cp);
+        } else {
+            *dst++ = static_cast<char>(0xC0 | (cp >> 6));
+            *dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        return 2;
+    }
+    if (lead >= 0xE0 && lead <= 0xEF && remaining >= 3 && IsContinuation(src[1]) && IsContinuation(src[2])) {
+        uint32_t cp = ((lead & 0x0Fu) << 12) | ((src[1] & 0x3Fu) << 6) | (src[2] & 0x3Fu);
+        if (cp >= 0xFF01 && cp <= 0xFF5E) {
+            // 全角ASCII
+            *dst++ = FoldAscii(static_cast<unsigned char>(cp - 0xFEE0));
+        } else if (cp == 0x3000) {
+            *dst++ = ' ';
+        } else {
+            *dst++ = static_cast<char>(src[0]);
+            *dst++ = static_cast<char>(src[1]);
+            *dst++ = static_cast<char>(src[2]);
+        }
+        return 3;
+    }
+    if (lead >= 0xF0 && lead <= 0xF4 && remaining >= 4 &&
+        IsContinuation(src[1]) && IsContinuation(src[2]) && IsContinuation(src[3])) {
+        for (size_t i = 0; i < 4; i++) {
+            *dst++ = static_cast<char>(src[i]);
+        }
+        return 4;
+    }
+    // 不合法的字节原样保留
+    *dst++ = static_cast<char>(lead);
+    return 1;
+}
+
+}  // namespace
+
+void AppendFoldedCase(std::string_view text, std::string& out) {
+    size_t base = out.size();
+    // 折叠不会增加字节数，先按原文长度分配，SIMD可以直接整块写入
+    out.resize(base + text.size());
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t n = text.size();
+    char* const dst_begin = &out[0] + base;
+    char* dst = dst_begin;
+    size_t i = 0;
+
+    while (i < n) {
+        // 整块都是ASCII时一次折叠并写入；块中有非ASCII字节时只提交它之前的部分
+        // （dst不会超过src的位置，整块写入不会越过分配的范围）
+#ifdef CASE_FOLD_AVX2
+        const __m256i upper_low32 = _mm256_set1_epi8('A' - 1);
+        const __m256i upper_high32 = _mm256_set1_epi8('Z' + 1);
+        const __m256i delta32 = _mm256_set1_epi8('a' - 'A');
+        while (i + 32 <= n && src[i] < 0x80) {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            // 非ASCII字节按有符号数比较为负，不会落在'A'-'Z'内
+            __m256i is_upper = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, upper_low32),
+                                                _mm256_cmpgt_epi8(upper_high32, bytes));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                                _mm256_add_epi8(bytes, _mm256_and_si256(is_upper, delta32)));
+            uint32_t high = static_cast<uint32_t>(_mm256_movemask_epi8(bytes));
+            if (high != 0) {
+                unsigned ascii = LowestBit(high);
+                i += ascii;
+                dst += ascii;
+                break;
+            }
+            i += 32;
+            dst += 32;
+        }
+#endif
+#ifdef CASE_FOLD_SSE2
+        const __m128i upper_low = _mm_set1_epi8('A' - 1);
+        const __m128i upper_high = _mm_set1_epi8('Z' + 1);
+        const __m128i delta = _mm_set1_epi8('a' - 'A');
+        while (i + 16 <= n && src[i] < 0x80) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i is_upper = _mm_and_si128(_mm_cmpgt_epi8(bytes, upper_low), _mm_cmplt_epi8(bytes, upper_high));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_add_epi8(bytes, _mm_and_si128(is_upper, delta)));
+            uint32_t high = static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+            if (high != 0) {
+                unsigned ascii = LowestBit(high);
+                i += ascii;
+                dst += ascii;
+                break;
+            }
+            i += 16;
+            dst += 16;
+        }
+#endif
+        if (i >= n) {
+            break;
+        }
+        unsigned char c = src[i];
+        if (c < 0x80) {
+            *dst++ = FoldAscii(c);
+            i++;
+        } else {
+            i += FoldMultiByte(src + i, n - i, dst);
+        }
+    }
+    out.resize(base + static_cast<size_t>(dst - dst_begin));
+}
+
+std::string FoldCase(std::string_view text) {
+    std::string result;
+    AppendFoldedCase(text, result);
+    return result;
+}
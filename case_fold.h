@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/**
+ * UTF-8文本的大小写折叠（分类时进程名、窗口标题和关键词统一使用）
+ *
+ * ASCII部分用SIMD批量处理（SSE2每次16字节，编译时启用AVX2则每次32字节），
+ * 遇到非ASCII字节时逐个解码UTF-8字符：
+ * - 全角ASCII（U+FF01-U+FF5E）和全角空格（U+3000）折叠为对应的ASCII字符，
+ *   因此"Ｓｔｅａｍ"与关键词"steam"匹配
+ * - 拉丁字母补充与扩展A、希腊字母、西里尔字母的大写转为小写
+ * - 其他字符（包括中文）以及不合法的UTF-8字节原样保留
+ * 折叠后的字节数不会超过原文。
+ */
+
+/**
+ * 把text折叠后追加到out
+ */
+void AppendFoldedCase(std::string_view text, std::string& out);
+
+/**
+ * 返回折叠后的文本
+ */
+std::string FoldCase(std::string_view text);
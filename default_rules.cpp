@@ -0,0 +1,131 @@
+#include "default_rules.h"
+#include <vector>
+
+void InitializeRules(RuleEngine& rule_engine) {
+    std::vector<Rule> rules;
+    Rule rule;
+    
+    // 规则1: 夜间弱光模式（23:00-07:00，优先级10）
+    rule = Rule();
+    rule.priority = 10;
+    rule.target_mode = LightMode::NIGHT_DIM;
+    Condition time_condition;
+    time_condition.type = ConditionType::TIME_RANGE;
+    time_condition.time_range = TimeRange(23, 0, 7, 0);  // 23:00-07:00
+    rule.conditions.push_back(time_condition);
+    rules.push_back(rule);
+    
+    // 规则2: 空闲时间超过10分钟，关闭灯光（优先级9）
+    rule = Rule();
+    rule.priority = 9;
+    rule.target_mode = LightMode::OFF;
+    Condition idle_condition;
+    idle_condition.type = ConditionType::IDLE_THRESHOLD;
+    idle_condition.idle_threshold = 10.0;  // 10分钟
+    idle_condition.idle_greater_than = true;  // >= 10分钟
+    rule.conditions.push_back(idle_condition);
+    rules.push_back(rule);
+    
+    // 规则3: 游戏类应用，使用游戏/屏幕同步模式（优先级8）
+    rule = Rule();
+    rule.priority = 8;
+    rule.target_mode = LightMode::GAME_SCREENSYNC;
+    Condition game_condition;
+    game_condition.type = ConditionType::APP_CATEGORY;
+    game_condition.app_category = AppCategory::GAME;
+    rule.conditions.push_back(game_condition);
+    rules.push_back(rule);
+    
+    // 规则4: 视频类应用，使用影视模式（优先级7）
+    rule = Rule();
+    rule.priority = 7;
+    rule.target_mode = LightMode::VIDEO_CINEMATIC;
+    Condition video_condition;
+    video_condition.type = ConditionType::APP_CATEGORY;
+    video_condition.app_category = AppCategory::VIDEO;
+    rule.conditions.push_back(video_condition);
+    rules.push_back(rule);
+    
+    // 规则5: 音乐类应用，使用音乐律动模式（优先级6）
+    rule = Rule();
+    rule.priority = 6;
+    rule.target_mode = LightMode::MUSIC;
+    Condition music_condition;
+    music_condition.type = ConditionType::APP_CATEGORY;
+    music_condition.app_category = AppCategory::MUSIC;
+    rule.conditions.push_back(music_condition);
+    rules.push_back(rule);
+    
+    // 规则6: 开发/编程类应用，使用办公/写代码模式（优先级5）
+    rule = Rule();
+    rule.priority = 5;
+    rule.target_mode = LightMode::WORK_CODING;
+    Condition dev_condition;
+    dev_condition.type = ConditionType::APP_CATEGORY;
+    dev_condition.app_category = AppCategory::DEVELOPMENT;
+    rule.conditions.push_back(dev_condition);
+    rules.push_back(rule);
+    
+    // 规则7: 文档/办公类应用，使用办公/写代码模式（优先级4）
+    rule = Rule();
+    rule.priority = 4;
+    rule.target_mode = LightMode::WORK_CODING;
+    Condition doc_condition;
+    doc_condition.type = ConditionType::APP_CATEGORY;
+    doc_condition.app_category = AppCategory::DOCUMENT;
+    rule.conditions.push_back(doc_condition);
+    rules.push_back(rule);
+    
+    // 规则8: 最近30秒CPU平均使用率超过80%，使用游戏/屏幕同步模式（优先级3）
+    // 使用窗口均值而不是瞬时值，避免编译等短暂的CPU峰值切换灯光模式
+    rule = Rule();
+    rule.priority = 3;
+    rule.target_mode = LightMode::GAME_SCREENSYNC;
+    Condition cpu_condition;
+    cpu_condition.type = ConditionType::CPU_AVERAGE;
+    cpu_condition.cpu_threshold = 80.0;  // 80%
+    cpu_condition.cpu_greater_than = true;  // > 80%
+    cpu_condition.window_seconds = 30.0;  // 最近30秒
+    rule.conditions.push_back(cpu_condition);
+    rules.push_back(rule);
+    
+    // 规则9: 有音频活动且非游戏场景，使用音乐律动模式（优先级2.5）
+    // 实现方式：由于游戏、视频、音乐应用会被更高优先级规则覆盖，
+    // 这个规则主要针对浏览器、未知应用等非游戏场景
+    // 优先级设置为2，高于工作日规则（1）和周末规则（0），确保音频规则优先
+    rule = Rule();
+    rule.priority = 2;
+    rule.target_mode = LightMode::MUSIC;
+    Condition audio_condition;
+    audio_condition.type = ConditionType::AUDIO_ACTIVITY;
+    audio_condition.audio_activity = true;  // 有音频
+    rule.conditions.push_back(audio_condition);
+    // 注意：由于游戏规则（优先级8）更高，游戏场景会被覆盖
+    // 视频规则（优先级7）和音乐规则（优先级6）也会覆盖
+    // 所以这个规则主要对浏览器、未知应用等非游戏场景生效
+    rules.push_back(rule);
+    
+    // 规则10: 工作日 09:00-18:00，使用办公/写代码模式（优先级1）
+    rule = Rule();
+    rule.priority = 1;
+    rule.target_mode = LightMode::WORK_CODING;
+    Condition weekday_time_condition;
+    weekday_time_condition.type = ConditionType::TIME_RANGE;
+    weekday_time_condition.time_range = TimeRange(9, 0, 18, 0, WeekdayType::WEEKDAY);  // 工作日 09:00-18:00
+    rule.conditions.push_back(weekday_time_condition);
+    rules.push_back(rule);
+    
+    // 规则11: 周末 09:00-18:00，使用音乐律动模式（优先级0，作为娱乐模式）
+    // 注意：这个优先级较低，会被其他规则（如游戏、视频等）覆盖
+    rule = Rule();
+    rule.priority = 0;
+    rule.target_mode = LightMode::MUSIC;
+    Condition weekend_time_condition;
+    weekend_time_condition.type = ConditionType::TIME_RANGE;
+    weekend_time_condition.time_range = TimeRange(9, 0, 18, 0, WeekdayType::WEEKEND);  // 周末 09:00-18:00
+    rule.conditions.push_back(weekend_time_condition);
+    rules.push_back(rule);
+    
+    // 注意：如果没有规则匹配，将返回默认模式（DEFAULT）
+    rule_engine.LoadRules(rules);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "rule_engine.h"
+
+/**
+ * 初始化规则引擎，加载默认规则集
+ * 主程序、集中评估服务、一周模拟和共享库（app_state_api）使用同一份规则
+ * @param rule_engine 规则引擎（原有规则会被替换）
+ */
+void InitializeRules(RuleEngine& rule_engine);
@@ -0,0 +1,395 @@
+// winsock2.h必须在windows.h（由rule_engine.h间接包含）之前包含
+#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+#endif
+
+#include "external_command.h"
+#include "metrics.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+namespace {
+
+// 监听线程检查停止标志的间隔
+const int kAcceptPollMs = 200;
+// 客户端连接空闲超过该时间后断开
+const int64_t kClientIdleMs = 30000;
+// 同时连接的客户端数上限（超过时新连接直接关闭）
+const size_t kMaxClients = 16;
+// 单行指令的最大长度
+const size_t kMaxLineLength = 256;
+
+#ifdef _WIN32
+typedef WSAPOLLFD PollFd;
+const int kSendFlags = 0;
+#else
+typedef pollfd PollFd;
+const int kSendFlags = MSG_NOSIGNAL;    // 客户端已关闭时返回错误而不是触发SIGPIPE
+#endif
+
+int PollSockets(PollFd* fds, size_t count, int timeout_ms) {
+#ifdef _WIN32
+    return WSAPoll(fds, static_cast<ULONG>(count), timeout_ms);
+#else
+    return poll(fds, static_cast<nfds_t>(count), timeout_ms);
+#endif
+}
+
+int64_t SteadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t SteadyNowMs() {
+    return SteadyNowNs() / 1000000;
+}
+
+/**
+ * 删除上次异常退出留下的套接字文件
+ * 只删除套接字（Windows下AF_UNIX套接字文件为重解析点），并且先尝试连接：能连上说明另一个实例仍在监听
+ * @return 路径不存在或已删除时返回true；路径是其他文件、仍有进程在监听或删除失败时返回false
+ */
+bool RemoveStaleSocket(const std::string& socket_path, const sockaddr_un& address) {
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesA(socket_path.c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES) {
+        return true;
+    }
+    if ((attributes & FILE_ATTRIBUTE_REPARSE_POINT) == 0) {
+        return false;
+    }
+#else
+    struct stat info;
+    if (lstat(socket_path.c_str(), &info) != 0) {
+        return errno == ENOENT;
+    }
+    if (!S_ISSOCK(info.st_mode)) {
+        return false;
+    }
+#endif
+
+    SocketHandle probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe == kInvalidSocket) {
+        return false;
+    }
+    bool listening = connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+    CloseSocketHandle(probe);
+    return !listening && std::remove(socket_path.c_str()) == 0;
+}
+
+}  // namespace
+
+ExternalCommandManager::ExternalCommandManager()
+    : dropped_(0),
+#ifdef _WIN32
+      wake_event_(CreateEventA(nullptr, FALSE, FALSE, nullptr)),
+#else
+      wake_pending_(false),
+#endif
+      override_active_(false), override_mode_(LightMode::DEFAULT), override_expiry_ms_(0),
+      listen_socket_(kInvalidSocket), running_(false) {
+}
+
+ExternalCommandManager::~ExternalCommandManager() {
+    StopListening();
+#ifdef _WIN32
+    if (wake_event_ != nullptr) {
+        CloseHandle(wake_event_);
+    }
+#endif
+}
+
+bool ExternalCommandManager::ReceiveCommand(const ExternalCommand& command) {
+    ExternalCommand queued = command;
+    queued.enqueue_ns = SteadyNowNs();
+    if (!queue_.TryPush(queued)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    Wake();
+    return true;
+}
+
+void ExternalCommandManager::Wake() {
+#ifdef _WIN32
+    SetEvent(wake_event_);
+#else
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_pending_ = true;
+    }
+    wake_cv_.notify_one();
+#endif
+}
+
+bool ExternalCommandManager::WaitForCommand(int timeout_ms) {
+    if (timeout_ms <= 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return WaitForSingleObject(wake_event_, static_cast<DWORD>(timeout_ms)) == WAIT_OBJECT_0;
+#else
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    bool woken = wake_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] { return wake_pending_; });
+    wake_pending_ = false;
+    return woken;
+#endif
+}
+
+int ExternalCommandManager::ApplyPendingCommands(ExternalCommand* last_applied) {
+    int applied = 0;
+    ExternalCommand command;
+    while (queue_.TryPop(command)) {
+        switch (command.action) {
+            case ExternalCommandAction::FORCE_MODE:
+                override_active_ = true;
+                override_mode_ = command.mode;
+                override_expiry_ms_ = 0;
+                break;
+            case ExternalCommandAction::TIMED_OVERRIDE:
+                override_active_ = true;
+                override_mode_ = command.mode;
+                override_expiry_ms_ = command.enqueue_ns / 1000000 + command.duration_ms;
+                break;
+            case ExternalCommandAction::CLEAR_OVERRIDE:
+                override_active_ = false;
+                break;
+        }
+        METRICS_RECORD(MetricStage::COMMAND_LATENCY, static_cast<uint64_t>(SteadyNowNs() - command.enqueue_ns));
+        if (last_applied != nullptr) {
+            *last_applied = command;
+        }
+        applied++;
+    }
+    return applied;
+}
+
+std::optional<LightMode> ExternalCommandManager::GetActiveOverride() {
+    if (!override_active_) {
+        return std::nullopt;
+    }
+    if (override_expiry_ms_ != 0 && SteadyNowMs() >= override_expiry_ms_) {
+        override_active_ = false;
+        return std::nullopt;
+    }
+    return override_mode_;
+}
+
+int64_t ExternalCommandManager::GetMillisecondsUntilExpiry() const {
+    if (!override_active_ || override_expiry_ms_ == 0) {
+        return -1;
+    }
+    return std::max<int64_t>(0, override_expiry_ms_ - SteadyNowMs());
+}
+
+std::optional<ExternalCommand> ExternalCommandManager::ParseCommand(const std::string& line, std::string& error) {
+    std::istringstream iss(line);
+    std::string verb;
+    iss >> verb;
+
+    ExternalCommand command = {};
+    command.type = ExternalCommandType::CUSTOM;
+
+    if (verb == "clear") {
+        command.action = ExternalCommandAction::CLEAR_OVERRIDE;
+        return command;
+    }
+
+    if (verb != "force" && verb != "override") {
+        error = "未知指令 \"" + verb + "\"";
+        return std::nullopt;
+    }
+
+    std::string mode_name;
+    iss >> mode_name;
+    std::optional<LightMode> mode = RuleEngine::ParseLightModeName(mode_name);
+    if (!mode.has_value()) {
+        error = "未知灯光模式 \"" + mode_name + "\"";
+        return std::nullopt;
+    }
+    command.mode = mode.value();
+
+    if (verb == "force") {
+        command.action = ExternalCommandAction::FORCE_MODE;
+        return command;
+    }
+
+    double seconds = 0.0;
+    if (!(iss >> seconds) || seconds <= 0.0 || seconds > 86400.0) {
+        error = "override 需要指定 (0, 86400] 秒的时长";
+        return std::nullopt;
+    }
+    command.action = ExternalCommandAction::TIMED_OVERRIDE;
+    command.duration_ms = static_cast<uint32_t>(seconds * 1000.0);
+    return command;
+}
+
+bool ExternalCommandManager::StartListening(const std::string& socket_path) {
+    if (running_.load()) {
+        return true;
+    }
+    if (socket_path.empty() || socket_path.size() >= sizeof(sockaddr_un().sun_path) || !InitSockets()) {
+        return false;
+    }
+
+    listen_socket_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_socket_ == kInvalidSocket) {
+        CleanupSockets();
+        return false;
+    }
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    // 上次异常退出可能留下了套接字文件
+    if (!RemoveStaleSocket(socket_path, address)) {
+        CloseSocketHandle(listen_socket_);
+        listen_socket_ = kInvalidSocket;
+        CleanupSockets();
+        return false;
+    }
+
+    if (bind(listen_socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listen_socket_, 8) != 0 ||
+        !SetNonBlocking(listen_socket_)) {
+        CloseSocketHandle(listen_socket_);
+        listen_socket_ = kInvalidSocket;
+        CleanupSockets();
+        return false;
+    }
+
+    socket_path_ = socket_path;
+    running_ = true;
+    listener_thread_ = std::thread(&ExternalCommandManager::ListenLoop, this);
+    return true;
+}
+
+void ExternalCommandManager::StopListening() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (listener_thread_.joinable()) {
+        listener_thread_.join();
+    }
+    CloseSocketHandle(listen_socket_);
+    listen_socket_ = kInvalidSocket;
+    std::remove(socket_path_.c_str());
+    CleanupSockets();
+}
+
+void ExternalCommandManager::ListenLoop() {
+    std::vector<PollFd> fds;
+    while (running_.load(std::memory_order_acquire)) {
+        fds.resize(clients_.size() + 1);
+        fds[0].fd = listen_socket_;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        for (size_t i = 0; i < clients_.size(); i++) {
+            fds[i + 1].fd = clients_[i].socket;
+            fds[i + 1].events = POLLIN;
+            fds[i + 1].revents = 0;
+        }
+
+        int ready = PollSockets(fds.data(), fds.size(), kAcceptPollMs);
+        if (ready > 0) {
+            // 倒序处理：断开时把最后一个客户端移到当前位置，不影响尚未处理的下标
+            for (size_t i = clients_.size(); i-- > 0;) {
+                if (fds[i + 1].revents != 0 && !ReadClient(clients_[i])) {
+                    CloseClient(i);
+                }
+            }
+            if (fds[0].revents & POLLIN) {
+                AcceptClients();
+            }
+        }
+
+        int64_t now_ms = SteadyNowMs();
+        for (size_t i = clients_.size(); i-- > 0;) {
+            if (now_ms - clients_[i].last_active_ms > kClientIdleMs) {
+                CloseClient(i);
+            }
+        }
+    }
+
+    while (!clients_.empty()) {
+        CloseClient(clients_.size() - 1);
+    }
+}
+
+void ExternalCommandManager::AcceptClients() {
+    while (true) {
+        SocketHandle socket_handle = accept(listen_socket_, nullptr, nullptr);
+        if (socket_handle == kInvalidSocket) {
+            return;     // 没有待接受的连接（监听套接字为非阻塞）
+        }
+        if (clients_.size() >= kMaxClients || !SetNonBlocking(socket_handle)) {
+            CloseSocketHandle(socket_handle);
+            continue;
+        }
+        clients_.push_back({socket_handle, std::string(), SteadyNowMs()});
+    }
+}
+
+bool ExternalCommandManager::ReadClient(Client& client) {
+    char buffer[512];
+    int received = recv(client.socket, buffer, sizeof(buffer), 0);
+    if (received < 0 && WouldBlock()) {
+        return true;
+    }
+    if (received <= 0) {
+        return false;
+    }
+    client.pending.append(buffer, static_cast<size_t>(received));
+    client.last_active_ms = SteadyNowMs();
+
+    size_t newline;
+    while ((newline = client.pending.find('\n')) != std::string::npos) {
+        std::string line = client.pending.substr(0, newline);
+        client.pending.erase(0, newline + 1);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+
+        std::string error;
+        std::optional<ExternalCommand> command = ParseCommand(line, error);
+        std::string reply;
+        if (!command.has_value()) {
+            reply = "error: " + error + "\n";
+        } else if (!ReceiveCommand(command.value())) {
+            reply = "error: 指令队列已满\n";
+        } else {
+            reply = "ok\n";
+        }
+        // 回复只有一行，客户端不读取回复导致发送缓冲区满时丢弃
+        send(client.socket, reply.data(), static_cast<int>(reply.size()), kSendFlags);
+    }
+
+    // 没有换行的超长输入，断开
+    return client.pending.size() <= kMaxLineLength;
+}
+
+void ExternalCommandManager::CloseClient(size_t index) {
+    CloseSocketHandle(clients_[index].socket);
+    if (index + 1 != clients_.size()) {
+        clients_[index] = std::move(clients_.back());
+    }
+    clients_.pop_back();
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "mpsc_ring.h"
+#include "rule_engine.h"
+#include "socket_util.h"
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <condition_variable>
+#include <mutex>
+#endif
+
+/**
+ * 外部指令来源
+ */
+enum class ExternalCommandType {
+    HARDWARE_BUTTON,    // 硬件按键
+    MOBILE_CONTROL,     // 手机控制
+    NETWORK_CONTROL,    // 网络控制
+    STREAM_CHAT,        // 直播弹幕
+    CUSTOM              // 自定义指令（脚本、伴侣程序等）
+};
+
+/**
+ * 外部指令动作
+ */
+enum class ExternalCommandAction {
+    FORCE_MODE,         // 强制使用某个灯光模式，直到被清除
+    TIMED_OVERRIDE,     // 在指定时长内使用某个灯光模式
+    CLEAR_OVERRIDE      // 清除手动覆盖，回到规则引擎的决策
+};
+
+/**
+ * 外部指令（定长，可直接放入无锁队列）
+ */
+struct ExternalCommand {
+    ExternalCommandType type;
+    ExternalCommandAction action;
+    LightMode mode;             // FORCE_MODE / TIMED_OVERRIDE
+    uint32_t duration_ms;       // TIMED_OVERRIDE
+    int64_t enqueue_ns;         // 入队时间（steady_clock，由ReceiveCommand填写，用于统计延迟）
+};
+
+/**
+ * 外部指令管理器
+ * 任意线程（本地套接字监听线程、热键、伴侣程序）通过ReceiveCommand把指令放入无锁MPSC队列，
+ * 并立即唤醒主循环；主循环在每个tick开始时无锁取出所有指令并更新手动覆盖状态。
+ * 手动覆盖状态只由主循环线程读写。
+ */
+class ExternalCommandManager {
+public:
+    ExternalCommandManager();
+    ~ExternalCommandManager();
+
+    ExternalCommandManager(const ExternalCommandManager&) = delete;
+    ExternalCommandManager& operator=(const ExternalCommandManager&) = delete;
+
+    /**
+     * 提交外部指令（任意线程调用），并唤醒正在等待的主循环
+     * @return 队列已满时返回false
+     */
+    bool ReceiveCommand(const ExternalCommand& command);
+
+    /**
+     * 在本地（Unix域）套接字上监听文本指令（后台线程）
+     * 每行一条指令：
+     *   force <灯光模式名>            强制使用某个模式
+     *   override <灯光模式名> <秒数>  临时使用某个模式
+     *   clear                         清除手动覆盖
+     * 每条指令回复一行 "ok" 或 "error: ..."
+     * 监听线程用一次poll同时等待监听套接字和所有已连接的客户端，一个客户端不发数据不会挡住其他客户端。
+     * @param socket_path 套接字文件路径（已存在且是上次异常退出留下的套接字时先删除；
+     *                    是普通文件或仍有进程在监听时不删除，返回false）
+     * @return 是否成功开始监听
+     */
+    bool StartListening(const std::string& socket_path);
+
+    /**
+     * 停止监听并删除套接字文件
+     */
+    void StopListening();
+
+    /**
+     * 等待下一个tick（仅主循环线程调用）
+     * 收到指令时立即返回
+     * @param timeout_ms 最长等待时间（毫秒）
+     * @return 是否因收到指令而提前返回
+     */
+    bool WaitForCommand(int timeout_ms);
+
+    /**
+     * 取出队列中的所有指令并更新手动覆盖状态（仅主循环线程调用，不加锁）
+     * @param last_applied 不为nullptr且处理了指令时，输出最后处理的一条指令（用于学习用户的选择）
+     * @return 处理的指令数
+     */
+    int ApplyPendingCommands(ExternalCommand* last_applied = nullptr);
+
+    /**
+     * 当前有效的手动覆盖（仅主循环线程调用）
+     * @return 灯光模式，没有覆盖或临时覆盖已到期时返回std::nullopt
+     */
+    std::optional<LightMode> GetActiveOverride();
+
+    /**
+     * 距离临时覆盖到期还有多少毫秒（仅主循环线程调用，用于安排下一次唤醒）
+     * @return 毫秒数，没有临时覆盖时返回-1
+     */
+    int64_t GetMillisecondsUntilExpiry() const;
+
+    /**
+     * 因队列已满而丢弃的指令数
+     */
+    uint64_t GetDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+    /**
+     * 解析一行文本指令
+     * @param line 指令文本（不含换行）
+     * @param error 解析失败时的原因
+     * @return 指令，格式错误时返回std::nullopt
+     */
+    static std::optional<ExternalCommand> ParseCommand(const std::string& line, std::string& error);
+
+private:
+    MpscRing<ExternalCommand, 64> queue_;
+    std::atomic<uint64_t> dropped_;
+
+    // 唤醒主循环（Windows下为自动重置事件，其他平台为条件变量）
+#ifdef _WIN32
+    void* wake_event_;
+#else
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    bool wake_pending_;
+#endif
+
+    // 手动覆盖状态（仅主循环线程访问）
+    bool override_active_;
+    LightMode override_mode_;
+    int64_t override_expiry_ms_;        // steady_clock毫秒，0表示不过期
+
+    // 本地套接字监听
+    std::string socket_path_;
+    SocketHandle listen_socket_;
+    std::thread listener_thread_;
+    std::atomic<bool> running_;
+
+    /**
+     * 已连接的客户端（仅监听线程访问）
+     */
+    struct Client {
+        SocketHandle socket;
+        std::string pending;        // 尚未收到换行的输入
+        int64_t last_active_ms;     // 最近一次收到数据的时间（steady_clock毫秒）
+    };
+    std::vector<Client> clients_;
+
+    void ListenLoop();
+    void AcceptClients();
+    /**
+     * 读取客户端的输入并回复其中的完整指令
+     * @return 客户端已关闭或出错、输入超长时返回false（由调用方断开）
+     */
+    bool ReadClient(Client& client);
+    void CloseClient(size_t index);
+    void Wake();
+};
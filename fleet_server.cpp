@@ -0,0 +1,590 @@
+// winsock2.h必须在windows.h（由rule_engine.h间接包含）之前包含
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+
+#include "fleet_server.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <thread>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+typedef WSAPOLLFD PollFd;
+const int kSendFlags = 0;
+#else
+typedef pollfd PollFd;
+const int kSendFlags = MSG_NOSIGNAL;    // 对端关闭时返回错误而不是触发SIGPIPE
+#endif
+
+// 单条连接未发出数据的上限，超过说明对端不再读取，断开该连接
+const size_t kMaxOutputBytes = 4 * 1024 * 1024;
+// 每次poll后单条连接最多读取的次数（避免单个连接独占事件循环）
+const int kMaxReadsPerPoll = 16;
+// 窗口历史不足时的统计值（见StateBatch）
+const double kNoWindowValue = std::numeric_limits<double>::quiet_NaN();
+// 回收空闲客户端槽位的间隔
+const int64_t kSweepIntervalMs = 1000;
+
+void SetNoDelay(SocketHandle socket_handle) {
+    int enabled = 1;
+    setsockopt(socket_handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&enabled), sizeof(enabled));
+}
+
+int PollSockets(PollFd* fds, size_t count, int timeout_ms) {
+#ifdef _WIN32
+    return WSAPoll(fds, static_cast<ULONG>(count), timeout_ms);
+#else
+    return poll(fds, static_cast<nfds_t>(count), timeout_ms);
+#endif
+}
+
+int64_t SteadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * 连接到127.0.0.1上的端口（连接成功后设为非阻塞）
+ */
+SocketHandle ConnectLoopback(uint16_t port) {
+    SocketHandle socket_handle = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (socket_handle == kInvalidSocket) {
+        return kInvalidSocket;
+    }
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(socket_handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        !SetNonBlocking(socket_handle)) {
+        CloseSocketHandle(socket_handle);
+        return kInvalidSocket;
+    }
+    SetNoDelay(socket_handle);
+    return socket_handle;
+}
+
+}  // namespace
+
+FleetServer::FleetServer(const std::vector<Rule>& rules)
+    : listen_socket_(kInvalidSocket), sockets_initialized_(false), next_connection_id_(1),
+      cpu_window_seconds_(0), audio_window_seconds_(0),
+      max_batch_size_(4096), batch_interval_ms_(20), first_dirty_ms_(-1),
+      max_clients_(65536), idle_timeout_ms_(5 * 60 * 1000), now_ms_(SteadyNowMs()), last_sweep_ms_(now_ms_),
+      stats_() {
+    evaluator_.Compile(rules);
+    for (size_t seconds : evaluator_.GetCpuWindows()) {
+        cpu_window_seconds_ = std::max(cpu_window_seconds_, seconds);
+    }
+    for (size_t seconds : evaluator_.GetAudioWindows()) {
+        audio_window_seconds_ = std::max(audio_window_seconds_, seconds);
+    }
+    batch_.SetWindowCounts(evaluator_.GetCpuWindows().size(), evaluator_.GetAudioWindows().size());
+}
+
+FleetServer::~FleetServer() {
+    while (!connections_.empty()) {
+        CloseConnection(connections_.size() - 1);
+    }
+    if (listen_socket_ != kInvalidSocket) {
+        CloseSocketHandle(listen_socket_);
+    }
+    if (sockets_initialized_) {
+        CleanupSockets();
+    }
+}
+
+void FleetServer::SetBatchLimits(size_t max_batch_size, int batch_interval_ms) {
+    max_batch_size_ = max_batch_size > 0 ? max_batch_size : 1;
+    batch_interval_ms_ = batch_interval_ms > 0 ? batch_interval_ms : 1;
+}
+
+void FleetServer::SetClientLimits(size_t max_clients, int idle_timeout_ms) {
+    max_clients_ = max_clients > 0 ? max_clients : 1;
+    idle_timeout_ms_ = idle_timeout_ms > 0 ? idle_timeout_ms : 1;
+}
+
+bool FleetServer::Start(uint16_t port) {
+    if (!sockets_initialized_) {
+        if (!InitSockets()) {
+            return false;
+        }
+        sockets_initialized_ = true;
+    }
+
+    listen_socket_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listen_socket_ == kInvalidSocket) {
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(listen_socket_, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    // 只监听回环地址：状态由本机（或本机上的网关）转发，不直接暴露到网络
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listen_socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listen_socket_, SOMAXCONN) != 0 ||
+        !SetNonBlocking(listen_socket_)) {
+        CloseSocketHandle(listen_socket_);
+        listen_socket_ = kInvalidSocket;
+        return false;
+    }
+    return true;
+}
+
+void FleetServer::Run(const std::atomic<bool>& running) {
+    std::vector<PollFd> fds;
+
+    while (running.load(std::memory_order_relaxed)) {
+        // 有未评估的更新时，最多等到批间隔到期
+        int timeout_ms = 100;
+        if (first_dirty_ms_ >= 0) {
+            int64_t waited = SteadyNowMs() - first_dirty_ms_;
+            timeout_ms = static_cast<int>(std::max<int64_t>(0, batch_interval_ms_ - waited));
+        }
+
+        fds.resize(connections_.size() + 1);
+        fds[0].fd = listen_socket_;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        for (size_t i = 0; i < connections_.size(); i++) {
+            fds[i + 1].fd = connections_[i].socket;
+            fds[i + 1].events = static_cast<short>(POLLIN | (connections_[i].output.empty() ? 0 : POLLOUT));
+            fds[i + 1].revents = 0;
+        }
+
+        int ready = PollSockets(fds.data(), fds.size(), timeout_ms);
+        now_ms_ = SteadyNowMs();
+        if (ready > 0) {
+            // 倒序处理：关闭连接时会把最后一个连接移到当前位置，而它已经处理过
+            for (size_t i = connections_.size(); i-- > 0;) {
+                short revents = fds[i + 1].revents;
+                if (revents == 0) {
+                    continue;
+                }
+                bool ok = true;
+                if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                    ok = ReadConnection(connections_[i]);
+                }
+                if (ok && (revents & POLLOUT)) {
+                    ok = FlushConnection(connections_[i]);
+                }
+                if (!ok) {
+                    CloseConnection(i);
+                }
+            }
+            if (fds[0].revents & POLLIN) {
+                AcceptConnections();
+            }
+        }
+
+        if (!dirty_slots_.empty() &&
+            (dirty_slots_.size() >= max_batch_size_ || now_ms_ - first_dirty_ms_ >= batch_interval_ms_)) {
+            EvaluateDirty();
+            // 先直接尝试发送，发不完的部分等待POLLOUT
+            for (size_t i = connections_.size(); i-- > 0;) {
+                if (!connections_[i].output.empty() && !FlushConnection(connections_[i])) {
+                    CloseConnection(i);
+                }
+            }
+        }
+        if (dirty_slots_.empty() && now_ms_ - last_sweep_ms_ >= kSweepIntervalMs) {
+            EvictStaleSlots();
+        }
+    }
+}
+
+void FleetServer::AcceptConnections() {
+    for (;;) {
+        SocketHandle socket_handle = accept(listen_socket_, nullptr, nullptr);
+        if (socket_handle == kInvalidSocket) {
+            return;
+        }
+        if (!SetNonBlocking(socket_handle)) {
+            CloseSocketHandle(socket_handle);
+            continue;
+        }
+        SetNoDelay(socket_handle);
+
+        Connection connection;
+        connection.socket = socket_handle;
+        connection.id = next_connection_id_++;
+        connection_index_[connection.id] = connections_.size();
+        connections_.push_back(std::move(connection));
+        stats_.connections_accepted++;
+    }
+}
+
+bool FleetServer::ReadConnection(Connection& connection) {
+    char buffer[64 * 1024];
+    for (int reads = 0; reads < kMaxReadsPerPoll; reads++) {
+        int received = recv(connection.socket, buffer, sizeof(buffer), 0);
+        if (received == 0) {
+            return false;   // 对端关闭
+        }
+        if (received < 0) {
+            return WouldBlock();
+        }
+        connection.input.insert(connection.input.end(), buffer, buffer + received);
+
+        // 处理所有完整的消息，剩余不足一条的字节留到下次
+        size_t message_count = connection.input.size() / sizeof(FleetStateMessage);
+        for (size_t m = 0; m < message_count; m++) {
+            FleetStateMessage message;
+            std::memcpy(&message, connection.input.data() + m * sizeof(FleetStateMessage), sizeof(message));
+            HandleState(message, connection.id);
+        }
+        connection.input.erase(connection.input.begin(),
+                               connection.input.begin() + message_count * sizeof(FleetStateMessage));
+    }
+    return true;
+}
+
+bool FleetServer::FlushConnection(Connection& connection) {
+    size_t sent_total = 0;
+    while (sent_total < connection.output.size()) {
+        int sent = send(connection.socket, connection.output.data() + sent_total,
+                        static_cast<int>(connection.output.size() - sent_total), kSendFlags);
+        if (sent < 0) {
+            if (!WouldBlock()) {
+                return false;
+            }
+            break;
+        }
+        sent_total += static_cast<size_t>(sent);
+    }
+    connection.output.erase(connection.output.begin(), connection.output.begin() + sent_total);
+    return connection.output.size() <= kMaxOutputBytes;
+}
+
+void FleetServer::CloseConnection(size_t index) {
+    CloseSocketHandle(connections_[index].socket);
+    connection_index_.erase(connections_[index].id);
+    if (index + 1 != connections_.size()) {
+        connections_[index] = std::move(connections_.back());
+        connection_index_[connections_[index].id] = index;
+    }
+    connections_.pop_back();
+}
+
+void FleetServer::HandleState(const FleetStateMessage& message, uint32_t connection_id) {
+    stats_.states_received++;
+
+    uint32_t slot_index;
+    auto it = client_slots_.find(message.client_id);
+    if (it == client_slots_.end()) {
+        if (slots_.size() >= max_clients_) {
+            // 槽位已满：先评估已有的更新，再回收空闲槽位；仍然没有空位时丢弃该客户端的状态
+            if (!dirty_slots_.empty()) {
+                EvaluateDirty();
+            }
+            EvictStaleSlots();
+            if (slots_.size() >= max_clients_) {
+                stats_.states_dropped++;
+                return;
+            }
+        }
+        slot_index = static_cast<uint32_t>(slots_.size());
+        client_slots_[message.client_id] = slot_index;
+        ClientSlot slot;
+        slot.client_id = message.client_id;
+        slot.connection_id = connection_id;
+        slot.last_mode = kNoMode;
+        slot.dirty = false;
+        slot.last_seen_ms = now_ms_;
+        slots_.push_back(slot);
+        slots_.back().cpu_window.Allocate(cpu_window_seconds_);
+        slots_.back().audio_window.Allocate(audio_window_seconds_);
+        latest_.push_back(message);
+    } else {
+        slot_index = it->second;
+    }
+
+    ClientSlot& slot = slots_[slot_index];
+    if (slot.connection_id != connection_id) {
+        // 客户端换了连接（如网关重连），新连接上需要重新收到当前模式
+        slot.connection_id = connection_id;
+        slot.last_mode = kNoMode;
+    }
+    latest_[slot_index] = message;
+    slot.last_seen_ms = now_ms_;
+    // 批间隔内被覆盖的上报也计入窗口，与客户端本地每次决策都采样一致
+    slot.cpu_window.Push(message.monotonic_second, message.cpu_usage);
+    slot.audio_window.Push(message.monotonic_second, (message.flags & kFleetFlagAudio) ? 1.0 : 0.0);
+
+    if (!slot.dirty) {
+        slot.dirty = true;
+        dirty_slots_.push_back(slot_index);
+        if (first_dirty_ms_ < 0) {
+            first_dirty_ms_ = now_ms_;
+        }
+    }
+}
+
+void FleetServer::EvaluateDirty() {
+    size_t count = dirty_slots_.size();
+    batch_.Resize(count);
+    for (size_t k = 0; k < count; k++) {
+        uint32_t slot_index = dirty_slots_[k];
+        const FleetStateMessage& message = latest_[slot_index];
+        batch_.category[k] = message.category;
+        batch_.cpu_usage[k] = message.cpu_usage;
+        batch_.idle_minutes[k] = message.idle_minutes;
+        batch_.minute_of_day[k] = message.minute_of_day;
+        batch_.audio[k] = (message.flags & kFleetFlagAudio) ? 1 : 0;
+        batch_.weekday[k] = (message.flags & kFleetFlagWeekday) ? 1 : 0;
+        const ClientSlot& slot = slots_[slot_index];
+        for (size_t w = 0; w < batch_.cpu_average.size(); w++) {
+            double mean = 0.0;
+            batch_.cpu_average[w][k] = slot.cpu_window.GetMean(evaluator_.GetCpuWindows()[w], mean)
+                                           ? mean : kNoWindowValue;
+        }
+        for (size_t w = 0; w < batch_.audio_ratio.size(); w++) {
+            double ratio = 0.0;
+            batch_.audio_ratio[w][k] = slot.audio_window.GetMean(evaluator_.GetAudioWindows()[w], ratio)
+                                           ? ratio : kNoWindowValue;
+        }
+        slots_[slot_index].dirty = false;
+    }
+
+    auto eval_begin = std::chrono::steady_clock::now();
+    evaluator_.Evaluate(batch_, modes_);
+    stats_.eval_ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - eval_begin).count());
+
+    // 只下发变化了的模式
+    for (size_t k = 0; k < count; k++) {
+        ClientSlot& slot = slots_[dirty_slots_[k]];
+        uint8_t mode = static_cast<uint8_t>(modes_[k]);
+        if (mode == slot.last_mode) {
+            continue;
+        }
+        auto connection_it = connection_index_.find(slot.connection_id);
+        if (connection_it == connection_index_.end()) {
+            continue;   // 连接已关闭，等客户端重新上报
+        }
+        slot.last_mode = mode;
+
+        FleetModeMessage reply = {};
+        reply.client_id = slot.client_id;
+        reply.mode = mode;
+        std::vector<char>& output = connections_[connection_it->second].output;
+        const char* bytes = reinterpret_cast<const char*>(&reply);
+        output.insert(output.end(), bytes, bytes + sizeof(reply));
+        stats_.modes_sent++;
+    }
+
+    stats_.batches++;
+    stats_.clients_evaluated += count;
+    stats_.known_clients = slots_.size();
+    dirty_slots_.clear();
+    first_dirty_ms_ = -1;
+}
+
+void FleetServer::EvictStaleSlots() {
+    // 只在没有未评估的更新时调用：移动槽位不需要修正dirty_slots_中的下标
+    last_sweep_ms_ = now_ms_;
+    for (size_t i = slots_.size(); i-- > 0;) {
+        const ClientSlot& slot = slots_[i];
+        bool connected = connection_index_.count(slot.connection_id) > 0;
+        if (connected && now_ms_ - slot.last_seen_ms < idle_timeout_ms_) {
+            continue;
+        }
+        client_slots_.erase(slot.client_id);
+        if (i + 1 != slots_.size()) {
+            slots_[i] = std::move(slots_.back());
+            latest_[i] = latest_.back();
+            client_slots_[slots_[i].client_id] = static_cast<uint32_t>(i);
+        }
+        slots_.pop_back();
+        latest_.pop_back();
+        stats_.clients_evicted++;
+    }
+    stats_.known_clients = slots_.size();
+}
+
+bool RunFleetLoadGenerator(uint16_t port, RuleEngine& rule_engine, size_t client_count, int rounds,
+                           size_t connection_count, FleetLoadStats& stats) {
+    stats = FleetLoadStats();
+    if (client_count == 0 || connection_count == 0 || !InitSockets()) {
+        return false;
+    }
+    connection_count = std::min(connection_count, client_count);
+
+    std::vector<SocketHandle> sockets;
+    for (size_t c = 0; c < connection_count; c++) {
+        SocketHandle socket_handle = ConnectLoopback(port);
+        if (socket_handle == kInvalidSocket) {
+            for (SocketHandle opened : sockets) {
+                CloseSocketHandle(opened);
+            }
+            CleanupSockets();
+            return false;
+        }
+        sockets.push_back(socket_handle);
+    }
+
+    // 校验需要重放的历史长度：最长的窗口再加窗口起点那一秒
+    std::vector<Rule> rules = rule_engine.GetRules();
+    size_t history_length = 1;
+    for (const auto& rule : rules) {
+        for (const auto& condition : rule.conditions) {
+            if (condition.type == ConditionType::CPU_AVERAGE || condition.type == ConditionType::AUDIO_RATIO) {
+                history_length = std::max(history_length, RuleEngine::GetWindowSeconds(condition) + 1);
+            }
+        }
+    }
+    history_length = std::min(history_length, static_cast<size_t>(std::max(rounds, 1)));
+
+    // history[client * history_length + round % history_length]：每个客户端最近发送的状态
+    std::vector<FleetStateMessage> history(client_count * history_length);
+    std::vector<FleetStateMessage> last_sent(client_count);
+    std::vector<uint8_t> last_received(client_count, 0xFF);
+    std::vector<std::vector<char>> pending_input(connection_count);
+    std::vector<std::vector<char>> outgoing(connection_count);
+    std::mt19937 random(12345);
+    std::uniform_real_distribution<float> cpu_distribution(0.0f, 100.0f);
+    std::uniform_real_distribution<float> busy_cpu_distribution(70.0f, 100.0f);
+    std::uniform_int_distribution<int> category_distribution(0, static_cast<int>(AppCategory::UNKNOWN));
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    // 读取所有连接上已到达的模式
+    auto drain_replies = [&]() {
+        char buffer[64 * 1024];
+        bool any = false;
+        for (size_t c = 0; c < connection_count; c++) {
+            for (;;) {
+                int received = recv(sockets[c], buffer, sizeof(buffer), 0);
+                if (received <= 0) {
+                    break;
+                }
+                any = true;
+                std::vector<char>& input = pending_input[c];
+                input.insert(input.end(), buffer, buffer + received);
+                size_t message_count = input.size() / sizeof(FleetModeMessage);
+                for (size_t m = 0; m < message_count; m++) {
+                    FleetModeMessage reply;
+                    std::memcpy(&reply, input.data() + m * sizeof(FleetModeMessage), sizeof(reply));
+                    if (reply.client_id < client_count) {
+                        last_received[reply.client_id] = reply.mode;
+                    }
+                    stats.modes_received++;
+                }
+                input.erase(input.begin(), input.begin() + message_count * sizeof(FleetModeMessage));
+            }
+        }
+        return any;
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+    bool ok = true;
+    for (int round = 0; round < rounds && ok; round++) {
+        for (size_t client = 0; client < client_count; client++) {
+            // 每轮为1秒；各客户端的起始时间错开97分钟，工作日/周末按客户端分配，客户端之间覆盖全天
+            uint16_t minute_of_day = static_cast<uint16_t>((client * 97 + static_cast<size_t>(round) / 60) % 1440);
+            bool weekday = client % 7 < 5;
+            // 每5个客户端中有1个持续高负载，让CPU窗口均值条件能够满足
+            bool busy = client % 5 == 0;
+
+            FleetStateMessage& message = last_sent[client];
+            message.client_id = static_cast<uint32_t>(client);
+            if (round == 0 || percent(random) < 20) {
+                message.category = static_cast<uint8_t>(category_distribution(random));
+            }
+            message.cpu_usage = busy ? busy_cpu_distribution(random) : cpu_distribution(random);
+            message.idle_minutes = percent(random) < 10 ? 15.0f : static_cast<float>(percent(random) % 5);
+            message.minute_of_day = minute_of_day;
+            message.flags = static_cast<uint8_t>((percent(random) < 30 ? kFleetFlagAudio : 0) |
+                                                 (weekday ? kFleetFlagWeekday : 0));
+            message.monotonic_second = static_cast<uint32_t>(round);
+            history[client * history_length + static_cast<size_t>(round) % history_length] = message;
+
+            const char* bytes = reinterpret_cast<const char*>(&message);
+            std::vector<char>& out = outgoing[client % connection_count];
+            out.insert(out.end(), bytes, bytes + sizeof(message));
+        }
+
+        // 发送本轮所有状态，发送缓冲区满时先读取回复，避免双方互相等待
+        for (size_t c = 0; c < connection_count && ok; c++) {
+            size_t sent_total = 0;
+            while (sent_total < outgoing[c].size()) {
+                int sent = send(sockets[c], outgoing[c].data() + sent_total,
+                                static_cast<int>(outgoing[c].size() - sent_total), kSendFlags);
+                if (sent < 0) {
+                    if (!WouldBlock()) {
+                        ok = false;
+                        break;
+                    }
+                    if (!drain_replies()) {
+                        std::this_thread::sleep_for(std::chrono::microseconds(200));
+                    }
+                    continue;
+                }
+                sent_total += static_cast<size_t>(sent);
+            }
+            stats.states_sent += sent_total / sizeof(FleetStateMessage);
+            outgoing[c].clear();
+        }
+        drain_replies();
+    }
+
+    // 等待服务端处理完最后一批（连续300ms没有新回复视为结束）
+    auto last_reply = std::chrono::steady_clock::now();
+    while (ok && std::chrono::steady_clock::now() - last_reply < std::chrono::milliseconds(300)) {
+        if (drain_replies()) {
+            last_reply = std::chrono::steady_clock::now();
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    stats.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    // 用本地规则引擎校验每个客户端最后收到的模式：清空窗口后按客户端的时钟重放最近的状态，
+    // 最后一次决策即为该客户端在本地运行规则引擎时的结果
+    size_t replay_count = std::min(history_length, static_cast<size_t>(std::max(rounds, 0)));
+    for (size_t client = 0; client < client_count && replay_count > 0; client++) {
+        if (history_length > 1) {
+            rule_engine.LoadRules(rules);
+        }
+        LightMode mode = LightMode::DEFAULT;
+        for (size_t r = static_cast<size_t>(rounds) - replay_count; r < static_cast<size_t>(rounds); r++) {
+            const FleetStateMessage& message = history[client * history_length + r % history_length];
+            SystemState state;
+            state.current_app_category = static_cast<AppCategory>(message.category);
+            state.cpu_usage = message.cpu_usage;
+            state.idle_minutes = message.idle_minutes;
+            state.current_hour = message.minute_of_day / 60;
+            state.current_minute = message.minute_of_day % 60;
+            state.has_audio_activity = (message.flags & kFleetFlagAudio) != 0;
+            state.is_weekday = (message.flags & kFleetFlagWeekday) != 0;
+            state.monotonic_seconds = static_cast<double>(message.monotonic_second);
+            mode = rule_engine.DecideLightMode(state);
+        }
+        if (static_cast<uint8_t>(mode) != last_received[client]) {
+            stats.mismatches++;
+        }
+    }
+
+    for (SocketHandle socket_handle : sockets) {
+        CloseSocketHandle(socket_handle);
+    }
+    CleanupSockets();
+    return ok;
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "batch_rule_evaluator.h"
+#include "rule_engine.h"
+#include "signal_window.h"
+#include "socket_util.h"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 客户端上报的状态（定长20字节，小端）
+ * 一条连接可以代理多个客户端（如楼层网关），以client_id区分
+ */
+struct FleetStateMessage {
+    uint32_t client_id;
+    float cpu_usage;            // CPU使用率 (0-100)
+    float idle_minutes;         // 空闲时间（分钟）
+    uint16_t minute_of_day;     // 当前时间（自0点起的分钟数）
+    uint8_t category;           // AppCategory
+    uint8_t flags;              // 见 kFleetFlag*
+    uint32_t monotonic_second;  // 客户端单调时钟的整秒数（滑动窗口条件按客户端自己的时钟采样）
+};
+
+/**
+ * 服务端下发的灯光模式（定长8字节，只在模式变化时发送）
+ */
+struct FleetModeMessage {
+    uint32_t client_id;
+    uint8_t mode;               // LightMode
+    uint8_t reserved[3];
+};
+
+const uint8_t kFleetFlagAudio = 0x01;       // 有音频活动
+const uint8_t kFleetFlagWeekday = 0x02;     // 工作日
+
+static_assert(sizeof(FleetStateMessage) == 20, "FleetStateMessage必须为20字节");
+static_assert(sizeof(FleetModeMessage) == 8, "FleetModeMessage必须为8字节");
+
+/**
+ * 服务端统计
+ */
+struct FleetServerStats {
+    uint64_t connections_accepted;
+    uint64_t states_received;
+    uint64_t batches;
+    uint64_t clients_evaluated;
+    uint64_t modes_sent;
+    uint64_t eval_ns;           // 规则评估累计耗时（纳秒）
+    uint64_t clients_evicted;   // 因空闲或连接关闭而回收的客户端槽位数
+    uint64_t states_dropped;    // 客户端数达到上限时丢弃的新客户端状态数
+    size_t known_clients;
+};
+
+/**
+ * 集中式规则评估服务
+ * 在本机回环地址上接受多个连接，连接上传输定长二进制的状态更新。
+ * 状态按客户端保存最新值，积累到批大小或批间隔到期时，把有更新的客户端
+ * 收集为结构数组，用BatchRuleEvaluator一次评估，只把模式发生变化的结果发回对应连接。
+ * 规则中有滑动窗口条件（CPU_AVERAGE / AUDIO_RATIO）时，每个客户端的每条上报都计入该客户端的窗口，
+ * 评估时把各窗口的统计值写入批量状态的窗口列。
+ * 客户端槽位有数量上限；所在连接已关闭或长时间没有上报的客户端定期回收（重新上报时从空窗口开始）。
+ * 单线程事件循环（poll/WSAPoll），不为每个连接创建线程。
+ */
+class FleetServer {
+public:
+    /**
+     * @param rules 共享规则集（按优先级排序，如 RuleEngine::GetRules 的返回值）
+     */
+    explicit FleetServer(const std::vector<Rule>& rules);
+    ~FleetServer();
+
+    FleetServer(const FleetServer&) = delete;
+    FleetServer& operator=(const FleetServer&) = delete;
+
+    /**
+     * 设置批处理参数
+     * @param max_batch_size 有更新的客户端达到该数量时立即评估
+     * @param batch_interval_ms 距离第一个未评估的更新超过该时间时评估
+     */
+    void SetBatchLimits(size_t max_batch_size, int batch_interval_ms);
+
+    /**
+     * 设置客户端槽位参数
+     * @param max_clients 同时保存状态的客户端数上限，达到上限后新客户端的状态被丢弃
+     * @param idle_timeout_ms 超过该时间没有上报的客户端被回收
+     */
+    void SetClientLimits(size_t max_clients, int idle_timeout_ms);
+
+    /**
+     * 在127.0.0.1上监听
+     * @param port 端口
+     * @return 是否成功
+     */
+    bool Start(uint16_t port);
+
+    /**
+     * 运行事件循环，直到running变为false
+     */
+    void Run(const std::atomic<bool>& running);
+
+    FleetServerStats GetStats() const { return stats_; }
+
+private:
+    struct Connection {
+        SocketHandle socket;
+        uint32_t id;                    // 连接编号（不复用，用于识别客户端所属的连接）
+        std::vector<char> input;        // 未凑满一条消息的字节
+        std::vector<char> output;       // 尚未发出的字节
+    };
+
+    struct ClientSlot {
+        uint32_t client_id;
+        uint32_t connection_id;         // 最近一次上报所在的连接
+        uint8_t last_mode;              // 最近一次发出的模式（kNoMode表示尚未发出）
+        bool dirty;                     // 有尚未评估的更新
+        int64_t last_seen_ms;           // 最近一次上报的时间（服务端单调时钟）
+        SignalWindow cpu_window;        // 规则没有对应的窗口条件时不分配
+        SignalWindow audio_window;
+    };
+
+    static const uint8_t kNoMode = 0xFF;
+
+    BatchRuleEvaluator evaluator_;
+    SocketHandle listen_socket_;
+    bool sockets_initialized_;
+    uint32_t next_connection_id_;
+    std::vector<Connection> connections_;
+    std::unordered_map<uint32_t, size_t> connection_index_;     // 连接编号 -> connections_下标
+
+    // 每个客户端最新的状态（按槽位存放；只在没有未评估更新时回收，回收时把最后一个槽位移到空位）
+    std::unordered_map<uint32_t, uint32_t> client_slots_;       // client_id -> 槽位
+    std::vector<ClientSlot> slots_;
+    std::vector<FleetStateMessage> latest_;
+    std::vector<uint32_t> dirty_slots_;
+
+    // 批评估的缓冲区（复用）
+    StateBatch batch_;
+    std::vector<LightMode> modes_;
+    size_t cpu_window_seconds_;         // 各CPU窗口中最长的（0表示没有CPU窗口条件）
+    size_t audio_window_seconds_;
+
+    size_t max_batch_size_;
+    int batch_interval_ms_;
+    int64_t first_dirty_ms_;            // 第一个未评估更新的到达时间（-1表示没有）
+    size_t max_clients_;
+    int idle_timeout_ms_;
+    int64_t now_ms_;                    // 本轮事件循环的时间
+    int64_t last_sweep_ms_;             // 上一次回收槽位的时间
+
+
+    FleetServerStats stats_;
+
+    void AcceptConnections();
+    bool ReadConnection(Connection& connection);
+    bool FlushConnection(Connection& connection);
+    void CloseConnection(size_t index);
+    void HandleState(const FleetStateMessage& message, uint32_t connection_id);
+    void EvaluateDirty();
+    void EvictStaleSlots();
+};
+
+/**
+ * 负载生成器统计
+ */
+struct FleetLoadStats {
+    uint64_t states_sent;
+    uint64_t modes_received;
+    uint64_t mismatches;        // 结束时服务端最后下发的模式与本地RuleEngine结果不一致的客户端数
+    double elapsed_seconds;
+};
+
+/**
+ * 本地负载生成器
+ * 用少量连接模拟大量客户端，按轮次为每个客户端发送随机变化的状态，
+ * 每轮相当于每个客户端过了1秒（单调时钟每轮加1，一天中的时间每60轮前进1分钟，各客户端的起始时间不同）。
+ * 结束后等待服务端下发完毕，并用本地RuleEngine校验每个客户端最后收到的模式：
+ * 规则有滑动窗口条件时，对每个客户端重新加载规则（清空窗口）后按原时钟重放最近一个窗口内发送的状态。
+ * @param port 服务端端口
+ * @param rule_engine 与服务端相同的规则（用于校验，校验时会重新加载规则）
+ * @param client_count 模拟的客户端数
+ * @param rounds 轮数（每轮每个客户端发送一次状态）
+ * @param connection_count 使用的连接数
+ * @param stats 输出统计
+ * @return 是否成功连接并完成
+ */
+bool RunFleetLoadGenerator(uint16_t port, RuleEngine& rule_engine, size_t client_count, int rounds,
+                           size_t connection_count, FleetLoadStats& stats);
@@ -0,0 +1,226 @@
+#include "frame_pacer.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <future>
+
+#ifdef _WIN32
+#include <windows.h>
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+namespace {
+
+// 实时优先级（SCHED_FIFO，1-99）：高于普通线程即可，不与内核线程争抢
+const int kRealtimePriority = 10;
+
+#ifdef _WIN32
+// 可等待定时器提前醒来的余量，最后一段自旋等待（高精度定时器的误差约0.5ms）
+const int64_t kSpinMarginNs = 200000;
+#endif
+
+/**
+ * 单调时钟（纳秒），与睡眠使用的时钟一致
+ */
+int64_t MonotonicNanoseconds() {
+#ifdef _WIN32
+    static const int64_t frequency = [] {
+        LARGE_INTEGER value;
+        QueryPerformanceFrequency(&value);
+        return static_cast<int64_t>(value.QuadPart);
+    }();
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // 分成整秒和余数两部分换算，避免乘法溢出
+    int64_t ticks = static_cast<int64_t>(counter.QuadPart);
+    return ticks / frequency * 1000000000LL + ticks % frequency * 1000000000LL / frequency;
+#elif defined(__linux__)
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * 睡到绝对时间deadline_ns（已过去时立即返回）
+ */
+class DeadlineSleeper {
+public:
+    DeadlineSleeper() {
+#ifdef _WIN32
+        // 高精度定时器需要Windows 10 1803及以上；不支持时退回普通定时器（精度取决于系统时钟分辨率）
+        timer_ = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (timer_ == nullptr) {
+            timer_ = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        }
+#endif
+    }
+
+    ~DeadlineSleeper() {
+#ifdef _WIN32
+        if (timer_ != nullptr) {
+            CloseHandle(timer_);
+        }
+#endif
+    }
+
+    DeadlineSleeper(const DeadlineSleeper&) = delete;
+    DeadlineSleeper& operator=(const DeadlineSleeper&) = delete;
+
+    void SleepUntil(int64_t deadline_ns) {
+#ifdef _WIN32
+        // 可等待定时器只接受相对时间或系统时间，按QPC换算成相对时间，最后一小段自旋
+        int64_t remaining = deadline_ns - MonotonicNanoseconds();
+        if (remaining > kSpinMarginNs && timer_ != nullptr) {
+            LARGE_INTEGER due;
+            due.QuadPart = -((remaining - kSpinMarginNs) / 100);  // 负数表示相对时间，单位100ns
+            if (SetWaitableTimer(timer_, &due, 0, nullptr, nullptr, FALSE)) {
+                WaitForSingleObject(timer_, INFINITE);
+            }
+        }
+        while (MonotonicNanoseconds() < deadline_ns) {
+            YieldProcessor();
+        }
+#elif defined(__linux__)
+        timespec ts;
+        ts.tv_sec = static_cast<time_t>(deadline_ns / 1000000000LL);
+        ts.tv_nsec = static_cast<long>(deadline_ns % 1000000000LL);
+        // 被信号打断时按同一个绝对时间继续睡
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+#else
+        std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(deadline_ns))));
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE timer_;
+#endif
+};
+
+}  // namespace
+
+FramePacer::FramePacer()
+    : options_(), callback_(), thread_(), running_(false),
+      jitter_(std::make_unique<LatencyHistogram>()), render_time_(std::make_unique<LatencyHistogram>()),
+      frames_(0), missed_(0), pinned_(false), realtime_(false) {
+}
+
+FramePacer::~FramePacer() {
+    Stop();
+}
+
+bool FramePacer::Start(const FramePacerOptions& options, FrameCallback callback) {
+    if (IsRunning() || !(options.frames_per_second > 0.0) || options.frames_per_second > 10000.0) {
+        return false;
+    }
+    options_ = options;
+    callback_ = std::move(callback);
+    jitter_ = std::make_unique<LatencyHistogram>();
+    render_time_ = std::make_unique<LatencyHistogram>();
+    frames_.store(0, std::memory_order_relaxed);
+    missed_.store(0, std::memory_order_relaxed);
+    pinned_.store(false, std::memory_order_relaxed);
+    realtime_.store(false, std::memory_order_relaxed);
+    running_.store(true, std::memory_order_release);
+
+    std::promise<void> configured;
+    std::future<void> configured_future = configured.get_future();
+    thread_ = std::thread([this, &configured] {
+        ConfigureThread();
+        configured.set_value();
+        PacingLoop();
+    });
+    configured_future.wait();
+    return true;
+}
+
+void FramePacer::Stop() {
+    running_.store(false, std::memory_order_release);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+FramePacingStats FramePacer::GetStats() const {
+    FramePacingStats stats;
+    stats.frames = frames_.load(std::memory_order_relaxed);
+    stats.missed_deadlines = missed_.load(std::memory_order_relaxed);
+    stats.jitter_p50_ns = jitter_->ValueAtQuantile(0.5);
+    stats.jitter_p99_ns = jitter_->ValueAtQuantile(0.99);
+    stats.jitter_p999_ns = jitter_->ValueAtQuantile(0.999);
+    stats.jitter_max_ns = jitter_->Max();
+    stats.render_p99_ns = render_time_->ValueAtQuantile(0.99);
+    stats.pinned = pinned_.load(std::memory_order_relaxed);
+    stats.realtime = realtime_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void FramePacer::ConfigureThread() {
+#ifdef _WIN32
+    if (options_.cpu_core >= 0 && options_.cpu_core < static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+        pinned_.store(SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << options_.cpu_core) != 0,
+                      std::memory_order_relaxed);
+    }
+    if (options_.realtime_priority) {
+        realtime_.store(SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0,
+                        std::memory_order_relaxed);
+    }
+#elif defined(__linux__)
+    if (options_.cpu_core >= 0 && options_.cpu_core < CPU_SETSIZE) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(options_.cpu_core, &cpus);
+        pinned_.store(pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0, std::memory_order_relaxed);
+    }
+    if (options_.realtime_priority) {
+        // 需要CAP_SYS_NICE或足够的RLIMIT_RTPRIO，否则失败并保持普通优先级
+        sched_param param = {};
+        param.sched_priority = std::clamp(kRealtimePriority, sched_get_priority_min(SCHED_FIFO),
+                                          sched_get_priority_max(SCHED_FIFO));
+        realtime_.store(pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0, std::memory_order_relaxed);
+    }
+#endif
+}
+
+void FramePacer::PacingLoop() {
+    DeadlineSleeper sleeper;
+    const int64_t period_ns = static_cast<int64_t>(1e9 / options_.frames_per_second);
+    const int64_t start_ns = MonotonicNanoseconds() + period_ns;
+    uint64_t frame_index = 0;
+
+    while (running_.load(std::memory_order_acquire)) {
+        int64_t deadline_ns = start_ns + static_cast<int64_t>(frame_index) * period_ns;
+        sleeper.SleepUntil(deadline_ns);
+        int64_t woke_ns = MonotonicNanoseconds();
+        uint64_t jitter_ns = static_cast<uint64_t>(std::max<int64_t>(woke_ns - deadline_ns, 0));
+        jitter_->Record(jitter_ns);
+        METRICS_RECORD(MetricStage::FRAME_JITTER, jitter_ns);
+
+        callback_(frame_index, static_cast<double>(deadline_ns - start_ns) / 1e9);
+        frames_.fetch_add(1, std::memory_order_relaxed);
+        int64_t done_ns = MonotonicNanoseconds();
+        render_time_->Record(static_cast<uint64_t>(std::max<int64_t>(done_ns - woke_ns, 0)));
+
+        // 下一帧晚于它之后一帧的计划时间才能开始时跳过它，不连续补帧
+        frame_index++;
+        int64_t late_ns = done_ns - (start_ns + static_cast<int64_t>(frame_index + 1) * period_ns);
+        if (late_ns >= 0) {
+            uint64_t skipped = static_cast<uint64_t>(late_ns / period_ns) + 1;
+            frame_index += skipped;
+            missed_.fetch_add(skipped, std::memory_order_relaxed);
+            METRICS_COUNT_BY(MetricCounter::FRAME_DEADLINES_MISSED, skipped);
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "metrics.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+
+/**
+ * 输出线程的选项
+ */
+struct FramePacerOptions {
+    double frames_per_second = 60.0;
+    int cpu_core = -1;              // 绑定到的CPU核（-1表示不绑定）
+    bool realtime_priority = false; // 提升为实时优先级（Linux: SCHED_FIFO，Windows: TIME_CRITICAL）
+};
+
+/**
+ * 帧节奏统计
+ * 抖动 = 线程实际醒来的时间 - 帧的计划时间（只会晚，不会早）
+ */
+struct FramePacingStats {
+    uint64_t frames;            // 已输出的帧数
+    uint64_t missed_deadlines;  // 因前面的帧太晚而被跳过的帧数
+    uint64_t jitter_p50_ns;
+    uint64_t jitter_p99_ns;
+    uint64_t jitter_p999_ns;
+    uint64_t jitter_max_ns;
+    uint64_t render_p99_ns;     // 渲染与输出回调耗时的p99
+    bool pinned;                // 是否已绑定CPU核
+    bool realtime;              // 是否已提升为实时优先级
+};
+
+/**
+ * 固定帧率的输出线程
+ * 第n帧的计划时间为 启动时间 + n * 帧间隔，线程用绝对时间的定时器睡到计划时间
+ * （Linux: clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME)，Windows: 高精度可等待定时器），
+ * 因此回调的耗时和睡眠的误差不会累积成漂移。某一帧的回调太慢、使后面的计划时间已经过去时，
+ * 不会连续补帧，而是跳到下一个还来得及的计划时间，跳过的帧记为错过。
+ * 帧节奏与主循环的决策tick完全独立：主循环只发布当前模式（见LightEffectRenderer::SetMode）。
+ *
+ * Start/Stop/GetStats只应在同一个线程中调用；回调在输出线程中执行。
+ */
+class FramePacer {
+public:
+    /**
+     * 帧回调：渲染并输出一帧
+     * @param frame_index 帧序号（跳过的帧也计入）
+     * @param time_seconds 帧的计划时间（相对启动，秒）
+     */
+    using FrameCallback = std::function<void(uint64_t frame_index, double time_seconds)>;
+
+    FramePacer();
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    /**
+     * 启动输出线程（返回前线程已完成CPU绑定和优先级设置，结果见GetStats）
+     * @return 帧率不合法或已在运行时返回false
+     */
+    bool Start(const FramePacerOptions& options, FrameCallback callback);
+
+    /**
+     * 停止输出线程（等待当前帧完成）
+     */
+    void Stop();
+
+    bool IsRunning() const { return thread_.joinable(); }
+
+    /**
+     * 最近一次Start以来的统计（运行中也可调用）
+     */
+    FramePacingStats GetStats() const;
+
+private:
+    FramePacerOptions options_;
+    FrameCallback callback_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+    std::unique_ptr<LatencyHistogram> jitter_;
+    std::unique_ptr<LatencyHistogram> render_time_;
+    std::atomic<uint64_t> frames_;
+    std::atomic<uint64_t> missed_;
+    std::atomic<bool> pinned_;
+    std::atomic<bool> realtime_;
+
+    void PacingLoop();
+
+    /**
+     * 在输出线程中绑定CPU核、提升优先级
+     */
+    void ConfigureThread();
+};
@@ -0,0 +1,585 @@
+#include "history_store.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char kMagic[4] = {'S', 'H', 'S', 'G'};
+const uint32_t kVersion = 1;
+const int64_t kSecondsPerDay = 86400;
+const int64_t kSecondsPerHour = 3600;
+const uint32_t kMaxParts = 1000;            // 每天最多的分卷数
+const uint32_t kMinSegmentBytes = 4096;
+
+// 记录标志字节：低3位为类别，接着3位为模式，最高两位表示之后是否携带进程符号和原因
+const uint8_t kCategoryMask = 0x07;
+const uint8_t kModeShift = 3;
+const uint8_t kModeMask = 0x07;
+const uint8_t kHasSymbol = 0x40;
+const uint8_t kHasReason = 0x80;
+const size_t kMaxRecordBytes = 1 + 5 + 5 + 5;   // 标志 + 3个32位varint
+
+/**
+ * 段文件头（136字节），之后是记录区
+ */
+struct SegmentHeader {
+    char magic[4];
+    uint32_t version;
+    int64_t day;                    // 自1970-01-01起的天数（UTC）
+    int64_t last_time;              // 最后一条记录的时间（秒）
+    uint32_t capacity;              // 文件大小
+    uint32_t used;                  // 已使用的字节数（含文件头），记录写完后才更新
+    uint32_t record_count;
+    uint32_t part;
+    uint32_t hour_offsets[24];      // 每小时第一条记录的偏移（0表示该小时没有记录）
+};
+
+static_assert(sizeof(SegmentHeader) == 136, "SegmentHeader必须为136字节");
+
+int64_t FloorDiv(int64_t value, int64_t divisor) {
+    int64_t quotient = value / divisor;
+    return (value % divisor != 0 && value < 0) ? quotient - 1 : quotient;
+}
+
+size_t PutVarint(uint8_t* out, uint32_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = static_cast<uint8_t>(value);
+    return length;
+}
+
+bool GetVarint(const uint8_t*& p, const uint8_t* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 进程名的符号表键：最后一个路径分隔符之后的部分，小写
+ */
+std::string SymbolKey(const std::string& process_name) {
+    size_t begin = process_name.find_last_of("\\/");
+    begin = (begin == std::string::npos) ? 0 : begin + 1;
+    std::string key;
+    key.reserve(process_name.size() - begin);
+    for (size_t i = begin; i < process_name.size(); i++) {
+        char c = process_name[i];
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        } else if (c == '\n' || c == '\r') {
+            c = ' ';    // 符号表每行一个
+        }
+        key.push_back(c);
+    }
+    return key;
+}
+
+bool IsValidHeader(const SegmentHeader& header, size_t file_size) {
+    return std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion &&
+           header.capacity == file_size && header.used >= sizeof(SegmentHeader) && header.used <= file_size;
+}
+
+}  // namespace
+
+/**
+ * 映射到内存的文件（只在history_store.cpp中使用）
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * 以读写方式映射文件；文件不存在或为空时创建为size字节，已存在时按原大小映射
+     */
+    bool OpenWritable(const std::string& path, size_t size) {
+        Close();
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                            nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file_, &file_size)) {
+            Close();
+            return false;
+        }
+        if (file_size.QuadPart > 0) {
+            size = static_cast<size_t>(file_size.QuadPart);
+        }
+        // 映射大小超过文件大小时CreateFileMapping会扩展文件
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(size), nullptr);
+        if (mapping_ == nullptr) {
+            Close();
+            return false;
+        }
+        data_ = static_cast<uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, size));
+#else
+        fd_ = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) {
+            return false;
+        }
+        struct stat file_stat;
+        if (fstat(fd_, &file_stat) != 0) {
+            Close();
+            return false;
+        }
+        if (file_stat.st_size > 0) {
+            size = static_cast<size_t>(file_stat.st_size);
+        } else if (ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+            Close();
+            return false;
+        }
+        void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        data_ = address != MAP_FAILED ? static_cast<uint8_t*>(address) : nullptr;
+#endif
+        if (data_ == nullptr) {
+            Close();
+            return false;
+        }
+        size_ = size;
+        return true;
+    }
+
+    /**
+     * 以只读方式映射已存在的文件
+     */
+    bool OpenReadOnly(const std::string& path) {
+        Close();
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file_, &file_size) || file_size.QuadPart == 0) {
+            Close();
+            return false;
+        }
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ == nullptr) {
+            Close();
+            return false;
+        }
+        data_ = static_cast<uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        size_t size = static_cast<size_t>(file_size.QuadPart);
+#else
+        fd_ = open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            return false;
+        }
+        struct stat file_stat;
+        if (fstat(fd_, &file_stat) != 0 || file_stat.st_size == 0) {
+            Close();
+            return false;
+        }
+        size_t size = static_cast<size_t>(file_stat.st_size);
+        void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd_, 0);
+        data_ = address != MAP_FAILED ? static_cast<uint8_t*>(address) : nullptr;
+#endif
+        if (data_ == nullptr) {
+            Close();
+            return false;
+        }
+        size_ = size;
+        return true;
+    }
+
+    void Flush() {
+        if (data_ == nullptr) {
+            return;
+        }
+#ifdef _WIN32
+        FlushViewOfFile(data_, 0);
+        FlushFileBuffers(file_);
+#else
+        msync(data_, size_, MS_SYNC);
+#endif
+    }
+
+    void Close() {
+#ifdef _WIN32
+        if (data_ != nullptr) {
+            UnmapViewOfFile(data_);
+        }
+        if (mapping_ != nullptr) {
+            CloseHandle(mapping_);
+            mapping_ = nullptr;
+        }
+        if (file_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(file_);
+            file_ = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (data_ != nullptr) {
+            munmap(data_, size_);
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    uint8_t* Data() const { return data_; }
+    size_t Size() const { return size_; }
+
+private:
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+HistoryStore::HistoryStore(uint32_t segment_bytes)
+    : segment_bytes_(std::max(segment_bytes, kMinSegmentBytes)), writer_day_(0), writer_part_(0),
+      force_full_record_(true), last_symbol_(0), last_reason_(0) {
+    symbols_.assign(1, std::string());
+}
+
+HistoryStore::~HistoryStore() {
+    Close();
+}
+
+bool HistoryStore::Open(const std::string& directory) {
+    Close();
+    if (directory.empty()) {
+        return false;
+    }
+#ifdef _WIN32
+    if (!CreateDirectoryA(directory.c_str(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS) {
+        return false;
+    }
+#else
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        return false;
+    }
+#endif
+    directory_ = directory;
+
+    // 加载符号表（编号0保留给“没有前台窗口”）
+    symbols_.assign(1, std::string());
+    symbol_ids_.clear();
+    std::ifstream file(directory_ + "/symbols.txt");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        symbol_ids_.emplace(line, static_cast<uint32_t>(symbols_.size()));
+        symbols_.push_back(line);
+    }
+    return true;
+}
+
+void HistoryStore::Close() {
+    if (writer_) {
+        writer_->Flush();
+        writer_.reset();
+    }
+    directory_.clear();
+    force_full_record_ = true;
+}
+
+void HistoryStore::Flush() {
+    if (writer_) {
+        writer_->Flush();
+    }
+}
+
+std::string HistoryStore::SegmentPath(int64_t day, uint32_t part) const {
+    return directory_ + "/seg-" + std::to_string(day) + "-" + std::to_string(part) + ".bin";
+}
+
+uint32_t HistoryStore::InternSymbol(const std::string& process_name) {
+    if (process_name.empty()) {
+        return 0;
+    }
+    std::string key = SymbolKey(process_name);
+    auto it = symbol_ids_.find(key);
+    if (it != symbol_ids_.end()) {
+        return it->second;
+    }
+    // 新进程名追加到符号表末尾（只在第一次见到该进程时写文件）
+    std::ofstream file(directory_ + "/symbols.txt", std::ios::app);
+    file << key << "\n";
+    if (!file.good()) {
+        return 0;
+    }
+    uint32_t id = static_cast<uint32_t>(symbols_.size());
+    symbol_ids_.emplace(key, id);
+    symbols_.push_back(key);
+    return id;
+}
+
+bool HistoryStore::OpenWriter(int64_t day, uint32_t min_part) {
+    writer_.reset();
+    for (uint32_t part = min_part; part < kMaxParts; part++) {
+        // 跳到该日最后一个已存在的分卷
+        if (std::ifstream(SegmentPath(day, part + 1)).good()) {
+            continue;
+        }
+        auto file = std::make_unique<MappedFile>();
+        if (!file->OpenWritable(SegmentPath(day, part), segment_bytes_) || file->Size() < sizeof(SegmentHeader)) {
+            return false;
+        }
+        SegmentHeader* header = reinterpret_cast<SegmentHeader*>(file->Data());
+        if (header->version == 0 && std::memcmp(header->magic, "\0\0\0\0", sizeof(kMagic)) == 0) {
+            // 新建的段（文件内容全为0）
+            std::memcpy(header->magic, kMagic, sizeof(kMagic));
+            header->version = kVersion;
+            header->day = day;
+            header->last_time = day * kSecondsPerDay;
+            header->capacity = static_cast<uint32_t>(file->Size());
+            header->used = sizeof(SegmentHeader);
+            header->record_count = 0;
+            header->part = part;
+        } else if (!IsValidHeader(*header, file->Size()) || header->day != day) {
+            return false;   // 不是本程序写入的文件，不覆盖
+        }
+        if (header->used + kMaxRecordBytes > header->capacity) {
+            continue;       // 已写满
+        }
+        writer_ = std::move(file);
+        writer_day_ = day;
+        writer_part_ = part;
+        force_full_record_ = true;
+        return true;
+    }
+    return false;
+}
+
+uint32_t HistoryStore::EncodeReason(HistoryReason reason, uint32_t rule_index) {
+    switch (reason) {
+        case HistoryReason::RULE:
+            return 3 + rule_index;
+        case HistoryReason::APP_OVERRIDE:
+            return 1;
+        case HistoryReason::MANUAL_OVERRIDE:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+void HistoryStore::DecodeReason(uint32_t code, HistoryReason& reason, uint32_t& rule_index) {
+    rule_index = 0;
+    if (code >= 3) {
+        reason = HistoryReason::RULE;
+        rule_index = code - 3;
+    } else if (code == 1) {
+        reason = HistoryReason::APP_OVERRIDE;
+    } else if (code == 2) {
+        reason = HistoryReason::MANUAL_OVERRIDE;
+    } else {
+        reason = HistoryReason::DEFAULT_MODE;
+    }
+}
+
+bool HistoryStore::Append(const HistoryRecord& record, const std::string& process_name) {
+    if (!IsOpen()) {
+        return false;
+    }
+    int64_t timestamp = record.timestamp;
+    int64_t day = FloorDiv(timestamp, kSecondsPerDay);
+    if (writer_ && day < writer_day_) {
+        day = writer_day_;  // 时钟回拨到前一天：继续写入当前段
+    }
+    if (!writer_ || day != writer_day_) {
+        if (!OpenWriter(day, 0)) {
+            return false;
+        }
+    }
+    SegmentHeader* header = reinterpret_cast<SegmentHeader*>(writer_->Data());
+    if (header->used + kMaxRecordBytes > header->capacity) {
+        if (!OpenWriter(day, writer_part_ + 1)) {
+            return false;
+        }
+        header = reinterpret_cast<SegmentHeader*>(writer_->Data());
+    }
+    timestamp = std::max(timestamp, header->last_time);
+
+    uint32_t symbol = InternSymbol(process_name);
+    uint32_t reason = EncodeReason(record.reason, record.rule_index);
+    int64_t day_start = day * kSecondsPerDay;
+    int hour = static_cast<int>((timestamp - day_start) / kSecondsPerHour);
+    int last_hour = static_cast<int>((header->last_time - day_start) / kSecondsPerHour);
+
+    // 每个小时桶（以及每个分卷）的第一条记录相对整点编码并携带完整字段，查询可从这里开始解码
+    bool bucket_start = header->record_count == 0 || hour != last_hour;
+    bool full = bucket_start || force_full_record_;
+    int64_t base = bucket_start ? day_start + hour * kSecondsPerHour : header->last_time;
+
+    uint8_t buffer[kMaxRecordBytes];
+    uint8_t flags = static_cast<uint8_t>((static_cast<uint8_t>(record.category) & kCategoryMask) |
+                                         ((static_cast<uint8_t>(record.mode) & kModeMask) << kModeShift));
+    if (full || symbol != last_symbol_) {
+        flags |= kHasSymbol;
+    }
+    if (full || reason != last_reason_) {
+        flags |= kHasReason;
+    }
+    size_t length = 0;
+    buffer[length++] = flags;
+    length += PutVarint(buffer + length, static_cast<uint32_t>(timestamp - base));
+    if (flags & kHasSymbol) {
+        length += PutVarint(buffer + length, symbol);
+    }
+    if (flags & kHasReason) {
+        length += PutVarint(buffer + length, reason);
+    }
+
+    // 先写记录，再更新头部的已用字节数
+    uint32_t offset = header->used;
+    std::memcpy(writer_->Data() + offset, buffer, length);
+    if (bucket_start) {
+        header->hour_offsets[hour] = offset;
+    }
+    header->last_time = timestamp;
+    header->record_count++;
+    header->used = offset + static_cast<uint32_t>(length);
+
+    last_symbol_ = symbol;
+    last_reason_ = reason;
+    force_full_record_ = false;
+    return true;
+}
+
+size_t HistoryStore::Query(int64_t begin, int64_t end,
+                           const std::function<void(const HistoryRecord&)>& visitor) const {
+    if (!IsOpen() || end <= begin) {
+        return 0;
+    }
+    size_t visited = 0;
+    int64_t first_day = FloorDiv(begin, kSecondsPerDay);
+    int64_t last_day = FloorDiv(end - 1, kSecondsPerDay);
+    for (int64_t day = first_day; day <= last_day; day++) {
+        int64_t day_start = day * kSecondsPerDay;
+        int first_hour = day == first_day ? static_cast<int>((begin - day_start) / kSecondsPerHour) : 0;
+        int last_hour = day == last_day ? static_cast<int>((end - 1 - day_start) / kSecondsPerHour) : 23;
+
+        for (uint32_t part = 0; part < kMaxParts; part++) {
+            MappedFile file;
+            if (!file.OpenReadOnly(SegmentPath(day, part))) {
+                break;
+            }
+            query_stats_.segments_opened++;
+            if (file.Size() < sizeof(SegmentHeader)) {
+                continue;
+            }
+            const SegmentHeader& header = *reinterpret_cast<const SegmentHeader*>(file.Data());
+            if (!IsValidHeader(header, file.Size()) || header.day != day) {
+                continue;
+            }
+
+            for (int hour = first_hour; hour <= last_hour; hour++) {
+                if (header.hour_offsets[hour] == 0 || header.hour_offsets[hour] >= header.used) {
+                    continue;
+                }
+                // 桶的结尾为下一个非空桶的开头
+                uint32_t bucket_end = header.used;
+                for (int next = hour + 1; next < 24; next++) {
+                    if (header.hour_offsets[next] != 0) {
+                        bucket_end = std::min(header.hour_offsets[next], header.used);
+                        break;
+                    }
+                }
+                query_stats_.buckets_decoded++;
+
+                const uint8_t* p = file.Data() + header.hour_offsets[hour];
+                const uint8_t* p_end = file.Data() + bucket_end;
+                HistoryRecord record = {};
+                record.timestamp = day_start + hour * kSecondsPerHour;
+                uint32_t reason = 0;
+                while (p < p_end) {
+                    uint8_t flags = *p++;
+                    uint32_t delta = 0;
+                    if (!GetVarint(p, p_end, delta) ||
+                        ((flags & kHasSymbol) && !GetVarint(p, p_end, record.process_symbol)) ||
+                        ((flags & kHasReason) && !GetVarint(p, p_end, reason))) {
+                        break;  // 记录不完整（写入时被中断）
+                    }
+                    query_stats_.records_decoded++;
+                    record.timestamp += delta;
+                    record.category = static_cast<AppCategory>(flags & kCategoryMask);
+                    uint8_t mode = (flags >> kModeShift) & kModeMask;
+                    record.mode = static_cast<LightMode>(std::min<uint8_t>(mode, static_cast<uint8_t>(LightMode::DEFAULT)));
+                    DecodeReason(reason, record.reason, record.rule_index);
+                    if (record.timestamp >= end) {
+                        return visited;
+                    }
+                    if (record.timestamp >= begin) {
+                        visitor(record);
+                        visited++;
+                    }
+                }
+            }
+        }
+    }
+    return visited;
+}
+
+HistorySummary HistoryStore::Summarize(int64_t begin, int64_t end, uint32_t max_gap_seconds) const {
+    HistorySummary summary;
+    if (end <= begin) {
+        return summary;
+    }
+    summary.flips_per_hour.assign(static_cast<size_t>((end - begin + kSecondsPerHour - 1) / kSecondsPerHour), 0);
+
+    HistoryRecord previous = {};
+    bool has_previous = false;
+    auto account = [&](const HistoryRecord& record, int64_t until) {
+        uint64_t seconds = static_cast<uint64_t>(std::min<int64_t>(until - record.timestamp, max_gap_seconds));
+        summary.category_seconds[static_cast<size_t>(record.category)] += seconds;
+        summary.mode_seconds[static_cast<size_t>(record.mode)] += seconds;
+    };
+    summary.record_count = Query(begin, end, [&](const HistoryRecord& record) {
+        if (has_previous) {
+            account(previous, record.timestamp);
+            if (record.mode != previous.mode) {
+                summary.flips_per_hour[static_cast<size_t>((record.timestamp - begin) / kSecondsPerHour)]++;
+            }
+        }
+        previous = record;
+        has_previous = true;
+    });
+    if (has_previous) {
+        account(previous, end);
+    }
+    return summary;
+}
+
+const std::string& HistoryStore::GetSymbolName(uint32_t symbol) const {
+    return symbol < symbols_.size() ? symbols_[symbol] : symbols_[0];
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "rule_engine.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 灯光模式的决策来源
+ */
+enum class HistoryReason : uint8_t {
+    DEFAULT_MODE,       // 没有规则匹配
+    RULE,               // 规则（rule_index为命中的规则索引）
+    APP_OVERRIDE,       // 用户为该应用指定的灯光模式
+    MANUAL_OVERRIDE     // 外部指令的手动覆盖
+};
+
+/**
+ * 一条历史记录（每个tick一条）
+ */
+struct HistoryRecord {
+    int64_t timestamp;          // Unix时间（秒）
+    uint32_t process_symbol;    // 前台进程名的符号编号（0表示没有前台窗口）
+    AppCategory category;
+    LightMode mode;
+    HistoryReason reason;
+    uint32_t rule_index;        // reason为RULE时有效
+};
+
+/**
+ * 时间范围的汇总
+ */
+struct HistorySummary {
+    uint64_t record_count = 0;
+    std::array<uint64_t, kAppCategoryCount> category_seconds = {};  // 按AppCategory的取值
+    std::array<uint64_t, kLightModeCount> mode_seconds = {};        // 按LightMode的取值
+    std::vector<uint32_t> flips_per_hour;               // 自范围起点起每小时的模式切换次数
+};
+
+/**
+ * 查询访问的数据量（用于确认查询只读取了相关的段）
+ */
+struct HistoryQueryStats {
+    uint64_t segments_opened = 0;
+    uint64_t buckets_decoded = 0;
+    uint64_t records_decoded = 0;
+};
+
+class MappedFile;
+
+/**
+ * 追加写入的会话/模式历史存储
+ *
+ * 磁盘布局（目录下）：
+ * - seg-<天>-<分卷>.bin：每个UTC日一个定长段文件（写满时追加分卷），整体映射到内存后追加写入。
+ *   段头部包含按小时的桶索引（每小时第一条记录的偏移）；每个桶的第一条记录相对整点编码，
+ *   因此查询可以直接从任意小时开始解码，只打开与时间范围重叠的段。
+ * - symbols.txt：进程名符号表，每行一个，行号即符号编号（从1开始）。
+ *
+ * 记录编码：1字节标志（类别、模式、是否携带进程/原因）+ 时间差（varint），
+ * 进程符号和决策原因只在变化时写出（varint）。1Hz采样时一条记录通常只占2字节，
+ * 一天不到200KB；任何时刻只映射正在写入的段和查询正在读取的段，内存占用与数据总量无关。
+ *
+ * 不是线程安全的：写入和查询应在同一个线程中调用（查询与其他进程的写入互不影响）。
+ */
+class HistoryStore {
+public:
+    /**
+     * @param segment_bytes 每个段文件的大小（字节），只影响新建的段
+     */
+    explicit HistoryStore(uint32_t segment_bytes = 1u << 20);
+    ~HistoryStore();
+
+    HistoryStore(const HistoryStore&) = delete;
+    HistoryStore& operator=(const HistoryStore&) = delete;
+
+    /**
+     * 打开存储目录（不存在时创建）并加载符号表
+     * @param directory 目录路径
+     * @return 是否成功
+     */
+    bool Open(const std::string& directory);
+
+    /**
+     * 刷新并关闭正在写入的段
+     */
+    void Close();
+
+    bool IsOpen() const { return !directory_.empty(); }
+
+    /**
+     * 追加一条记录
+     * 时间戳早于上一条记录时按上一条记录的时间写入（系统时钟回拨）
+     * @param record 记录（process_symbol由process_name决定，传入的值被忽略）
+     * @param process_name 前台进程名（为空表示没有前台窗口）
+     * @return 是否写入成功
+     */
+    bool Append(const HistoryRecord& record, const std::string& process_name);
+
+    /**
+     * 把正在写入的段刷新到磁盘
+     */
+    void Flush();
+
+    /**
+     * 按时间顺序访问 [begin, end) 内的记录
+     * 只打开与范围重叠的段，并从范围起点所在的小时桶开始解码
+     * @return 访问的记录数
+     */
+    size_t Query(int64_t begin, int64_t end, const std::function<void(const HistoryRecord&)>& visitor) const;
+
+    /**
+     * 汇总 [begin, end) 内各类别、各模式的时长和每小时的模式切换次数
+     * 每条记录的时长为到下一条记录的间隔，但不超过max_gap_seconds（程序未运行的时间不计入）
+     */
+    HistorySummary Summarize(int64_t begin, int64_t end, uint32_t max_gap_seconds = 10) const;
+
+    /**
+     * 符号编号对应的进程名（编号无效时返回空字符串）
+     */
+    const std::string& GetSymbolName(uint32_t symbol) const;
+
+    /**
+     * 累计的查询访问量
+     */
+    HistoryQueryStats GetQueryStats() const { return query_stats_; }
+
+    /**
+     * 决策原因的编码（0为默认模式，1为应用覆盖，2为手动覆盖，3+i为规则i）
+     */
+    static uint32_t EncodeReason(HistoryReason reason, uint32_t rule_index);
+    static void DecodeReason(uint32_t code, HistoryReason& reason, uint32_t& rule_index);
+
+private:
+    uint32_t segment_bytes_;
+    std::string directory_;
+
+    // 符号表
+    std::vector<std::string> symbols_;                      // 下标为符号编号，0为空字符串
+    std::unordered_map<std::string, uint32_t> symbol_ids_;
+
+    // 正在写入的段
+    std::unique_ptr<MappedFile> writer_;
+    int64_t writer_day_;
+    uint32_t writer_part_;
+    bool force_full_record_;        // 下一条记录是否必须携带进程和原因（重新打开已有的段后）
+    uint32_t last_symbol_;
+    uint32_t last_reason_;
+
+    mutable HistoryQueryStats query_stats_;
+
+    uint32_t InternSymbol(const std::string& process_name);
+    std::string SegmentPath(int64_t day, uint32_t part) const;
+
+    /**
+     * 打开可写入该日期记录的段（最后一个分卷；写满时新建下一个分卷）
+     */
+    bool OpenWriter(int64_t day, uint32_t min_part);
+};
@@ -0,0 +1,282 @@
+#include "learned_app_store.h"
+#include "case_fold.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace {
+
+const char kMagic[4] = {'S', 'L', 'A', 'S'};
+// 版本2的键按FoldCase折叠后计算；版本1只折叠ASCII，纯ASCII进程名的键两者相同，因此仍可读取版本1的文件
+// （非ASCII进程名的旧记录不再被命中，按最久未使用淘汰）
+const uint32_t kVersion = 2;
+const uint32_t kAsciiKeyVersion = 1;
+
+/**
+ * 文件头（16字节）
+ */
+struct StoreHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+/**
+ * 磁盘上的定长记录（16字节）
+ */
+struct StoreRecord {
+    uint64_t key;
+    int8_t category;
+    int8_t mode_override;
+    uint16_t reserved;
+    uint32_t last_used;
+};
+
+static_assert(sizeof(StoreHeader) == 16, "StoreHeader必须为16字节");
+static_assert(sizeof(StoreRecord) == 16, "StoreRecord必须为16字节");
+
+}  // namespace
+
+LearnedAppStore::LearnedAppStore(size_t max_entries)
+    : max_entries_(max_entries > 0 ? max_entries : 1), clock_(0), dirty_(false) {
+    entries_.reserve(max_entries_);
+}
+
+uint64_t LearnedAppStore::MakeKey(const std::string& process_name) {
+    // 只对最后一个路径分隔符之后的部分折叠大小写后计算FNV-1a哈希
+    size_t begin = process_name.find_last_of("\\/");
+    begin = (begin == std::string::npos) ? 0 : begin + 1;
+    std::string_view base_name = std::string_view(process_name).substr(begin);
+
+    // 非ASCII进程名（如全角、西里尔字母）按与分类器相同的规则折叠；纯ASCII时直接逐字节转小写，不分配内存
+    std::string folded;
+    for (unsigned char c : base_name) {
+        if (c >= 0x80) {
+            folded = FoldCase(base_name);
+            base_name = folded;
+            break;
+        }
+    }
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : base_name) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<unsigned char>(c - 'A' + 'a');
+        }
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool LearnedAppStore::Load(const std::string& file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    StoreHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        (header.version != kVersion && header.version != kAsciiKeyVersion)) {
+        return false;
+    }
+
+    // 记录数必须与文件大小一致，损坏的文件头不会导致按其中的数字分配内存
+    file.seekg(0, std::ios::end);
+    std::streamoff file_size = file.tellg();
+    if (file_size < 0 || static_cast<uint64_t>(file_size) !=
+                         sizeof(StoreHeader) + static_cast<uint64_t>(header.count) * sizeof(StoreRecord)) {
+        return false;
+    }
+    file.seekg(sizeof(StoreHeader), std::ios::beg);
+
+    // 一次性读取所有记录
+    std::vector<StoreRecord> records(header.count);
+    if (header.count > 0 &&
+        !file.read(reinterpret_cast<char*>(records.data()),
+                   static_cast<std::streamsize>(records.size() * sizeof(StoreRecord)))) {
+        return false;
+    }
+
+    // 文件可能由更大上限的实例写入：只保留最近使用的max_entries_条
+    if (records.size() > max_entries_) {
+        std::nth_element(records.begin(), records.begin() + static_cast<std::ptrdiff_t>(max_entries_), records.end(),
+                         [](const StoreRecord& a, const StoreRecord& b) { return a.last_used > b.last_used; });
+        records.resize(max_entries_);
+    }
+
+    entries_.clear();
+    clock_ = 0;
+    dirty_ = false;
+    for (const auto& record : records) {
+        // 类别与模式超出枚举范围的记录（文件损坏或被手动修改）直接丢弃，避免之后按它们索引数组
+        if (record.category < -1 || record.category > static_cast<int8_t>(AppCategory::UNKNOWN) ||
+            record.mode_override < -1 || record.mode_override > static_cast<int8_t>(LightMode::DEFAULT)) {
+            dirty_ = true;
+            continue;
+        }
+        LearnedAppEntry entry;
+        entry.category = record.category;
+        entry.mode_override = record.mode_override;
+        entry.last_used = record.last_used;
+        entries_[record.key] = entry;
+        if (record.last_used > clock_) {
+            clock_ = record.last_used;
+        }
+    }
+
+    return true;
+}
+
+bool LearnedAppStore::Save(const std::string& file_path) {
+    std::string temp_path = file_path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        StoreHeader header;
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.count = static_cast<uint32_t>(entries_.size());
+        header.reserved = 0;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        std::vector<StoreRecord> records;
+        records.reserve(entries_.size());
+        for (const auto& pair : entries_) {
+            StoreRecord record;
+            record.key = pair.first;
+            record.category = pair.second.category;
+            record.mode_override = pair.second.mode_override;
+            record.reserved = 0;
+            record.last_used = pair.second.last_used;
+            records.push_back(record);
+        }
+        file.write(reinterpret_cast<const char*>(records.data()),
+                   static_cast<std::streamsize>(records.size() * sizeof(StoreRecord)));
+        if (!file.good()) {
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    bool ok = MoveFileExA(temp_path.c_str(), file_path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool ok = std::rename(temp_path.c_str(), file_path.c_str()) == 0;
+#endif
+    if (ok) {
+        dirty_ = false;
+    }
+    return ok;
+}
+
+LearnedAppEntry& LearnedAppStore::Touch(uint64_t key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        EvictIfFull();
+        LearnedAppEntry entry;
+        entry.category = -1;
+        entry.mode_override = -1;
+        entry.last_used = 0;
+        it = entries_.emplace(key, entry).first;
+    }
+    it->second.last_used = ++clock_;
+    return it->second;
+}
+
+void LearnedAppStore::EvictIfFull() {
+    if (entries_.size() < max_entries_) {
+        return;
+    }
+    // 只在写入新条目且已满时执行，淘汰最久未使用的条目
+    auto oldest = entries_.begin();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->second.last_used < oldest->second.last_used) {
+            oldest = it;
+        }
+    }
+    if (oldest != entries_.end()) {
+        entries_.erase(oldest);
+    }
+}
+
+void LearnedAppStore::LearnCategory(const std::string& process_name, AppCategory category) {
+    LearnedAppEntry& entry = Touch(MakeKey(process_name));
+    entry.category = static_cast<int8_t>(category);
+    dirty_ = true;
+}
+
+void LearnedAppStore::RecordModeOverride(const std::string& process_name, LightMode mode) {
+    LearnedAppEntry& entry = Touch(MakeKey(process_name));
+    entry.mode_override = static_cast<int8_t>(mode);
+    dirty_ = true;
+}
+
+bool LearnedAppStore::ClearModeOverride(const std::string& process_name) {
+    auto it = entries_.find(MakeKey(process_name));
+    if (it == entries_.end() || it->second.mode_override < 0) {
+        return false;
+    }
+    if (it->second.category < 0) {
+        entries_.erase(it);
+    } else {
+        it->second.mode_override = -1;
+    }
+    dirty_ = true;
+    return true;
+}
+
+bool LearnedAppStore::Forget(const std::string& process_name) {
+    if (entries_.erase(MakeKey(process_name)) == 0) {
+        return false;
+    }
+    dirty_ = true;
+    return true;
+}
+
+std::optional<AppCategory> LearnedAppStore::LookupCategory(const std::string& process_name) {
+    auto it = entries_.find(MakeKey(process_name));
+    if (it == entries_.end() || it->second.category < 0) {
+        return std::nullopt;
+    }
+    // 只更新内存中的使用时间，不标记为需要保存
+    it->second.last_used = ++clock_;
+    return static_cast<AppCategory>(it->second.category);
+}
+
+std::optional<AppCategory> LearnedAppStore::PeekCategory(const std::string& process_name) const {
+    auto it = entries_.find(MakeKey(process_name));
+    if (it == entries_.end() || it->second.category < 0) {
+        return std::nullopt;
+    }
+    return static_cast<AppCategory>(it->second.category);
+}
+
+std::optional<LightMode> LearnedAppStore::LookupModeOverride(const std::string& process_name) {
+    auto it = entries_.find(MakeKey(process_name));
+    if (it == entries_.end() || it->second.mode_override < 0) {
+        return std::nullopt;
+    }
+    it->second.last_used = ++clock_;
+    return static_cast<LightMode>(it->second.mode_override);
+}
+
+size_t LearnedAppStore::CountModeOverrides() const {
+    size_t count = 0;
+    for (const auto& pair : entries_) {
+        if (pair.second.mode_override >= 0) {
+            count++;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "rule_engine.h"
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * 学习到的单个应用记录
+ */
+struct LearnedAppEntry {
+    int8_t category;        // 学习到的应用类别（-1表示未设置）
+    int8_t mode_override;   // 用户为该应用指定的灯光模式（-1表示未设置）
+    uint32_t last_used;     // 最近使用的逻辑时钟（用于淘汰）
+};
+
+/**
+ * 学习型应用分类存储
+ * 记录用户为未知进程手动指定（或确认）的类别，以及用户为其覆盖的灯光模式。
+ * 以进程名（小写）的64位哈希为键，查询为O(1)；条目数有上限，
+ * 超出时淘汰最久未使用的条目。磁盘格式为定长记录，一次读取即可加载。
+ */
+class LearnedAppStore {
+public:
+    /**
+     * @param max_entries 最多保存的应用数
+     */
+    explicit LearnedAppStore(size_t max_entries = 4096);
+
+    /**
+     * 从文件加载（文件不存在时保持为空）
+     * @param file_path 文件路径
+     * @return 是否成功加载
+     */
+    bool Load(const std::string& file_path);
+
+    /**
+     * 保存到文件（先写临时文件再替换）
+     * @param file_path 文件路径
+     * @return 是否保存成功
+     */
+    bool Save(const std::string& file_path);
+
+    /**
+     * 记录用户为进程指定或确认的类别
+     * @param process_name 进程名（可包含路径，不区分大小写）
+     * @param category 应用类别
+     */
+    void LearnCategory(const std::string& process_name, AppCategory category);
+
+    /**
+     * 记录用户为进程覆盖的灯光模式
+     * @param process_name 进程名（可包含路径，不区分大小写）
+     * @param mode 灯光模式
+     */
+    void RecordModeOverride(const std::string& process_name, LightMode mode);
+
+    /**
+     * 删除进程的灯光模式覆盖（保留学习到的类别）
+     * @return 是否存在并删除
+     */
+    bool ClearModeOverride(const std::string& process_name);
+
+    /**
+     * 删除进程的所有学习记录
+     * @return 是否存在并删除
+     */
+    bool Forget(const std::string& process_name);
+
+    /**
+     * 查询学习到的类别
+     * @param process_name 进程名（可包含路径，不区分大小写）
+     * @return 类别，如果没有记录则返回std::nullopt
+     */
+    std::optional<AppCategory> LookupCategory(const std::string& process_name);
+
+    /**
+     * 查询学习到的类别，但不更新使用时间
+     * 只读，可在没有写入者时被多个线程同时调用（用于批量分类）
+     * @param process_name 进程名（可包含路径，不区分大小写）
+     * @return 类别，如果没有记录则返回std::nullopt
+     */
+    std::optional<AppCategory> PeekCategory(const std::string& process_name) const;
+
+    /**
+     * 查询用户覆盖的灯光模式
+     * @param process_name 进程名（可包含路径，不区分大小写）
+     * @return 灯光模式，如果没有记录则返回std::nullopt
+     */
+    std::optional<LightMode> LookupModeOverride(const std::string& process_name);
+
+    /**
+     * 统计设置了灯光模式覆盖的应用数
+     */
+    size_t CountModeOverrides() const;
+
+    size_t Size() const { return entries_.size(); }
+    bool IsDirty() const { return dirty_; }
+
+    /**
+     * 计算进程名的键（去除路径、按FoldCase折叠大小写后的FNV-1a 64位哈希）
+     */
+    static uint64_t MakeKey(const std::string& process_name);
+
+private:
+    size_t max_entries_;
+    std::unordered_map<uint64_t, LearnedAppEntry> entries_;
+    uint32_t clock_;
+    bool dirty_;
+
+    LearnedAppEntry& Touch(uint64_t key);
+    void EvictIfFull();
+};
@@ -0,0 +1,123 @@
+#include "light_effect.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+// ambient_color_中表示"有值"的位
+const uint32_t kAmbientValid = 0x80000000u;
+
+/**
+ * 模式的基色与动画参数
+ */
+struct ModeEffect {
+    LightColor color;
+    double min_brightness;  // 动画的最低亮度（与最高亮度相同时为静态）
+    double max_brightness;
+    double period_seconds;  // 动画周期（秒）
+};
+
+ModeEffect GetModeEffect(LightMode mode) {
+    switch (mode) {
+        case LightMode::GAME_SCREENSYNC:
+            return {{255, 64, 0}, 1.0, 1.0, 0.0};
+        case LightMode::VIDEO_CINEMATIC:
+            return {{255, 147, 41}, 0.35, 0.35, 0.0};
+        case LightMode::MUSIC:
+            return {{180, 0, 255}, 0.4, 1.0, 0.5};
+        case LightMode::WORK_CODING:
+            return {{255, 244, 229}, 0.8, 0.8, 0.0};
+        case LightMode::NIGHT_DIM:
+            return {{255, 120, 20}, 0.1, 0.1, 0.0};
+        case LightMode::OFF:
+            return {{0, 0, 0}, 0.0, 0.0, 0.0};
+        case LightMode::DEFAULT:
+        default:
+            return {{0, 120, 255}, 0.3, 0.7, 4.0};
+    }
+}
+
+uint8_t ScaleChannel(uint8_t value, double factor) {
+    return static_cast<uint8_t>(std::lround(std::clamp(value * factor, 0.0, 255.0)));
+}
+
+uint8_t MixChannel(uint8_t from, uint8_t to, double t) {
+    return static_cast<uint8_t>(std::lround(from + (static_cast<double>(to) - from) * t));
+}
+
+/**
+ * 模式在time_seconds时的颜色（不含过渡）
+ * @param ambient 画面主色（见LightEffectRenderer::ambient_color_）
+ */
+LightColor RenderMode(LightMode mode, double time_seconds, uint32_t ambient) {
+    ModeEffect effect = GetModeEffect(mode);
+    if (mode == LightMode::VIDEO_CINEMATIC && (ambient & kAmbientValid) != 0) {
+        effect.color = {static_cast<uint8_t>(ambient >> 16), static_cast<uint8_t>(ambient >> 8),
+                        static_cast<uint8_t>(ambient)};
+    }
+    double brightness = effect.max_brightness;
+    if (effect.period_seconds > 0.0 && effect.max_brightness > effect.min_brightness) {
+        // 正弦呼吸：0.5 - 0.5cos 从最低亮度开始
+        double phase = std::fmod(time_seconds, effect.period_seconds) / effect.period_seconds;
+        double wave = 0.5 - 0.5 * std::cos(2.0 * kPi * phase);
+        brightness = effect.min_brightness + (effect.max_brightness - effect.min_brightness) * wave;
+    }
+    return {ScaleChannel(effect.color.r, brightness),
+            ScaleChannel(effect.color.g, brightness),
+            ScaleChannel(effect.color.b, brightness)};
+}
+
+}  // namespace
+
+LightEffectRenderer::LightEffectRenderer(double transition_seconds)
+    : target_mode_(static_cast<int>(LightMode::DEFAULT)), ambient_color_(0),
+      transition_seconds_(std::max(transition_seconds, 0.0)), has_rendered_(false), current_mode_(LightMode::DEFAULT), transition_start_(0.0),
+      from_color_{0, 0, 0}, last_color_{0, 0, 0} {
+}
+
+void LightEffectRenderer::SetMode(LightMode mode) {
+    target_mode_.store(static_cast<int>(mode), std::memory_order_relaxed);
+}
+
+void LightEffectRenderer::SetAmbientColor(const LightColor& color) {
+    ambient_color_.store(kAmbientValid | (static_cast<uint32_t>(color.r) << 16) |
+                         (static_cast<uint32_t>(color.g) << 8) | color.b, std::memory_order_relaxed);
+}
+
+void LightEffectRenderer::ClearAmbientColor() {
+    ambient_color_.store(0, std::memory_order_relaxed);
+}
+
+LightFrame LightEffectRenderer::Render(uint64_t frame_index, double time_seconds) {
+    LightMode target = GetMode();
+    if (!has_rendered_) {
+        // 第一帧直接显示目标模式
+        current_mode_ = target;
+        transition_start_ = time_seconds - transition_seconds_;
+        has_rendered_ = true;
+    } else if (target != current_mode_) {
+        // 从上一帧的颜色（可能处于上一次过渡中）开始新的过渡
+        current_mode_ = target;
+        transition_start_ = time_seconds;
+        from_color_ = last_color_;
+    }
+
+    LightColor color = RenderMode(current_mode_, time_seconds, ambient_color_.load(std::memory_order_relaxed));
+    double elapsed = time_seconds - transition_start_;
+    if (transition_seconds_ > 0.0 && elapsed < transition_seconds_) {
+        double t = std::max(elapsed, 0.0) / transition_seconds_;
+        color = {MixChannel(from_color_.r, color.r, t),
+                 MixChannel(from_color_.g, color.g, t),
+                 MixChannel(from_color_.b, color.b, t)};
+    }
+    last_color_ = color;
+
+    LightFrame frame;
+    frame.index = frame_index;
+    frame.time_seconds = time_seconds;
+    frame.mode = current_mode_;
+    frame.color = color;
+    return frame;
+}
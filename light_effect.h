@@ -0,0 +1,77 @@
+#pragma once
+
+#include "rule_engine.h"
+#include <atomic>
+#include <cstdint>
+
+/**
+ * 灯带颜色（已乘以亮度，可直接输出）
+ */
+struct LightColor {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+};
+
+/**
+ * 一帧灯光输出
+ */
+struct LightFrame {
+    uint64_t index;         // 帧序号（从0开始，跳过的帧也计入）
+    double time_seconds;    // 帧的计划时间（相对输出线程启动）
+    LightMode mode;         // 该帧对应的灯光模式（过渡期间为目标模式）
+    LightColor color;
+};
+
+/**
+ * 按灯光模式渲染动画帧
+ * 各模式有自己的基色和动画（音乐模式脉动、默认模式呼吸，其余为静态；视频模式有画面主色时使用主色），
+ * 模式切换时从上一帧的颜色线性过渡到新模式，过渡时长按帧的计划时间计算，
+ * 因此动画和过渡的平滑程度只取决于输出帧率，与决策tick的间隔无关。
+ *
+ * SetMode/SetAmbientColor可在任意线程中调用（主循环每个tick发布当前模式，画面采集线程发布主色）；
+ * Render只应在输出线程中调用。
+ */
+class LightEffectRenderer {
+public:
+    /**
+     * @param transition_seconds 模式切换的过渡时长（秒）
+     */
+    explicit LightEffectRenderer(double transition_seconds = 0.5);
+
+    /**
+     * 发布当前灯光模式（下一帧开始生效）
+     */
+    void SetMode(LightMode mode);
+
+    LightMode GetMode() const { return static_cast<LightMode>(target_mode_.load(std::memory_order_relaxed)); }
+
+    /**
+     * 发布画面的主色（见PaletteExtractor），VIDEO_CINEMATIC模式以它代替固定的基色
+     */
+    void SetAmbientColor(const LightColor& color);
+
+    /**
+     * 不再使用画面主色（如停止画面采集）
+     */
+    void ClearAmbientColor();
+
+    /**
+     * 渲染一帧
+     * @param frame_index 帧序号
+     * @param time_seconds 帧的计划时间（秒，不应倒退）
+     */
+    LightFrame Render(uint64_t frame_index, double time_seconds);
+
+private:
+    std::atomic<int> target_mode_;
+    std::atomic<uint32_t> ambient_color_;  // 0xRRGGBB，最高位为1表示有值
+    double transition_seconds_;
+
+    // 以下只在输出线程中访问
+    bool has_rendered_;
+    LightMode current_mode_;
+    double transition_start_;   // 当前过渡的开始时间（秒）
+    LightColor from_color_;     // 过渡的起始颜色
+    LightColor last_color_;     // 上一帧输出的颜色
+};
@@ -2,15 +2,45 @@
 #include "app_classifier.h"
 #include "rule_engine.h"
 #include "audio_monitor.h"
+#include "process_tree.h"
+#include "state_logger.h"
+#include "metrics.h"
+#include "learned_app_store.h"
+#include "fleet_server.h"
+#include "external_command.h"
+#include "sensor_provider.h"
+#include "default_rules.h"
+#include "week_simulator.h"
+#include "history_store.h"
+#include "session_aggregator.h"
+#include "async_probe.h"
+#include "tick_budget.h"
+#include "case_fold.h"
+#include "frame_pacer.h"
+#include "light_effect.h"
+#include "palette_extractor.h"
+#include "state_publisher.h"
+#include "path_prefix_trie.h"
+#include "thread_pool.h"
 #include <iostream>
-#include <iomanip>
-#include <sstream>
+#include <fstream>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <algorithm>
+#include <vector>
 #include <chrono>
 #include <thread>
 #include <atomic>
 #include <csignal>
 #include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <random>
+#include <filesystem>
+#include <functional>
+#include <unordered_map>
 #include <windows.h>
 
 // 全局变量用于信号处理
@@ -32,75 +62,6 @@ BOOL WINAPI ConsoleCtrlHandler(DWORD dwCtrlType) {
     return FALSE;
 }
 
-/**
- * 获取当前时间戳字符串
- */
-std::string GetCurrentTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-    
-    std::tm tm_buf;
-    localtime_s(&tm_buf, &time_t);
-    
-    std::ostringstream oss;
-    oss << std::put_time(&tm_buf, "%Y-%m-%d %H:%M:%S");
-    oss << '.' << std::setfill('0') << std::setw(3) << ms.count();
-    
-    return oss.str();
-}
-
-/**
- * 获取当前时间（小时:分钟）
- */
-std::string GetCurrentTimeString() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    
-    std::tm tm_buf;
-    localtime_s(&tm_buf, &time_t);
-    
-    std::ostringstream oss;
-    oss << std::setfill('0') << std::setw(2) << tm_buf.tm_hour << ":"
-        << std::setfill('0') << std::setw(2) << tm_buf.tm_min;
-    
-    return oss.str();
-}
-
-/**
- * 获取星期几（周一~周日）
- */
-std::string GetWeekday() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    
-    std::tm tm_buf;
-    localtime_s(&tm_buf, &time_t);
-    
-    // tm_wday: 0=周日, 1=周一, ..., 6=周六
-    const char* weekdays[] = {"周日", "周一", "周二", "周三", "周四", "周五", "周六"};
-    int weekday_index = tm_buf.tm_wday;
-    
-    return std::string(weekdays[weekday_index]);
-}
-
-/**
- * 判断是否是工作日（周一～周五）
- * @return true表示工作日，false表示周末
- */
-bool IsWeekday() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    
-    std::tm tm_buf;
-    localtime_s(&tm_buf, &time_t);
-    
-    // tm_wday: 0=周日, 1=周一, ..., 6=周六
-    // 工作日：1-5（周一到周五）
-    return tm_buf.tm_wday >= 1 && tm_buf.tm_wday <= 5;
-}
-
 /**
  * 获取用户空闲时间（从上次键盘/鼠标操作起，已经空闲了多少分钟）
  * @return 空闲时间（分钟），如果获取失败则返回-1
@@ -213,327 +174,2250 @@ public:
 };
 
 /**
- * 初始化规则引擎，添加示例规则
- */
-void InitializeRules(RuleEngine& rule_engine) {
-    Rule rule;
-    
-    // 规则1: 夜间弱光模式（23:00-07:00，优先级10）
-    rule = Rule();
-    rule.priority = 10;
-    rule.target_mode = LightMode::NIGHT_DIM;
-    Condition time_condition;
-    time_condition.type = ConditionType::TIME_RANGE;
-    time_condition.time_range = TimeRange(23, 0, 7, 0);  // 23:00-07:00
-    rule.conditions.push_back(time_condition);
-    rule_engine.AddRule(rule);
-    
-    // 规则2: 空闲时间超过10分钟，关闭灯光（优先级9）
-    rule = Rule();
-    rule.priority = 9;
-    rule.target_mode = LightMode::OFF;
-    Condition idle_condition;
-    idle_condition.type = ConditionType::IDLE_THRESHOLD;
-    idle_condition.idle_threshold = 10.0;  // 10分钟
-    idle_condition.idle_greater_than = true;  // >= 10分钟
-    rule.conditions.push_back(idle_condition);
-    rule_engine.AddRule(rule);
-    
-    // 规则3: 游戏类应用，使用游戏/屏幕同步模式（优先级8）
-    rule = Rule();
-    rule.priority = 8;
-    rule.target_mode = LightMode::GAME_SCREENSYNC;
-    Condition game_condition;
-    game_condition.type = ConditionType::APP_CATEGORY;
-    game_condition.app_category = AppCategory::GAME;
-    rule.conditions.push_back(game_condition);
-    rule_engine.AddRule(rule);
-    
-    // 规则4: 视频类应用，使用影视模式（优先级7）
-    rule = Rule();
-    rule.priority = 7;
-    rule.target_mode = LightMode::VIDEO_CINEMATIC;
-    Condition video_condition;
-    video_condition.type = ConditionType::APP_CATEGORY;
-    video_condition.app_category = AppCategory::VIDEO;
-    rule.conditions.push_back(video_condition);
-    rule_engine.AddRule(rule);
-    
-    // 规则5: 音乐类应用，使用音乐律动模式（优先级6）
-    rule = Rule();
-    rule.priority = 6;
-    rule.target_mode = LightMode::MUSIC;
-    Condition music_condition;
-    music_condition.type = ConditionType::APP_CATEGORY;
-    music_condition.app_category = AppCategory::MUSIC;
-    rule.conditions.push_back(music_condition);
-    rule_engine.AddRule(rule);
-    
-    // 规则6: 开发/编程类应用，使用办公/写代码模式（优先级5）
-    rule = Rule();
-    rule.priority = 5;
-    rule.target_mode = LightMode::WORK_CODING;
-    Condition dev_condition;
-    dev_condition.type = ConditionType::APP_CATEGORY;
-    dev_condition.app_category = AppCategory::DEVELOPMENT;
-    rule.conditions.push_back(dev_condition);
-    rule_engine.AddRule(rule);
-    
-    // 规则7: 文档/办公类应用，使用办公/写代码模式（优先级4）
-    rule = Rule();
-    rule.priority = 4;
-    rule.target_mode = LightMode::WORK_CODING;
-    Condition doc_condition;
-    doc_condition.type = ConditionType::APP_CATEGORY;
-    doc_condition.app_category = AppCategory::DOCUMENT;
-    rule.conditions.push_back(doc_condition);
-    rule_engine.AddRule(rule);
-    
-    // 规则8: CPU使用率超过80%，使用游戏/屏幕同步模式（优先级3）
-    rule = Rule();
-    rule.priority = 3;
-    rule.target_mode = LightMode::GAME_SCREENSYNC;
-    Condition cpu_condition;
-    cpu_condition.type = ConditionType::CPU_THRESHOLD;
-    cpu_condition.cpu_threshold = 80.0;  // 80%
-    cpu_condition.cpu_greater_than = true;  // > 80%
-    rule.conditions.push_back(cpu_condition);
-    rule_engine.AddRule(rule);
-    
-    // 规则9: 有音频活动且非游戏场景，使用音乐律动模式（优先级2.5）
-    // 实现方式：由于游戏、视频、音乐应用会被更高优先级规则覆盖，
-    // 这个规则主要针对浏览器、未知应用等非游戏场景
-    // 优先级设置为2，高于工作日规则（1）和周末规则（0），确保音频规则优先
-    rule = Rule();
-    rule.priority = 2;
-    rule.target_mode = LightMode::MUSIC;
-    Condition audio_condition;
-    audio_condition.type = ConditionType::AUDIO_ACTIVITY;
-    audio_condition.audio_activity = true;  // 有音频
-    rule.conditions.push_back(audio_condition);
-    // 注意：由于游戏规则（优先级8）更高，游戏场景会被覆盖
-    // 视频规则（优先级7）和音乐规则（优先级6）也会覆盖
-    // 所以这个规则主要对浏览器、未知应用等非游戏场景生效
-    rule_engine.AddRule(rule);
-    
-    // 规则10: 工作日 09:00-18:00，使用办公/写代码模式（优先级1）
-    rule = Rule();
-    rule.priority = 1;
-    rule.target_mode = LightMode::WORK_CODING;
-    Condition weekday_time_condition;
-    weekday_time_condition.type = ConditionType::TIME_RANGE;
-    weekday_time_condition.time_range = TimeRange(9, 0, 18, 0, WeekdayType::WEEKDAY);  // 工作日 09:00-18:00
-    rule.conditions.push_back(weekday_time_condition);
-    rule_engine.AddRule(rule);
-    
-    // 规则11: 周末 09:00-18:00，使用音乐律动模式（优先级0，作为娱乐模式）
-    // 注意：这个优先级较低，会被其他规则（如游戏、视频等）覆盖
-    rule = Rule();
-    rule.priority = 0;
-    rule.target_mode = LightMode::MUSIC;
-    Condition weekend_time_condition;
-    weekend_time_condition.type = ConditionType::TIME_RANGE;
-    weekend_time_condition.time_range = TimeRange(9, 0, 18, 0, WeekdayType::WEEKEND);  // 周末 09:00-18:00
-    rule.conditions.push_back(weekend_time_condition);
-    rule_engine.AddRule(rule);
-    
-    // 注意：如果没有规则匹配，将返回默认模式（DEFAULT）
+ * 温度采样结果（摄氏度，没有可用读数时为NaN）
+ */
+struct TemperatureSample {
+    double cpu_temperature;
+    double gpu_temperature;
+};
+
+// 各采样的默认时限（毫秒），可用 --probe-timeout 统一指定
+const int kWindowProbeTimeoutMs = 200;
+const int kCpuProbeTimeoutMs = 100;
+const int kIdleProbeTimeoutMs = 50;
+const int kAudioProbeTimeoutMs = 200;
+const int kTemperatureProbeTimeoutMs = 300;
+
+// 默认的tick预算（毫秒），可用 --tick-budget 指定
+const int kDefaultTickBudgetMs = 250;
+
+// 分类缓存的最大进程数（超过时清空重建）
+const size_t kCategoryCacheLimit = 256;
+
+/**
+ * 各类采样的采样函数（在采样器的后台线程中调用）
+ */
+struct ProbeTasks {
+    std::function<std::optional<WindowInfo>()> window;     // 前台窗口（含进程树解析，不含分类）
+    std::function<double()> cpu;
+    std::function<double()> idle;                           // 获取失败时返回负数
+    std::function<bool()> audio;
+    std::function<TemperatureSample()> temperature;
+};
+
+/**
+ * 读取本机状态的采样函数
+ */
+ProbeTasks MakeSystemProbeTasks(WindowMonitor& window_monitor, ProcessTreeTracker& process_tree,
+                                CpuMonitor& cpu_monitor, AudioMonitor& audio_monitor,
+                                SensorProvider& sensor_provider) {
+    ProbeTasks tasks;
+    tasks.window = [&window_monitor, &process_tree] {
+        std::optional<WindowInfo> window_info = window_monitor.GetForegroundWindowInfo();
+        if (!window_info.has_value()) {
+            return window_info;
+        }
+        // 只有前台进程不在进程树中（新进程或pid被复用）时才增量扫描进程表
+        const ProcessNode* node = process_tree.Find(window_info->process_id);
+        if (node == nullptr ||
+            (window_info->parent_process_id != 0 && node->parent_pid != window_info->parent_process_id)) {
+            process_tree.Update();
+            METRICS_COUNT(MetricCounter::PROCESS_TREE_SCANS);
+        }
+        window_info->ancestor_names = process_tree.GetAncestorNames(window_info->process_id);
+        return window_info;
+    };
+    tasks.cpu = [&cpu_monitor] {
+        METRICS_TIMER_BEGIN(system_probe_begin);
+        double cpu_usage = cpu_monitor.GetCpuUsage();
+        METRICS_TIMER_END(system_probe_begin, MetricStage::SYSTEM_PROBE);
+        return cpu_usage;
+    };
+    tasks.idle = GetUserIdleMinutes;
+    // AudioMonitor在主线程以多线程套间初始化COM，后台线程隐式属于同一套间
+    tasks.audio = [&audio_monitor] { return audio_monitor.GetAudioActivity(); };
+    tasks.temperature = [&sensor_provider] {
+        sensor_provider.Sample();
+        TemperatureSample sample;
+        sample.cpu_temperature = sensor_provider.GetMaxTemperature(SensorKind::CPU);
+        sample.gpu_temperature = sensor_provider.GetMaxTemperature(SensorKind::GPU);
+        return sample;
+    };
+    return tasks;
 }
 
 /**
- * 打印应用状态信息
+ * 主循环的状态采样器
+ * 规则引擎在条件第一次用到某个字段时回调Probe，采样结果同时写入本tick的日志记录。
+ * 每类采样在各自的后台线程中执行并有独立的时限：卡住的OpenProcess、缓慢的传感器读取等
+ * 超过时限时不再等待，本tick使用该字段上一次的值并在日志中标记为过期。
+ * 设置了tick预算时，采样最多等到预算的采样截止时间；预算用完后分类改走更便宜的路径。
+ * 应用分类仍在主循环线程中进行（分类器和学习记录不是线程安全的）。
  */
-void PrintState(const WindowInfo& window_info, AppCategory category, CpuMonitor& cpu_monitor, 
-                RuleEngine& rule_engine, const SystemState& system_state, bool debug_mode = false) {
-    std::string timestamp = GetCurrentTimestamp();
-    std::string current_time = GetCurrentTimeString();
-    std::string weekday = GetWeekday();
-    double cpu_usage = cpu_monitor.GetCpuUsage();
-    double idle_minutes = GetUserIdleMinutes();
+class TickProber : public StateProber {
+public:
+    TickProber(AppClassifier& app_classifier, ProbeTasks tasks)
+        : app_classifier_(app_classifier),
+          window_probe_(std::move(tasks.window), std::chrono::milliseconds(kWindowProbeTimeoutMs)),
+          cpu_probe_(std::move(tasks.cpu), std::chrono::milliseconds(kCpuProbeTimeoutMs)),
+          idle_probe_(std::move(tasks.idle), std::chrono::milliseconds(kIdleProbeTimeoutMs)),
+          audio_probe_(std::move(tasks.audio), std::chrono::milliseconds(kAudioProbeTimeoutMs)),
+          temperature_probe_(std::move(tasks.temperature), std::chrono::milliseconds(kTemperatureProbeTimeoutMs)),
+          budget_(nullptr), record_(nullptr), started_probes_(0) {}
     
-    // 决定灯光模式（对外接口：定期调用获取当前模式）
-    LightMode light_mode = rule_engine.DecideLightMode(system_state);
+    /**
+     * 把所有采样的时限设为同一个值
+     */
+    void SetProbeTimeout(std::chrono::milliseconds timeout) {
+        window_probe_.SetTimeout(timeout);
+        cpu_probe_.SetTimeout(timeout);
+        idle_probe_.SetTimeout(timeout);
+        audio_probe_.SetTimeout(timeout);
+        temperature_probe_.SetTimeout(timeout);
+    }
     
-    // Demo输出格式：清晰显示关键信息
-    std::cout << "[" << timestamp << "]" << std::endl;
-    std::cout << "  应用类别: " << AppClassifier::GetCategoryName(category) << std::endl;
-    std::cout << "  当前时间: " << current_time << " (" << weekday << ")" << std::endl;
-    std::cout << std::fixed << std::setprecision(1);
-    std::cout << "  CPU使用率: " << cpu_usage << "%" << std::endl;
-    if (idle_minutes >= 0.0) {
-        std::cout << "  Idle时间: " << idle_minutes << " 分钟" << std::endl;
-    } else {
-        std::cout << "  Idle时间: 无法获取" << std::endl;
+    /**
+     * 设置tick预算（传入nullptr表示不限制）；由调用方管理生命周期
+     */
+    void SetTickBudget(TickBudget* budget) { budget_ = budget; }
+    
+    /**
+     * 开始新的tick
+     * @param record 本tick的日志记录（采样结果写入其中）
+     */
+    void BeginTick(StateLogRecord* record) {
+        record_ = record;
+        window_info_.reset();
+        started_probes_ = 0;
     }
-    std::cout << std::defaultfloat;
-    std::cout << "  音频活动: " << (system_state.has_audio_activity ? "有" : "无") << std::endl;
-    std::cout << "  当前判定的灯光模式: " << RuleEngine::GetLightModeName(light_mode) << std::endl;
     
-    // 调试信息（可选）
-    if (debug_mode) {
-        std::cout << "  [调试] 进程名称: " << window_info.process_name << std::endl;
-        std::cout << "  [调试] 窗口标题: " << window_info.window_title << std::endl;
-        std::cout << "  [调试] 进程ID: " << window_info.process_id << std::endl;
+    /**
+     * 同时开始所有采样（之后的Probe只等待结果），用于每个tick采样所有字段
+     */
+    void StartAll() {
+        for (size_t i = 0; i < static_cast<size_t>(StateProbe::COUNT); i++) {
+            StartProbe(static_cast<StateProbe>(i));
+        }
     }
     
-    // 调试模式：显示用于匹配的文本
-    if (debug_mode) {
-        std::string process_lower = window_info.process_name;
-        std::string title_lower = window_info.window_title;
-        std::transform(process_lower.begin(), process_lower.end(), process_lower.begin(),
-                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-        std::transform(title_lower.begin(), title_lower.end(), title_lower.begin(),
-                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-        std::cout << "  [调试] 匹配文本: " << process_lower << " " << title_lower << std::endl;
+    /**
+     * 本tick的前台窗口信息（未采样或获取失败时为空；采样超时时为上一次的值）
+     */
+    const std::optional<WindowInfo>& GetWindowInfo() const { return window_info_; }
+    
+    /**
+     * 某类采样累计的超时次数
+     */
+    uint64_t GetTimeoutCount(StateProbe probe) const {
+        switch (probe) {
+            case StateProbe::APP_CATEGORY:
+                return window_probe_.GetTimeoutCount();
+            case StateProbe::CPU:
+                return cpu_probe_.GetTimeoutCount();
+            case StateProbe::IDLE:
+                return idle_probe_.GetTimeoutCount();
+            case StateProbe::AUDIO:
+                return audio_probe_.GetTimeoutCount();
+            case StateProbe::TEMPERATURE:
+                return temperature_probe_.GetTimeoutCount();
+            default:
+                return 0;
+        }
     }
     
-    std::cout << std::string(60, '-') << std::endl;
-}
+    void Probe(StateProbe probe, SystemState& state) override {
+        StartProbe(probe);
+        std::chrono::steady_clock::time_point limit = budget_ != nullptr
+            ? budget_->GetProbeDeadline() : std::chrono::steady_clock::time_point::max();
+        switch (probe) {
+            case StateProbe::APP_CATEGORY: {
+                ProbeResult<std::optional<WindowInfo>> result = window_probe_.Wait(limit);
+                MarkStale(probe, result.stale);
+                ApplyWindow(result.has_value ? result.value : std::nullopt, state);
+                break;
+            }
+            case StateProbe::CPU: {
+                // 每个tick最多采样一次CPU（重复调用会重置CPU基线）
+                ProbeResult<double> result = cpu_probe_.Wait(limit);
+                MarkStale(probe, result.stale);
+                state.cpu_usage = result.has_value ? result.value : 0.0;
+                record_->cpu_usage = static_cast<float>(state.cpu_usage);
+                break;
+            }
+            case StateProbe::IDLE: {
+                ProbeResult<double> result = idle_probe_.Wait(limit);
+                MarkStale(probe, result.stale);
+                double idle_minutes = result.has_value ? result.value : -1.0;
+                state.idle_minutes = idle_minutes >= 0.0 ? idle_minutes : 0.0;
+                record_->idle_available = idle_minutes >= 0.0;
+                record_->idle_minutes = static_cast<float>(idle_minutes);
+                break;
+            }
+            case StateProbe::AUDIO: {
+                ProbeResult<bool> result = audio_probe_.Wait(limit);
+                MarkStale(probe, result.stale);
+                state.has_audio_activity = result.has_value && result.value;
+                record_->has_audio_activity = state.has_audio_activity;
+                break;
+            }
+            case StateProbe::TEMPERATURE: {
+                ProbeResult<TemperatureSample> result = temperature_probe_.Wait(limit);
+                MarkStale(probe, result.stale);
+                if (result.has_value) {
+                    state.cpu_temperature = result.value.cpu_temperature;
+                    state.gpu_temperature = result.value.gpu_temperature;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
 
-/**
- * 主函数
- */
-int main(int argc, char* argv[]) {
-    // 设置控制台代码页为UTF-8以支持中文显示
-    SetConsoleOutputCP(65001);
+private:
+    AppClassifier& app_classifier_;
+    AsyncProbe<std::optional<WindowInfo>> window_probe_;
+    AsyncProbe<double> cpu_probe_;
+    AsyncProbe<double> idle_probe_;
+    AsyncProbe<bool> audio_probe_;
+    AsyncProbe<TemperatureSample> temperature_probe_;
+    TickBudget* budget_;
+    StateLogRecord* record_;
+    std::optional<WindowInfo> window_info_;
+    uint32_t started_probes_;   // 本tick已开始的采样（ProbeBit位掩码）
+    std::unordered_map<std::string, AppCategory> category_cache_;  // 各进程最近一次完整分类的结果
     
-    // 设置信号处理
-    SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
+    /**
+     * 开始某类采样（每个tick最多一次）
+     */
+    void StartProbe(StateProbe probe) {
+        if ((started_probes_ & ProbeBit(probe)) != 0) {
+            return;
+        }
+        started_probes_ |= ProbeBit(probe);
+        switch (probe) {
+            case StateProbe::APP_CATEGORY:
+                window_probe_.Start();
+                break;
+            case StateProbe::CPU:
+                cpu_probe_.Start();
+                break;
+            case StateProbe::IDLE:
+                idle_probe_.Start();
+                break;
+            case StateProbe::AUDIO:
+                audio_probe_.Start();
+                break;
+            case StateProbe::TEMPERATURE:
+                temperature_probe_.Start();
+                break;
+            default:
+                break;
+        }
+    }
     
-    // 解析命令行参数
-    int interval_ms = 3000;  // 默认3秒
-    bool debug_mode = false;  // 调试模式
-    std::string config_file = "app_category_config.txt";  // 默认配置文件路径
+    void MarkStale(StateProbe probe, bool stale) {
+        if (stale) {
+            record_->stale_probes |= static_cast<uint8_t>(ProbeBit(probe));
+            METRICS_COUNT(MetricCounter::PROBE_TIMEOUTS);
+        }
+    }
     
-    for (int i = 1; i < argc; i++) {
-        std::string arg = argv[i];
-        if (arg == "--debug" || arg == "-d") {
-            debug_mode = true;
-        } else if (arg == "--config" || arg == "-c") {
-            // 指定配置文件路径
-            if (i + 1 < argc) {
-                config_file = argv[++i];
+    void ApplyWindow(const std::optional<WindowInfo>& window_info, SystemState& state) {
+        window_info_ = window_info;
+        if (!window_info_.has_value()) {
+            state.current_app_category = AppCategory::UNKNOWN;
+            record_->kind = StateLogKind::NO_WINDOW;
+            record_->category = AppCategory::UNKNOWN;
+            return;
+        }
+        const WindowInfo& info = window_info_.value();
+        
+        // 分类应用；预算用完时优先使用该进程上一次的完整分类，没有缓存时跳过关键词扫描
+        if (budget_ != nullptr && budget_->IsExhausted()) {
+            auto it = category_cache_.find(info.process_name);
+            if (it != category_cache_.end()) {
+                state.current_app_category = it->second;
+                budget_->RecordFallback(BudgetFallback::CACHED_CLASSIFICATION);
             } else {
-                std::cerr << "错误: --config 参数需要指定文件路径" << std::endl;
+                state.current_app_category = app_classifier_.ClassifyWithoutKeywords(info);
+                budget_->RecordFallback(BudgetFallback::SKIPPED_KEYWORD_SCAN);
             }
         } else {
-            try {
-                interval_ms = std::stoi(arg);
-                if (interval_ms < 100) {
-                    std::cerr << "警告: 间隔时间太短，将使用最小值100ms" << std::endl;
-                    interval_ms = 100;
-                }
-            } catch (...) {
-                // 忽略无效参数
+            state.current_app_category = app_classifier_.Classify(info);
+            if (category_cache_.size() >= kCategoryCacheLimit) {
+                category_cache_.clear();
             }
+            category_cache_[info.process_name] = state.current_app_category;
         }
+        
+        record_->kind = StateLogKind::TICK;
+        record_->category = state.current_app_category;
+        record_->process_id = info.process_id;
+        StateLogger::CopyText(record_->process_name, sizeof(record_->process_name), info.process_name);
+        StateLogger::CopyText(record_->window_title, sizeof(record_->window_title), info.window_title);
+    }
+};
+
+/**
+ * 采样并决定本tick的灯光模式（主循环和tick预算压力测试共用）
+ * @param eager_probes 是否采样所有字段
+ * @param force_window_probe 是否无论规则结果如何都采样前台窗口
+ * @return 灯光模式；预算在规则评估前已用完时返回std::nullopt（调用方保持上一次的模式）
+ */
+std::optional<LightMode> DecideTick(TickProber& tick_prober, RuleEngine& rule_engine, TickBudget& tick_budget,
+                                    SystemState& system_state, bool eager_probes, bool force_window_probe) {
+    if (eager_probes) {
+        // 每个tick采样所有字段：先同时开始所有采样，再逐个等待（总耗时取决于最慢的一个，且不超过其时限）
+        tick_prober.StartAll();
+        for (size_t i = 0; i < static_cast<size_t>(StateProbe::COUNT); i++) {
+            tick_prober.Probe(static_cast<StateProbe>(i), system_state);
+        }
+        system_state.pending_probes = 0;
+    } else if (force_window_probe) {
+        tick_prober.Probe(StateProbe::APP_CATEGORY, system_state);
+        system_state.pending_probes &= ~ProbeBit(StateProbe::APP_CATEGORY);
     }
     
-    std::cout << "应用状态监控程序" << std::endl;
-    std::cout << "监控间隔: " << interval_ms << "ms" << std::endl;
-    std::cout << "按 Ctrl+C 退出" << std::endl;
-    std::cout << std::string(60, '=') << std::endl;
-    
-    WindowMonitor window_monitor;
-    AppClassifier app_classifier;
-    
-    // 尝试从配置文件加载应用分类映射
-    // 如果配置文件不存在，会使用默认映射
-    if (!app_classifier.LoadConfigFile(config_file)) {
-        std::cout << "提示: 未找到配置文件 \"" << config_file 
-                  << "\"，使用默认应用分类映射" << std::endl;
-    } else {
-        std::cout << "已从配置文件加载应用分类: " << config_file << std::endl;
+    if (tick_budget.IsExhausted()) {
+        tick_budget.RecordFallback(BudgetFallback::HELD_MODE);
+        return std::nullopt;
+    }
+    return rule_engine.DecideLightMode(system_state);
+}
+
+/**
+ * 输出tick预算的统计（耗时、超出预算的tick数、各降级路径的触发次数）
+ */
+void PrintTickBudgetStats(const TickBudget& tick_budget) {
+    std::cout << "tick预算 " << tick_budget.GetBudget().count() / 1000.0 << " ms: " << tick_budget.GetTickCount()
+              << " 个tick，最长 " << tick_budget.GetMaxElapsed().count() / 1000.0 << " ms，超出预算 "
+              << tick_budget.GetOverrunCount() << " 次" << std::endl;
+    std::cout << "降级路径:";
+    for (size_t i = 0; i < static_cast<size_t>(BudgetFallback::COUNT); i++) {
+        BudgetFallback fallback = static_cast<BudgetFallback>(i);
+        std::cout << " " << TickBudget::GetFallbackName(fallback) << " " << tick_budget.GetFallbackCount(fallback);
+    }
+    std::cout << std::endl;
+}
+
+/**
+ * 模拟采样的延迟：按概率正常返回、变慢或卡住
+ * @param slow_percent 变慢的概率（百分比），延迟在 [slow_ms/4, slow_ms] 内均匀分布
+ * @param hang_percent 卡住的概率（百分比）
+ */
+void InjectProbeDelay(std::mt19937& rng, int slow_percent, int slow_ms, int hang_percent, int hang_ms) {
+    int roll = static_cast<int>(rng() % 100);
+    int delay_ms = 0;
+    if (roll < hang_percent) {
+        delay_ms = hang_ms;
+    } else if (roll < hang_percent + slow_percent) {
+        delay_ms = slow_ms / 4 + static_cast<int>(rng() % static_cast<uint32_t>(slow_ms - slow_ms / 4 + 1));
+    }
+    if (delay_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    }
+}
+
+/**
+ * tick预算压力测试：用随机变慢和卡住的模拟采样运行主循环的采样与决策，
+ * 检查每个tick的耗时都不超过预算，并输出各降级路径的触发次数
+ * @param tick_count tick数
+ * @param budget_ms 每个tick的预算（毫秒）
+ * @param probe_timeout_ms 所有采样的统一时限（0表示使用默认时限）
+ * @param eager_probes 是否每个tick采样所有字段
+ * @return 是否所有tick都在预算内
+ */
+bool RunTickBudgetStress(int tick_count, int budget_ms, int probe_timeout_ms, bool eager_probes) {
+    if (budget_ms <= 0) {
+        std::cerr << "错误: --stress-tick-budget 需要tick预算（--tick-budget 不能为0）" << std::endl;
+        return false;
     }
     
-    CpuMonitor cpu_monitor;
-    AudioMonitor audio_monitor;
-    RuleEngine rule_engine;
+    // 模拟的前台窗口：已知进程、只能靠关键词识别的进程和无法识别的进程
+    const std::vector<std::pair<std::string, std::string>> windows = {
+        {"chrome.exe", "GitHub - Google Chrome"},
+        {"Code.exe", "main.cpp - Visual Studio Code"},
+        {"unknown_player.exe", "movie.mkv - video player"},
+        {"steam_game_7.exe", "Game Launcher"},
+        {"spotify.exe", "Spotify Premium"},
+        {"tool_1234.exe", "Untitled"},
+    };
     
-    // 初始化音频监控
-    if (!audio_monitor.Initialize()) {
-        std::cerr << "警告: 音频监控初始化失败，音频活动检测可能不可用" << std::endl;
-    }
+    // 每类采样有自己的随机数发生器（各自只在一个后台线程中调用）
+    ProbeTasks tasks;
+    tasks.window = [rng = std::mt19937(1), tick = uint32_t(0), &windows]() mutable {
+        InjectProbeDelay(rng, 20, 150, 2, 3000);
+        // 每8个tick切换一次前台窗口
+        size_t index = (tick++ / 8) % windows.size();
+        WindowInfo window_info;
+        window_info.process_name = windows[index].first;
+        window_info.window_title = windows[index].second;
+        window_info.is_near_fullscreen = false;
+        window_info.process_id = static_cast<uint32_t>(1000 + index);
+        window_info.parent_process_id = 0;
+        return std::optional<WindowInfo>(window_info);
+    };
+    tasks.cpu = [rng = std::mt19937(2)]() mutable {
+        InjectProbeDelay(rng, 10, 300, 0, 0);
+        return static_cast<double>(rng() % 100);
+    };
+    tasks.idle = [rng = std::mt19937(3)]() mutable {
+        InjectProbeDelay(rng, 5, 100, 0, 0);
+        return static_cast<double>(rng() % 30);
+    };
+    tasks.audio = [rng = std::mt19937(4)]() mutable {
+        InjectProbeDelay(rng, 10, 500, 0, 0);
+        return (rng() & 1) != 0;
+    };
+    tasks.temperature = [rng = std::mt19937(5)]() mutable {
+        InjectProbeDelay(rng, 15, 800, 2, 5000);
+        TemperatureSample sample;
+        sample.cpu_temperature = 40.0 + rng() % 50;
+        sample.gpu_temperature = 35.0 + rng() % 50;
+        return sample;
+    };
     
-    // 初始化规则引擎，添加示例规则
+    AppClassifier app_classifier;
+    RuleEngine rule_engine;
     InitializeRules(rule_engine);
+    TickBudget tick_budget{std::chrono::milliseconds(budget_ms)};
+    TickProber tick_prober(app_classifier, std::move(tasks));
+    if (probe_timeout_ms > 0) {
+        tick_prober.SetProbeTimeout(std::chrono::milliseconds(probe_timeout_ms));
+    }
+    tick_prober.SetTickBudget(&tick_budget);
     
-    // 用于跟踪上一次的灯光模式，检测变化
-    LightMode last_light_mode = LightMode::DEFAULT;
-    bool has_last_mode = false;
+    std::time_t now = std::time(nullptr);
+    std::tm tm_buf;
+    localtime_s(&tm_buf, &now);
+    const auto stress_start = std::chrono::steady_clock::now();
     
-    while (g_running) {
-        auto window_info_opt = window_monitor.GetForegroundWindowInfo();
-        
-        // 获取当前系统状态
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        std::tm tm_buf;
-        localtime_s(&tm_buf, &time_t);
-        
-        double cpu_usage = cpu_monitor.GetCpuUsage();
-        double idle_minutes = GetUserIdleMinutes();
-        bool has_audio = audio_monitor.GetAudioActivity();
-        bool is_weekday = IsWeekday();
-        
+    std::cout << "tick预算压力测试: " << tick_count << " 个tick，预算 " << budget_ms << " ms，"
+              << (eager_probes ? "每个tick采样所有字段" : "惰性采样") << std::endl;
+    LightMode last_mode = LightMode::DEFAULT;
+    std::vector<double> elapsed_ms;
+    elapsed_ms.reserve(static_cast<size_t>(tick_count));
+    for (int tick = 0; tick < tick_count && g_running; tick++) {
+        tick_budget.BeginTick();
+        StateLogRecord record = {};
         SystemState system_state;
+        system_state.current_app_category = AppCategory::UNKNOWN;
+        system_state.cpu_usage = 0.0;
+        system_state.idle_minutes = 0.0;
+        system_state.has_audio_activity = false;
         system_state.current_hour = tm_buf.tm_hour;
         system_state.current_minute = tm_buf.tm_min;
-        system_state.cpu_usage = cpu_usage;
-        system_state.idle_minutes = idle_minutes >= 0.0 ? idle_minutes : 0.0;
-        system_state.has_audio_activity = has_audio;
-        system_state.is_weekday = is_weekday;
+        system_state.is_weekday = tm_buf.tm_wday >= 1 && tm_buf.tm_wday <= 5;
+        system_state.monotonic_seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - stress_start).count();
+        system_state.prober = &tick_prober;
+        system_state.pending_probes = kAllProbes;
+        tick_prober.BeginTick(&record);
         
-        // 决定当前灯光模式（对外接口：定期调用获取当前模式）
-        LightMode current_light_mode = rule_engine.DecideLightMode(system_state);
+        std::optional<LightMode> decided_mode = DecideTick(tick_prober, rule_engine, tick_budget, system_state,
+                                                           eager_probes, true);
+        last_mode = decided_mode.value_or(last_mode);
+        elapsed_ms.push_back(tick_budget.EndTick().count() / 1000.0);
         
-        // 检测模式变化
-        if (has_last_mode && last_light_mode != current_light_mode) {
-            std::cout << std::endl;
-            std::cout << ">>> Mode changed to: " << RuleEngine::GetLightModeName(current_light_mode) 
-                      << " (from " << RuleEngine::GetLightModeName(last_light_mode) << ")" << std::endl;
-            std::cout << std::endl;
+        // tick间隔很短，卡住的采样会跨越多个tick
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    
+    if (elapsed_ms.empty()) {
+        return false;
+    }
+    std::sort(elapsed_ms.begin(), elapsed_ms.end());
+    std::cout << "tick耗时: p50 " << elapsed_ms[elapsed_ms.size() / 2] << " ms，p99 "
+              << elapsed_ms[std::min(elapsed_ms.size() - 1, elapsed_ms.size() * 99 / 100)] << " ms" << std::endl;
+    PrintTickBudgetStats(tick_budget);
+    std::cout << "采样超时:";
+    for (size_t i = 0; i < static_cast<size_t>(StateProbe::COUNT); i++) {
+        StateProbe probe = static_cast<StateProbe>(i);
+        std::cout << " " << RuleEngine::GetProbeName(probe) << " " << tick_prober.GetTimeoutCount(probe);
+    }
+    std::cout << std::endl;
+    
+    bool held = tick_budget.GetOverrunCount() == 0;
+    std::cout << (held ? "结果: 所有tick都在预算内" : "结果: 有tick超出预算") << std::endl;
+    return held;
+}
+
+/**
+ * 大小写折叠基准：比较逐字节std::tolower与case_fold的吞吐，并统计折叠结果不同的标题数
+ * @param corpus_file 标题语料（UTF-8，每行一个标题，或 "进程名\t窗口标题"）；为空时使用内置的模拟标题
+ * @return 是否成功读取语料
+ */
+bool RunCaseFoldBenchmark(const std::string& corpus_file) {
+    std::vector<std::string> titles;
+    if (!corpus_file.empty()) {
+        std::ifstream file(corpus_file, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "错误: 无法读取标题语料: " << corpus_file << std::endl;
+            return false;
         }
-        
-        if (window_info_opt.has_value()) {
-            const WindowInfo& window_info = window_info_opt.value();
-            
-            // 分类应用
-            AppCategory category = app_classifier.Classify(window_info);
-            system_state.current_app_category = category;
-            
-            // 周期性输出完整状态信息（包括时间信息、CPU使用率和灯光模式）
-            PrintState(window_info, category, cpu_monitor, rule_engine, system_state, debug_mode);
-        } else {
-            // 即使无法获取窗口信息，也显示时间信息、CPU使用率和用户空闲时间
-            system_state.current_app_category = AppCategory::UNKNOWN;
-            
-            std::string current_time = GetCurrentTimeString();
-            std::string weekday = GetWeekday();
-            
-            std::cout << "[" << GetCurrentTimestamp() << "] 无法获取窗口信息" << std::endl;
-            std::cout << "  当前时间: " << current_time << std::endl;
-            std::cout << "  星期: " << weekday << std::endl;
-            std::cout << std::fixed << std::setprecision(1);
-            std::cout << "  CPU使用率: " << cpu_usage << "%" << std::endl;
-            if (idle_minutes >= 0.0) {
-                std::cout << "  用户空闲时间: " << idle_minutes << " 分钟" << std::endl;
-            } else {
-                std::cout << "  用户空闲时间: 无法获取" << std::endl;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (!line.empty()) {
+                titles.push_back(line);
             }
-            std::cout << std::defaultfloat;
-            std::cout << "  音频活动: " << (system_state.has_audio_activity ? "有" : "无") << std::endl;
-            std::cout << "  应用类别: 未知" << std::endl;
-            std::cout << "  灯光模式: " << RuleEngine::GetLightModeName(current_light_mode) << std::endl;
-            std::cout << std::string(60, '-') << std::endl;
         }
-        
-        // 更新上一次的模式
-        last_light_mode = current_light_mode;
-        has_last_mode = true;
-        
-        // 等待指定时间（3秒）
-        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+    } else {
+        // 常见的窗口标题：纯ASCII、中文、全角拉丁字母和其他文字混合
+        const char* const kSampleTitles[] = {
+            "GitHub - Pull requests - Google Chrome",
+            "rule_engine.cpp - Skydimo-Lights - Visual Studio Code",
+            "【官方】ＳＴＥＡＭ 夏季特卖开启 - 哔哩哔哩 (゜-゜)つロ 干杯~-bilibili",
+            "网易云音乐 - 晴天 - 周杰伦",
+            "Ｙｏｕｔｕｂｅ　Ｍｕｓｉｃ - 每日推荐",
+            "季度报告.docx - Word",
+            "Документ1 - Microsoft Word",
+            "Café Society (2016) - VLC media player",
+            "Windows PowerShell",
+            "ÜBERSICHT - Posteingang - Outlook",
+            "Ελληνικά - Wikipedia — Mozilla Firefox",
+            "C:\\Program Files\\Steam\\steamapps\\common\\Counter-Strike Global Offensive\\csgo.exe",
+        };
+        std::mt19937 rng(12345);
+        const size_t sample_count = sizeof(kSampleTitles) / sizeof(kSampleTitles[0]);
+        for (size_t i = 0; i < 100000; i++) {
+            titles.push_back(std::string(kSampleTitles[rng() % sample_count]) + " (" + std::to_string(rng() % 1000) + ")");
+        }
+    }
+    if (titles.empty()) {
+        std::cerr << "错误: 标题语料为空" << std::endl;
+        return false;
+    }
+    
+    size_t total_bytes = 0;
+    size_t non_ascii_titles = 0;
+    for (const auto& title : titles) {
+        total_bytes += title.size();
+        if (std::any_of(title.begin(), title.end(), [](char c) { return static_cast<unsigned char>(c) >= 0x80; })) {
+            non_ascii_titles++;
+        }
+    }
+    std::cout << "标题数: " << titles.size() << "，总字节数: " << total_bytes << "，含非ASCII字符的标题: "
+              << non_ascii_titles << std::endl;
+    
+    // 每种实现重复到处理约200MB，取总耗时
+    const size_t rounds = std::max<size_t>(1, (200u << 20) / std::max<size_t>(total_bytes, 1));
+    std::string buffer;
+    size_t checksum = 0;
+    
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; round++) {
+        for (const auto& title : titles) {
+            buffer.assign(title);
+            std::transform(buffer.begin(), buffer.end(), buffer.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            checksum += buffer.size();
+        }
+    }
+    double tolower_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    
+    begin = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; round++) {
+        for (const auto& title : titles) {
+            buffer.clear();
+            AppendFoldedCase(title, buffer);
+            checksum += buffer.size();
+        }
+    }
+    double fold_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    
+    double megabytes = static_cast<double>(total_bytes) * rounds / (1024.0 * 1024.0);
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "逐字节std::tolower: " << megabytes / tolower_seconds << " MB/s" << std::endl;
+    std::cout << "case_fold:          " << megabytes / fold_seconds << " MB/s  (" << std::setprecision(2)
+              << tolower_seconds / fold_seconds << "x)" << std::endl;
+    
+    // 非ASCII字符（全角字母、带重音的拉丁字母、希腊/西里尔字母）的折叠结果与逐字节转换不同
+    size_t changed = 0;
+    for (const auto& title : titles) {
+        std::string bytewise = title;
+        std::transform(bytewise.begin(), bytewise.end(), bytewise.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (FoldCase(title) != bytewise) {
+            changed++;
+        }
+    }
+    std::cout << "折叠结果与逐字节转换不同的标题: " << changed << " (校验和 " << checksum % 1000 << ")" << std::endl;
+    return true;
+}
+
+/**
+ * 没有开启决策追踪时的决策依据（发布到共享内存，供托盘程序等显示）
+ */
+std::string DescribeDecision(HistoryReason reason, int winning_rule, bool mode_held) {
+    switch (reason) {
+        case HistoryReason::MANUAL_OVERRIDE:
+            return "手动覆盖";
+        case HistoryReason::APP_OVERRIDE:
+            return "用户为该应用指定的灯光模式";
+        default:
+            break;
+    }
+    if (mode_held) {
+        return "超出tick预算，保持上一次的灯光模式";
+    }
+    if (winning_rule >= 0) {
+        return "规则 #" + std::to_string(winning_rule);
+    }
+    return "没有规则匹配，使用默认模式";
+}
+
+/**
+ * 由本tick的状态记录和系统状态组成要发布的状态
+ */
+PublishedState MakePublishedState(const StateLogRecord& record, const SystemState& system_state,
+                                  HistoryReason reason, int winning_rule, bool mode_held, uint32_t led_color) {
+    PublishedState state = {};
+    state.timestamp_ms = record.timestamp_ms;
+    state.cpu_usage = record.cpu_usage;
+    state.idle_minutes = record.idle_minutes;
+    state.cpu_temperature = system_state.cpu_temperature;
+    state.gpu_temperature = system_state.gpu_temperature;
+    std::copy(std::begin(system_state.category_seconds_today), std::end(system_state.category_seconds_today),
+              std::begin(state.category_seconds_today));
+    state.process_id = record.process_id;
+    state.led_color = led_color;
+    state.winning_rule = winning_rule;
+    state.category = static_cast<uint8_t>(record.category);
+    state.light_mode = static_cast<uint8_t>(record.light_mode);
+    state.reason = static_cast<uint8_t>(reason);
+    state.flags = (record.has_audio_activity ? kPublishedAudioActive : 0) |
+                  (record.idle_available ? kPublishedIdleAvailable : 0) |
+                  (mode_held ? kPublishedModeHeld : 0);
+    state.hour = record.hour;
+    state.minute = record.minute;
+    state.weekday = record.weekday;
+    state.skipped_probes = record.skipped_probes;
+    state.stale_probes = record.stale_probes;
+    state.budget_fallbacks = record.budget_fallbacks;
+    std::memcpy(state.process_name, record.process_name, sizeof(state.process_name));
+    if (record.decision_reason[0] != '\0') {
+        std::memcpy(state.decision_reason, record.decision_reason, sizeof(state.decision_reason));
+    } else {
+        StateLogger::CopyText(state.decision_reason, sizeof(state.decision_reason),
+                              DescribeDecision(reason, winning_rule, mode_held));
+    }
+    return state;
+}
+
+/**
+ * 读取共享内存中发布的状态并输出（与托盘程序等读取方使用同样的方式）
+ * @return 是否读到状态
+ */
+bool PrintPublishedState(const std::string& shm_name) {
+    StateReader reader;
+    PublishedState state;
+    if (!reader.Open(shm_name) || !reader.Read(state)) {
+        std::cerr << "错误: 没有读到共享内存中的状态: " << shm_name << "（监控程序是否正在运行？）" << std::endl;
+        return false;
+    }
+    char color[8];
+    std::snprintf(color, sizeof(color), "#%06X", static_cast<unsigned>(state.led_color & 0xFFFFFF));
+    std::cout << "发布者进程: " << reader.GetPublisherPid() << "  第 " << state.update_count << " 次发布" << std::endl;
+    std::cout << "前台进程: " << (state.process_name[0] != '\0' ? state.process_name : "（无）")
+              << "  类别: " << AppClassifier::GetCategoryName(static_cast<AppCategory>(state.category))
+              << "  灯光模式: " << RuleEngine::GetLightModeName(static_cast<LightMode>(state.light_mode)) << std::endl;
+    std::cout << "决策依据: " << state.decision_reason << std::endl;
+    std::cout << "CPU: " << state.cpu_usage << "%  空闲: " << state.idle_minutes << " 分钟  音频: "
+              << ((state.flags & kPublishedAudioActive) != 0 ? "有" : "无") << "  灯带颜色: " << color << std::endl;
+    return true;
+}
+
+// 帧节奏基准的默认帧率与p99抖动目标
+const double kBenchFrameRate = 120.0;
+const uint64_t kFrameJitterTargetNs = 1000000;
+
+/**
+ * 把颜色打包为0xRRGGBB
+ */
+uint32_t PackColor(const LightColor& color) {
+    return (static_cast<uint32_t>(color.r) << 16) | (static_cast<uint32_t>(color.g) << 8) | color.b;
+}
+
+/**
+ * 启动输出线程：每帧按当前模式渲染，写入输出端（灯带驱动接入前为最近一帧的颜色）
+ * CPU绑定或实时优先级没有生效时给出警告，仍按普通线程运行
+ */
+bool StartFrameOutput(FramePacer& frame_pacer, const FramePacerOptions& options, LightEffectRenderer& renderer,
+                      std::atomic<uint32_t>& latest_color) {
+    bool started = frame_pacer.Start(options, [&renderer, &latest_color](uint64_t frame_index, double time_seconds) {
+        LightFrame frame = renderer.Render(frame_index, time_seconds);
+        latest_color.store(PackColor(frame.color), std::memory_order_relaxed);
+    });
+    if (!started) {
+        std::cerr << "错误: 无法启动输出线程（帧率 " << options.frames_per_second << "）" << std::endl;
+        return false;
+    }
+    FramePacingStats stats = frame_pacer.GetStats();
+    if (options.cpu_core >= 0 && !stats.pinned) {
+        std::cerr << "警告: 无法把输出线程绑定到CPU核 " << options.cpu_core << std::endl;
+    }
+    if (options.realtime_priority && !stats.realtime) {
+        std::cerr << "警告: 无法提升输出线程的优先级，按普通优先级运行" << std::endl;
+    }
+    return true;
+}
+
+/**
+ * 输出帧节奏统计（帧数、跳过的帧、抖动分位数、渲染耗时）
+ */
+void PrintFramePacingStats(const FramePacer& frame_pacer, double frames_per_second) {
+    FramePacingStats stats = frame_pacer.GetStats();
+    std::ostringstream oss;
+    oss << "帧输出 " << frames_per_second << " fps: " << stats.frames << " 帧，跳过 " << stats.missed_deadlines
+        << " 帧" << (stats.pinned ? "（已绑定CPU核）" : "") << (stats.realtime ? "（实时优先级）" : "") << "\n";
+    oss << std::fixed << std::setprecision(3);
+    oss << "帧抖动: p50 " << stats.jitter_p50_ns / 1e6 << " ms  p99 " << stats.jitter_p99_ns / 1e6
+        << " ms  p99.9 " << stats.jitter_p999_ns / 1e6 << " ms  最大 " << stats.jitter_max_ns / 1e6
+        << " ms  渲染p99 " << stats.render_p99_ns / 1e6 << " ms";
+    std::cout << oss.str() << std::endl;
+}
+
+/**
+ * 帧节奏基准：按指定帧率输出seconds秒，期间每秒切换一次灯光模式（覆盖模式过渡），输出抖动统计
+ * @return p99抖动是否低于目标（1ms）
+ */
+bool RunFramePacingBenchmark(int seconds, FramePacerOptions options) {
+    if (options.frames_per_second <= 0.0) {
+        options.frames_per_second = kBenchFrameRate;
+    }
+    LightEffectRenderer renderer;
+    std::atomic<uint32_t> latest_color(0);
+    FramePacer frame_pacer;
+    if (!StartFrameOutput(frame_pacer, options, renderer, latest_color)) {
+        return false;
+    }
+    std::cout << "帧节奏基准: " << options.frames_per_second << " fps，" << seconds << " 秒" << std::endl;
+    
+    for (int second = 0; second < seconds && g_running; second++) {
+        renderer.SetMode(static_cast<LightMode>(static_cast<size_t>(second) % kLightModeCount));
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+    frame_pacer.Stop();
+    
+    PrintFramePacingStats(frame_pacer, options.frames_per_second);
+    bool met = frame_pacer.GetStats().jitter_p99_ns < kFrameJitterTargetNs;
+    std::cout << "目标 p99抖动 < " << kFrameJitterTargetNs / 1e6 << " ms: " << (met ? "达到" : "未达到") << std::endl;
+    return met;
+}
+
+// 主色提取每帧的耗时上限（单核60fps）
+const uint64_t kPaletteFrameBudgetNs = 1000000000 / 60;
+
+/**
+ * 视频片段中的一帧（RGB24，行间无填充）
+ */
+struct ClipFrame {
+    int width;
+    int height;
+    std::vector<uint8_t> pixels;
+};
+
+/**
+ * 读取PPM帧序列（多个P6图像首尾相接，如 ffmpeg -i 视频 -vf scale=160:-2 -f image2pipe -vcodec ppm 片段.ppm）
+ * @return 是否读到至少一帧（格式错误时停在出错的帧之前）
+ */
+bool LoadPpmClip(const std::string& clip_file, std::vector<ClipFrame>& frames) {
+    std::ifstream file(clip_file, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    // 读取头部的下一个数字（跳过空白和注释）
+    auto read_number = [&file](int& value) {
+        int c = file.get();
+        while (c != EOF && (std::isspace(c) || c == '#')) {
+            if (c == '#') {
+                while (c != EOF && c != '\n') {
+                    c = file.get();
+                }
+            }
+            c = file.get();
+        }
+        if (c == EOF || !std::isdigit(c)) {
+            return false;
+        }
+        value = 0;
+        while (c != EOF && std::isdigit(c)) {
+            value = value * 10 + (c - '0');
+            c = file.get();
+        }
+        // 数字后的一个空白字符属于头部
+        return c != EOF;
+    };
+    while (true) {
+        char magic[2];
+        if (!file.read(magic, 2) || magic[0] != 'P' || magic[1] != '6') {
+            break;
+        }
+        ClipFrame frame;
+        int max_value = 0;
+        if (!read_number(frame.width) || !read_number(frame.height) || !read_number(max_value) ||
+            frame.width <= 0 || frame.height <= 0 || max_value != 255) {
+            break;
+        }
+        frame.pixels.resize(static_cast<size_t>(frame.width) * frame.height * 3);
+        if (!file.read(reinterpret_cast<char*>(frame.pixels.data()), static_cast<std::streamsize>(frame.pixels.size()))) {
+            break;
+        }
+        frames.push_back(std::move(frame));
+        // 跳过帧之间可能存在的空白
+        while (std::isspace(file.peek())) {
+            file.get();
+        }
+    }
+    return !frames.empty();
+}
+
+/**
+ * 生成模拟的视频片段：160x90，60fps共10秒，4个场景（缓慢移动的色块、噪点、上下黑边），场景之间硬切
+ */
+std::vector<ClipFrame> MakeSyntheticClip() {
+    const int width = 160;
+    const int height = 90;
+    const int letterbox = 10;
+    const int frame_count = 600;
+    const uint8_t kScenes[4][3][3] = {
+        {{20, 40, 120}, {230, 140, 40}, {30, 30, 40}},      // 夜景与路灯
+        {{40, 120, 40}, {120, 180, 230}, {200, 200, 190}},  // 草地与天空
+        {{150, 20, 20}, {250, 200, 60}, {60, 20, 10}},      // 火光
+        {{10, 80, 90}, {0, 160, 170}, {220, 230, 240}},     // 海面
+    };
+    std::mt19937 rng(2024);
+    std::vector<ClipFrame> frames(frame_count);
+    for (int f = 0; f < frame_count; f++) {
+        const uint8_t (*scene)[3] = kScenes[f * 4 / frame_count];
+        double shift = std::fmod(f * 0.4, static_cast<double>(width));
+        ClipFrame& frame = frames[f];
+        frame.width = width;
+        frame.height = height;
+        frame.pixels.assign(static_cast<size_t>(width) * height * 3, 0);
+        for (int y = letterbox; y < height - letterbox; y++) {
+            for (int x = 0; x < width; x++) {
+                // 三个色块按列和行划分，随时间水平移动
+                int region = y > height * 2 / 3 ? 2 : (static_cast<int>(x + shift) % width < width / 2 ? 0 : 1);
+                uint8_t* pixel = &frame.pixels[(static_cast<size_t>(y) * width + x) * 3];
+                for (int c = 0; c < 3; c++) {
+                    int noisy = scene[region][c] + static_cast<int>(rng() % 21) - 10;
+                    pixel[c] = static_cast<uint8_t>(std::clamp(noisy, 0, 255));
+                }
+            }
+        }
+    }
+    return frames;
+}
+
+/**
+ * 用一种设置处理整个片段，输出每帧耗时、迭代次数和调色板稳定性
+ * @return 每帧耗时的p99（纳秒）
+ */
+uint64_t RunPaletteClip(const std::vector<ClipFrame>& frames, const PaletteOptions& options, const char* label) {
+    PaletteExtractor extractor(options);
+    LatencyHistogram frame_time;
+    uint64_t iterations = 0;
+    double palette_change = 0.0;  // 相邻两帧输出调色板各颜色通道差的平均值
+    size_t dominant_switches = 0;
+    std::vector<PaletteEntry> previous;
+    size_t previous_dominant = 0;
+    for (const auto& clip_frame : frames) {
+        FrameView view = {clip_frame.pixels.data(), clip_frame.width, clip_frame.height,
+                          static_cast<size_t>(clip_frame.width) * 3, PixelFormat::RGB24};
+        auto begin = std::chrono::steady_clock::now();
+        const std::vector<PaletteEntry>& palette = extractor.Update(view);
+        frame_time.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count()));
+        iterations += static_cast<uint64_t>(extractor.GetLastIterations());
+        if (!previous.empty()) {
+            double change = 0.0;
+            for (size_t i = 0; i < palette.size(); i++) {
+                change += std::abs(palette[i].color.r - previous[i].color.r) +
+                          std::abs(palette[i].color.g - previous[i].color.g) +
+                          std::abs(palette[i].color.b - previous[i].color.b);
+            }
+            palette_change += change / (palette.size() * 3);
+            if (extractor.GetDominantIndex() != previous_dominant) {
+                dominant_switches++;
+            }
+        }
+        previous = palette;
+        previous_dominant = extractor.GetDominantIndex();
+    }
+    
+    double mean_us = static_cast<double>(frame_time.Sum()) / frame_time.Count() / 1000.0;
+    uint64_t p99_ns = frame_time.ValueAtQuantile(0.99);
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(3);
+    oss << label << ": 平均 " << mean_us / 1000.0 << " ms  p99 " << p99_ns / 1e6 << " ms  最大 "
+        << frame_time.Max() / 1e6 << " ms  (单核约 " << std::setprecision(0) << 1e6 / mean_us << " fps)"
+        << std::setprecision(2) << "\n    平均迭代 " << static_cast<double>(iterations) / frames.size()
+        << " 次  调色板每帧变化 " << palette_change / std::max<size_t>(frames.size() - 1, 1)
+        << " 色阶  主色切换 " << dominant_switches << " 次";
+    std::cout << oss.str() << std::endl;
+    
+    const std::vector<PaletteEntry>& palette = extractor.GetPalette();
+    std::cout << "    最后一帧调色板:";
+    for (size_t i = 0; i < palette.size(); i++) {
+        char hex[8];
+        std::snprintf(hex, sizeof(hex), "#%02X%02X%02X", palette[i].color.r, palette[i].color.g, palette[i].color.b);
+        std::cout << " " << hex << "(" << static_cast<int>(palette[i].weight * 100 + 0.5f) << "%)"
+                  << (i == extractor.GetDominantIndex() ? "*" : "");
+    }
+    std::cout << std::endl;
+    return p99_ns;
+}
+
+/**
+ * 主色提取基准：逐帧处理视频片段，比较热启动与每帧重新初始化，检查能否在单核上维持60fps
+ * @param clip_file PPM帧序列；为空时使用模拟片段
+ * @return 是否成功读取片段且热启动的p99耗时在一帧（1/60秒）以内
+ */
+bool RunPaletteBenchmark(const std::string& clip_file) {
+    std::vector<ClipFrame> frames;
+    if (clip_file.empty()) {
+        frames = MakeSyntheticClip();
+    } else if (!LoadPpmClip(clip_file, frames)) {
+        std::cerr << "错误: 无法读取视频片段（PPM帧序列）: " << clip_file << std::endl;
+        return false;
+    }
+    std::cout << "视频片段: " << frames.size() << " 帧，" << frames[0].width << "x" << frames[0].height << std::endl;
+    
+    PaletteOptions options;
+    uint64_t warm_p99_ns = RunPaletteClip(frames, options, "热启动");
+    options.warm_start = false;
+    RunPaletteClip(frames, options, "每帧重新初始化");
+    
+    bool met = warm_p99_ns < kPaletteFrameBudgetNs;
+    std::cout << "目标 单核60fps（每帧 < " << std::fixed << std::setprecision(2) << kPaletteFrameBudgetNs / 1e6
+              << " ms）: " << (met ? "达到" : "未达到") << std::defaultfloat << std::endl;
+    return met;
+}
+
+/**
+ * 打印一次进程表扫描的统计
+ */
+void PrintProcessScanStats(const char* label, const ProcessScanStats& stats) {
+    std::cout << label << ": " << stats.elapsed_us / 1000.0 << " ms（进程 " << stats.total << "，新增 " << stats.added
+              << "，退出 " << stats.removed << "，pid复用 " << stats.reused << "）" << std::endl;
+}
+
+/**
+ * 进程树基准：测量首次扫描、无变化时的增量扫描以及有进程启动/退出/pid复用时的扫描耗时
+ * Windows下进程表来自系统快照，测量的是当前系统的真实进程表（process_count不适用）；
+ * 其他平台在临时目录中伪造一个包含process_count个进程的proc目录树。
+ * @param process_count 伪造的进程数
+ * @return 是否成功
+ */
+bool RunProcessTreeBenchmark(size_t process_count) {
+    const int steady_scans = 50;
+#ifdef _WIN32
+    (void)process_count;
+    ProcessTreeTracker tracker;
+#else
+    namespace fs = std::filesystem;
+    fs::path root = fs::temp_directory_path() / ("skydimo_fake_proc_" +
+        std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    std::error_code error;
+    fs::remove_all(root, error);
+    if (!fs::create_directories(root, error)) {
+        std::cerr << "错误: 无法创建伪造的proc目录: " << root.string() << std::endl;
+        return false;
+    }
+    
+    // stat格式: pid (comm) state ppid ... starttime(第22个字段)
+    auto write_process = [](const fs::path& dir, uint32_t pid, uint32_t ppid, uint64_t start_time,
+                            const std::string& name) {
+        fs::create_directory(dir);
+        std::ofstream stat(dir / "stat");
+        stat << pid << " (" << name << ") S " << ppid;
+        for (int field = 5; field <= 21; field++) {
+            stat << " 0";
+        }
+        stat << " " << start_time << " 0 0\n";
+    };
+    
+    // pid 1 之下是若干启动器，其余进程随机挂在更早启动的进程之下
+    std::mt19937 rng(12345);
+    std::vector<uint32_t> pids;
+    const char* const kNames[] = {"steam", "explorer", "code", "bash", "game", "helper", "worker"};
+    for (size_t i = 0; i < process_count; i++) {
+        uint32_t pid = static_cast<uint32_t>(i + 1);
+        uint32_t ppid = i == 0 ? 0 : (i <= 20 ? 1 : pids[rng() % pids.size()]);
+        write_process(root / std::to_string(pid), pid, ppid, 1000 + i, kNames[rng() % 7]);
+        pids.push_back(pid);
+    }
+    ProcessTreeTracker tracker(root.string());
+#endif
+    
+    PrintProcessScanStats("首次扫描", tracker.Update());
+    
+    double total_us = 0.0;
+    double max_us = 0.0;
+    for (int i = 0; i < steady_scans; i++) {
+        ProcessScanStats stats = tracker.Update();
+        total_us += stats.elapsed_us;
+        max_us = std::max(max_us, stats.elapsed_us);
+    }
+    std::cout << "无变化的增量扫描: 平均 " << total_us / steady_scans / 1000.0 << " ms，最长 "
+              << max_us / 1000.0 << " ms（" << steady_scans << " 次）" << std::endl;
+    
+#ifndef _WIN32
+    // 1%的进程退出、1%的pid被新进程复用、新启动1%的进程
+    // 复用的pid先在别处建好目录再替换，保证新目录得到新的inode号
+    size_t churn = std::max<size_t>(1, process_count / 100);
+    uint64_t next_start_time = 1000 + process_count;
+    for (size_t i = 0; i < churn; i++) {
+        uint32_t exited = pids[process_count - 1 - i];
+        fs::remove_all(root / std::to_string(exited), error);
+        
+        uint32_t reused = pids[process_count / 2 + i];
+        fs::path staging = root / ("staging_" + std::to_string(reused));
+        write_process(staging, reused, 1, next_start_time++, "reused");
+        fs::remove_all(root / std::to_string(reused), error);
+        fs::rename(staging, root / std::to_string(reused), error);
+        
+        uint32_t started = static_cast<uint32_t>(process_count + 1 + i);
+        write_process(root / std::to_string(started), started, pids[rng() % 20 + 1], next_start_time++, "new");
+    }
+    PrintProcessScanStats("进程启动/退出后的扫描", tracker.Update());
+    
+    fs::remove_all(root, error);
+#endif
+    return true;
+}
+
+/**
+ * 规则加载基准：生成大量随机规则，测量批量加载和单次决策的耗时
+ * @param rule_count 规则数
+ */
+void RunRuleLoadBenchmark(size_t rule_count) {
+    std::mt19937 rng(12345);
+    std::vector<Rule> rules(rule_count);
+    for (auto& rule : rules) {
+        rule.priority = static_cast<int>(rng() % 1000);
+        rule.target_mode = static_cast<LightMode>(rng() % 6);
+        size_t condition_count = 1 + rng() % 3;
+        for (size_t i = 0; i < condition_count; i++) {
+            Condition condition;
+            switch (rng() % 4) {
+                case 0:
+                    condition.type = ConditionType::APP_CATEGORY;
+                    condition.app_category = static_cast<AppCategory>(rng() % 8);
+                    break;
+                case 1:
+                    condition.type = ConditionType::TIME_RANGE;
+                    condition.time_range = TimeRange(static_cast<int>(rng() % 24), 0, static_cast<int>(rng() % 24), 59);
+                    break;
+                case 2:
+                    condition.type = ConditionType::CPU_THRESHOLD;
+                    condition.cpu_threshold = static_cast<double>(rng() % 100);
+                    condition.cpu_greater_than = (rng() & 1) != 0;
+                    break;
+                default:
+                    condition.type = ConditionType::AUDIO_ACTIVITY;
+                    condition.audio_activity = (rng() & 1) != 0;
+                    break;
+            }
+            rule.conditions.push_back(condition);
+        }
+    }
+    
+    RuleEngine rule_engine;
+    auto load_begin = std::chrono::steady_clock::now();
+    rule_engine.LoadRules(rules);
+    double load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_begin).count();
+    
+    SystemState state;
+    state.current_app_category = AppCategory::UNKNOWN;
+    state.cpu_usage = 50.0;
+    state.idle_minutes = 0.0;
+    state.current_hour = 12;
+    state.current_minute = 0;
+    state.has_audio_activity = false;
+    state.is_weekday = true;
+    auto decide_begin = std::chrono::steady_clock::now();
+    LightMode mode = rule_engine.DecideLightMode(state);
+    double decide_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - decide_begin).count();
+    
+    std::cout << "加载 " << rule_engine.GetRuleCount() << " 条规则: " << load_ms << " ms" << std::endl;
+    std::cout << "单次决策: " << decide_us << " us（" << RuleEngine::GetLightModeName(mode) << "）" << std::endl;
+    
+    // 关闭与开启决策追踪时的平均决策耗时（重复到约0.5秒，两种情况交替三轮取最小值以减少干扰）
+    const size_t decisions = std::max<size_t>(100, static_cast<size_t>(500000.0 / std::max(decide_us, 0.01)) / 6);
+    auto time_decisions = [&]() {
+        auto begin = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < decisions; i++) {
+            state.cpu_usage = static_cast<double>(i % 100);
+            state.current_hour = static_cast<int>(i % 24);
+            rule_engine.DecideLightMode(state);
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / decisions;
+    };
+    double untraced_ns = 0.0;
+    double traced_ns = 0.0;
+    for (int round = 0; round < 3; round++) {
+        rule_engine.DisableTrace();
+        double ns = time_decisions();
+        untraced_ns = round == 0 ? ns : std::min(untraced_ns, ns);
+        rule_engine.EnableTrace();
+        ns = time_decisions();
+        traced_ns = round == 0 ? ns : std::min(traced_ns, ns);
+    }
+    rule_engine.DisableTrace();
+    std::cout << "平均决策（" << decisions << " 次）: 关闭追踪 " << untraced_ns << " ns，开启追踪 " << traced_ns
+              << " ns（" << std::showpos << (traced_ns / untraced_ns - 1.0) * 100.0 << std::noshowpos << "%）" << std::endl;
+}
+
+/**
+ * 批量分类基准：比较逐项Classify、单线程ClassifyBatch与线程池ClassifyBatch的吞吐，并核对结果一致
+ * @param window_count 合成的窗口数
+ * @return 批量分类结果是否与逐项分类一致
+ */
+bool RunClassifyBatchBenchmark(size_t window_count) {
+    // 已知进程、需要关键词匹配的未知进程、完全无法识别的进程混合
+    const char* const kNames[] = {
+        "chrome.exe", "code.exe", "C:\\Games\\mygame\\Game-Win64-Shipping.exe", "spotify.exe", "unknown_tool.exe",
+        "WINWORD.EXE", "obs64.exe", "javaw.exe", "PotPlayerMini64.exe", "helper.exe",
+    };
+    const char* const kTitles[] = {
+        "GitHub - Pull requests - Google Chrome", "rule_engine.cpp - Skydimo-Lights - Visual Studio Code",
+        "Minecraft 1.20.4 - Singleplayer", "网易云音乐 - 晴天", "", "季度报告.docx - Word",
+        "OBS 30.0.2 - Profile: Untitled", "IntelliJ IDEA", "Movie.2024.mkv - PotPlayer", "Settings",
+    };
+    std::mt19937 rng(12345);
+    std::vector<WindowInfo> windows(window_count);
+    for (auto& window : windows) {
+        window.process_name = kNames[rng() % 10];
+        window.window_title = std::string(kTitles[rng() % 10]) + " (" + std::to_string(rng() % 1000) + ")";
+        window.is_near_fullscreen = false;
+        window.process_id = 0;
+        window.parent_process_id = 0;
+    }
+    
+    AppClassifier classifier;
+    ThreadPool pool;
+    const int rounds = 20;
+    auto windows_per_second = [&](double seconds) { return window_count * rounds / seconds; };
+    
+    std::vector<AppCategory> expected(window_count);
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < window_count; i++) {
+            expected[i] = classifier.Classify(windows[i]);
+        }
+    }
+    double classify_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    
+    AppBatch batch;
+    begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        batch.Clear();
+        batch.Reserve(window_count, window_count * 48);
+        for (const auto& window : windows) {
+            batch.Add(window.process_name, window.window_title);
+        }
+    }
+    double build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    
+    std::vector<AppCategory> categories;
+    begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        classifier.ClassifyBatch(batch, categories);
+    }
+    double batch_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    bool matched = categories == expected;
+    
+    begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        classifier.ClassifyBatch(batch, categories, &pool);
+    }
+    double pool_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    matched = matched && categories == expected;
+    
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "窗口数: " << window_count << "（每种方式重复 " << rounds << " 次）" << std::endl;
+    std::cout << "逐项Classify:        " << windows_per_second(classify_seconds) / 1e6 << " M窗口/秒" << std::endl;
+    std::cout << "构建AppBatch:        " << windows_per_second(build_seconds) / 1e6 << " M窗口/秒" << std::endl;
+    std::cout << "ClassifyBatch:       " << windows_per_second(batch_seconds) / 1e6 << " M窗口/秒" << std::endl;
+    std::cout << "ClassifyBatch+线程池: " << windows_per_second(pool_seconds) / 1e6 << " M窗口/秒（"
+              << pool.GetConcurrency() << " 个线程）" << std::endl;
+    std::cout << std::defaultfloat;
+    std::cout << "结果与逐项分类" << (matched ? "一致" : "不一致") << std::endl;
+    return matched;
+}
+
+/**
+ * 路径前缀基准：配置不同数量的目录前缀，测量单次查找的耗时（应与前缀数量无关）
+ */
+void RunPathPrefixBenchmark() {
+    const char* const kSamplePaths[] = {
+        "C:\\Program Files (x86)\\Steam\\steamapps\\common\\Counter-Strike Global Offensive\\game\\bin\\win64\\cs2.exe",
+        "D:\\SteamLibrary\\steamapps\\common\\Elden Ring\\Game\\eldenring.exe",
+        "C:\\Program Files\\JetBrains\\CLion 2024.1\\bin\\clion64.exe",
+        "C:\\Program Files\\Vendor42\\Product7\\bin\\app.exe",
+        "C:\\Users\\user\\AppData\\Local\\Programs\\Microsoft VS Code\\Code.exe",
+        "\\\\?\\C:\\Windows\\System32\\notepad.exe",
+    };
+    const size_t path_count = sizeof(kSamplePaths) / sizeof(kSamplePaths[0]);
+    const size_t lookups = 1000000;
+    
+    for (size_t prefix_count : {10u, 1000u, 100000u}) {
+        PathPrefixTrie trie;
+        trie.Insert("steamapps/common/", AppCategory::GAME);
+        trie.Insert("C:\\Program Files\\JetBrains\\", AppCategory::DEVELOPMENT);
+        std::mt19937 rng(12345);
+        while (trie.Size() < prefix_count) {
+            std::string prefix = "C:\\Program Files\\Vendor" + std::to_string(rng() % 1000) + "\\Product" +
+                                 std::to_string(rng() % 1000) + "\\";
+            trie.Insert(prefix, static_cast<AppCategory>(rng() % 7));
+        }
+        
+        size_t matched = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; i++) {
+            if (trie.Find(kSamplePaths[i % path_count]).has_value()) {
+                matched++;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << "前缀数: " << trie.Size() << "  单次查找: " << seconds * 1e9 / lookups << " ns"
+                  << "  命中: " << matched * 100 / lookups << "%" << std::endl;
+    }
+}
+
+// 历史汇总中一条记录最多计入的时长（秒），更长的间隔视为程序未运行
+const uint32_t kHistoryMaxGapSeconds = 60;
+
+// 今日使用统计的快照保存间隔
+const int64_t kSessionSnapshotIntervalMs = 60000;
+
+// 记录历史或会话时，规则没有用到前台窗口的tick之间最多隔这么久强制采样一次前台窗口
+// （两次采样之间的tick沿用上一次采样的结果，因此记录的前台应用最多滞后这么久）
+const int64_t kTrackingWindowProbeIntervalMs = 10000;
+
+/**
+ * 本地日期编号（yyyymmdd）
+ */
+int32_t LocalDayNumber(const std::tm& tm_buf) {
+    return (tm_buf.tm_year + 1900) * 10000 + (tm_buf.tm_mon + 1) * 100 + tm_buf.tm_mday;
+}
+
+/**
+ * 格式化时长，如 "12h05m"
+ */
+std::string FormatDuration(uint64_t seconds) {
+    std::ostringstream oss;
+    oss << seconds / 3600 << "h" << std::setw(2) << std::setfill('0') << seconds % 3600 / 60 << "m";
+    return oss.str();
+}
+
+/**
+ * 输出历史汇总：各类别、各模式的时长和每小时的模式切换次数
+ */
+void PrintHistorySummary(const HistorySummary& summary, int64_t begin) {
+    std::cout << "记录数: " << summary.record_count << std::endl;
+    std::cout << "各类别时长:" << std::endl;
+    for (size_t i = 0; i < summary.category_seconds.size(); i++) {
+        if (summary.category_seconds[i] > 0) {
+            std::cout << "  " << AppClassifier::GetCategoryName(static_cast<AppCategory>(i)) << ": "
+                      << FormatDuration(summary.category_seconds[i]) << std::endl;
+        }
+    }
+    std::cout << "各模式时长:" << std::endl;
+    for (size_t i = 0; i < summary.mode_seconds.size(); i++) {
+        if (summary.mode_seconds[i] > 0) {
+            std::cout << "  " << RuleEngine::GetLightModeName(static_cast<LightMode>(i)) << ": "
+                      << FormatDuration(summary.mode_seconds[i]) << std::endl;
+        }
+    }
+    std::cout << "模式切换（每小时，只列出有切换的小时）:" << std::endl;
+    for (size_t hour = 0; hour < summary.flips_per_hour.size(); hour++) {
+        if (summary.flips_per_hour[hour] == 0) {
+            continue;
+        }
+        std::time_t hour_start = static_cast<std::time_t>(begin + static_cast<int64_t>(hour) * 3600);
+        std::tm tm_buf;
+        localtime_s(&tm_buf, &hour_start);
+        std::cout << "  " << std::put_time(&tm_buf, "%m-%d %H:%M") << "  " << summary.flips_per_hour[hour] << std::endl;
+    }
+}
+
+/**
+ * 历史报告：汇总最近若干天的记录
+ * @param history_dir 历史存储目录
+ * @param days 天数
+ * @return 是否成功
+ */
+bool RunHistoryReport(const std::string& history_dir, int days) {
+    HistoryStore history_store;
+    if (!history_store.Open(history_dir)) {
+        std::cerr << "错误: 无法打开历史目录: " << history_dir << std::endl;
+        return false;
+    }
+    int64_t now = static_cast<int64_t>(std::time(nullptr));
+    int64_t begin = now - static_cast<int64_t>(days) * 86400;
+    begin -= begin % 3600;  // 从整点开始，每小时的切换次数按整点分组
+    HistorySummary summary = history_store.Summarize(begin, now + 1, kHistoryMaxGapSeconds);
+    std::cout << "最近 " << days << " 天的历史（" << history_dir << "）" << std::endl;
+    PrintHistorySummary(summary, begin);
+    HistoryQueryStats stats = history_store.GetQueryStats();
+    std::cout << "读取段: " << stats.segments_opened << "  解码小时桶: " << stats.buckets_decoded << std::endl;
+    return true;
+}
+
+/**
+ * 历史存储基准：按1Hz写入若干天的模拟记录，然后查询最近一周
+ * 数据写入当前目录下新建的 history_bench_<时间> 目录
+ * @param days 天数
+ */
+void RunHistoryBenchmark(int days) {
+    const uint32_t segment_bytes = 1u << 20;
+    std::string directory = "history_bench_" + std::to_string(std::time(nullptr));
+    HistoryStore history_store(segment_bytes);
+    if (!history_store.Open(directory)) {
+        std::cerr << "错误: 无法创建目录: " << directory << std::endl;
+        return;
+    }
+    
+    // 模拟的一天：白天办公、晚上游戏或看视频，偶尔切换应用
+    const char* const process_names[] = {"code.exe", "chrome.exe", "game.exe", "vlc.exe", "spotify.exe"};
+    const AppCategory categories[] = {AppCategory::DEVELOPMENT, AppCategory::BROWSER, AppCategory::GAME,
+                                      AppCategory::VIDEO, AppCategory::MUSIC};
+    const LightMode modes[] = {LightMode::WORK_CODING, LightMode::DEFAULT, LightMode::GAME_SCREENSYNC,
+                               LightMode::VIDEO_CINEMATIC, LightMode::MUSIC};
+    std::mt19937 rng(12345);
+    int64_t end = static_cast<int64_t>(std::time(nullptr));
+    int64_t begin = end - static_cast<int64_t>(days) * 86400;
+    size_t app = 0;
+    uint64_t appended = 0;
+    auto write_begin = std::chrono::steady_clock::now();
+    for (int64_t t = begin; t < end; t++) {
+        int hour = static_cast<int>(t / 3600 % 24);
+        if (rng() % 600 == 0) {
+            app = hour >= 9 && hour < 18 ? rng() % 2 : 2 + rng() % 3;
+        }
+        HistoryRecord record = {};
+        record.timestamp = t;
+        record.category = categories[app];
+        record.mode = modes[app];
+        record.reason = HistoryReason::RULE;
+        record.rule_index = static_cast<uint32_t>(app);
+        if (history_store.Append(record, process_names[app])) {
+            appended++;
+        }
+    }
+    history_store.Flush();
+    double write_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - write_begin).count();
+    std::cout << "写入 " << appended << " 条记录: " << write_s << " s（"
+              << static_cast<uint64_t>(appended / std::max(write_s, 1e-9)) << " 条/秒）" << std::endl;
+    
+    auto query_begin = std::chrono::steady_clock::now();
+    HistorySummary summary = history_store.Summarize(end - 7 * 86400, end, kHistoryMaxGapSeconds);
+    double query_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - query_begin).count();
+    HistoryQueryStats stats = history_store.GetQueryStats();
+    std::cout << "查询最近一周: " << query_ms << " ms，读取段 " << stats.segments_opened
+              << "，解码记录 " << stats.records_decoded << "，游戏时长 "
+              << FormatDuration(summary.category_seconds[static_cast<size_t>(AppCategory::GAME)]) << std::endl;
+    
+    query_begin = std::chrono::steady_clock::now();
+    summary = history_store.Summarize(end - 3600, end, kHistoryMaxGapSeconds);
+    query_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - query_begin).count();
+    HistoryQueryStats hour_stats = history_store.GetQueryStats();
+    std::cout << "查询最近一小时: " << query_ms << " ms，读取段 " << hour_stats.segments_opened - stats.segments_opened
+              << "，解码记录 " << hour_stats.records_decoded - stats.records_decoded << std::endl;
+    std::cout << "同时映射的内存不超过 " << 2 * segment_bytes / 1024 << " KB（正在写入和正在查询的段各一个）" << std::endl;
+    std::cout << "基准数据目录: " << directory << "（可删除）" << std::endl;
+}
+
+/**
+ * 主函数
+ */
+int main(int argc, char* argv[]) {
+    // 设置控制台代码页为UTF-8以支持中文显示
+    SetConsoleOutputCP(65001);
+    
+    // 设置信号处理
+    SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
+    
+    // 解析命令行参数
+    int interval_ms = 3000;  // 默认3秒
+    bool debug_mode = false;  // 调试模式
+    bool trace_mode = false;  // 决策追踪（记录命中的规则及更高优先级规则未满足的条件）
+    bool fixed_condition_order = false;  // 按编写顺序评估条件（关闭自适应条件顺序）
+    bool eager_probes = false;  // 每个tick采样所有字段（关闭惰性采样）
+    int probe_timeout_ms = 0;  // 所有采样的统一时限（0表示使用各采样的默认时限）
+    int tick_budget_ms = kDefaultTickBudgetMs;  // 每个tick的时间预算（0表示不限制）
+    int stress_budget_ticks = 0;  // tick预算压力测试的tick数（0表示不运行）
+    bool bench_case_fold = false;  // 运行大小写折叠基准
+    std::string case_fold_corpus;  // 大小写折叠基准的标题语料（为空表示使用内置标题）
+    bool bench_path_prefix = false;  // 运行路径前缀查找基准
+    int bench_process_count = 0;  // 进程树基准的进程数（0表示不运行）
+    int bench_batch_windows = 0;  // 批量分类基准的窗口数（0表示不运行）
+    FramePacerOptions frame_options;  // 输出线程的帧率、CPU绑定与优先级
+    frame_options.frames_per_second = 0.0;  // 0表示不启动输出线程
+    int bench_frame_seconds = 0;  // 帧节奏基准的秒数（0表示不运行）
+    bool bench_palette = false;  // 运行主色提取基准
+    std::string palette_clip;  // 主色提取基准的视频片段（为空表示使用模拟片段）
+    int log_interval_ms = 0;  // 状态未变化时的完整状态输出间隔（0表示只在变化时输出）
+    std::string config_file = "app_category_config.txt";  // 默认配置文件路径
+    std::string metrics_file;  // 指标文件路径（为空表示不导出）
+    int metrics_interval_ms = 5000;  // 指标文件刷新间隔
+    std::string learned_store_file = "learned_apps.bin";  // 学习记录文件路径
+    std::vector<std::string> assignments;  // --assign 进程名=类别名
+    std::vector<std::string> overrides;    // --override 进程名=灯光模式名
+    std::vector<std::string> forgets;      // --forget 进程名
+    int fleet_server_port = 0;   // 集中评估服务端口（0表示不以服务模式运行）
+    int fleet_loadgen_port = 0;  // 负载生成器目标端口（0表示不运行）
+    int fleet_clients = 10000;   // 负载生成器模拟的客户端数
+    int fleet_rounds = 50;       // 负载生成器发送的轮数
+    int bench_rule_count = 0;    // 规则加载基准的规则数（0表示不运行）
+    std::string simulate_scenario;  // 一周模拟的场景文件（为空表示不运行）
+    std::string command_socket;  // 外部指令套接字路径（为空表示不监听）
+    std::string sensors_root = "/sys";  // 温度传感器所在的sysfs根目录
+    std::string history_dir;  // 历史记录目录（为空表示不记录，用--history-dir开启）
+    std::string session_snapshot_file = "sessions.snapshot";  // 今日使用统计快照文件（为空表示不统计）
+    int history_report_days = 0;  // 历史报告的天数（0表示不输出）
+    int bench_history_days = 0;   // 历史存储基准的天数（0表示不运行）
+    std::string state_shm_name = "skydimo_state";  // 发布当前状态的共享内存段名称（为空表示不发布）
+    bool read_state = false;      // 读取共享内存中的状态并输出
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--debug" || arg == "-d") {
+            debug_mode = true;
+        } else if (arg == "--trace" || arg == "-t") {
+            trace_mode = true;
+        } else if (arg == "--fixed-condition-order") {
+            fixed_condition_order = true;
+        } else if (arg == "--eager-probes") {
+            eager_probes = true;
+        } else if (arg == "--probe-timeout") {
+            // 指定每类采样的时限（毫秒）
+            if (i + 1 < argc) {
+                try {
+                    probe_timeout_ms = std::max(1, std::stoi(argv[++i]));
+                } catch (...) {
+                    std::cerr << "错误: --probe-timeout 参数需要指定毫秒数" << std::endl;
+                }
+            } else {
+                std::cerr << "错误: --probe-timeout 参数需要指定毫秒数" << std::endl;
+            }
+        } else if (arg == "--tick-budget") {
+            // 指定每个tick的时间预算（毫秒，0表示不限制）
+            if (i + 1 < argc) {
+                try {
+                    tick_budget_ms = std::max(0, std::stoi(argv[++i]));
+                } catch (...) {
+                    std::cerr << "错误: --tick-budget 参数需要指定毫秒数" << std::endl;
+                }
+            } else {
+                std::cerr << "错误: --tick-budget 参数需要指定毫秒数" << std::endl;
+            }
+        } else if (arg == "--stress-tick-budget") {
+            // tick预算压力测试
+            if (i + 1 < argc) {
+                try {
+                    stress_budget_ticks = std::stoi(argv[++i]);
+                } catch (...) {
+                    stress_budget_ticks = 0;
+                }
+            }
+            if (stress_budget_ticks <= 0) {
+                std::cerr << "错误: --stress-tick-budget 参数需要指定正整数" << std::endl;
+            }
+        } else if (arg == "--bench-case-fold") {
+            // 大小写折叠基准（可选的标题语料文件）
+            bench_case_fold = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                case_fold_corpus = argv[++i];
+            }
+        } else if (arg == "--bench-process-tree") {
+            // 进程树增量扫描基准
+            if (i + 1 < argc) {
+                try {
+                    bench_process_count = std::stoi(argv[++i]);
+                } catch (...) {
+                    bench_process_count = 0;
+                }
+            }
+            if (bench_process_count <= 0) {
+                std::cerr << "错误: --bench-process-tree 参数需要指定正整数" << std::endl;
+            }
+        } else if (arg == "--bench-classify-batch") {
+            // 批量分类基准（可选的窗口数，默认10000）
+            bench_batch_windows = 10000;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                try {
+                    bench_batch_windows = std::stoi(argv[++i]);
+                } catch (...) {
+                    bench_batch_windows = 0;
+                }
+                if (bench_batch_windows <= 0) {
+                    std::cerr << "错误: --bench-classify-batch 参数需要指定正整数" << std::endl;
+                }
+            }
+        } else if (arg == "--bench-path-prefix") {
+            // 路径前缀查找基准
+            bench_path_prefix = true;
+        } else if (arg == "--frame-rate") {
+            // 输出线程的帧率（0表示不启动输出线程）
+            if (i + 1 < argc) {
+                try {
+                    frame_options.frames_per_second = std::max(0.0, std::stod(argv[++i]));
+                } catch (...) {
+                    std::cerr << "错误: --frame-rate 参数需要指定帧率" << std::endl;
+                }
+            } else {
+                std::cerr << "错误: --frame-rate 参数需要指定帧率" << std::endl;
+            }
+        } else if (arg == "--frame-cpu") {
+            // 把输出线程绑定到指定的CPU核
+            if (i + 1 < argc) {
+                try {
+                    frame_options.cpu_core = std::stoi(argv[++i]);
+                } catch (...) {
+                    std::cerr << "错误: --frame-cpu 参数需要指定CPU核序号" << std::endl;
+                }
+            } else {
+                std::cerr << "错误: --frame-cpu 参数需要指定CPU核序号" << std::endl;
+            }
+        } else if (arg == "--frame-realtime") {
+            frame_options.realtime_priority = true;
+        } else if (arg == "--bench-frame-pacing") {
+            // 帧节奏基准
+            if (i + 1 < argc) {
+                try {
+                    bench_frame_seconds = std::stoi(argv[++i]);
+                } catch (...) {
+                    bench_frame_seconds = 0;
+                }
+            }
+            if (bench_frame_seconds <= 0) {
+                std::cerr << "错误: --bench-frame-pacing 参数需要指定秒数" << std::endl;
+            }
+        } else if (arg == "--bench-palette") {
+            // 主色提取基准（可选的PPM帧序列）
+            bench_palette = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                palette_clip = argv[++i];
+            }
+        } else if (arg == "--log-interval") {
+            // 指定状态未变化时的输出间隔（毫秒）
+            if (i + 1 < argc) {
+                try {
+                    log_interval_ms = std::max(0, std::stoi(argv[++i]));
+                } catch (...) {
+                    std::cerr << "错误: --log-interval 参数需要指定毫秒数" << std::endl;
+                }
+            } else {
+                std::cerr << "错误: --log-interval 参数需要指定毫秒数" << std::endl;
+            }
+        } else if (arg == "--metrics-file") {
+            // 指定Prometheus文本格式的指标文件路径
+            if (i + 1 < argc) {
+                metrics_file = argv[++i];
+            } else {
+                std::cerr << "错误: --metrics-file 参数需要指定文件路径" << std::endl;
+            }
+        } else if (arg == "--metrics-interval") {
+            // 指定指标文件刷新间隔（毫秒）
+            if (i + 1 < argc) {
+                try {
+                    metrics_interval_ms = std::max(100, std::stoi(argv[++i]));
+                } catch (...) {
+                    std::cerr << "错误: --metrics-interval 参数需要指定毫秒数" << std::endl;
+                }
+            } else {
+                std::cerr << "错误: --metrics-interval 参数需要指定毫秒数" << std::endl;
+            }
+        } else if (arg == "--learned-store") {
+            // 指定学习记录文件路径
+            if (i + 1 < argc) {
+                learned_store_file = argv[++i];
+            } else {
+                std::cerr << "错误: --learned-store 参数需要指定文件路径" << std::endl;
+            }
+        } else if (arg == "--assign" || arg == "--override" || arg == "--forget") {
+            // 手动为进程指定类别 / 覆盖灯光模式 / 删除学习记录
+            if (i + 1 < argc) {
+                std::vector<std::string>& target =
+                    arg == "--assign" ? assignments : (arg == "--override" ? overrides : forgets);
+                target.push_back(argv[++i]);
+            } else {
+                std::cerr << "错误: " << arg << " 参数需要指定进程" << std::endl;
+            }
+        } else if (arg == "--bench-rule-load") {
+            // 规则加载基准
+            if (i + 1 < argc) {
+                try {
+                    bench_rule_count = std::stoi(argv[++i]);
+                } catch (...) {
+                    bench_rule_count = 0;
+                }
+            }
+            if (bench_rule_count <= 0) {
+                std::cerr << "错误: --bench-rule-load 参数需要指定正整数" << std::endl;
+            }
+        } else if (arg == "--history-dir") {
+            // 指定历史记录目录
+            if (i + 1 < argc) {
+                history_dir = argv[++i];
+            } else {
+                std::cerr << "错误: --history-dir 参数需要指定目录" << std::endl;
+            }
+        } else if (arg == "--no-history") {
+            history_dir.clear();
+        } else if (arg == "--session-snapshot") {
+            // 指定今日使用统计的快照文件
+            if (i + 1 < argc) {
+                session_snapshot_file = argv[++i];
+            } else {
+                std::cerr << "错误: --session-snapshot 参数需要指定文件路径" << std::endl;
+            }
+        } else if (arg == "--no-sessions") {
+            session_snapshot_file.clear();
+        } else if (arg == "--state-shm") {
+            // 指定发布当前状态的共享内存段名称
+            if (i + 1 < argc) {
+                state_shm_name = argv[++i];
+            } else {
+                std::cerr << "错误: --state-shm 参数需要指定名称" << std::endl;
+            }
+        } else if (arg == "--no-state-shm") {
+            state_shm_name.clear();
+        } else if (arg == "--read-state") {
+            read_state = true;
+        } else if (arg == "--history-report" || arg == "--bench-history") {
+            // 汇总最近若干天的历史 / 历史存储基准
+            int& target = arg == "--history-report" ? history_report_days : bench_history_days;
+            if (i + 1 < argc) {
+                try {
+                    target = std::stoi(argv[++i]);
+                } catch (...) {
+                    target = 0;
+                }
+            }
+            if (target <= 0) {
+                std::cerr << "错误: " << arg << " 参数需要指定天数" << std::endl;
+            }
+        } else if (arg == "--simulate-week") {
+            // 按场景模拟规则集一周的灯光模式
+            if (i + 1 < argc) {
+                simulate_scenario = argv[++i];
+            } else {
+                std::cerr << "错误: --simulate-week 参数需要指定场景文件" << std::endl;
+            }
+        } else if (arg == "--fleet-server" || arg == "--fleet-loadgen" ||
+                   arg == "--fleet-clients" || arg == "--fleet-rounds") {
+            // 集中评估服务 / 本地负载生成器
+            int value = 0;
+            if (i + 1 < argc) {
+                try {
+                    value = std::stoi(argv[++i]);
+                } catch (...) {
+                    value = 0;
+                }
+            }
+            if (value <= 0) {
+                std::cerr << "错误: " << arg << " 参数需要指定正整数" << std::endl;
+            } else if (arg == "--fleet-server") {
+                fleet_server_port = value;
+            } else if (arg == "--fleet-loadgen") {
+                fleet_loadgen_port = value;
+            } else if (arg == "--fleet-clients") {
+                fleet_clients = value;
+            } else {
+                fleet_rounds = value;
+            }
+        } else if (arg == "--command-socket") {
+            // 指定外部指令（手动覆盖）的本地套接字路径
+            if (i + 1 < argc) {
+                command_socket = argv[++i];
+            } else {
+                std::cerr << "错误: --command-socket 参数需要指定套接字路径" << std::endl;
+            }
+        } else if (arg == "--sensors-root") {
+            // 指定温度传感器的sysfs根目录（可指向伪造的目录树用于测试）
+            if (i + 1 < argc) {
+                sensors_root = argv[++i];
+            } else {
+                std::cerr << "错误: --sensors-root 参数需要指定目录" << std::endl;
+            }
+        } else if (arg == "--config" || arg == "-c") {
+            // 指定配置文件路径
+            if (i + 1 < argc) {
+                config_file = argv[++i];
+            } else {
+                std::cerr << "错误: --config 参数需要指定文件路径" << std::endl;
+            }
+        } else {
+            try {
+                interval_ms = std::stoi(arg);
+                if (interval_ms < 100) {
+                    std::cerr << "警告: 间隔时间太短，将使用最小值100ms" << std::endl;
+                    interval_ms = 100;
+                }
+            } catch (...) {
+                // 忽略无效参数
+            }
+        }
+    }
+    
+    // 集中评估服务模式：只评估各客户端上报的状态，不监控本机
+    if (fleet_server_port > 0) {
+        RuleEngine fleet_rules;
+        InitializeRules(fleet_rules);
+        FleetServer fleet_server(fleet_rules.GetRules());
+        if (!fleet_server.Start(static_cast<uint16_t>(fleet_server_port))) {
+            std::cerr << "错误: 无法监听端口 " << fleet_server_port << std::endl;
+            return 1;
+        }
+        std::cout << "集中评估服务已启动: 127.0.0.1:" << fleet_server_port << "，按 Ctrl+C 退出" << std::endl;
+        fleet_server.Run(g_running);
+        
+        FleetServerStats stats = fleet_server.GetStats();
+        std::cout << "连接数: " << stats.connections_accepted
+                  << "  客户端数: " << stats.known_clients
+                  << "  收到状态: " << stats.states_received
+                  << "  批次数: " << stats.batches
+                  << "  下发模式: " << stats.modes_sent
+                  << "  回收客户端: " << stats.clients_evicted
+                  << "  丢弃状态: " << stats.states_dropped << std::endl;
+        if (stats.clients_evaluated > 0) {
+            std::cout << "平均批大小: " << stats.clients_evaluated / std::max<uint64_t>(stats.batches, 1)
+                      << "  每客户端评估耗时: " << static_cast<double>(stats.eval_ns) / stats.clients_evaluated
+                      << " ns" << std::endl;
+        }
+        return 0;
+    }
+    
+    if (bench_rule_count > 0) {
+        RunRuleLoadBenchmark(static_cast<size_t>(bench_rule_count));
+        return 0;
+    }
+    
+    if (bench_case_fold) {
+        return RunCaseFoldBenchmark(case_fold_corpus) ? 0 : 1;
+    }
+    
+    if (bench_process_count > 0) {
+        return RunProcessTreeBenchmark(static_cast<size_t>(bench_process_count)) ? 0 : 1;
+    }
+    
+    if (bench_batch_windows > 0) {
+        return RunClassifyBatchBenchmark(static_cast<size_t>(bench_batch_windows)) ? 0 : 1;
+    }
+    
+    if (bench_path_prefix) {
+        RunPathPrefixBenchmark();
+        return 0;
+    }
+    
+    if (read_state) {
+        return PrintPublishedState(state_shm_name) ? 0 : 1;
+    }
+    
+    if (bench_palette) {
+        return RunPaletteBenchmark(palette_clip) ? 0 : 1;
+    }
+    
+    if (bench_frame_seconds > 0) {
+        return RunFramePacingBenchmark(bench_frame_seconds, frame_options) ? 0 : 1;
+    }
+    
+    if (stress_budget_ticks > 0) {
+        return RunTickBudgetStress(stress_budget_ticks, tick_budget_ms, probe_timeout_ms, eager_probes) ? 0 : 1;
+    }
+    
+    if (history_report_days > 0) {
+        if (history_dir.empty()) {
+            std::cerr << "错误: --history-report 需要用 --history-dir 指定历史目录" << std::endl;
+            return 1;
+        }
+        return RunHistoryReport(history_dir, history_report_days) ? 0 : 1;
+    }
+    
+    if (bench_history_days > 0) {
+        RunHistoryBenchmark(bench_history_days);
+        return 0;
+    }
+    
+    // 一周模拟：用当前规则集评估场景中一周的每一分钟
+    if (!simulate_scenario.empty()) {
+        SimulationScenario scenario;
+        std::string error;
+        if (!scenario.LoadFromFile(simulate_scenario, error)) {
+            std::cerr << "错误: " << error << std::endl;
+            return 1;
+        }
+        RuleEngine simulated_rules;
+        InitializeRules(simulated_rules);
+        std::vector<Rule> rules = simulated_rules.GetRules();
+        WeekSimulator simulator;
+        SimulationResult result = simulator.Run(rules, scenario);
+        WeekSimulator::PrintResult(result, rules, std::cout);
+        return 0;
+    }
+    
+    // 负载生成器：模拟大量客户端向集中评估服务发送状态，并校验下发的模式
+    if (fleet_loadgen_port > 0) {
+        RuleEngine fleet_rules;
+        InitializeRules(fleet_rules);
+        FleetLoadStats stats;
+        if (!RunFleetLoadGenerator(static_cast<uint16_t>(fleet_loadgen_port), fleet_rules,
+                                   static_cast<size_t>(fleet_clients), fleet_rounds, 16, stats)) {
+            std::cerr << "错误: 无法连接到集中评估服务 127.0.0.1:" << fleet_loadgen_port << std::endl;
+            return 1;
+        }
+        std::cout << "发送状态: " << stats.states_sent
+                  << "  收到模式: " << stats.modes_received
+                  << "  耗时: " << stats.elapsed_seconds << "s"
+                  << "  吞吐: " << static_cast<uint64_t>(stats.states_sent / std::max(stats.elapsed_seconds, 1e-9))
+                  << " 状态/秒" << std::endl;
+        if (stats.mismatches == 0) {
+            std::cout << "校验: 所有客户端最后收到的模式均与本地规则引擎一致" << std::endl;
+        } else {
+            std::cout << "校验: " << stats.mismatches << " 个客户端最后收到的模式与本地规则引擎不一致" << std::endl;
+        }
+        return stats.mismatches == 0 ? 0 : 1;
+    }
+    
+    std::cout << "应用状态监控程序" << std::endl;
+    std::cout << "监控间隔: " << interval_ms << "ms" << std::endl;
+    std::cout << "按 Ctrl+C 退出" << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+    
+    WindowMonitor window_monitor;
+    AppClassifier app_classifier;
+    
+    // 尝试从配置文件加载应用分类映射
+    // 如果配置文件不存在，会使用默认映射
+    if (!app_classifier.LoadConfigFile(config_file)) {
+        std::cout << "提示: 未找到配置文件 \"" << config_file 
+                  << "\"，使用默认应用分类映射" << std::endl;
+    } else {
+        std::cout << "已从配置文件加载应用分类: " << config_file << std::endl;
+    }
+    
+    // 加载学习记录，并应用命令行中的手动指定
+    LearnedAppStore learned_store;
+    if (learned_store.Load(learned_store_file)) {
+        std::cout << "已加载学习记录: " << learned_store_file
+                  << " (" << learned_store.Size() << " 个应用)" << std::endl;
+    }
+    for (const auto& assignment : assignments) {
+        size_t equal_pos = assignment.find('=');
+        std::optional<AppCategory> category;
+        if (equal_pos != std::string::npos) {
+            category = AppClassifier::ParseCategoryName(assignment.substr(equal_pos + 1));
+        }
+        if (equal_pos == 0 || !category.has_value()) {
+            std::cerr << "错误: --assign 格式应为 进程名=类别名，忽略 \"" << assignment << "\"" << std::endl;
+            continue;
+        }
+        learned_store.LearnCategory(assignment.substr(0, equal_pos), category.value());
+    }
+    for (const auto& override_arg : overrides) {
+        size_t equal_pos = override_arg.find('=');
+        std::optional<LightMode> mode;
+        if (equal_pos != std::string::npos) {
+            mode = RuleEngine::ParseLightModeName(override_arg.substr(equal_pos + 1));
+        }
+        if (equal_pos == 0 || !mode.has_value()) {
+            std::cerr << "错误: --override 格式应为 进程名=灯光模式名，忽略 \"" << override_arg << "\"" << std::endl;
+            continue;
+        }
+        learned_store.RecordModeOverride(override_arg.substr(0, equal_pos), mode.value());
+    }
+    for (const auto& process_name : forgets) {
+        learned_store.Forget(process_name);
+    }
+    if (learned_store.IsDirty() && !learned_store.Save(learned_store_file)) {
+        std::cerr << "警告: 无法保存学习记录: " << learned_store_file << std::endl;
+    }
+    app_classifier.SetLearnedStore(&learned_store);
+    
+    CpuMonitor cpu_monitor;
+    AudioMonitor audio_monitor;
+    RuleEngine rule_engine;
+    ProcessTreeTracker process_tree;  // 进程树（用于继承祖先进程的类别）
+    SensorProvider sensor_provider(sensors_root);  // CPU/GPU温度传感器
+    if (sensor_provider.Discover() > 0) {
+        std::cout << "已发现温度传感器: " << sensor_provider.GetSensorCount() << " 个" << std::endl;
+    }
+    TickProber tick_prober(app_classifier,
+                           MakeSystemProbeTasks(window_monitor, process_tree, cpu_monitor, audio_monitor, sensor_provider));
+    if (probe_timeout_ms > 0) {
+        tick_prober.SetProbeTimeout(std::chrono::milliseconds(probe_timeout_ms));
+    }
+    TickBudget tick_budget{std::chrono::milliseconds(tick_budget_ms)};
+    tick_prober.SetTickBudget(&tick_budget);
+    bool has_mode_overrides = learned_store.CountModeOverrides() > 0;
+    
+    // 会话与模式历史：每个tick追加一条记录
+    HistoryStore history_store;
+    if (!history_dir.empty()) {
+        if (history_store.Open(history_dir)) {
+            std::cout << "历史记录目录: " << history_dir << std::endl;
+        } else {
+            std::cerr << "警告: 无法打开历史记录目录: " << history_dir << "，不记录历史" << std::endl;
+        }
+    }
+    bool history_write_failed = false;
+    std::string last_known_process;                         // 最近一次采样到的前台进程（没有前台窗口时为空）
+    AppCategory last_known_category = AppCategory::UNKNOWN;
+    int64_t last_window_probe_ms = 0;  // 时间戳为Unix毫秒，第一个tick即采样
+    
+    // 应用使用会话与今日累计时长（供状态输出和CATEGORY_USAGE_TODAY条件使用），定期保存快照以便重启后恢复；
+    // 与历史记录相互独立，默认开启
+    bool track_sessions = !session_snapshot_file.empty();
+    SessionAggregator session_aggregator(std::max<uint32_t>(kHistoryMaxGapSeconds,
+                                                            static_cast<uint32_t>(3 * interval_ms / 1000)));
+    int64_t last_snapshot_ms = 0;
+    if (track_sessions) {
+        std::time_t start_time = std::time(nullptr);
+        std::tm start_tm;
+        localtime_s(&start_tm, &start_time);
+        if (session_aggregator.LoadSnapshot(session_snapshot_file, LocalDayNumber(start_tm))) {
+            std::cout << "已恢复今日使用统计: " << session_snapshot_file << std::endl;
+        }
+    }
+    
+    // 初始化音频监控
+    if (!audio_monitor.Initialize()) {
+        std::cerr << "警告: 音频监控初始化失败，音频活动检测可能不可用" << std::endl;
+    }
+    
+    // 初始化规则引擎，添加示例规则
+    InitializeRules(rule_engine);
+    if (!track_sessions) {
+        for (const auto& rule : rule_engine.GetRules()) {
+            bool uses_usage_today = std::any_of(rule.conditions.begin(), rule.conditions.end(),
+                                                [](const Condition& condition) {
+                                                    return condition.type == ConditionType::CATEGORY_USAGE_TODAY;
+                                                });
+            if (uses_usage_today) {
+                std::cerr << "警告: 规则使用了今日累计时长条件，但今日使用统计已关闭（--no-sessions），该条件不会满足"
+                          << std::endl;
+                break;
+            }
+        }
+    }
+    if (trace_mode) {
+        rule_engine.EnableTrace();
+    }
+    rule_engine.SetAdaptiveOrdering(!fixed_condition_order);
+    
+    // 异步状态日志：主循环只提交定长记录，由后台线程格式化输出
+    StateLogger state_logger;
+    state_logger.SetDebugMode(debug_mode);
+    state_logger.SetLogInterval(log_interval_ms);
+    state_logger.Start();
+    
+    // 当前状态发布到共享内存（读取方不需要系统调用，也不影响主循环）
+    StatePublisher state_publisher;
+    if (!state_shm_name.empty()) {
+        if (state_publisher.Open(state_shm_name)) {
+            std::cout << "状态共享内存: " << state_shm_name << std::endl;
+        } else if (state_publisher.GetOtherPublisherPid() != 0) {
+            std::cerr << "警告: 状态共享内存 " << state_shm_name << " 正由另一个实例（进程ID "
+                      << state_publisher.GetOtherPublisherPid() << "）发布，本实例不发布状态"
+                      << "（可用 --state-shm 指定其他名称）" << std::endl;
+        } else {
+            std::cerr << "警告: 无法创建状态共享内存: " << state_shm_name << std::endl;
+        }
+    }
+    
+    // 会话结束事件（调试模式下输出）
+    session_aggregator.SetEventHandler([&](SessionEventType type, const AppSession& session) {
+        if (type == SessionEventType::CLOSED) {
+            state_logger.LogSessionClosed(session.last_seen * 1000, session.process_name, session.category,
+                                          session.seconds,
+                                          session_aggregator.GetDailyUsage().category_seconds[
+                                              static_cast<size_t>(session.category)]);
+        }
+    });
+    
+    // 各阶段延迟指标导出（编译时未启用 APP_METRICS_ENABLED 时不可用）
+    MetricsExporter metrics_exporter;
+    if (!metrics_file.empty()) {
+#ifdef APP_METRICS_ENABLED
+        metrics_exporter.Start(metrics_file, metrics_interval_ms);
+        std::cout << "指标文件: " << metrics_file << " (每 " << metrics_interval_ms << "ms 刷新)" << std::endl;
+#else
+        (void)metrics_interval_ms;
+        std::cerr << "警告: 编译时未启用指标统计（ENABLE_METRICS=OFF），忽略 --metrics-file" << std::endl;
+#endif
+    }
+    
+    // 外部指令（手动覆盖）：收到指令时立即唤醒主循环
+    ExternalCommandManager command_manager;
+    if (!command_socket.empty()) {
+        if (command_manager.StartListening(command_socket)) {
+            std::cout << "外部指令套接字: " << command_socket << std::endl;
+        } else {
+            std::cerr << "警告: 无法监听外部指令套接字: " << command_socket << std::endl;
+        }
+    }
+    
+    // 输出线程：按固定帧率渲染当前模式的灯光效果，与决策tick无关
+    LightEffectRenderer light_renderer;
+    std::atomic<uint32_t> latest_frame_color(0);
+    FramePacer frame_pacer;
+    if (frame_options.frames_per_second > 0.0 &&
+        StartFrameOutput(frame_pacer, frame_options, light_renderer, latest_frame_color)) {
+        std::cout << "输出帧率: " << frame_options.frames_per_second << " fps" << std::endl;
+    }
+    
+    // 用于跟踪上一次的灯光模式，检测变化
+    LightMode last_light_mode = LightMode::DEFAULT;
+    bool has_last_mode = false;
+    int winning_rule = -1;  // 上一次规则评估命中的规则（超出预算保持模式时沿用）
+    
+    // 滑动窗口条件使用的单调时钟起点
+    const auto monitor_start = std::chrono::steady_clock::now();
+    
+    while (g_running) {
+        METRICS_TIMER_BEGIN(tick_begin);
+        tick_budget.BeginTick();
+        
+        // 每个tick只读取一次时间，所有时间字段都来自同一个快照
+        auto now = std::chrono::system_clock::now();
+        auto time_t = std::chrono::system_clock::to_time_t(now);
+        std::tm tm_buf;
+        localtime_s(&tm_buf, &time_t);
+        int64_t timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            now.time_since_epoch()).count();
+        
+        StateLogRecord record = {};
+        record.timestamp_ms = timestamp_ms;
+        record.weekday = static_cast<uint8_t>(tm_buf.tm_wday);
+        record.hour = static_cast<uint8_t>(tm_buf.tm_hour);
+        record.minute = static_cast<uint8_t>(tm_buf.tm_min);
+        
+        // 时间字段立即填充；其余字段由规则引擎在条件用到时通过tick_prober采样
+        SystemState system_state;
+        system_state.current_app_category = AppCategory::UNKNOWN;
+        system_state.cpu_usage = 0.0;
+        system_state.idle_minutes = 0.0;
+        system_state.has_audio_activity = false;
+        system_state.current_hour = tm_buf.tm_hour;
+        system_state.current_minute = tm_buf.tm_min;
+        // tm_wday: 0=周日, 1=周一, ..., 6=周六；工作日为1-5
+        system_state.is_weekday = tm_buf.tm_wday >= 1 && tm_buf.tm_wday <= 5;
+        system_state.monotonic_seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - monitor_start).count();
+        system_state.prober = &tick_prober;
+        system_state.pending_probes = kAllProbes;
+        int32_t local_day = LocalDayNumber(tm_buf);
+        session_aggregator.FillSystemState(local_day, system_state);
+        tick_prober.BeginTick(&record);
+        
+        // 决定当前灯光模式（每个tick只计算一次）；用户为某些应用指定了灯光模式时，
+        // 无论规则结果如何都需要知道前台进程；记录历史或会话时按限定的间隔采样前台进程。
+        // 预算在规则评估前已用完时保持上一次的模式
+        bool tracking_probe_due = (history_store.IsOpen() || track_sessions) &&
+                                  timestamp_ms - last_window_probe_ms >= kTrackingWindowProbeIntervalMs;
+        std::optional<LightMode> decided_mode = DecideTick(tick_prober, rule_engine, tick_budget, system_state,
+                                                           eager_probes, has_mode_overrides || tracking_probe_due);
+        LightMode current_light_mode = decided_mode.value_or(last_light_mode);
+        record.skipped_probes = static_cast<uint8_t>(system_state.pending_probes);
+        if (decided_mode.has_value()) {
+            for (size_t i = 0; i < static_cast<size_t>(StateProbe::COUNT); i++) {
+                if ((system_state.pending_probes & ProbeBit(static_cast<StateProbe>(i))) != 0) {
+                    METRICS_COUNT(MetricCounter::PROBES_SKIPPED);
+                }
+            }
+            winning_rule = rule_engine.GetLastWinningRule();
+        }
+        const std::optional<WindowInfo>& window_info_opt = tick_prober.GetWindowInfo();
+        HistoryReason history_reason = winning_rule >= 0 ? HistoryReason::RULE : HistoryReason::DEFAULT_MODE;
+        
+        // 决策追踪：记录命中的规则及更高优先级规则未满足的条件
+        std::string decision_reason;
+        if (!decided_mode.has_value()) {
+            if (rule_engine.IsTraceEnabled()) {
+                decision_reason = "超出tick预算，保持上一次的灯光模式";
+            }
+        } else if (const DecisionTrace* trace = rule_engine.GetLastTrace()) {
+            decision_reason = rule_engine.SummarizeDecision(*trace);
+        }
+        
+        // 取出外部指令；学习用户为前台应用强制的灯光模式（临时覆盖不学习）。
+        // 在该应用上清除覆盖时同时忘记学到的模式，否则清除后学到的模式会立即再次生效
+        ExternalCommand last_command;
+        if (command_manager.ApplyPendingCommands(&last_command) > 0 &&
+            last_command.action != ExternalCommandAction::TIMED_OVERRIDE) {
+            if (!window_info_opt.has_value()) {
+                // 惰性采样时本tick可能还没有采样前台窗口
+                tick_prober.Probe(StateProbe::APP_CATEGORY, system_state);
+                system_state.pending_probes &= ~ProbeBit(StateProbe::APP_CATEGORY);
+                record.skipped_probes = static_cast<uint8_t>(system_state.pending_probes);
+            }
+            if (window_info_opt.has_value()) {
+                if (last_command.action == ExternalCommandAction::FORCE_MODE) {
+                    learned_store.RecordModeOverride(window_info_opt->process_name, last_command.mode);
+                    has_mode_overrides = true;
+                } else if (learned_store.ClearModeOverride(window_info_opt->process_name)) {
+                    has_mode_overrides = learned_store.CountModeOverrides() > 0;
+                }
+            }
+        }
+        
+        // 用户为当前应用指定过灯光模式时，以用户的选择为准
+        if (window_info_opt.has_value()) {
+            std::optional<LightMode> mode_override =
+                learned_store.LookupModeOverride(window_info_opt->process_name);
+            if (mode_override.has_value()) {
+                current_light_mode = mode_override.value();
+                history_reason = HistoryReason::APP_OVERRIDE;
+                if (rule_engine.IsTraceEnabled()) {
+                    decision_reason = "用户为该应用指定的灯光模式";
+                }
+            }
+        }
+        
+        // 手动覆盖（热键、伴侣程序、脚本）优先于所有自动决策
+        std::optional<LightMode> manual_override = command_manager.GetActiveOverride();
+        if (manual_override.has_value()) {
+            current_light_mode = manual_override.value();
+            history_reason = HistoryReason::MANUAL_OVERRIDE;
+            if (rule_engine.IsTraceEnabled()) {
+                decision_reason = "手动覆盖";
+            }
+        }
+        record.light_mode = current_light_mode;
+        light_renderer.SetMode(current_light_mode);
+        StateLogger::CopyText(record.decision_reason, sizeof(record.decision_reason), decision_reason);
+        
+        // 检测模式变化
+        METRICS_TIMER_BEGIN(output_begin);
+        if (has_last_mode && last_light_mode != current_light_mode) {
+            state_logger.LogModeChange(timestamp_ms, last_light_mode, current_light_mode, decision_reason);
+            METRICS_COUNT(MetricCounter::MODE_CHANGES);
+        }
+        record.budget_fallbacks = tick_budget.GetTickFallbacks();
+        state_logger.LogTick(record);
+        if (state_publisher.IsOpen()) {
+            state_publisher.Publish(MakePublishedState(record, system_state, history_reason, winning_rule,
+                                                       !decided_mode.has_value(),
+                                                       latest_frame_color.load(std::memory_order_relaxed)));
+        }
+        // 历史与会话不在每个tick强制采样前台窗口：本tick规则没有用到（未采样）时沿用最近一次采样到的
+        // 前台进程和类别，最多滞后kTrackingWindowProbeIntervalMs
+        if ((history_store.IsOpen() || track_sessions) &&
+            (system_state.pending_probes & ProbeBit(StateProbe::APP_CATEGORY)) == 0) {
+            last_known_process = window_info_opt.has_value() ? window_info_opt->process_name : std::string();
+            last_known_category = record.category;
+            last_window_probe_ms = timestamp_ms;
+        }
+        if (history_store.IsOpen()) {
+            HistoryRecord history_record = {};
+            history_record.timestamp = timestamp_ms / 1000;
+            history_record.category = last_known_category;
+            history_record.mode = current_light_mode;
+            history_record.reason = history_reason;
+            history_record.rule_index = winning_rule >= 0 ? static_cast<uint32_t>(winning_rule) : 0;
+            bool written = history_store.Append(history_record, last_known_process);
+            if (!written && !history_write_failed) {
+                std::cerr << "警告: 无法写入历史记录: " << history_dir << std::endl;
+            }
+            history_write_failed = !written;
+        }
+        if (track_sessions) {
+            session_aggregator.Update(timestamp_ms / 1000, local_day, last_known_process, last_known_category,
+                                      current_light_mode);
+            if (timestamp_ms - last_snapshot_ms >= kSessionSnapshotIntervalMs) {
+                // 预算已用完时推迟到下一个tick（写文件可能很慢）
+                if (tick_budget.IsExhausted()) {
+                    tick_budget.RecordFallback(BudgetFallback::DEFERRED_SNAPSHOT);
+                } else {
+                    session_aggregator.SaveSnapshot(session_snapshot_file);
+                    last_snapshot_ms = timestamp_ms;
+                }
+            }
+        }
+        METRICS_TIMER_END(output_begin, MetricStage::OUTPUT);
+        
+        // 更新上一次的模式
+        last_light_mode = current_light_mode;
+        has_last_mode = true;
+        
+        METRICS_COUNT(MetricCounter::TICKS);
+        METRICS_TIMER_END(tick_begin, MetricStage::TICK);
+        tick_budget.EndTick();
+        
+        // 等待到下一个tick；收到外部指令时立即唤醒，临时覆盖到期时也按时唤醒
+        int wait_ms = interval_ms;
+        int64_t until_expiry_ms = command_manager.GetMillisecondsUntilExpiry();
+        if (until_expiry_ms >= 0 && until_expiry_ms < wait_ms) {
+            wait_ms = static_cast<int>(until_expiry_ms) + 1;
+        }
+        command_manager.WaitForCommand(wait_ms);
+    }
+    
+    frame_pacer.Stop();
+    state_publisher.Close();
+    command_manager.StopListening();
+    history_store.Close();
+    if (track_sessions && !session_aggregator.SaveSnapshot(session_snapshot_file)) {
+        std::cerr << "警告: 无法保存今日使用统计: " << session_snapshot_file << std::endl;
+    }
+    state_logger.Stop();
+    metrics_exporter.Stop();
+    
+    if (debug_mode) {
+        RuleEvaluationStats evaluation_stats = rule_engine.GetEvaluationStats();
+        if (evaluation_stats.decisions > 0) {
+            std::cout << "规则评估: " << evaluation_stats.decisions << " 次决策，平均每次评估 "
+                      << static_cast<double>(evaluation_stats.predicates_evaluated) / evaluation_stats.decisions
+                      << " 个条件，条件顺序调整 " << evaluation_stats.reorders << " 次" << std::endl;
+            
+            // 惰性采样跳过的探测（换算为每小时）
+            double hours = std::chrono::duration<double>(std::chrono::steady_clock::now() - monitor_start).count() / 3600.0;
+            std::cout << "跳过的采样（每小时）:";
+            for (size_t i = 0; i < static_cast<size_t>(StateProbe::COUNT); i++) {
+                double per_hour = hours > 0.0 ? static_cast<double>(evaluation_stats.probes_skipped[i]) / hours : 0.0;
+                std::cout << " " << RuleEngine::GetProbeName(static_cast<StateProbe>(i)) << " " << per_hour;
+            }
+            std::cout << std::endl;
+        }
+        
+        // 超过时限而使用了上一次值的采样
+        std::cout << "采样超时:";
+        for (size_t i = 0; i < static_cast<size_t>(StateProbe::COUNT); i++) {
+            StateProbe probe = static_cast<StateProbe>(i);
+            std::cout << " " << RuleEngine::GetProbeName(probe) << " " << tick_prober.GetTimeoutCount(probe);
+        }
+        std::cout << std::endl;
+        if (tick_budget.IsEnabled()) {
+            PrintTickBudgetStats(tick_budget);
+        }
+        if (frame_options.frames_per_second > 0.0) {
+            PrintFramePacingStats(frame_pacer, frame_options.frames_per_second);
+        }
+        
+        const DailyUsage& usage = session_aggregator.GetDailyUsage();
+        if (track_sessions && usage.day != 0) {
+            std::cout << "今日使用（" << usage.session_count << " 个会话）:";
+            for (size_t i = 0; i < usage.category_seconds.size(); i++) {
+                if (usage.category_seconds[i] > 0) {
+                    std::cout << " " << AppClassifier::GetCategoryName(static_cast<AppCategory>(i)) << " "
+                              << FormatDuration(usage.category_seconds[i]);
+                }
+            }
+            std::cout << std::endl;
+        }
+    }
+    
+    if (learned_store.IsDirty() && !learned_store.Save(learned_store_file)) {
+        std::cerr << "警告: 无法保存学习记录: " << learned_store_file << std::endl;
     }
     
     std::cout << std::endl << "程序已退出" << std::endl;
@@ -0,0 +1,251 @@
+#include "metrics.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+/**
+ * 最高有效位的位置（value必须非0）
+ */
+int HighestBit(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+const double kQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+}  // namespace
+
+LatencyHistogram::LatencyHistogram() : count_(0), sum_(0), max_(0) {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+int LatencyHistogram::BucketIndex(uint64_t value) {
+    if (value < static_cast<uint64_t>(kSubBucketCount)) {
+        return static_cast<int>(value);
+    }
+    int shift = HighestBit(value) - kSubBucketBits;
+    if (shift > kMaxShift) {
+        return kBucketCount - 1;
+    }
+    int mantissa = static_cast<int>(value >> shift);   // [16, 32)
+    return (shift + 1) * kSubBucketCount + (mantissa - kSubBucketCount);
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(int index) {
+    if (index < kSubBucketCount) {
+        return static_cast<uint64_t>(index);
+    }
+    int shift = index / kSubBucketCount - 1;
+    uint64_t mantissa = static_cast<uint64_t>(kSubBucketCount + index % kSubBucketCount);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t value_ns) {
+    buckets_[BucketIndex(value_ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value_ns, std::memory_order_relaxed);
+
+    uint64_t current_max = max_.load(std::memory_order_relaxed);
+    while (value_ns > current_max &&
+           !max_.compare_exchange_weak(current_max, value_ns, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::ValueAtQuantile(double quantile) const {
+    uint64_t total = 0;
+    for (const auto& bucket : buckets_) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t target = static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(total)));
+    if (target == 0) {
+        target = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketCount; i++) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            // 桶上界可能超过实际最大值，取二者较小者
+            uint64_t upper = BucketUpperBound(i);
+            uint64_t max_value = Max();
+            return upper < max_value ? upper : max_value;
+        }
+    }
+    return Max();
+}
+
+MetricsRegistry& MetricsRegistry::Instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::MetricsRegistry() {
+    for (auto& counter : counters_) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+const char* MetricsRegistry::GetStageName(MetricStage stage) {
+    switch (stage) {
+        case MetricStage::TICK:
+            return "tick";
+        case MetricStage::WINDOW_PROBE:
+            return "window_probe";
+        case MetricStage::PROCESS_RESOLVE:
+            return "process_resolve";
+        case MetricStage::CLASSIFY:
+            return "classify";
+        case MetricStage::SYSTEM_PROBE:
+            return "system_probe";
+        case MetricStage::AUDIO_PROBE:
+            return "audio_probe";
+        case MetricStage::RULE_EVAL:
+            return "rule_eval";
+        case MetricStage::OUTPUT:
+            return "output";
+        case MetricStage::COMMAND_LATENCY:
+            return "command_latency";
+        case MetricStage::FRAME_JITTER:
+            return "frame_jitter";
+        default:
+            return "unknown";
+    }
+}
+
+const char* MetricsRegistry::GetCounterName(MetricCounter counter) {
+    switch (counter) {
+        case MetricCounter::TICKS:
+            return "app_ticks_total";
+        case MetricCounter::MODE_CHANGES:
+            return "app_mode_changes_total";
+        case MetricCounter::PROCESS_TREE_SCANS:
+            return "app_process_tree_scans_total";
+        case MetricCounter::PROBES_SKIPPED:
+            return "app_probes_skipped_total";
+        case MetricCounter::PROBE_TIMEOUTS:
+            return "app_probe_timeouts_total";
+        case MetricCounter::BUDGET_FALLBACKS:
+            return "app_tick_budget_fallbacks_total";
+        case MetricCounter::BUDGET_OVERRUNS:
+            return "app_tick_budget_overruns_total";
+        case MetricCounter::FRAME_DEADLINES_MISSED:
+            return "app_frame_deadlines_missed_total";
+        default:
+            return "app_unknown_total";
+    }
+}
+
+std::string MetricsRegistry::RenderPrometheus() const {
+    std::ostringstream oss;
+    oss << std::setprecision(9);
+
+    oss << "# HELP app_stage_latency_seconds Per-stage latency of the monitoring loop.\n";
+    oss << "# TYPE app_stage_latency_seconds summary\n";
+    for (size_t i = 0; i < histograms_.size(); i++) {
+        const LatencyHistogram& histogram = histograms_[i];
+        const char* stage = GetStageName(static_cast<MetricStage>(i));
+        for (double quantile : kQuantiles) {
+            oss << "app_stage_latency_seconds{stage=\"" << stage << "\",quantile=\"" << quantile << "\"} "
+                << static_cast<double>(histogram.ValueAtQuantile(quantile)) / 1e9 << "\n";
+        }
+        oss << "app_stage_latency_seconds_sum{stage=\"" << stage << "\"} "
+            << static_cast<double>(histogram.Sum()) / 1e9 << "\n";
+        oss << "app_stage_latency_seconds_count{stage=\"" << stage << "\"} " << histogram.Count() << "\n";
+    }
+
+    oss << "# HELP app_stage_latency_max_seconds Maximum observed per-stage latency.\n";
+    oss << "# TYPE app_stage_latency_max_seconds gauge\n";
+    for (size_t i = 0; i < histograms_.size(); i++) {
+        oss << "app_stage_latency_max_seconds{stage=\"" << GetStageName(static_cast<MetricStage>(i)) << "\"} "
+            << static_cast<double>(histograms_[i].Max()) / 1e9 << "\n";
+    }
+
+    for (size_t i = 0; i < counters_.size(); i++) {
+        const char* name = GetCounterName(static_cast<MetricCounter>(i));
+        oss << "# TYPE " << name << " counter\n";
+        oss << name << " " << counters_[i].load(std::memory_order_relaxed) << "\n";
+    }
+    return oss.str();
+}
+
+MetricsExporter::MetricsExporter() : interval_ms_(5000), running_(false) {
+}
+
+MetricsExporter::~MetricsExporter() {
+    Stop();
+}
+
+void MetricsExporter::Start(const std::string& file_path, int interval_ms) {
+    if (running_.exchange(true)) {
+        return;
+    }
+    file_path_ = file_path;
+    interval_ms_ = interval_ms > 0 ? interval_ms : 5000;
+    thread_ = std::thread(&MetricsExporter::ExportLoop, this);
+}
+
+void MetricsExporter::Stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    WriteOnce();
+}
+
+bool MetricsExporter::WriteOnce() const {
+    std::string temp_path = file_path_ + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << MetricsRegistry::Instance().RenderPrometheus();
+        if (!file.good()) {
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    return MoveFileExA(temp_path.c_str(), file_path_.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(temp_path.c_str(), file_path_.c_str()) == 0;
+#endif
+}
+
+void MetricsExporter::ExportLoop() {
+    // 以较短的步长睡眠，保证Stop能及时返回
+    const int step_ms = 100;
+    int waited_ms = 0;
+    while (running_.load(std::memory_order_acquire)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(step_ms));
+        waited_ms += step_ms;
+        if (waited_ms >= interval_ms_) {
+            WriteOnce();
+            waited_ms = 0;
+        }
+    }
+}
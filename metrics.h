@@ -0,0 +1,199 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <thread>
+
+/**
+ * 被计时的阶段
+ */
+enum class MetricStage {
+    TICK,               // 整个tick
+    WINDOW_PROBE,       // 前台窗口探测（包含进程解析）
+    PROCESS_RESOLVE,    // 进程名/路径解析
+    CLASSIFY,           // 应用分类
+    SYSTEM_PROBE,       // CPU/空闲时间采样
+    AUDIO_PROBE,        // 音频活动探测
+    RULE_EVAL,          // 规则评估
+    OUTPUT,             // 输出（日志提交等）
+    COMMAND_LATENCY,    // 外部指令从入队到被主循环应用的延迟
+    FRAME_JITTER,       // 输出线程醒来的时间与帧计划时间之差
+    COUNT
+};
+
+/**
+ * 计数器
+ */
+enum class MetricCounter {
+    TICKS,                  // tick次数
+    MODE_CHANGES,           // 灯光模式变化次数
+    PROCESS_TREE_SCANS,     // 进程表扫描次数
+    PROBES_SKIPPED,         // 惰性采样中因更高优先级规则已命中而跳过的采样次数
+    PROBE_TIMEOUTS,         // 超过时限而使用上一次值的采样次数
+    BUDGET_FALLBACKS,       // 超出tick预算而改走降级路径的次数
+    BUDGET_OVERRUNS,        // 总耗时超过tick预算的tick数
+    FRAME_DEADLINES_MISSED, // 输出线程跳过的帧数
+    COUNT
+};
+
+/**
+ * HDR风格的延迟直方图（对数-线性分桶）
+ * 每个2的幂区间再线性细分为16个子桶，相对误差不超过1/16，
+ * 覆盖1ns到约36分钟，记录只需一次原子自增，不分配内存。
+ */
+class LatencyHistogram {
+public:
+    static const int kSubBucketBits = 4;
+    static const int kSubBucketCount = 1 << kSubBucketBits;
+    static const int kMaxShift = 37;
+    static const int kBucketCount = (kMaxShift + 2) * kSubBucketCount;
+
+    LatencyHistogram();
+
+    /**
+     * 记录一个样本
+     * @param value_ns 延迟（纳秒）
+     */
+    void Record(uint64_t value_ns);
+
+    /**
+     * 计算分位数（近似值，取所在桶的上界）
+     * @param quantile 分位数 (0-1)
+     * @return 延迟（纳秒），无样本时返回0
+     */
+    uint64_t ValueAtQuantile(double quantile) const;
+
+    uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t Sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t Max() const { return max_.load(std::memory_order_relaxed); }
+
+    static int BucketIndex(uint64_t value);
+    static uint64_t BucketUpperBound(int index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_;
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+};
+
+/**
+ * 指标注册表（进程内唯一）
+ */
+class MetricsRegistry {
+public:
+    static MetricsRegistry& Instance();
+
+    void Record(MetricStage stage, uint64_t value_ns) {
+        histograms_[static_cast<size_t>(stage)].Record(value_ns);
+    }
+
+    void Increment(MetricCounter counter, uint64_t delta = 1) {
+        counters_[static_cast<size_t>(counter)].fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    const LatencyHistogram& GetHistogram(MetricStage stage) const {
+        return histograms_[static_cast<size_t>(stage)];
+    }
+
+    uint64_t GetCounter(MetricCounter counter) const {
+        return counters_[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * 以Prometheus文本格式导出所有指标
+     */
+    std::string RenderPrometheus() const;
+
+    static const char* GetStageName(MetricStage stage);
+    static const char* GetCounterName(MetricCounter counter);
+
+private:
+    MetricsRegistry();
+
+    std::array<LatencyHistogram, static_cast<size_t>(MetricStage::COUNT)> histograms_;
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(MetricCounter::COUNT)> counters_;
+};
+
+/**
+ * 作用域计时器：析构时把经过的时间记录到对应阶段
+ */
+class ScopedStageTimer {
+public:
+    explicit ScopedStageTimer(MetricStage stage)
+        : stage_(stage), begin_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedStageTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - begin_;
+        MetricsRegistry::Instance().Record(
+            stage_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    MetricStage stage_;
+    std::chrono::steady_clock::time_point begin_;
+};
+
+/**
+ * 指标导出器
+ * 后台线程定期把Prometheus文本写入文件（先写临时文件再替换，读取方不会看到半个文件）
+ */
+class MetricsExporter {
+public:
+    MetricsExporter();
+    ~MetricsExporter();
+
+    /**
+     * 启动导出线程
+     * @param file_path 输出文件路径
+     * @param interval_ms 刷新间隔（毫秒）
+     */
+    void Start(const std::string& file_path, int interval_ms = 5000);
+
+    /**
+     * 停止导出线程（停止前会再写一次）
+     */
+    void Stop();
+
+    /**
+     * 立即写一次指标文件
+     * @return 是否写入成功
+     */
+    bool WriteOnce() const;
+
+private:
+    std::string file_path_;
+    int interval_ms_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+    void ExportLoop();
+};
+
+// 编译期开关：未定义 APP_METRICS_ENABLED 时所有埋点展开为空语句，不产生任何开销
+#ifdef APP_METRICS_ENABLED
+#define METRICS_CONCAT_INNER(a, b) a##b
+#define METRICS_CONCAT(a, b) METRICS_CONCAT_INNER(a, b)
+#define METRICS_SCOPE(stage) ScopedStageTimer METRICS_CONCAT(metrics_scope_, __LINE__)(stage)
+#define METRICS_COUNT(counter) MetricsRegistry::Instance().Increment(counter)
+#define METRICS_COUNT_BY(counter, delta) MetricsRegistry::Instance().Increment(counter, delta)
+#define METRICS_RECORD(stage, value_ns) MetricsRegistry::Instance().Record(stage, value_ns)
+#define METRICS_TIMER_BEGIN(name) const auto name = std::chrono::steady_clock::now()
+#define METRICS_TIMER_END(name, stage) \
+    MetricsRegistry::Instance().Record(stage, static_cast<uint64_t>( \
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - (name)).count()))
+#else
+#define METRICS_SCOPE(stage) ((void)0)
+#define METRICS_COUNT(counter) ((void)0)
+#define METRICS_COUNT_BY(counter, delta) ((void)0)
+#define METRICS_RECORD(stage, value_ns) ((void)0)
+#define METRICS_TIMER_BEGIN(name) ((void)0)
+#define METRICS_TIMER_END(name, stage) ((void)0)
+#endif
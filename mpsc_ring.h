@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+/**
+ * 多生产者/单消费者无锁环形队列
+ * 容量固定（必须为2的幂），每个槽位带一个序号：生产者用CAS领取写入位置，
+ * 写完后发布槽位序号；消费者只读自己的下标，按序号判断槽位是否已写入。
+ * 入队是lock-free的（只在与其他生产者竞争时重试），出队是wait-free的，不会分配内存。
+ * @tparam T 元素类型（必须可平凡复制）
+ * @tparam Capacity 容量（2的幂）
+ */
+template <typename T, size_t Capacity>
+class MpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity必须是2的幂");
+    static_assert(std::is_trivially_copyable<T>::value, "元素必须可平凡复制");
+
+public:
+    MpscRing() : head_(0), tail_(0) {
+        for (size_t i = 0; i < Capacity; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * 入队（任意线程调用）
+     * @return 队列已满时返回false，元素被丢弃
+     */
+    bool TryPush(const T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[tail & (Capacity - 1)];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (sequence == tail) {
+                // 槽位空闲，尝试领取
+                if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                    cell.value = item;
+                    cell.sequence.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (sequence < tail) {
+                return false;   // 消费者尚未取走上一轮的元素，队列已满
+            } else {
+                tail = tail_.load(std::memory_order_relaxed);  // 被其他生产者抢先，重新读取
+            }
+        }
+    }
+
+    /**
+     * 出队（仅消费者线程调用）
+     * @return 队列为空（或下一个槽位仍在写入中）时返回false
+     */
+    bool TryPop(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[head & (Capacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != head + 1) {
+            return false;
+        }
+        item = cell.value;
+        // 槽位在下一轮（head + Capacity）重新可写
+        cell.sequence.store(head + Capacity, std::memory_order_release);
+        head_.store(head + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    // 消费者和生产者的下标放在不同缓存行，避免伪共享
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+    alignas(64) Cell cells_[Capacity];
+};
@@ -0,0 +1,336 @@
+#include "palette_extractor.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PALETTE_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PALETTE_SSE2 1
+#endif
+
+namespace {
+
+// 主色切换的滞后：另一种颜色的权重超过当前主色这么多时才切换
+const float kDominantHysteresis = 0.1f;
+
+/**
+ * 一次分配的结果：各中心的像素和与像素数，以及离自己中心最远的像素（用于重新播种空的中心）
+ */
+struct Assignment {
+    std::array<double, PaletteExtractor::kMaxPaletteSize> sum_r;
+    std::array<double, PaletteExtractor::kMaxPaletteSize> sum_g;
+    std::array<double, PaletteExtractor::kMaxPaletteSize> sum_b;
+    std::array<uint32_t, PaletteExtractor::kMaxPaletteSize> count;
+    size_t farthest;
+    float farthest_distance;
+};
+
+inline void Accumulate(Assignment& out, size_t i, size_t label, float distance,
+                       const float* r, const float* g, const float* b) {
+    out.sum_r[label] += r[i];
+    out.sum_g[label] += g[i];
+    out.sum_b[label] += b[i];
+    out.count[label]++;
+    if (distance > out.farthest_distance) {
+        out.farthest_distance = distance;
+        out.farthest = i;
+    }
+}
+
+/**
+ * 把每个像素分配给最近的中心（距离相同时取序号小的中心，各实现结果一致）
+ */
+void AssignSamples(const float* r, const float* g, const float* b, size_t n,
+                   const float* cr, const float* cg, const float* cb, size_t k, Assignment& out) {
+    out.sum_r.fill(0.0);
+    out.sum_g.fill(0.0);
+    out.sum_b.fill(0.0);
+    out.count.fill(0);
+    out.farthest = 0;
+    out.farthest_distance = -1.0f;
+    size_t i = 0;
+
+#ifdef PALETTE_AVX2
+    alignas(32) float labels8[8];
+    alignas(32) float distances8[8];
+    for (; i + 8 <= n; i += 8) {
+        __m256 pr = _mm256_loadu_ps(r + i);
+        __m256 pg = _mm256_loadu_ps(g + i);
+        __m256 pb = _mm256_loadu_ps(b + i);
+        __m256 best = _mm256_set1_ps(FLT_MAX);
+        __m256 best_label = _mm256_setzero_ps();
+        for (size_t c = 0; c < k; c++) {
+            __m256 dr = _mm256_sub_ps(pr, _mm256_set1_ps(cr[c]));
+            __m256 dg = _mm256_sub_ps(pg, _mm256_set1_ps(cg[c]));
+            __m256 db = _mm256_sub_ps(pb, _mm256_set1_ps(cb[c]));
+            __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dr, dr), _mm256_mul_ps(dg, dg)), _mm256_mul_ps(db, db));
+            __m256 less = _mm256_cmp_ps(d, best, _CMP_LT_OQ);
+            best = _mm256_min_ps(d, best);
+            best_label = _mm256_blendv_ps(best_label, _mm256_set1_ps(static_cast<float>(c)), less);
+        }
+        _mm256_store_ps(labels8, best_label);
+        _mm256_store_ps(distances8, best);
+        for (size_t j = 0; j < 8; j++) {
+            Accumulate(out, i + j, static_cast<size_t>(labels8[j]), distances8[j], r, g, b);
+        }
+    }
+#endif
+#ifdef PALETTE_SSE2
+    alignas(16) float labels4[4];
+    alignas(16) float distances4[4];
+    for (; i + 4 <= n; i += 4) {
+        __m128 pr = _mm_loadu_ps(r + i);
+        __m128 pg = _mm_loadu_ps(g + i);
+        __m128 pb = _mm_loadu_ps(b + i);
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128 best_label = _mm_setzero_ps();
+        for (size_t c = 0; c < k; c++) {
+            __m128 dr = _mm_sub_ps(pr, _mm_set1_ps(cr[c]));
+            __m128 dg = _mm_sub_ps(pg, _mm_set1_ps(cg[c]));
+            __m128 db = _mm_sub_ps(pb, _mm_set1_ps(cb[c]));
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+            __m128 less = _mm_cmplt_ps(d, best);
+            best = _mm_min_ps(d, best);
+            // SSE2没有blendv，用与/与非选择
+            best_label = _mm_or_ps(_mm_and_ps(less, _mm_set1_ps(static_cast<float>(c))),
+                                   _mm_andnot_ps(less, best_label));
+        }
+        _mm_store_ps(labels4, best_label);
+        _mm_store_ps(distances4, best);
+        for (size_t j = 0; j < 4; j++) {
+            Accumulate(out, i + j, static_cast<size_t>(labels4[j]), distances4[j], r, g, b);
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        float best = FLT_MAX;
+        size_t best_label = 0;
+        for (size_t c = 0; c < k; c++) {
+            float dr = r[i] - cr[c];
+            float dg = g[i] - cg[c];
+            float db = b[i] - cb[c];
+            float d = dr * dr + dg * dg + db * db;
+            if (d < best) {
+                best = d;
+                best_label = c;
+            }
+        }
+        Accumulate(out, i, best_label, best, r, g, b);
+    }
+}
+
+uint8_t ToChannel(float value) {
+    return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 255.0f)));
+}
+
+}  // namespace
+
+PaletteExtractor::PaletteExtractor(const PaletteOptions& options)
+    : options_(options), r_(), g_(), b_(), center_r_(), center_g_(), center_b_(), has_centers_(false),
+      palette_(), smoothed_r_(), smoothed_g_(), smoothed_b_(), dominant_(0), last_iterations_(0) {
+    options_.palette_size = std::clamp<size_t>(options_.palette_size, 1, kMaxPaletteSize);
+    options_.max_samples = std::max<size_t>(options_.max_samples, options_.palette_size);
+    options_.max_iterations = std::max(options_.max_iterations, 1);
+    options_.cold_iterations = std::max(options_.cold_iterations, 1);
+    options_.smoothing = std::clamp(options_.smoothing, 0.0f, 1.0f);
+    r_.reserve(options_.max_samples);
+    g_.reserve(options_.max_samples);
+    b_.reserve(options_.max_samples);
+}
+
+void PaletteExtractor::Reset() {
+    has_centers_ = false;
+    palette_.clear();
+    dominant_ = 0;
+    last_iterations_ = 0;
+}
+
+LightColor PaletteExtractor::GetDominantColor() const {
+    if (palette_.empty()) {
+        return {0, 0, 0};
+    }
+    return palette_[dominant_].color;
+}
+
+const std::vector<PaletteEntry>& PaletteExtractor::Update(const FrameView& frame) {
+    Sample(frame);
+    if (r_.empty()) {
+        return palette_;
+    }
+    bool warm = options_.warm_start && has_centers_;
+    if (!warm) {
+        SeedCenters();
+    }
+    std::array<uint32_t, kMaxPaletteSize> counts{};
+    last_iterations_ = RunKMeans(warm ? options_.max_iterations : options_.cold_iterations, counts);
+    has_centers_ = true;
+    UpdatePalette(counts);
+    return palette_;
+}
+
+void PaletteExtractor::Sample(const FrameView& frame) {
+    r_.clear();
+    g_.clear();
+    b_.clear();
+    if (frame.data == nullptr || frame.width <= 0 || frame.height <= 0) {
+        return;
+    }
+    size_t pixels = static_cast<size_t>(frame.width) * static_cast<size_t>(frame.height);
+    size_t step = 1;
+    while (pixels / (step * step) > options_.max_samples) {
+        step++;
+    }
+    size_t bytes_per_pixel = frame.format == PixelFormat::BGRA32 ? 4 : 3;
+    size_t red = frame.format == PixelFormat::BGRA32 ? 2 : 0;
+    size_t blue = frame.format == PixelFormat::BGRA32 ? 0 : 2;
+
+    for (int pass = 0; pass < 2; pass++) {
+        // 第二遍不过滤暗像素（整个画面都很暗时仍然输出调色板）
+        int min_luma = pass == 0 ? options_.min_luma : 0;
+        for (size_t y = step / 2; y < static_cast<size_t>(frame.height); y += step) {
+            const uint8_t* row = frame.data + y * frame.stride;
+            for (size_t x = step / 2; x < static_cast<size_t>(frame.width); x += step) {
+                const uint8_t* pixel = row + x * bytes_per_pixel;
+                int pr = pixel[red];
+                int pg = pixel[1];
+                int pb = pixel[blue];
+                if ((77 * pr + 150 * pg + 29 * pb) >> 8 < min_luma) {
+                    continue;
+                }
+                r_.push_back(static_cast<float>(pr));
+                g_.push_back(static_cast<float>(pg));
+                b_.push_back(static_cast<float>(pb));
+            }
+        }
+        if (r_.size() >= options_.palette_size || min_luma == 0) {
+            break;
+        }
+        r_.clear();
+        g_.clear();
+        b_.clear();
+    }
+}
+
+void PaletteExtractor::SeedCenters() {
+    const size_t n = r_.size();
+    const size_t k = options_.palette_size;
+    double mean_r = 0.0;
+    double mean_g = 0.0;
+    double mean_b = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        mean_r += r_[i];
+        mean_g += g_[i];
+        mean_b += b_[i];
+    }
+    float ref_r = static_cast<float>(mean_r / n);
+    float ref_g = static_cast<float>(mean_g / n);
+    float ref_b = static_cast<float>(mean_b / n);
+
+    // 每个像素到已选中心的最近距离；第一个中心取离均值最远的像素，之后每次取离已选中心最远的像素
+    std::vector<float> nearest(n, FLT_MAX);
+    for (size_t c = 0; c < k; c++) {
+        size_t farthest = 0;
+        float farthest_distance = -1.0f;
+        for (size_t i = 0; i < n; i++) {
+            float dr = r_[i] - ref_r;
+            float dg = g_[i] - ref_g;
+            float db = b_[i] - ref_b;
+            nearest[i] = std::min(nearest[i], dr * dr + dg * dg + db * db);
+            if (nearest[i] > farthest_distance) {
+                farthest_distance = nearest[i];
+                farthest = i;
+            }
+        }
+        center_r_[c] = ref_r = r_[farthest];
+        center_g_[c] = ref_g = g_[farthest];
+        center_b_[c] = ref_b = b_[farthest];
+        if (c == 0) {
+            // 均值只用于选第一个中心
+            std::fill(nearest.begin(), nearest.end(), FLT_MAX);
+        }
+    }
+}
+
+int PaletteExtractor::RunKMeans(int max_iterations, std::array<uint32_t, kMaxPaletteSize>& counts) {
+    const size_t k = options_.palette_size;
+    const float convergence_squared = options_.convergence * options_.convergence;
+    Assignment assignment;
+    int iteration = 0;
+    while (iteration < max_iterations) {
+        iteration++;
+        AssignSamples(r_.data(), g_.data(), b_.data(), r_.size(),
+                      center_r_.data(), center_g_.data(), center_b_.data(), k, assignment);
+        float max_move = 0.0f;
+        bool reseeded = false;
+        for (size_t c = 0; c < k; c++) {
+            float new_r;
+            float new_g;
+            float new_b;
+            if (assignment.count[c] > 0) {
+                new_r = static_cast<float>(assignment.sum_r[c] / assignment.count[c]);
+                new_g = static_cast<float>(assignment.sum_g[c] / assignment.count[c]);
+                new_b = static_cast<float>(assignment.sum_b[c] / assignment.count[c]);
+            } else if (!reseeded && assignment.farthest_distance > 0.0f) {
+                // 空的中心改用离自己中心最远的像素（每次迭代只重新播种一个，避免多个中心落在同一像素上）
+                new_r = r_[assignment.farthest];
+                new_g = g_[assignment.farthest];
+                new_b = b_[assignment.farthest];
+                reseeded = true;
+            } else {
+                continue;
+            }
+            float dr = new_r - center_r_[c];
+            float dg = new_g - center_g_[c];
+            float db = new_b - center_b_[c];
+            max_move = std::max(max_move, dr * dr + dg * dg + db * db);
+            center_r_[c] = new_r;
+            center_g_[c] = new_g;
+            center_b_[c] = new_b;
+        }
+        counts = assignment.count;
+        if (max_move < convergence_squared) {
+            break;
+        }
+    }
+    return iteration;
+}
+
+void PaletteExtractor::UpdatePalette(const std::array<uint32_t, kMaxPaletteSize>& counts) {
+    const size_t k = options_.palette_size;
+    uint32_t total = 0;
+    for (size_t c = 0; c < k; c++) {
+        total += counts[c];
+    }
+    bool first = palette_.empty();
+    if (first) {
+        palette_.resize(k);
+    }
+    // 第一帧直接采用结果，之后按smoothing向新结果靠近
+    float alpha = first ? 1.0f : options_.smoothing;
+    size_t heaviest = 0;
+    for (size_t c = 0; c < k; c++) {
+        float weight = total > 0 ? static_cast<float>(counts[c]) / static_cast<float>(total) : 0.0f;
+        if (first) {
+            smoothed_r_[c] = center_r_[c];
+            smoothed_g_[c] = center_g_[c];
+            smoothed_b_[c] = center_b_[c];
+            palette_[c].weight = weight;
+        } else {
+            smoothed_r_[c] += alpha * (center_r_[c] - smoothed_r_[c]);
+            smoothed_g_[c] += alpha * (center_g_[c] - smoothed_g_[c]);
+            smoothed_b_[c] += alpha * (center_b_[c] - smoothed_b_[c]);
+            palette_[c].weight += alpha * (weight - palette_[c].weight);
+        }
+        palette_[c].color = {ToChannel(smoothed_r_[c]), ToChannel(smoothed_g_[c]), ToChannel(smoothed_b_[c])};
+        if (palette_[c].weight > palette_[heaviest].weight) {
+            heaviest = c;
+        }
+    }
+    if (first || palette_[heaviest].weight > palette_[dominant_].weight + kDominantHysteresis) {
+        dominant_ = heaviest;
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "light_effect.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * 画面帧的像素格式
+ */
+enum class PixelFormat {
+    RGB24,      // 每像素3字节 R,G,B（PPM等）
+    BGRA32      // 每像素4字节 B,G,R,A（Windows屏幕采集）
+};
+
+/**
+ * 一帧（已缩小的）画面，不持有像素数据
+ */
+struct FrameView {
+    const uint8_t* data;
+    int width;
+    int height;
+    size_t stride;          // 每行字节数
+    PixelFormat format;
+};
+
+/**
+ * 主色提取的参数
+ */
+struct PaletteOptions {
+    size_t palette_size = 5;        // 调色板颜色数（1-8）
+    size_t max_samples = 4096;      // 每帧最多取的像素数（超过时按网格间隔取样）
+    int max_iterations = 3;         // 每帧最多的k-means迭代次数
+    int cold_iterations = 10;       // 没有上一帧调色板（或关闭热启动）时的最多迭代次数
+    float convergence = 1.0f;       // 所有中心的移动都小于该距离（0-255色阶）时提前结束
+    float smoothing = 0.2f;         // 输出调色板每帧向新结果靠近的比例（1表示不平滑）
+    int min_luma = 16;              // 亮度低于该值的像素（黑边、暗场）不参与聚类
+    bool warm_start = true;         // 用上一帧的调色板作为初始中心
+};
+
+/**
+ * 调色板中的一种颜色
+ */
+struct PaletteEntry {
+    LightColor color;
+    float weight;           // 该颜色覆盖的像素比例（平滑后）
+};
+
+/**
+ * 视频画面的主色调色板（供VIDEO_CINEMATIC的整屋氛围光使用）
+ *
+ * 每帧对取样像素做增量k-means：以上一帧的中心作为初始中心（热启动），
+ * 画面连续时一两次迭代即可收敛，各颜色的序号在帧间保持对应；
+ * 第一帧用最远点法选初始中心。像素到各中心的距离用SIMD批量计算（SSE2每次4个像素，
+ * 编译时启用AVX2则每次8个）。没有像素归入的中心改用离自己中心最远的像素重新播种。
+ * 输出调色板按smoothing做指数平滑，主色切换带有滞后，避免灯光随画面闪烁。
+ *
+ * 不是线程安全的：只应在画面采集线程中调用。
+ */
+class PaletteExtractor {
+public:
+    static constexpr size_t kMaxPaletteSize = 8;
+
+    explicit PaletteExtractor(const PaletteOptions& options = PaletteOptions());
+
+    /**
+     * 处理一帧画面
+     * @return 更新后的（平滑）调色板
+     */
+    const std::vector<PaletteEntry>& Update(const FrameView& frame);
+
+    const std::vector<PaletteEntry>& GetPalette() const { return palette_; }
+
+    /**
+     * 主色（权重最大的颜色，切换带滞后）；还没有处理过画面时为黑色
+     */
+    LightColor GetDominantColor() const;
+    size_t GetDominantIndex() const { return dominant_; }
+
+    /**
+     * 上一帧的k-means迭代次数
+     */
+    int GetLastIterations() const { return last_iterations_; }
+
+    /**
+     * 丢弃上一帧的调色板（如切换视频源）
+     */
+    void Reset();
+
+private:
+    PaletteOptions options_;
+
+    // 取样像素（结构数组，便于SIMD）
+    std::vector<float> r_;
+    std::vector<float> g_;
+    std::vector<float> b_;
+
+    // k-means中心（未平滑）
+    std::array<float, kMaxPaletteSize> center_r_;
+    std::array<float, kMaxPaletteSize> center_g_;
+    std::array<float, kMaxPaletteSize> center_b_;
+    bool has_centers_;
+
+    std::vector<PaletteEntry> palette_;
+    std::array<float, kMaxPaletteSize> smoothed_r_;     // 平滑后的颜色（浮点，避免取整误差累积）
+    std::array<float, kMaxPaletteSize> smoothed_g_;
+    std::array<float, kMaxPaletteSize> smoothed_b_;
+    size_t dominant_;
+    int last_iterations_;
+
+    /**
+     * 按网格间隔取样，跳过过暗的像素（剩余像素太少时保留全部）
+     */
+    void Sample(const FrameView& frame);
+
+    /**
+     * 最远点法选初始中心
+     */
+    void SeedCenters();
+
+    /**
+     * 迭代k-means
+     * @param counts 输出各中心最后一次分配到的像素数
+     * @return 迭代次数
+     */
+    int RunKMeans(int max_iterations, std::array<uint32_t, kMaxPaletteSize>& counts);
+
+    /**
+     * 平滑输出调色板并更新主色
+     */
+    void UpdatePalette(const std::array<uint32_t, kMaxPaletteSize>& counts);
+};
@@ -0,0 +1,193 @@
+#include "path_prefix_trie.h"
+#include "app_classifier.h"
+#include "case_fold.h"
+
+namespace {
+
+bool IsSeparator(char c) {
+    return c == '\\' || c == '/';
+}
+
+}  // namespace
+
+PathPrefixTrie::PathPrefixTrie() : size_(0), has_relative_(false) {
+    Clear();
+}
+
+void PathPrefixTrie::Clear() {
+    component_ids_.clear();
+    component_names_.clear();
+    labels_.clear();
+    children_.clear();
+    nodes_.clear();
+    // 两个根：绝对前缀和相对前缀
+    nodes_.push_back({0, 0, -1});
+    nodes_.push_back({0, 0, -1});
+    size_ = 0;
+    has_relative_ = false;
+}
+
+bool PathPrefixTrie::SplitPath(std::string_view folded_path, std::vector<std::string_view>& components) {
+    components.clear();
+    std::string_view rest = folded_path;
+
+    // Win32设备路径前缀 "\\?\"、"\\.\"，以及其后的 "UNC\"
+    if (rest.size() >= 4 && IsSeparator(rest[0]) && IsSeparator(rest[1]) &&
+        (rest[2] == '?' || rest[2] == '.') && IsSeparator(rest[3])) {
+        rest.remove_prefix(4);
+        if (rest.size() >= 4 && rest.substr(0, 3) == "unc" && IsSeparator(rest[3])) {
+            rest.remove_prefix(4);
+        }
+        SplitPath(rest, components);
+        return true;
+    }
+
+    bool absolute = (!rest.empty() && IsSeparator(rest[0])) || (rest.size() >= 2 && rest[1] == ':');
+    size_t begin = 0;
+    while (begin <= rest.size()) {
+        size_t end = begin;
+        while (end < rest.size() && !IsSeparator(rest[end])) {
+            end++;
+        }
+        std::string_view component = rest.substr(begin, end - begin);
+        if (component == "..") {
+            if (!components.empty()) {
+                components.pop_back();
+            }
+        } else if (!component.empty() && component != ".") {
+            components.push_back(component);
+        }
+        begin = end + 1;
+    }
+    return absolute;
+}
+
+bool PathPrefixTrie::Insert(std::string_view prefix, AppCategory category) {
+    std::string folded = FoldCase(prefix);
+    std::vector<std::string_view> components;
+    bool absolute = SplitPath(folded, components);
+    if (components.empty()) {
+        return false;
+    }
+
+    // 组成部分编号（新出现的组成部分复制一份，作为哈希表的键）
+    std::vector<uint32_t> ids;
+    ids.reserve(components.size());
+    for (std::string_view component : components) {
+        auto it = component_ids_.find(component);
+        if (it == component_ids_.end()) {
+            component_names_.emplace_back(component);
+            it = component_ids_.emplace(component_names_.back(), static_cast<uint32_t>(component_ids_.size())).first;
+        }
+        ids.push_back(it->second);
+    }
+
+    uint32_t node = absolute ? 0 : 1;
+    size_t i = 0;
+    while (i < ids.size()) {
+        auto it = children_.find(ChildKey(node, ids[i]));
+        if (it == children_.end()) {
+            // 没有以该组成部分开头的边：剩余的组成部分整体作为一条新边
+            uint32_t leaf = static_cast<uint32_t>(nodes_.size());
+            nodes_.push_back({static_cast<uint32_t>(labels_.size()), static_cast<uint32_t>(ids.size() - i), -1});
+            labels_.insert(labels_.end(), ids.begin() + static_cast<std::ptrdiff_t>(i), ids.end());
+            children_.emplace(ChildKey(node, ids[i]), leaf);
+            node = leaf;
+            break;
+        }
+
+        uint32_t child = it->second;
+        uint32_t label_begin = nodes_[child].label_begin;
+        uint32_t label_length = nodes_[child].label_length;
+        uint32_t matched = 1;
+        while (matched < label_length && i + matched < ids.size() &&
+               labels_[label_begin + matched] == ids[i + matched]) {
+            matched++;
+        }
+        if (matched < label_length) {
+            // 在边的中间分叉：插入一个持有已匹配部分的中间节点，原节点保留剩余部分（及其子节点）
+            uint32_t middle = static_cast<uint32_t>(nodes_.size());
+            nodes_.push_back({label_begin, matched, -1});
+            it->second = middle;
+            nodes_[child].label_begin = label_begin + matched;
+            nodes_[child].label_length = label_length - matched;
+            children_.emplace(ChildKey(middle, labels_[label_begin + matched]), child);
+            child = middle;
+        }
+        node = child;
+        i += matched;
+    }
+
+    if (nodes_[node].category < 0) {
+        size_++;
+    }
+    nodes_[node].category = static_cast<int32_t>(category);
+    if (!absolute) {
+        has_relative_ = true;
+    }
+    return true;
+}
+
+void PathPrefixTrie::Walk(uint32_t root, const std::vector<uint32_t>& components, size_t begin,
+                          size_t& best_end, int32_t& best_category) const {
+    uint32_t node = root;
+    size_t i = begin;
+    while (i < components.size()) {
+        // 路径中出现过未配置的组成部分时不会再有匹配
+        if (components[i] == kNoComponent) {
+            return;
+        }
+        auto it = children_.find(ChildKey(node, components[i]));
+        if (it == children_.end()) {
+            return;
+        }
+        const Node& child = nodes_[it->second];
+        if (i + child.label_length > components.size()) {
+            return;
+        }
+        for (uint32_t k = 1; k < child.label_length; k++) {
+            if (labels_[child.label_begin + k] != components[i + k]) {
+                return;
+            }
+        }
+        i += child.label_length;
+        node = it->second;
+        if (child.category >= 0 && i > best_end) {
+            best_end = i;
+            best_category = child.category;
+        }
+    }
+}
+
+std::optional<AppCategory> PathPrefixTrie::Find(std::string_view path) const {
+    if (size_ == 0 || path.empty()) {
+        return std::nullopt;
+    }
+
+    std::string folded = FoldCase(path);
+    std::vector<std::string_view> names;
+    bool absolute = SplitPath(folded, names);
+
+    // 每个组成部分只哈希一次，之后沿树向下走只比较编号
+    std::vector<uint32_t> components;
+    components.reserve(names.size());
+    for (std::string_view name : names) {
+        auto it = component_ids_.find(name);
+        components.push_back(it != component_ids_.end() ? it->second : kNoComponent);
+    }
+
+    size_t best_end = 0;
+    int32_t best_category = -1;
+    if (absolute) {
+        Walk(0, components, 0, best_end, best_category);
+    }
+    if (has_relative_) {
+        for (size_t begin = 0; begin < components.size(); begin++) {
+            Walk(1, components, begin, best_end, best_category);
+        }
+    }
+    if (best_category < 0) {
+        return std::nullopt;
+    }
+    return static_cast<AppCategory>(best_category);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+enum class AppCategory;
+
+/**
+ * 可执行文件路径前缀到应用类别的映射（按安装目录分类，如Steam游戏库、JetBrains安装目录）
+ *
+ * 路径先规范化为目录组成部分的序列：'\\' 与 '/' 都作为分隔符，大小写折叠（见case_fold.h），
+ * 去掉空组成部分和 "."，".." 回退一级，去掉 "\\?\" 与 "\\?\UNC\" 前缀。
+ * 前缀按组成部分匹配，"C:\Games" 匹配 "C:\Games\a.exe"，不匹配 "C:\GamesOld\a.exe"。
+ *
+ * 前缀分两种：
+ * - 绝对前缀（以盘符或分隔符开头，如 "C:\Program Files\JetBrains\"）只从路径开头匹配
+ * - 相对前缀（如 "steamapps/common/"）可以从路径中任意一级目录开始匹配
+ * 多个前缀都匹配时，匹配结束位置最深（最具体）的优先；深度相同时绝对前缀优先。
+ *
+ * 前缀编译为按组成部分压缩的基数树：组成部分在插入时编号，没有分叉的连续组成部分合并到同一条边上，
+ * 子节点按 (父节点, 组成部分编号) 在一张哈希表中查找。查找时每个组成部分只哈希一次，
+ * 绝对前缀的查找为O(路径长度)，与配置的前缀数量无关；相对前缀从每一级目录开始各走一次树，
+ * 代价不超过 组成部分数 x 最长前缀的级数。
+ *
+ * 构建后只读：Find可以在多个线程中同时调用，Insert/Clear期间不得查找。
+ */
+class PathPrefixTrie {
+public:
+    PathPrefixTrie();
+
+    /**
+     * 添加前缀（相同前缀再次添加时覆盖类别）
+     * @param prefix 目录前缀（绝对或相对，见类说明）
+     * @param category 应用类别
+     * @return 规范化后为空（如 "\" 或 "."）时返回false
+     */
+    bool Insert(std::string_view prefix, AppCategory category);
+
+    /**
+     * 查找路径所在的（最深的）已配置目录的类别
+     * @param path 可执行文件的完整路径
+     * @return 类别，没有前缀匹配时返回std::nullopt
+     */
+    std::optional<AppCategory> Find(std::string_view path) const;
+
+    void Clear();
+
+    /**
+     * 已配置的前缀数
+     */
+    size_t Size() const { return size_; }
+
+    bool Empty() const { return size_ == 0; }
+
+private:
+    static constexpr uint32_t kNoComponent = 0xFFFFFFFFu;
+
+    /**
+     * 树节点：从父节点到本节点的边上的组成部分为 labels_[label_begin, label_begin + label_length)
+     */
+    struct Node {
+        uint32_t label_begin;
+        uint32_t label_length;
+        int32_t category;       // 以本节点结尾的前缀的类别（-1表示不是前缀的结尾）
+    };
+
+    // 组成部分的编号（键指向component_names_中的字符串）
+    std::deque<std::string> component_names_;
+    std::unordered_map<std::string_view, uint32_t> component_ids_;
+
+    std::vector<uint32_t> labels_;
+    std::vector<Node> nodes_;                           // nodes_[0]为绝对前缀的根，nodes_[1]为相对前缀的根
+    std::unordered_map<uint64_t, uint32_t> children_;   // (父节点 << 32 | 边上第一个组成部分) -> 子节点
+    size_t size_;
+    bool has_relative_;                                 // 是否配置了相对前缀（没有时查找不必逐级重走）
+
+    /**
+     * 规范化已折叠大小写的路径
+     * @param components 输出组成部分（指向folded_path）
+     * @return 路径是否为绝对路径
+     */
+    static bool SplitPath(std::string_view folded_path, std::vector<std::string_view>& components);
+
+    /**
+     * 从root开始沿components[begin, ...)向下走，记录经过的最深的前缀结尾
+     * @param best_end 输入为目前最深的匹配结束位置，找到更深的匹配时更新
+     * @param best_category 与best_end对应的类别
+     */
+    void Walk(uint32_t root, const std::vector<uint32_t>& components, size_t begin,
+              size_t& best_end, int32_t& best_category) const;
+
+    static uint64_t ChildKey(uint32_t parent, uint32_t component) {
+        return (static_cast<uint64_t>(parent) << 32) | component;
+    }
+};
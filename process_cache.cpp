@@ -0,0 +1,308 @@
+#include "process_cache.h"
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <tlhelp32.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#endif
+
+namespace {
+
+/**
+ * 从完整路径中提取文件名
+ */
+std::string BaseName(const std::string& path) {
+    size_t last_slash = path.find_last_of("\\/");
+    if (last_slash != std::string::npos) {
+        return path.substr(last_slash + 1);
+    }
+    return path;
+}
+
+#ifdef _WIN32
+std::string WideToUtf8(const wchar_t* wstr) {
+    if (wstr == nullptr || wstr[0] == L'\0') {
+        return "";
+    }
+
+    int size_needed = WideCharToMultiByte(CP_UTF8, 0, wstr, -1, NULL, 0, NULL, NULL);
+    if (size_needed <= 0) {
+        return "";
+    }
+
+    std::string result(size_needed, 0);
+    WideCharToMultiByte(CP_UTF8, 0, wstr, -1, &result[0], size_needed, NULL, NULL);
+
+    // 移除末尾的null字符
+    if (!result.empty() && result.back() == '\0') {
+        result.pop_back();
+    }
+    return result;
+}
+#else
+/**
+ * 通过已打开的stat文件描述符读取进程启动时间
+ * 原进程被回收后读取会失败，因此同时能检测pid复用
+ */
+bool ReadStat(int fd, std::string& comm, uint32_t& ppid, uint64_t& start_time) {
+    char buffer[1024];
+    ssize_t n = pread(fd, buffer, sizeof(buffer) - 1, 0);
+    if (n <= 0) {
+        return false;
+    }
+    buffer[n] = '\0';
+    return ParseProcStat(buffer, comm, ppid, start_time);
+}
+#endif
+
+}  // namespace
+
+#ifndef _WIN32
+// 格式: pid (comm) state ppid ... starttime(第22个字段) ...
+// comm中可能包含空格和括号，因此以最后一个')'为界
+bool ParseProcStat(const char* buffer, std::string& comm, uint32_t& ppid, uint64_t& start_time) {
+    const char* open = std::strchr(buffer, '(');
+    const char* close = std::strrchr(buffer, ')');
+    if (open == nullptr || close == nullptr || close < open) {
+        return false;
+    }
+    comm.assign(open + 1, close);
+
+    // ')'之后从第3个字段（state）开始
+    const char* p = close + 1;
+    for (int field = 3; field <= 22; field++) {
+        while (*p == ' ') {
+            p++;
+        }
+        if (*p == '\0') {
+            return false;
+        }
+        if (field == 4) {
+            ppid = static_cast<uint32_t>(std::strtoul(p, nullptr, 10));
+        } else if (field == 22) {
+            start_time = std::strtoull(p, nullptr, 10);
+            return true;
+        }
+        while (*p != ' ' && *p != '\0') {
+            p++;
+        }
+    }
+    return false;
+}
+
+#endif
+
+ProcessInfoCache::ProcessInfoCache(size_t capacity)
+    : capacity_(capacity > 0 ? capacity : 1), stats_{0, 0, 0, 0, 0} {
+}
+
+ProcessInfoCache::~ProcessInfoCache() {
+    Clear();
+}
+
+const ProcessInfo* ProcessInfoCache::Lookup(uint32_t pid) {
+    auto now = std::chrono::steady_clock::now();
+    auto it = entries_.find(pid);
+    if (it != entries_.end()) {
+        if (IsSameProcessAlive(it->second, now)) {
+            // 命中：移动到LRU头部
+            lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+            stats_.hits++;
+            return &it->second.info;
+        }
+        if (HasHandle(it->second.handle)) {
+            // 原进程已退出，该pid可能已被新进程复用
+            stats_.reused_pids++;
+        } else {
+            // 没有句柄的条目到期，重新解析
+            stats_.revalidations++;
+        }
+        Erase(it);
+    }
+
+    stats_.misses++;
+
+    Entry entry;
+    if (!Resolve(pid, entry.info, entry.handle)) {
+        return nullptr;
+    }
+    entry.expires_at = now + kUnpinnedEntryTtl;
+
+    // 超出容量时淘汰最近最少使用的条目
+    while (entries_.size() >= capacity_ && !lru_.empty()) {
+        Erase(entries_.find(lru_.back()));
+        stats_.evictions++;
+    }
+
+    lru_.push_front(pid);
+    entry.lru_it = lru_.begin();
+    auto inserted = entries_.emplace(pid, std::move(entry));
+    return &inserted.first->second.info;
+}
+
+size_t ProcessInfoCache::Prune() {
+    auto now = std::chrono::steady_clock::now();
+    size_t removed = 0;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        auto next = std::next(it);
+        if (!IsSameProcessAlive(it->second, now)) {
+            Erase(it);
+            removed++;
+        }
+        it = next;
+    }
+    return removed;
+}
+
+void ProcessInfoCache::Clear() {
+    for (auto& pair : entries_) {
+        CloseNativeHandle(pair.second.handle);
+    }
+    entries_.clear();
+    lru_.clear();
+}
+
+void ProcessInfoCache::Erase(std::unordered_map<uint32_t, Entry>::iterator it) {
+    if (it == entries_.end()) {
+        return;
+    }
+    CloseNativeHandle(it->second.handle);
+    lru_.erase(it->second.lru_it);
+    entries_.erase(it);
+}
+
+#ifdef _WIN32
+
+bool ProcessInfoCache::Resolve(uint32_t pid, ProcessInfo& info, NativeHandle& handle) {
+    info = ProcessInfo();
+    info.pid = pid;
+
+    // 只打开一次进程：持有句柄期间该pid不会被系统复用
+    handle = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, FALSE, pid);
+    if (handle == NULL) {
+        // 没有查询权限（提权进程、受反作弊保护的游戏）时，只用SYNCHRONIZE权限固定pid，
+        // 名称和父进程ID从快照获取，启动时间未知（保持为0）
+        handle = OpenProcess(SYNCHRONIZE, FALSE, pid);
+    } else {
+        FILETIME creation_time, exit_time, kernel_time, user_time;
+        if (GetProcessTimes(handle, &creation_time, &exit_time, &kernel_time, &user_time)) {
+            ULARGE_INTEGER start;
+            start.LowPart = creation_time.dwLowDateTime;
+            start.HighPart = creation_time.dwHighDateTime;
+            info.start_time = start.QuadPart;
+        }
+
+        wchar_t process_path[MAX_PATH] = {0};
+        DWORD size = MAX_PATH;
+        if (QueryFullProcessImageNameW(handle, 0, process_path, &size)) {
+            std::string path = WideToUtf8(process_path);
+            info.name = BaseName(path);
+            info.executable_path = path;
+        }
+    }
+
+    // 父进程ID只能从快照中获取；进程名获取失败时也从快照中补全
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (snapshot != INVALID_HANDLE_VALUE) {
+        PROCESSENTRY32W pe32;
+        pe32.dwSize = sizeof(PROCESSENTRY32W);
+
+        if (Process32FirstW(snapshot, &pe32)) {
+            do {
+                if (pe32.th32ProcessID == pid) {
+                    info.parent_pid = pe32.th32ParentProcessID;
+                    if (info.name.empty()) {
+                        info.name = WideToUtf8(pe32.szExeFile);
+                    }
+                    break;
+                }
+            } while (Process32NextW(snapshot, &pe32));
+        }
+        CloseHandle(snapshot);
+    }
+
+    if (info.name.empty()) {
+        if (handle != NULL) {
+            CloseHandle(handle);
+        }
+        handle = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool ProcessInfoCache::IsSameProcessAlive(const Entry& entry, std::chrono::steady_clock::time_point now) {
+    if (entry.handle == NULL) {
+        // 连SYNCHRONIZE句柄也无法打开时无法检测复用，只在有效期内沿用快照解析的结果
+        return now < entry.expires_at;
+    }
+    return WaitForSingleObject(entry.handle, 0) == WAIT_TIMEOUT;
+}
+
+bool ProcessInfoCache::HasHandle(NativeHandle handle) {
+    return handle != NULL;
+}
+
+void ProcessInfoCache::CloseNativeHandle(NativeHandle handle) {
+    if (handle != NULL) {
+        CloseHandle(handle);
+    }
+}
+
+#else
+
+bool ProcessInfoCache::Resolve(uint32_t pid, ProcessInfo& info, NativeHandle& handle) {
+    info = ProcessInfo();
+    info.pid = pid;
+
+    std::string proc_dir = "/proc/" + std::to_string(pid);
+    handle = open((proc_dir + "/stat").c_str(), O_RDONLY | O_CLOEXEC);
+    if (handle < 0) {
+        return false;
+    }
+
+    std::string comm;
+    if (!ReadStat(handle, comm, info.parent_pid, info.start_time)) {
+        close(handle);
+        handle = -1;
+        return false;
+    }
+
+    // /proc/<pid>/exe 可能因权限不足无法读取，此时退回到comm（最长15个字符）
+    char exe_path[PATH_MAX];
+    ssize_t n = readlink((proc_dir + "/exe").c_str(), exe_path, sizeof(exe_path) - 1);
+    if (n > 0) {
+        exe_path[n] = '\0';
+        info.executable_path = std::string(exe_path);
+        info.name = BaseName(exe_path);
+    } else {
+        info.name = comm;
+    }
+    return true;
+}
+
+bool ProcessInfoCache::IsSameProcessAlive(const Entry& entry, std::chrono::steady_clock::time_point) {
+    std::string comm;
+    uint32_t ppid = 0;
+    uint64_t start_time = 0;
+    if (!ReadStat(entry.handle, comm, ppid, start_time)) {
+        return false;
+    }
+    return start_time == entry.info.start_time;
+}
+
+bool ProcessInfoCache::HasHandle(NativeHandle handle) {
+    return handle >= 0;
+}
+
+void ProcessInfoCache::CloseNativeHandle(NativeHandle handle) {
+    if (handle >= 0) {
+        close(handle);
+    }
+}
+
+#endif
@@ -0,0 +1,135 @@
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <optional>
+#include <list>
+#include <unordered_map>
+
+/**
+ * 进程元数据
+ * 以 (pid, 进程启动时间) 作为进程身份，pid被系统复用时启动时间必然不同
+ */
+struct ProcessInfo {
+    uint32_t pid;                                 // 进程ID
+    uint64_t start_time;                          // 进程启动时间（Windows: FILETIME，Linux: 开机后的时钟滴答数）
+    uint32_t parent_pid;                          // 父进程ID（获取失败为0）
+    std::string name;                             // 可执行文件名
+    std::optional<std::string> executable_path;   // 可执行文件路径（可选）
+
+    ProcessInfo() : pid(0), start_time(0), parent_pid(0) {}
+};
+
+#ifndef _WIN32
+/**
+ * 解析 /proc/<pid>/stat 内容
+ * @param buffer 以'\0'结尾的stat文件内容
+ * @param comm 输出的进程名（comm字段，最长15个字符）
+ * @param ppid 输出的父进程ID
+ * @param start_time 输出的启动时间（开机后的时钟滴答数）
+ * @return 是否解析成功
+ */
+bool ParseProcStat(const char* buffer, std::string& comm, uint32_t& ppid, uint64_t& start_time);
+#endif
+
+/**
+ * 进程元数据缓存统计
+ */
+struct ProcessCacheStats {
+    uint64_t hits;          // 命中次数（无需任何进程查询）
+    uint64_t misses;        // 未命中次数（需要完整解析一次）
+    uint64_t reused_pids;   // 检测到pid被复用（旧进程已退出）的次数
+    uint64_t evictions;     // 因容量上限被淘汰的条目数
+    uint64_t revalidations; // 无法持有句柄的条目到期后重新解析的次数
+};
+
+/**
+ * 进程元数据缓存
+ * 每个进程生命周期内只解析一次名称、路径和父进程ID。
+ * 缓存条目持有进程句柄（Windows）或 /proc/<pid>/stat 文件描述符（Linux），
+ * 持有期间可以廉价地判断原进程是否仍然存活，从而识别pid复用。
+ * 无法打开进程的查询权限时（提权进程、受反作弊保护的游戏）退而只申请SYNCHRONIZE权限持有句柄；
+ * 连这也失败时，按快照解析出的条目缓存kUnpinnedEntryTtl后再重新解析，而不是每个tick都重新解析。
+ * 超出容量时按最近最少使用（LRU）淘汰。
+ */
+class ProcessInfoCache {
+public:
+    /**
+     * @param capacity 最多缓存的进程数
+     */
+    explicit ProcessInfoCache(size_t capacity = 128);
+    ~ProcessInfoCache();
+
+    ProcessInfoCache(const ProcessInfoCache&) = delete;
+    ProcessInfoCache& operator=(const ProcessInfoCache&) = delete;
+
+    /**
+     * 查询进程元数据，命中时不进行任何进程查询
+     * @param pid 进程ID
+     * @return 进程元数据指针（在下一次Lookup/Prune/Clear之前有效），解析失败返回nullptr
+     */
+    const ProcessInfo* Lookup(uint32_t pid);
+
+    /**
+     * 移除所有已退出进程的条目
+     * @return 移除的条目数
+     */
+    size_t Prune();
+
+    /**
+     * 清空缓存并释放所有句柄
+     */
+    void Clear();
+
+    size_t Size() const { return entries_.size(); }
+    size_t Capacity() const { return capacity_; }
+    const ProcessCacheStats& GetStats() const { return stats_; }
+
+private:
+#ifdef _WIN32
+    using NativeHandle = HANDLE;
+#else
+    using NativeHandle = int;
+#endif
+
+    // 没有存活检测句柄的条目的有效期（期间无法识别pid复用）
+    static constexpr std::chrono::seconds kUnpinnedEntryTtl{10};
+
+    struct Entry {
+        ProcessInfo info;
+        NativeHandle handle;   // 用于检测进程是否仍然存活（可能没有，见HasHandle）
+        std::chrono::steady_clock::time_point expires_at;   // 没有句柄时的有效期
+        std::list<uint32_t>::iterator lru_it;
+    };
+
+    size_t capacity_;
+    std::unordered_map<uint32_t, Entry> entries_;
+    std::list<uint32_t> lru_;   // 头部为最近使用
+    ProcessCacheStats stats_;
+
+    /**
+     * 完整解析进程元数据（每个进程生命周期只调用一次）
+     * @param pid 进程ID
+     * @param info 输出的进程元数据
+     * @param handle 输出的存活检测句柄
+     * @return 是否解析成功
+     */
+    static bool Resolve(uint32_t pid, ProcessInfo& info, NativeHandle& handle);
+
+    /**
+     * 检查缓存条目对应的原进程是否仍然存活（同一个 pid + 启动时间）
+     * 条目没有句柄时只检查是否仍在有效期内
+     */
+    static bool IsSameProcessAlive(const Entry& entry, std::chrono::steady_clock::time_point now);
+
+    static bool HasHandle(NativeHandle handle);
+
+    static void CloseNativeHandle(NativeHandle handle);
+
+    void Erase(std::unordered_map<uint32_t, Entry>::iterator it);
+};
@@ -0,0 +1,227 @@
+#include "process_tree.h"
+#include "process_cache.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <tlhelp32.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#endif
+
+ProcessTreeTracker::ProcessTreeTracker(const std::string& proc_root)
+    : proc_root_(proc_root), generation_(0), last_stats_{0, 0, 0, 0, 0.0} {
+}
+
+const ProcessNode* ProcessTreeTracker::Find(uint32_t pid) const {
+    auto it = nodes_.find(pid);
+    if (it == nodes_.end()) {
+        return nullptr;
+    }
+    return &it->second.node;
+}
+
+std::vector<std::string> ProcessTreeTracker::GetAncestorNames(uint32_t pid, size_t max_depth) const {
+    std::vector<std::string> ancestors;
+    auto it = nodes_.find(pid);
+    if (it == nodes_.end()) {
+        return ancestors;
+    }
+
+    const ProcessNode* child = &it->second.node;
+    while (ancestors.size() < max_depth) {
+        uint32_t parent_pid = child->parent_pid;
+        if (parent_pid == 0 || parent_pid == pid) {
+            break;
+        }
+        auto parent_it = nodes_.find(parent_pid);
+        if (parent_it == nodes_.end()) {
+            break;
+        }
+        const ProcessNode* parent = &parent_it->second.node;
+        // 父进程pid已被复用时，“父进程”会比子进程启动得更晚
+        if (parent->start_time != 0 && child->start_time != 0 &&
+            parent->start_time > child->start_time) {
+            break;
+        }
+        ancestors.push_back(parent->name);
+        child = parent;
+    }
+    return ancestors;
+}
+
+#ifdef _WIN32
+
+ProcessScanStats ProcessTreeTracker::Update() {
+    auto begin = std::chrono::steady_clock::now();
+    ProcessScanStats stats{0, 0, 0, 0, 0.0};
+    generation_++;
+
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) {
+        last_stats_ = stats;
+        return stats;
+    }
+
+    PROCESSENTRY32W pe32;
+    pe32.dwSize = sizeof(PROCESSENTRY32W);
+    if (Process32FirstW(snapshot, &pe32)) {
+        do {
+            uint32_t pid = pe32.th32ProcessID;
+            auto it = nodes_.find(pid);
+            // 快照不包含启动时间：父进程ID变化视为pid被复用
+            if (it != nodes_.end() && it->second.node.parent_pid == pe32.th32ParentProcessID) {
+                it->second.generation = generation_;
+                continue;
+            }
+
+            // 只有新进程才需要转换进程名
+            char name[MAX_PATH * 3] = {0};
+            WideCharToMultiByte(CP_UTF8, 0, pe32.szExeFile, -1, name, sizeof(name), NULL, NULL);
+
+            Entry entry;
+            entry.node.parent_pid = pe32.th32ParentProcessID;
+            entry.node.start_time = 0;
+            entry.node.name = name;
+            entry.identity = 0;
+            entry.generation = generation_;
+
+            if (it != nodes_.end()) {
+                it->second = std::move(entry);
+                stats.reused++;
+            } else {
+                nodes_.emplace(pid, std::move(entry));
+                stats.added++;
+            }
+        } while (Process32NextW(snapshot, &pe32));
+    }
+    CloseHandle(snapshot);
+
+    for (auto it = nodes_.begin(); it != nodes_.end();) {
+        if (it->second.generation != generation_) {
+            it = nodes_.erase(it);
+            stats.removed++;
+        } else {
+            ++it;
+        }
+    }
+
+    stats.total = nodes_.size();
+    stats.elapsed_us = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - begin).count();
+    last_stats_ = stats;
+    return stats;
+}
+
+bool ProcessTreeTracker::ReadProcess(uint32_t, ProcessNode&) const {
+    // Windows下所有信息都来自同一次快照，不需要单独读取
+    return false;
+}
+
+#else
+
+ProcessScanStats ProcessTreeTracker::Update() {
+    auto begin = std::chrono::steady_clock::now();
+    ProcessScanStats stats{0, 0, 0, 0, 0.0};
+    generation_++;
+
+    DIR* dir = opendir(proc_root_.c_str());
+    if (dir == nullptr) {
+        last_stats_ = stats;
+        return stats;
+    }
+
+    while (struct dirent* ent = readdir(dir)) {
+        // 只关心数字命名的进程目录
+        const char* p = ent->d_name;
+        if (*p < '0' || *p > '9') {
+            continue;
+        }
+        char* end = nullptr;
+        unsigned long value = std::strtoul(p, &end, 10);
+        if (end == nullptr || *end != '\0') {
+            continue;
+        }
+        uint32_t pid = static_cast<uint32_t>(value);
+
+        // /proc/<pid> 目录在进程退出时被销毁，复用同一pid的新进程会得到新的inode号，
+        // 因此比较 d_ino 即可在不读取任何文件的情况下识别pid复用
+        uint64_t identity = static_cast<uint64_t>(ent->d_ino);
+        auto it = nodes_.find(pid);
+        if (it != nodes_.end() && it->second.identity == identity) {
+            it->second.generation = generation_;
+            continue;
+        }
+
+        Entry entry;
+        if (!ReadProcess(pid, entry.node)) {
+            // 读取期间进程已退出
+            continue;
+        }
+        entry.identity = identity;
+        entry.generation = generation_;
+
+        if (it != nodes_.end()) {
+            it->second = std::move(entry);
+            stats.reused++;
+        } else {
+            nodes_.emplace(pid, std::move(entry));
+            stats.added++;
+        }
+    }
+    closedir(dir);
+
+    for (auto it = nodes_.begin(); it != nodes_.end();) {
+        if (it->second.generation != generation_) {
+            it = nodes_.erase(it);
+            stats.removed++;
+        } else {
+            ++it;
+        }
+    }
+
+    stats.total = nodes_.size();
+    stats.elapsed_us = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - begin).count();
+    last_stats_ = stats;
+    return stats;
+}
+
+bool ProcessTreeTracker::ReadProcess(uint32_t pid, ProcessNode& node) const {
+    std::string proc_dir = proc_root_ + "/" + std::to_string(pid);
+
+    int fd = open((proc_dir + "/stat").c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    char buffer[1024];
+    ssize_t n = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (n <= 0) {
+        return false;
+    }
+    buffer[n] = '\0';
+
+    std::string comm;
+    if (!ParseProcStat(buffer, comm, node.parent_pid, node.start_time)) {
+        return false;
+    }
+    node.name = comm;
+
+    // comm最长15个字符，能读取 exe 链接时使用完整的文件名
+    char exe_path[PATH_MAX];
+    ssize_t len = readlink((proc_dir + "/exe").c_str(), exe_path, sizeof(exe_path) - 1);
+    if (len > 0) {
+        exe_path[len] = '\0';
+        const char* slash = std::strrchr(exe_path, '/');
+        node.name = slash != nullptr ? slash + 1 : exe_path;
+    }
+    return true;
+}
+
+#endif
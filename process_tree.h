@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * 进程表中的单个节点
+ */
+struct ProcessNode {
+    uint32_t parent_pid;    // 父进程ID
+    uint64_t start_time;    // 进程启动时间（Windows快照不提供，为0）
+    std::string name;       // 可执行文件名
+};
+
+/**
+ * 一次扫描的统计信息
+ */
+struct ProcessScanStats {
+    size_t total;           // 扫描后进程总数
+    size_t added;           // 新出现的进程数（需要读取详细信息）
+    size_t removed;         // 已退出的进程数
+    size_t reused;          // 检测到pid被复用的进程数
+    double elapsed_us;      // 本次扫描耗时（微秒）
+};
+
+/**
+ * 进程表跟踪器
+ * 在内存中维护 pid -> (ppid, 名称, 启动时间) 的进程树，
+ * 每次扫描只与上一次结果做差分：已知进程不再读取详细信息，
+ * 只有新出现或pid被复用的进程才会被解析。
+ * 用于把游戏启动器、IDE等祖先进程的类别继承给子进程。
+ */
+class ProcessTreeTracker {
+public:
+    /**
+     * @param proc_root Linux下 proc 文件系统的根目录（可指向伪造的目录树用于测试）
+     */
+    explicit ProcessTreeTracker(const std::string& proc_root = "/proc");
+
+    /**
+     * 增量扫描进程表
+     * @return 本次扫描的统计信息
+     */
+    ProcessScanStats Update();
+
+    /**
+     * 查找进程节点
+     * @param pid 进程ID
+     * @return 节点指针（在下一次Update之前有效），不存在返回nullptr
+     */
+    const ProcessNode* Find(uint32_t pid) const;
+
+    /**
+     * 获取祖先进程名（从父进程开始，由近及远）
+     * 通过启动时间校验和深度限制避免pid复用造成的错误链路和环
+     * @param pid 进程ID
+     * @param max_depth 最多向上查找的层数
+     * @return 祖先进程名列表
+     */
+    std::vector<std::string> GetAncestorNames(uint32_t pid, size_t max_depth = 8) const;
+
+    size_t Size() const { return nodes_.size(); }
+    const ProcessScanStats& GetLastScanStats() const { return last_stats_; }
+
+private:
+    struct Entry {
+        ProcessNode node;
+        uint64_t identity;      // 廉价的身份标记（Linux: /proc/<pid> 目录的inode号）
+        uint64_t generation;    // 最近一次在扫描中出现的代数
+    };
+
+    std::string proc_root_;
+    std::unordered_map<uint32_t, Entry> nodes_;
+    uint64_t generation_;
+    ProcessScanStats last_stats_;
+
+    /**
+     * 读取单个进程的详细信息（只在进程首次出现时调用）
+     */
+    bool ReadProcess(uint32_t pid, ProcessNode& node) const;
+};
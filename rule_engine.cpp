@@ -1,105 +1,754 @@
 #include "rule_engine.h"
+#include "metrics.h"
 #include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
 
-RuleEngine::RuleEngine() {
+namespace {
+
+// 窗口条件允许的最长窗口（1天）
+const double kMaxWindowSeconds = 86400.0;
+
+// 尚未计时的条件按该耗时估计（纳秒）
+const double kDefaultConditionCostNs = 20.0;
+
+// 新顺序的期望耗时至少降低该比例才调整（计时有噪声，避免顺序来回抖动）
+const double kReorderMinGain = 0.1;
+
+}  // namespace
+
+RuleEngine::RuleEngine()
+    : last_winning_rule_(-1), trace_enabled_(false), trace_sequence_(0), adaptive_ordering_(true), evaluation_stats_(),
+      windows_active_(false), cpu_window_seconds_(0), audio_window_seconds_(0),
+      category_window_active_(false), has_window_category_(false),
+      window_category_(AppCategory::UNKNOWN), window_category_since_(0.0), window_now_(0.0) {
     // 可以添加一些默认规则
 }
 
 void RuleEngine::AddRule(const Rule& rule) {
-    rules_.push_back(rule);
-    // 按优先级排序（优先级高的在前，便于查找）
-    std::sort(rules_.begin(), rules_.end(), 
-        [](const Rule& a, const Rule& b) {
-            return a.priority > b.priority;
+    // 插入到优先级不低于它的最后一条规则之后（优先级高的在前，便于查找）
+    auto position = std::upper_bound(rules_.begin(), rules_.end(), rule.priority,
+        [](int priority, const StoredRule& stored) {
+            return priority > stored.priority;
         });
+    
+    // 条件追加到存储末尾，规则只记录区间，插入规则不需要移动已有的条件
+    StoredRule stored = AppendRule(rule);
+    rules_.insert(position, stored);
+    for (size_t i = 0; i < rule.conditions.size(); i++) {
+        condition_order_.push_back(static_cast<uint32_t>(i));
+    }
+    condition_stats_.resize(conditions_.size(), ConditionStats());
+    
+    // 规则索引已变化，旧的追踪记录不再有意义
+    trace_sequence_ = 0;
+    
+    // 只有需要更长的窗口时才重新分配
+    size_t cpu_seconds = cpu_window_seconds_;
+    size_t audio_seconds = audio_window_seconds_;
+    ScanWindowConditions(stored.first_condition, stored.condition_count);
+    if (cpu_window_seconds_ != cpu_seconds) {
+        cpu_window_.Allocate(cpu_window_seconds_);
+    }
+    if (audio_window_seconds_ != audio_seconds) {
+        audio_window_.Allocate(audio_window_seconds_);
+    }
+}
+
+void RuleEngine::LoadRules(const std::vector<Rule>& rules) {
+    // 按优先级稳定排序的下标，规则本身不移动
+    std::vector<uint32_t> sorted(rules.size());
+    for (size_t i = 0; i < sorted.size(); i++) {
+        sorted[i] = static_cast<uint32_t>(i);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [&rules](uint32_t a, uint32_t b) {
+        return rules[a].priority > rules[b].priority;
+    });
+    
+    size_t condition_count = 0;
+    for (const auto& rule : rules) {
+        condition_count += rule.conditions.size();
+    }
+    
+    rules_.clear();
+    conditions_.clear();
+    rules_.reserve(rules.size());
+    conditions_.reserve(condition_count);
+    for (uint32_t index : sorted) {
+        rules_.push_back(AppendRule(rules[index]));
+    }
+    
+    trace_sequence_ = 0;
+    ResetConditionOrder();
+    AllocateWindows();
 }
 
 void RuleEngine::ClearRules() {
     rules_.clear();
+    conditions_.clear();
+    trace_sequence_ = 0;
+    ResetConditionOrder();
+    AllocateWindows();
+}
+
+std::vector<Rule> RuleEngine::GetRules() const {
+    std::vector<Rule> rules(rules_.size());
+    for (size_t i = 0; i < rules_.size(); i++) {
+        const StoredRule& stored = rules_[i];
+        rules[i].target_mode = stored.target_mode;
+        rules[i].priority = stored.priority;
+        rules[i].conditions.reserve(stored.condition_count);
+        for (uint32_t k = 0; k < stored.condition_count; k++) {
+            rules[i].conditions.push_back(UnpackCondition(conditions_[stored.first_condition + k]));
+        }
+    }
+    return rules;
+}
+
+RuleEngine::StoredRule RuleEngine::AppendRule(const Rule& rule) {
+    StoredRule stored;
+    stored.first_condition = static_cast<uint32_t>(conditions_.size());
+    stored.condition_count = static_cast<uint32_t>(rule.conditions.size());
+    stored.target_mode = rule.target_mode;
+    stored.priority = rule.priority;
+    for (const auto& condition : rule.conditions) {
+        conditions_.push_back(PackCondition(condition));
+    }
+    return stored;
+}
+
+RuleEngine::StoredCondition RuleEngine::PackCondition(const Condition& condition) {
+    StoredCondition stored = {};
+    stored.type = condition.type;
+    stored.threshold = 0.0;
+    stored.window_seconds = condition.window_seconds.has_value()
+                                ? condition.window_seconds.value()
+                                : std::numeric_limits<double>::quiet_NaN();
+    switch (condition.type) {
+        case ConditionType::APP_CATEGORY:
+        case ConditionType::APP_CATEGORY_SUSTAINED:
+            stored.valid = condition.app_category.has_value();
+            if (stored.valid) {
+                stored.value = static_cast<uint8_t>(condition.app_category.value());
+            }
+            break;
+        case ConditionType::TIME_RANGE:
+            stored.valid = condition.time_range.has_value();
+            if (stored.valid) {
+                const TimeRange& range = condition.time_range.value();
+                stored.weekday_type = static_cast<uint8_t>(range.weekday_type);
+                stored.start_minute = static_cast<uint16_t>(range.start_hour * 60 + range.start_minute);
+                stored.end_minute = static_cast<uint16_t>(range.end_hour * 60 + range.end_minute);
+            }
+            break;
+        case ConditionType::CPU_THRESHOLD:
+        case ConditionType::CPU_AVERAGE:
+            stored.valid = condition.cpu_threshold.has_value();
+            if (stored.valid) {
+                stored.threshold = condition.cpu_threshold.value();
+                stored.greater = condition.cpu_greater_than;
+            }
+            break;
+        case ConditionType::IDLE_THRESHOLD:
+            stored.valid = condition.idle_threshold.has_value();
+            if (stored.valid) {
+                stored.threshold = condition.idle_threshold.value();
+                stored.greater = condition.idle_greater_than;
+            }
+            break;
+        case ConditionType::AUDIO_ACTIVITY:
+            stored.valid = condition.audio_activity.has_value();
+            if (stored.valid) {
+                stored.value = condition.audio_activity.value() ? 1 : 0;
+            }
+            break;
+        case ConditionType::CPU_TEMPERATURE:
+        case ConditionType::GPU_TEMPERATURE:
+            stored.valid = condition.temperature_threshold.has_value();
+            if (stored.valid) {
+                stored.threshold = condition.temperature_threshold.value();
+                stored.greater = condition.temperature_greater_than;
+            }
+            break;
+        case ConditionType::AUDIO_RATIO:
+            stored.valid = condition.audio_ratio.has_value();
+            if (stored.valid) {
+                stored.threshold = condition.audio_ratio.value();
+            }
+            break;
+        case ConditionType::CATEGORY_USAGE_TODAY:
+            stored.valid = condition.app_category.has_value() && condition.usage_minutes.has_value();
+            if (stored.valid) {
+                stored.value = static_cast<uint8_t>(condition.app_category.value());
+                stored.threshold = condition.usage_minutes.value() * 60.0;  // 存为秒
+            }
+            break;
+        default:
+            stored.valid = false;
+            break;
+    }
+    stored.window = static_cast<uint32_t>(GetWindowSeconds(condition));
+    return stored;
+}
+
+Condition RuleEngine::UnpackCondition(const StoredCondition& stored) {
+    Condition condition;
+    condition.type = stored.type;
+    if (!std::isnan(stored.window_seconds)) {
+        condition.window_seconds = stored.window_seconds;
+    }
+    if (!stored.valid) {
+        return condition;
+    }
+    switch (stored.type) {
+        case ConditionType::APP_CATEGORY:
+        case ConditionType::APP_CATEGORY_SUSTAINED:
+            condition.app_category = static_cast<AppCategory>(stored.value);
+            break;
+        case ConditionType::TIME_RANGE:
+            condition.time_range = TimeRange(stored.start_minute / 60, stored.start_minute % 60,
+                                             stored.end_minute / 60, stored.end_minute % 60,
+                                             static_cast<WeekdayType>(stored.weekday_type));
+            break;
+        case ConditionType::CPU_THRESHOLD:
+        case ConditionType::CPU_AVERAGE:
+            condition.cpu_threshold = stored.threshold;
+            condition.cpu_greater_than = stored.greater;
+            break;
+        case ConditionType::IDLE_THRESHOLD:
+            condition.idle_threshold = stored.threshold;
+            condition.idle_greater_than = stored.greater;
+            break;
+        case ConditionType::AUDIO_ACTIVITY:
+            condition.audio_activity = stored.value != 0;
+            break;
+        case ConditionType::CPU_TEMPERATURE:
+        case ConditionType::GPU_TEMPERATURE:
+            condition.temperature_threshold = stored.threshold;
+            condition.temperature_greater_than = stored.greater;
+            break;
+        case ConditionType::AUDIO_RATIO:
+            condition.audio_ratio = stored.threshold;
+            break;
+        case ConditionType::CATEGORY_USAGE_TODAY:
+            condition.app_category = static_cast<AppCategory>(stored.value);
+            condition.usage_minutes = stored.threshold / 60.0;
+            break;
+        default:
+            break;
+    }
+    return condition;
+}
+
+void RuleEngine::ResetConditionOrder() {
+    condition_order_.assign(conditions_.size(), 0);
+    for (const auto& rule : rules_) {
+        for (uint32_t i = 0; i < rule.condition_count; i++) {
+            condition_order_[rule.first_condition + i] = static_cast<uint32_t>(i);
+        }
+    }
+    condition_stats_.assign(conditions_.size(), ConditionStats());
+}
+
+void RuleEngine::SetAdaptiveOrdering(bool enabled) {
+    adaptive_ordering_ = enabled;
+    if (!enabled) {
+        ResetConditionOrder();
+    }
 }
-LightMode RuleEngine::DecideLightMode(const SystemState& state) {
+
+void RuleEngine::ResetEvaluationStats() {
+    evaluation_stats_ = RuleEvaluationStats();
+}
+
+const ConditionStats& RuleEngine::GetConditionStats(size_t rule_index, size_t condition_index) const {
+    return condition_stats_[rules_[rule_index].first_condition + condition_index];
+}
+
+std::vector<size_t> RuleEngine::GetConditionOrder(size_t rule_index) const {
+    const StoredRule& rule = rules_[rule_index];
+    return std::vector<size_t>(condition_order_.begin() + rule.first_condition,
+                               condition_order_.begin() + rule.first_condition + rule.condition_count);
+}
+
+void RuleEngine::ReorderConditions() {
+    bool changed = false;
+    std::vector<double> costs;
+    std::vector<double> pass_rates;
+    std::vector<double> keys;
+    std::vector<uint32_t> candidate;
+    for (const auto& rule : rules_) {
+        size_t begin = rule.first_condition;
+        size_t count = rule.condition_count;
+        if (count < 2) {
+            continue;
+        }
+        ConditionStats* stats = &condition_stats_[begin];
+        
+        // AND链的期望耗时在按 耗时/不满足率 从小到大排列时最小
+        costs.assign(count, 0.0);
+        pass_rates.assign(count, 0.0);
+        keys.assign(count, 0.0);
+        for (size_t i = 0; i < count; i++) {
+            const ConditionStats& s = stats[i];
+            costs[i] = s.cost_samples > 0
+                           ? static_cast<double>(s.cost_ns) / static_cast<double>(s.cost_samples)
+                           : kDefaultConditionCostNs;
+            // 没有数据（排在总是不满足的条件之后）时按一半估计
+            pass_rates[i] = s.evaluations > 0
+                                ? static_cast<double>(s.passes) / static_cast<double>(s.evaluations)
+                                : 0.5;
+            keys[i] = costs[i] / std::max(1.0 - pass_rates[i], 1e-3);
+        }
+        
+        uint32_t* order = &condition_order_[begin];
+        candidate.assign(order, order + count);
+        std::stable_sort(candidate.begin(), candidate.end(), [&keys](uint32_t a, uint32_t b) {
+            return keys[a] < keys[b];
+        });
+        
+        // 期望耗时 = Σ 条件耗时 × 之前所有条件都满足的概率
+        auto expected_cost = [&costs, &pass_rates](const uint32_t* sequence, size_t length) {
+            double total = 0.0;
+            double reach = 1.0;
+            for (size_t k = 0; k < length; k++) {
+                total += reach * costs[sequence[k]];
+                reach *= pass_rates[sequence[k]];
+            }
+            return total;
+        };
+        if (expected_cost(candidate.data(), count) < (1.0 - kReorderMinGain) * expected_cost(order, count)) {
+            std::copy(candidate.begin(), candidate.end(), order);
+            changed = true;
+        }
+        
+        // 满足率随使用情况变化，计数减半；耗时基本只取决于条件类型，继续累计以减小计时噪声
+        for (size_t i = 0; i < count; i++) {
+            stats[i].evaluations /= 2;
+            stats[i].passes /= 2;
+        }
+    }
+    if (changed) {
+        evaluation_stats_.reorders++;
+    }
+}
+
+size_t RuleEngine::GetWindowSeconds(const Condition& condition) {
+    if (!condition.window_seconds.has_value()) {
+        return 0;
+    }
+    double seconds = condition.window_seconds.value();
+    if (!(seconds > 0.0) || seconds > kMaxWindowSeconds) {
+        return 0;
+    }
+    return static_cast<size_t>(std::ceil(seconds));
+}
+
+void RuleEngine::ScanWindowConditions(size_t first, size_t count) {
+    for (size_t i = first; i < first + count; i++) {
+        const StoredCondition& condition = conditions_[i];
+        switch (condition.type) {
+            case ConditionType::CPU_AVERAGE:
+                cpu_window_seconds_ = std::max<size_t>(cpu_window_seconds_, condition.window);
+                windows_active_ = true;
+                break;
+            case ConditionType::AUDIO_RATIO:
+                audio_window_seconds_ = std::max<size_t>(audio_window_seconds_, condition.window);
+                windows_active_ = true;
+                break;
+            case ConditionType::APP_CATEGORY_SUSTAINED:
+                windows_active_ = true;
+                category_window_active_ = true;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void RuleEngine::AllocateWindows() {
+    cpu_window_seconds_ = 0;
+    audio_window_seconds_ = 0;
+    windows_active_ = false;
+    category_window_active_ = false;
+    ScanWindowConditions(0, conditions_.size());
+    cpu_window_.Allocate(cpu_window_seconds_);
+    audio_window_.Allocate(audio_window_seconds_);
+    has_window_category_ = false;
+}
+
+void RuleEngine::UpdateWindows(SystemState& state) {
+    // 窗口需要连续的采样，窗口条件用到的字段每次决策都要采样
+    window_now_ = state.monotonic_seconds;
+    int64_t second = static_cast<int64_t>(std::floor(state.monotonic_seconds));
+    if (cpu_window_.IsAllocated()) {
+        EnsureProbed(state, StateProbe::CPU);
+        cpu_window_.Push(second, state.cpu_usage);
+    }
+    if (audio_window_.IsAllocated()) {
+        EnsureProbed(state, StateProbe::AUDIO);
+        audio_window_.Push(second, state.has_audio_activity ? 1.0 : 0.0);
+    }
+    if (!category_window_active_) {
+        return;
+    }
+    EnsureProbed(state, StateProbe::APP_CATEGORY);
+    if (!has_window_category_ || state.current_app_category != window_category_) {
+        has_window_category_ = true;
+        window_category_ = state.current_app_category;
+        window_category_since_ = state.monotonic_seconds;
+    }
+}
+
+LightMode RuleEngine::DecideLightMode(SystemState& state) {
+    METRICS_SCOPE(MetricStage::RULE_EVAL);
+    
+    if (windows_active_) {
+        UpdateWindows(state);
+    }
+    
+    uint64_t decision = ++evaluation_stats_.decisions;
+    bool sample_cost = adaptive_ordering_ && decision % kCostSampleInterval == 0;
+    
+    // 追踪关闭时走不含任何追踪代码的实例化版本，只在这里做一次分支
+    LightMode mode;
+    if (!trace_enabled_) {
+        mode = EvaluateRules<false>(state, nullptr, sample_cost);
+    } else {
+        DecisionTrace& trace = trace_buffer_[trace_sequence_ % trace_buffer_.size()];
+        trace.sequence = ++trace_sequence_;
+        trace.skipped_rule_count = 0;
+        mode = EvaluateRules<true>(state, &trace, sample_cost);
+        trace.state = state;    // 评估之后复制，包含评估过程中惰性采样的字段
+    }
+    
+    // 决策结束后仍未采样的字段
+    if (state.pending_probes != 0) {
+        for (size_t i = 0; i < static_cast<size_t>(StateProbe::COUNT); i++) {
+            if ((state.pending_probes & ProbeBit(static_cast<StateProbe>(i))) != 0) {
+                evaluation_stats_.probes_skipped[i]++;
+            }
+        }
+    }
+    
+    if (adaptive_ordering_ && decision % kReorderInterval == 0) {
+        ReorderConditions();
+    }
+    return mode;
+}
+
+template <bool kTrace>
+LightMode RuleEngine::EvaluateRules(SystemState& state, DecisionTrace* trace, bool sample_cost) {
     // 遍历所有规则，找到第一个所有条件都满足的规则
     // 由于已经按优先级排序，第一个匹配的就是优先级最高的
-    for (const auto& rule : rules_) {
+    uint64_t predicates = 0;
+    const StoredCondition* all_conditions = conditions_.data();
+    for (size_t rule_index = 0; rule_index < rules_.size(); rule_index++) {
+        const StoredRule& rule = rules_[rule_index];
+        const StoredCondition* conditions = all_conditions + rule.first_condition;
+        const uint32_t* order = &condition_order_[rule.first_condition];
+        ConditionStats* stats = &condition_stats_[rule.first_condition];
         bool all_conditions_met = true;
         
-        // 检查所有条件（AND逻辑）
-        for (const auto& condition : rule.conditions) {
-            if (!CheckCondition(condition, state)) {
+        // 按当前顺序检查所有条件（AND逻辑）；追踪记录的是条件的原始索引
+        for (size_t k = 0; k < rule.condition_count; k++) {
+            uint32_t condition_index = order[k];
+            ConditionStats& condition_stats = stats[condition_index];
+            bool passed;
+            if (sample_cost) {
+                auto begin = std::chrono::steady_clock::now();
+                passed = CheckCondition(conditions[condition_index], state);
+                condition_stats.cost_ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - begin).count());
+                condition_stats.cost_samples++;
+            } else {
+                passed = CheckCondition(conditions[condition_index], state);
+            }
+            condition_stats.evaluations++;
+            predicates++;
+            if (!passed) {
                 all_conditions_met = false;
+                if constexpr (kTrace) {
+                    if (rule_index < DecisionTrace::kMaxTracedRules) {
+                        trace->first_failed_condition[rule_index] = static_cast<uint16_t>(
+                            std::min<size_t>(condition_index, DecisionTrace::kConditionIndexSaturated));
+                        trace->skipped_rule_count = static_cast<uint16_t>(rule_index + 1);
+                    }
+                }
                 break;
             }
+            condition_stats.passes++;
         }
         
         // 如果所有条件都满足，返回该规则的目标模式
         if (all_conditions_met) {
+            if constexpr (kTrace) {
+                trace->winning_rule = static_cast<int>(rule_index);
+                trace->mode = rule.target_mode;
+            }
+            evaluation_stats_.predicates_evaluated += predicates;
+            last_winning_rule_ = static_cast<int>(rule_index);
             return rule.target_mode;
         }
     }
+    evaluation_stats_.predicates_evaluated += predicates;
+    last_winning_rule_ = -1;
     
     // 没有规则匹配，返回默认模式
+    if constexpr (kTrace) {
+        trace->winning_rule = -1;
+        trace->mode = LightMode::DEFAULT;
+    }
     return LightMode::DEFAULT;
 }
 
-bool RuleEngine::CheckCondition(const Condition& condition, const SystemState& state) {
+void RuleEngine::EnableTrace(size_t capacity) {
+    trace_buffer_.assign(capacity > 0 ? capacity : 1, DecisionTrace());
+    trace_sequence_ = 0;
+    trace_enabled_ = true;
+}
+
+void RuleEngine::DisableTrace() {
+    trace_enabled_ = false;
+}
+
+std::vector<DecisionTrace> RuleEngine::GetRecentTraces(size_t max_count) const {
+    std::vector<DecisionTrace> traces;
+    if (trace_buffer_.empty()) {
+        return traces;
+    }
+    
+    uint64_t available = std::min<uint64_t>(trace_sequence_, trace_buffer_.size());
+    uint64_t count = std::min<uint64_t>(available, max_count);
+    traces.reserve(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t sequence = trace_sequence_ - i;   // 序号从1开始
+        traces.push_back(trace_buffer_[(sequence - 1) % trace_buffer_.size()]);
+    }
+    return traces;
+}
+
+const DecisionTrace* RuleEngine::GetLastTrace() const {
+    if (trace_buffer_.empty() || trace_sequence_ == 0) {
+        return nullptr;
+    }
+    return &trace_buffer_[(trace_sequence_ - 1) % trace_buffer_.size()];
+}
+
+std::string RuleEngine::DescribeCondition(const Condition& condition) {
+    std::ostringstream oss;
+    oss << GetConditionTypeName(condition.type);
     switch (condition.type) {
         case ConditionType::APP_CATEGORY:
             if (condition.app_category.has_value()) {
-                return state.current_app_category == condition.app_category.value();
+                oss << " == " << AppClassifier::GetCategoryName(condition.app_category.value());
             }
-            return false;
-            
+            break;
         case ConditionType::TIME_RANGE:
             if (condition.time_range.has_value()) {
-                return CheckTimeRange(condition.time_range.value(), 
-                                     state.current_hour, state.current_minute,
-                                     state.is_weekday);
+                const TimeRange& range = condition.time_range.value();
+                oss << " " << std::setfill('0') << std::setw(2) << range.start_hour << ":"
+                    << std::setw(2) << range.start_minute << "-"
+                    << std::setw(2) << range.end_hour << ":" << std::setw(2) << range.end_minute;
+                if (range.weekday_type == WeekdayType::WEEKDAY) {
+                    oss << " (工作日)";
+                } else if (range.weekday_type == WeekdayType::WEEKEND) {
+                    oss << " (周末)";
+                }
             }
-            return false;
-            
+            break;
         case ConditionType::CPU_THRESHOLD:
             if (condition.cpu_threshold.has_value()) {
-                if (condition.cpu_greater_than) {
-                    return state.cpu_usage > condition.cpu_threshold.value();
-                } else {
-                    return state.cpu_usage <= condition.cpu_threshold.value();
-                }
+                oss << (condition.cpu_greater_than ? " > " : " <= ") << condition.cpu_threshold.value() << "%";
             }
-            return false;
-            
+            break;
         case ConditionType::IDLE_THRESHOLD:
             if (condition.idle_threshold.has_value()) {
-                if (condition.idle_greater_than) {
-                    return state.idle_minutes >= condition.idle_threshold.value();
-                } else {
-                    return state.idle_minutes < condition.idle_threshold.value();
-                }
+                oss << (condition.idle_greater_than ? " >= " : " < ") << condition.idle_threshold.value() << " 分钟";
             }
-            return false;
-            
+            break;
         case ConditionType::AUDIO_ACTIVITY:
             if (condition.audio_activity.has_value()) {
-                return state.has_audio_activity == condition.audio_activity.value();
+                oss << (condition.audio_activity.value() ? " == 有" : " == 无");
             }
-            return false;
+            break;
+        case ConditionType::CPU_TEMPERATURE:
+        case ConditionType::GPU_TEMPERATURE:
+            if (condition.temperature_threshold.has_value()) {
+                oss << (condition.temperature_greater_than ? " > " : " <= ")
+                    << condition.temperature_threshold.value() << "°C";
+            }
+            break;
+        case ConditionType::CPU_AVERAGE:
+            if (condition.cpu_threshold.has_value() && condition.window_seconds.has_value()) {
+                oss << "(" << condition.window_seconds.value() << "秒)"
+                    << (condition.cpu_greater_than ? " > " : " <= ") << condition.cpu_threshold.value() << "%";
+            }
+            break;
+        case ConditionType::AUDIO_RATIO:
+            if (condition.audio_ratio.has_value() && condition.window_seconds.has_value()) {
+                oss << "(" << condition.window_seconds.value() << "秒) >= "
+                    << condition.audio_ratio.value() * 100.0 << "%";
+            }
+            break;
+        case ConditionType::APP_CATEGORY_SUSTAINED:
+            if (condition.app_category.has_value() && condition.window_seconds.has_value()) {
+                oss << " == " << AppClassifier::GetCategoryName(condition.app_category.value())
+                    << " 持续 " << condition.window_seconds.value() << " 秒";
+            }
+            break;
+        case ConditionType::CATEGORY_USAGE_TODAY:
+            if (condition.app_category.has_value() && condition.usage_minutes.has_value()) {
+                oss << "(" << AppClassifier::GetCategoryName(condition.app_category.value()) << ") >= "
+                    << condition.usage_minutes.value() << " 分钟";
+            }
+            break;
+        default:
+            break;
+    }
+    return oss.str();
+}
+
+std::string RuleEngine::ExplainDecision(const DecisionTrace& trace) const {
+    std::ostringstream oss;
+    oss << "决策#" << trace.sequence << ": " << GetLightModeName(trace.mode) << "\n";
+    
+    for (size_t i = 0; i < trace.skipped_rule_count && i < rules_.size(); i++) {
+        const StoredRule& rule = rules_[i];
+        size_t failed = static_cast<size_t>(trace.first_failed_condition[i]);
+        oss << "  规则#" << i << " (优先级" << rule.priority << ", "
+            << GetLightModeName(rule.target_mode) << ") 未满足";
+        if (failed < rule.condition_count) {
+            oss << ": 条件" << failed << " ["
+                << DescribeCondition(UnpackCondition(conditions_[rule.first_condition + failed])) << "]";
+        }
+        oss << "\n";
+    }
+    
+    if (trace.winning_rule >= 0 && static_cast<size_t>(trace.winning_rule) < rules_.size()) {
+        const StoredRule& rule = rules_[trace.winning_rule];
+        oss << "  规则#" << trace.winning_rule << " (优先级" << rule.priority << ", "
+            << GetLightModeName(rule.target_mode) << ") 命中\n";
+    } else {
+        oss << "  没有规则匹配，使用默认模式\n";
+    }
+    return oss.str();
+}
+
+std::string RuleEngine::SummarizeDecision(const DecisionTrace& trace) const {
+    std::ostringstream oss;
+    if (trace.winning_rule >= 0 && static_cast<size_t>(trace.winning_rule) < rules_.size()) {
+        oss << "命中规则#" << trace.winning_rule << "(优先级" << rules_[trace.winning_rule].priority << ")";
+    } else {
+        oss << "无规则匹配";
+    }
+    if (trace.skipped_rule_count > 0) {
+        oss << "，未满足:";
+        for (size_t i = 0; i < trace.skipped_rule_count; i++) {
+            oss << " #" << i << "条件" << trace.first_failed_condition[i];
+        }
+    }
+    return oss.str();
+}
+
+bool RuleEngine::CheckCondition(const StoredCondition& condition, SystemState& state) {
+    // 缺少必需字段的条件永不满足
+    if (!condition.valid) {
+        return false;
+    }
+    
+    switch (condition.type) {
+        case ConditionType::APP_CATEGORY:
+            EnsureProbed(state, StateProbe::APP_CATEGORY);
+            return static_cast<uint8_t>(state.current_app_category) == condition.value;
+            
+        case ConditionType::TIME_RANGE:
+            return CheckTimeRange(condition, state.current_hour, state.current_minute, state.is_weekday);
+            
+        case ConditionType::CPU_THRESHOLD:
+            EnsureProbed(state, StateProbe::CPU);
+            if (condition.greater) {
+                return state.cpu_usage > condition.threshold;
+            } else {
+                return state.cpu_usage <= condition.threshold;
+            }
+            
+        case ConditionType::IDLE_THRESHOLD:
+            EnsureProbed(state, StateProbe::IDLE);
+            if (condition.greater) {
+                return state.idle_minutes >= condition.threshold;
+            } else {
+                return state.idle_minutes < condition.threshold;
+            }
+            
+        case ConditionType::AUDIO_ACTIVITY:
+            EnsureProbed(state, StateProbe::AUDIO);
+            return (state.has_audio_activity ? 1 : 0) == condition.value;
+            
+        case ConditionType::CPU_TEMPERATURE:
+        case ConditionType::GPU_TEMPERATURE: {
+            EnsureProbed(state, StateProbe::TEMPERATURE);
+            double temperature = condition.type == ConditionType::CPU_TEMPERATURE
+                                     ? state.cpu_temperature : state.gpu_temperature;
+            // 没有读数（NaN）时两种比较都为false
+            if (condition.greater) {
+                return temperature > condition.threshold;
+            } else {
+                return temperature <= condition.threshold;
+            }
+        }
+            
+        case ConditionType::CPU_AVERAGE: {
+            // 历史不足一个窗口时条件不满足（两种比较方向都是）
+            double mean = 0.0;
+            if (!cpu_window_.GetMean(condition.window, mean)) {
+                return false;
+            }
+            if (condition.greater) {
+                return mean > condition.threshold;
+            } else {
+                return mean <= condition.threshold;
+            }
+        }
+            
+        case ConditionType::AUDIO_RATIO: {
+            double ratio = 0.0;
+            if (!audio_window_.GetMean(condition.window, ratio)) {
+                return false;
+            }
+            return ratio >= condition.threshold;
+        }
+            
+        case ConditionType::APP_CATEGORY_SUSTAINED:
+            return condition.window > 0 && has_window_category_ &&
+                   static_cast<uint8_t>(window_category_) == condition.value &&
+                   window_now_ - window_category_since_ >= static_cast<double>(condition.window);
+            
+        case ConditionType::CATEGORY_USAGE_TODAY:
+            return condition.value < kAppCategoryCount &&
+                   state.category_seconds_today[condition.value] >= condition.threshold;
             
         default:
             return false;
     }
 }
 
-bool RuleEngine::CheckTimeRange(const TimeRange& time_range, int current_hour, int current_minute, bool is_weekday) {
+bool RuleEngine::CheckTimeRange(const StoredCondition& condition, int current_hour, int current_minute, bool is_weekday) {
     // 检查工作日类型限制
-    if (time_range.weekday_type == WeekdayType::WEEKDAY && !is_weekday) {
+    WeekdayType weekday_type = static_cast<WeekdayType>(condition.weekday_type);
+    if (weekday_type == WeekdayType::WEEKDAY && !is_weekday) {
         return false;  // 要求工作日，但当前是周末
     }
-    if (time_range.weekday_type == WeekdayType::WEEKEND && is_weekday) {
+    if (weekday_type == WeekdayType::WEEKEND && is_weekday) {
         return false;  // 要求周末，但当前是工作日
     }
     
-    // 将时间转换为分钟数，便于比较
-    int start_minutes = time_range.start_hour * 60 + time_range.start_minute;
-    int end_minutes = time_range.end_hour * 60 + time_range.end_minute;
+    // 时间已在加载规则时转换为分钟数，便于比较
+    int start_minutes = condition.start_minute;
+    int end_minutes = condition.end_minute;
     int current_minutes = current_hour * 60 + current_minute;
     
     // 处理跨天的情况（如 23:00-07:00）
@@ -132,6 +781,48 @@ std::string RuleEngine::GetLightModeName(LightMode mode) {
     }
 }
 
+std::optional<LightMode> RuleEngine::ParseLightModeName(const std::string& mode_name) {
+    std::string name;
+    name.reserve(mode_name.size());
+    for (unsigned char c : mode_name) {
+        name.push_back(static_cast<char>(std::toupper(c)));
+    }
+    
+    if (name == "GAME_SCREENSYNC") {
+        return LightMode::GAME_SCREENSYNC;
+    } else if (name == "VIDEO_CINEMATIC") {
+        return LightMode::VIDEO_CINEMATIC;
+    } else if (name == "MUSIC") {
+        return LightMode::MUSIC;
+    } else if (name == "WORK_CODING") {
+        return LightMode::WORK_CODING;
+    } else if (name == "NIGHT_DIM") {
+        return LightMode::NIGHT_DIM;
+    } else if (name == "OFF") {
+        return LightMode::OFF;
+    } else if (name == "DEFAULT") {
+        return LightMode::DEFAULT;
+    }
+    return std::nullopt;
+}
+
+std::string RuleEngine::GetProbeName(StateProbe probe) {
+    switch (probe) {
+        case StateProbe::APP_CATEGORY:
+            return "前台窗口";
+        case StateProbe::CPU:
+            return "CPU使用率";
+        case StateProbe::IDLE:
+            return "空闲时间";
+        case StateProbe::AUDIO:
+            return "音频活动";
+        case StateProbe::TEMPERATURE:
+            return "温度";
+        default:
+            return "未知";
+    }
+}
+
 std::string RuleEngine::GetConditionTypeName(ConditionType type) {
     switch (type) {
         case ConditionType::APP_CATEGORY:
@@ -144,6 +835,18 @@ std::string RuleEngine::GetConditionTypeName(ConditionType type) {
             return "空闲时间";
         case ConditionType::AUDIO_ACTIVITY:
             return "音频活动";
+        case ConditionType::CPU_TEMPERATURE:
+            return "CPU温度";
+        case ConditionType::GPU_TEMPERATURE:
+            return "GPU温度";
+        case ConditionType::CPU_AVERAGE:
+            return "CPU平均使用率";
+        case ConditionType::AUDIO_RATIO:
+            return "音频活动占比";
+        case ConditionType::APP_CATEGORY_SUSTAINED:
+            return "应用类别持续";
+        case ConditionType::CATEGORY_USAGE_TODAY:
+            return "应用类别今日累计";
         default:
             return "未知";
     }
@@ -1,11 +1,13 @@
 #pragma once
 
 #include "app_classifier.h"
+#include "signal_window.h"
 #include <string>
 #include <vector>
 #include <optional>
 #include <ctime>
 #include <cstdint>
+#include <limits>
 
 /**
  * 灯光模式枚举
@@ -20,6 +22,8 @@ enum class LightMode {
     DEFAULT             // 默认模式
 };
 
+const size_t kLightModeCount = static_cast<size_t>(LightMode::DEFAULT) + 1;
+
 /**
  * 条件类型枚举
  */
@@ -28,7 +32,13 @@ enum class ConditionType {
     TIME_RANGE,         // 时间段
     CPU_THRESHOLD,      // CPU使用率阈值
     IDLE_THRESHOLD,     // Idle时间阈值
-    AUDIO_ACTIVITY      // 音频活动（有/无）
+    AUDIO_ACTIVITY,     // 音频活动（有/无）
+    CPU_TEMPERATURE,    // CPU温度阈值
+    GPU_TEMPERATURE,    // GPU温度阈值
+    CPU_AVERAGE,        // 窗口内CPU平均使用率阈值
+    AUDIO_RATIO,        // 窗口内有音频活动的采样占比
+    APP_CATEGORY_SUSTAINED, // 应用类别持续时间
+    CATEGORY_USAGE_TODAY    // 应用类别今日累计时长
 };
 
 /**
@@ -61,15 +71,20 @@ struct Condition {
     ConditionType type;
     
     // 根据类型使用不同的字段
-    std::optional<AppCategory> app_category;      // APP_CATEGORY
+    std::optional<AppCategory> app_category;      // APP_CATEGORY / APP_CATEGORY_SUSTAINED / CATEGORY_USAGE_TODAY
     std::optional<TimeRange> time_range;           // TIME_RANGE
-    std::optional<double> cpu_threshold;           // CPU_THRESHOLD (阈值)
-    bool cpu_greater_than;                         // CPU_THRESHOLD (是否大于阈值)
+    std::optional<double> cpu_threshold;           // CPU_THRESHOLD / CPU_AVERAGE (阈值)
+    bool cpu_greater_than;                         // CPU_THRESHOLD / CPU_AVERAGE (是否大于阈值)
     std::optional<double> idle_threshold;          // IDLE_THRESHOLD (阈值，分钟)
     bool idle_greater_than;                        // IDLE_THRESHOLD (是否大于等于阈值)
     std::optional<bool> audio_activity;            // AUDIO_ACTIVITY (true=有音频, false=无音频)
+    std::optional<double> temperature_threshold;   // CPU_TEMPERATURE / GPU_TEMPERATURE (阈值，摄氏度)
+    bool temperature_greater_than;                 // CPU_TEMPERATURE / GPU_TEMPERATURE (是否大于阈值)
+    std::optional<double> audio_ratio;             // AUDIO_RATIO (占比下限，0-1)
+    std::optional<double> window_seconds;          // CPU_AVERAGE / AUDIO_RATIO / APP_CATEGORY_SUSTAINED (窗口长度，秒)
+    std::optional<double> usage_minutes;           // CATEGORY_USAGE_TODAY (今日累计时长下限，分钟)
     
-    Condition() : cpu_greater_than(false), idle_greater_than(false) {}
+    Condition() : cpu_greater_than(false), idle_greater_than(false), temperature_greater_than(false) {}
 };
 
 /**
@@ -83,6 +98,41 @@ struct Rule {
     Rule() : target_mode(LightMode::DEFAULT), priority(0) {}
 };
 
+/**
+ * 可以惰性采样的状态字段
+ */
+enum class StateProbe {
+    APP_CATEGORY,       // 前台窗口与应用类别
+    CPU,                // CPU使用率
+    IDLE,               // 用户空闲时间
+    AUDIO,              // 音频活动
+    TEMPERATURE,        // CPU/GPU温度
+    COUNT
+};
+
+inline uint32_t ProbeBit(StateProbe probe) {
+    return 1u << static_cast<uint32_t>(probe);
+}
+
+const uint32_t kAllProbes = (1u << static_cast<uint32_t>(StateProbe::COUNT)) - 1;
+
+struct SystemState;
+
+/**
+ * 状态采样接口（惰性采样时由规则引擎回调）
+ */
+class StateProber {
+public:
+    virtual ~StateProber() {}
+    
+    /**
+     * 采样一个字段并写入state
+     * @param probe 字段
+     * @param state 系统状态
+     */
+    virtual void Probe(StateProbe probe, SystemState& state) = 0;
+};
+
 /**
  * 系统状态结构（用于规则匹配）
  */
@@ -94,6 +144,57 @@ struct SystemState {
     int current_minute;                   // 当前分钟 (0-59)
     bool has_audio_activity;               // 是否有音频活动
     bool is_weekday;                       // 是否是工作日（true=工作日，false=周末）
+    // 硬件温度（摄氏度），没有传感器时为NaN，此时温度条件不满足
+    double cpu_temperature = std::numeric_limits<double>::quiet_NaN();
+    double gpu_temperature = std::numeric_limits<double>::quiet_NaN();
+    // 采样时间（单调时钟，秒），用于滑动窗口条件
+    double monotonic_seconds = 0.0;
+    // 今天各应用类别的累计时长（秒，按AppCategory的取值），由会话统计在决策前填入
+    uint32_t category_seconds_today[kAppCategoryCount] = {};
+    // 惰性采样：pending_probes中标记的字段（ProbeBit位掩码）尚未采样，
+    // 规则引擎在条件第一次用到时调用prober采样；决策结束后仍标记的字段即被跳过的采样
+    StateProber* prober = nullptr;
+    uint32_t pending_probes = 0;
+};
+
+/**
+ * 单次决策的追踪记录
+ * 记录命中的规则，以及每条更高优先级规则中第一个不满足的条件，
+ * 用于事后回答"为什么是这个灯光模式"
+ */
+struct DecisionTrace {
+    static const size_t kMaxTracedRules = 32;     // 最多记录的高优先级规则数
+    
+    uint64_t sequence;                              // 决策序号（从1开始递增）
+    SystemState state;                              // 决策时的系统状态
+    int winning_rule;                               // 命中的规则索引（按优先级排序后），-1表示没有规则匹配
+    LightMode mode;                                 // 决策结果
+    uint16_t skipped_rule_count;                    // 命中规则之前未满足的规则数
+    static constexpr uint16_t kConditionIndexSaturated = 0xFFFF;   // 条件索引超出uint16_t时记录的值
+    
+    uint16_t first_failed_condition[kMaxTracedRules]; // 每条未满足规则中（按当时的评估顺序）第一个不满足的条件的原始索引
+};
+
+/**
+ * 单个条件的运行时统计（用于自适应条件顺序）
+ * 每次重排条件顺序后评估/满足次数减半，使满足率跟随最近的使用情况
+ */
+struct ConditionStats {
+    uint64_t evaluations;       // 被评估的次数
+    uint64_t passes;            // 满足的次数
+    uint64_t cost_samples;      // 计时采样次数（每kCostSampleInterval次决策计时一次）
+    uint64_t cost_ns;           // 计时采样的累计耗时（纳秒）
+};
+
+/**
+ * 规则评估的累计统计（不衰减）
+ */
+struct RuleEvaluationStats {
+    uint64_t decisions;             // 决策次数
+    uint64_t predicates_evaluated;  // 评估的条件总数（除以决策次数即平均每次决策评估的条件数）
+    uint64_t reorders;              // 条件顺序实际发生变化的次数
+    uint64_t probes_performed[static_cast<size_t>(StateProbe::COUNT)];  // 惰性采样实际执行的次数
+    uint64_t probes_skipped[static_cast<size_t>(StateProbe::COUNT)];    // 惰性采样被跳过的次数
 };
 
 /**
@@ -106,21 +207,43 @@ public:
     
     /**
      * 添加规则
+     * 插入到优先级不低于它的规则之后（优先级相同时保持添加顺序），O(N)；
+     * 一次加载大量规则请使用LoadRules。
+     * 规则中的滑动窗口条件需要更长的缓冲区时在此重新分配（并清空已有的窗口历史）
      * @param rule 规则对象
      */
     void AddRule(const Rule& rule);
     
+    /**
+     * 批量加载规则（替换现有规则）
+     * 按优先级从高到低稳定排序（优先级相同时保持传入顺序），所有条件按排序后的顺序
+     * 复制到一块连续存储中，总耗时O(N log N)；滑动窗口缓冲区在此一次性分配
+     * @param rules 规则列表
+     */
+    void LoadRules(const std::vector<Rule>& rules);
+    
     /**
      * 清空所有规则
      */
     void ClearRules();
     
+    /**
+     * 获取所有规则（按优先级从高到低排序）
+     * 规则在内部以平铺形式存储，这里重新构造，不要在热路径上调用
+     */
+    std::vector<Rule> GetRules() const;
+    
+    size_t GetRuleCount() const { return rules_.size(); }
+    
     /**
      * 根据当前系统状态决定灯光模式
+     * 存在滑动窗口条件时，状态同时计入各信号的窗口（每次决策即一次采样）。
+     * state.pending_probes中的字段只在条件用到时才通过state.prober采样并写回state，
+     * 更高优先级的规则命中后，只被低优先级规则用到的字段不会被采样。
      * @param state 系统状态
      * @return 应该使用的灯光模式
      */
-    LightMode DecideLightMode(const SystemState& state);
+    LightMode DecideLightMode(SystemState& state);
     
     /**
      * 获取灯光模式的中文名称
@@ -129,32 +252,254 @@ public:
      */
     static std::string GetLightModeName(LightMode mode);
     
+    /**
+     * 解析灯光模式名（GAME_SCREENSYNC、NIGHT_DIM等，不区分大小写）
+     * @param mode_name 灯光模式名
+     * @return 灯光模式，无法识别时返回std::nullopt
+     */
+    static std::optional<LightMode> ParseLightModeName(const std::string& mode_name);
+
+    /**
+     * 窗口条件的窗口长度（整秒，向上取整），无效时返回0
+     */
+    static size_t GetWindowSeconds(const Condition& condition);
+
     /**
      * 获取条件类型的中文名称
      * @param type 条件类型
      * @return 中文名称
      */
     static std::string GetConditionTypeName(ConditionType type);
+    
+    /**
+     * 获取采样字段的中文名称
+     */
+    static std::string GetProbeName(StateProbe probe);
+    
+    /**
+     * 开启决策追踪
+     * 追踪缓冲区在此一次性分配，之后每次决策只覆盖环形缓冲区中的一项
+     * @param capacity 保留最近多少次决策
+     */
+    void EnableTrace(size_t capacity = 64);
+    
+    /**
+     * 关闭决策追踪（评估回到不含任何追踪代码的快速路径）
+     */
+    void DisableTrace();
+    
+    bool IsTraceEnabled() const { return trace_enabled_; }
+    
+    /**
+     * 获取最近的决策追踪记录
+     * @param max_count 最多返回多少条
+     * @return 追踪记录（最新的在前）
+     */
+    std::vector<DecisionTrace> GetRecentTraces(size_t max_count = 1) const;
+    
+    /**
+     * 获取最近一次决策的追踪记录（不分配内存）
+     * @return 追踪记录指针，未开启追踪或尚无决策时返回nullptr
+     */
+    const DecisionTrace* GetLastTrace() const;
+    
+    /**
+     * 生成决策的详细解释（多行文本）
+     * @param trace 追踪记录
+     * @return 解释文本
+     */
+    std::string ExplainDecision(const DecisionTrace& trace) const;
+    
+    /**
+     * 生成决策的单行摘要（用于日志）
+     * @param trace 追踪记录
+     * @return 摘要文本，例如 "命中规则#2(优先级8)，未满足: #0条件0 #1条件0"
+     */
+    std::string SummarizeDecision(const DecisionTrace& trace) const;
+    
+    /**
+     * 开启/关闭自适应条件顺序（默认开启）
+     * 开启时引擎记录每个条件的满足率和耗时，每kReorderInterval次决策按
+     * "耗时 / 不满足率"从小到大重排每条规则的条件，使便宜且容易不满足的条件先执行。
+     * 条件是无副作用的AND关系，顺序不影响决策结果；GetRules返回的规则保持原顺序。
+     * 关闭时恢复按编写顺序评估。
+     */
+    void SetAdaptiveOrdering(bool enabled);
+    
+    bool IsAdaptiveOrdering() const { return adaptive_ordering_; }
+    
+    /**
+     * 获取规则评估的累计统计
+     */
+    RuleEvaluationStats GetEvaluationStats() const { return evaluation_stats_; }
+    
+    /**
+     * 最近一次决策命中的规则索引（按优先级排序后，与GetRules()的顺序相同）
+     * 不需要开启追踪；没有规则匹配或尚无决策时返回-1
+     */
+    int GetLastWinningRule() const { return last_winning_rule_; }
+    
+    /**
+     * 清零累计统计（条件统计和当前顺序保留）
+     */
+    void ResetEvaluationStats();
+    
+    /**
+     * 获取条件的运行时统计
+     * @param rule_index 规则索引（按优先级排序后）
+     * @param condition_index 条件在规则中的原始索引
+     */
+    const ConditionStats& GetConditionStats(size_t rule_index, size_t condition_index) const;
+    
+    /**
+     * 获取规则当前的条件评估顺序
+     * @param rule_index 规则索引（按优先级排序后）
+     * @return 条件的原始索引，按评估顺序排列
+     */
+    std::vector<size_t> GetConditionOrder(size_t rule_index) const;
+    
+    static const uint64_t kReorderInterval = 256;       // 每多少次决策重排一次条件
+    static const uint64_t kCostSampleInterval = 64;     // 每多少次决策对条件计时一次
 
 private:
-    std::vector<Rule> rules_;
+    /**
+     * 内部存储的规则
+     * 条件位于 conditions_[first_condition, first_condition + condition_count)
+     */
+    struct StoredRule {
+        uint32_t first_condition;
+        uint32_t condition_count;
+        LightMode target_mode;
+        int priority;
+    };
+    
+    /**
+     * 内部存储的条件（定长32字节，不含std::optional）
+     */
+    struct StoredCondition {
+        ConditionType type;
+        bool valid;                 // 该类型需要的字段都已设置（否则条件永不满足）
+        bool greater;               // CPU/空闲/温度阈值的比较方向
+        uint8_t value;              // APP_CATEGORY / APP_CATEGORY_SUSTAINED: 类别；AUDIO_ACTIVITY: 0/1
+        uint8_t weekday_type;       // TIME_RANGE: WeekdayType
+        uint16_t start_minute;      // TIME_RANGE: 开始时间（自0点起的分钟数）
+        uint16_t end_minute;        // TIME_RANGE: 结束时间
+        uint32_t window;            // 窗口条件的整秒窗口长度（0表示无效）
+        double threshold;           // CPU/空闲/温度阈值，或AUDIO_RATIO的占比下限
+        double window_seconds;      // 原始窗口长度（未设置时为NaN，用于还原Condition）
+    };
+    
+    std::vector<StoredRule> rules_;             // 按优先级从高到低
+    std::vector<StoredCondition> conditions_;   // 所有规则的条件（每条规则的条件连续存放）
+    
+    /**
+     * 条件与内部存储形式之间的转换
+     */
+    static StoredCondition PackCondition(const Condition& condition);
+    static Condition UnpackCondition(const StoredCondition& stored);
+    
+    /**
+     * 把规则的条件追加到条件存储末尾
+     * @return 规则的内部存储形式
+     */
+    StoredRule AppendRule(const Rule& rule);
+    
+    int last_winning_rule_;                     // 最近一次决策命中的规则索引
+    
+    // 决策追踪（环形缓冲区，开启追踪时预先分配）
+    bool trace_enabled_;
+    std::vector<DecisionTrace> trace_buffer_;
+    uint64_t trace_sequence_;
+    
+    // 自适应条件顺序（与conditions_一一对应，规则的条件区间内存放）
+    bool adaptive_ordering_;
+    std::vector<uint32_t> condition_order_;         // 各规则当前的评估顺序（条件在规则内的原始索引）
+    std::vector<ConditionStats> condition_stats_;   // 按条件原始索引存放
+    RuleEvaluationStats evaluation_stats_;
+    
+    /**
+     * 按规则重建条件顺序和统计（恢复编写顺序）
+     */
+    void ResetConditionOrder();
+    
+    /**
+     * 按统计重排每条规则的条件顺序
+     */
+    void ReorderConditions();
+    
+    // 滑动窗口条件（按信号各一个缓冲区，在添加规则时按最长窗口分配）
+    bool windows_active_;
+    size_t cpu_window_seconds_;
+    size_t audio_window_seconds_;
+    SignalWindow cpu_window_;
+    SignalWindow audio_window_;
+    bool category_window_active_;           // 是否存在APP_CATEGORY_SUSTAINED条件
+    bool has_window_category_;
+    AppCategory window_category_;           // 最近一次采样的应用类别
+    double window_category_since_;          // 该类别开始的时间（秒）
+    double window_now_;                     // 最近一次采样的时间（秒）
+    
+    /**
+     * 按规则中的窗口条件重新分配各信号的窗口
+     */
+    void AllocateWindows();
+    
+    /**
+     * 统计一段条件中的窗口条件（更新各信号需要的最长窗口）
+     */
+    void ScanWindowConditions(size_t first, size_t count);
+    
+    /**
+     * 把一次采样计入各信号的窗口（常数时间）
+     */
+    void UpdateWindows(SystemState& state);
+    
+    /**
+     * 确保字段已采样（惰性采样）
+     */
+    void EnsureProbed(SystemState& state, StateProbe probe) {
+        uint32_t bit = ProbeBit(probe);
+        if ((state.pending_probes & bit) != 0) {
+            state.pending_probes &= ~bit;
+            evaluation_stats_.probes_performed[static_cast<size_t>(probe)]++;
+            if (state.prober != nullptr) {
+                state.prober->Probe(probe, state);
+            }
+        }
+    }
+    
+    /**
+     * 按优先级评估规则
+     * kTrace为false时编译出的代码不包含任何追踪逻辑
+     * @param state 系统状态
+     * @param sample_cost 是否对每个条件计时
+     * @param trace 追踪记录（kTrace为false时忽略）
+     * @return 灯光模式
+     */
+    template <bool kTrace>
+    LightMode EvaluateRules(SystemState& state, DecisionTrace* trace, bool sample_cost);
+    
+    /**
+     * 描述条件内容（用于解释决策）
+     */
+    static std::string DescribeCondition(const Condition& condition);
     
     /**
-     * 检查条件是否满足
+     * 检查条件是否满足（条件用到的字段尚未采样时先采样）
      * @param condition 条件
      * @param state 系统状态
      * @return 是否满足
      */
-    bool CheckCondition(const Condition& condition, const SystemState& state);
+    bool CheckCondition(const StoredCondition& condition, SystemState& state);
     
     /**
      * 检查时间段条件
-     * @param time_range 时间段
+     * @param condition 时间段条件
      * @param current_hour 当前小时
      * @param current_minute 当前分钟
      * @param is_weekday 是否是工作日
      * @return 是否在时间段内且符合工作日类型要求
      */
-    bool CheckTimeRange(const TimeRange& time_range, int current_hour, int current_minute, bool is_weekday);
+    static bool CheckTimeRange(const StoredCondition& condition, int current_hour, int current_minute, bool is_weekday);
 };
 
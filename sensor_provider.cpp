@@ -0,0 +1,193 @@
+#include "sensor_provider.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const double kNoReading = std::numeric_limits<double>::quiet_NaN();
+
+/**
+ * 读取短文本文件的第一行（仅在发现阶段使用）
+ */
+std::string ReadFirstLine(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+bool StartsWith(const std::string& text, const char* prefix) {
+    return text.compare(0, std::strlen(prefix), prefix) == 0;
+}
+
+bool EndsWith(const std::string& text, const char* suffix) {
+    size_t length = std::strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+#ifndef _WIN32
+/**
+ * 列出目录下以prefix开头的条目（按名称排序，保证传感器顺序稳定）
+ */
+std::vector<std::string> ListEntries(const std::string& dir_path, const char* prefix) {
+    std::vector<std::string> entries;
+    DIR* dir = opendir(dir_path.c_str());
+    if (dir == nullptr) {
+        return entries;
+    }
+    while (struct dirent* ent = readdir(dir)) {
+        std::string name = ent->d_name;
+        if (StartsWith(name, prefix)) {
+            entries.push_back(name);
+        }
+    }
+    closedir(dir);
+    std::sort(entries.begin(), entries.end());
+    return entries;
+}
+#endif
+
+}  // namespace
+
+SensorProvider::SensorProvider(const std::string& sysfs_root) : sysfs_root_(sysfs_root) {
+}
+
+SensorProvider::~SensorProvider() {
+    CloseAll();
+}
+
+SensorKind SensorProvider::ClassifySensor(const std::string& name) {
+    static const char* const kCpuNames[] = {
+        "coretemp", "k10temp", "k8temp", "zenpower", "cpu_thermal", "cpu-thermal", "x86_pkg_temp", "soc_thermal"
+    };
+    static const char* const kGpuNames[] = {
+        "amdgpu", "radeon", "nouveau", "nvidia", "i915", "gpu_thermal", "gpu-thermal"
+    };
+    for (const char* cpu_name : kCpuNames) {
+        if (name == cpu_name) {
+            return SensorKind::CPU;
+        }
+    }
+    for (const char* gpu_name : kGpuNames) {
+        if (name == gpu_name) {
+            return SensorKind::GPU;
+        }
+    }
+    return SensorKind::OTHER;
+}
+
+void SensorProvider::CloseAll() {
+#ifndef _WIN32
+    for (int fd : fds_) {
+        close(fd);
+    }
+#endif
+    fds_.clear();
+    readings_.clear();
+}
+
+void SensorProvider::AddSensor(const std::string& path, const std::string& label, SensorKind kind) {
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    fds_.push_back(fd);
+    readings_.push_back(SensorReading{label, kind, kNoReading});
+#else
+    (void)path;
+    (void)label;
+    (void)kind;
+#endif
+}
+
+#ifdef _WIN32
+
+size_t SensorProvider::Discover() {
+    // Windows没有sysfs；温度需要通过WMI或厂商SDK读取，这里不提供传感器
+    CloseAll();
+    return 0;
+}
+
+bool SensorProvider::Sample() {
+    return false;
+}
+
+#else
+
+size_t SensorProvider::Discover() {
+    CloseAll();
+
+    // hwmon：每个设备一个目录，name文件给出驱动名，temp*_input为毫摄氏度
+    std::string hwmon_root = sysfs_root_ + "/class/hwmon";
+    for (const std::string& device : ListEntries(hwmon_root, "hwmon")) {
+        std::string device_path = hwmon_root + "/" + device;
+        std::string name = ReadFirstLine(device_path + "/name");
+        SensorKind kind = ClassifySensor(name);
+        for (const std::string& entry : ListEntries(device_path, "temp")) {
+            if (!EndsWith(entry, "_input")) {
+                continue;
+            }
+            std::string label = (name.empty() ? device : name) + "/" + entry.substr(0, entry.size() - 6);
+            AddSensor(device_path + "/" + entry, label, kind);
+        }
+    }
+
+    // 热区：type文件给出热区类型，temp为毫摄氏度
+    std::string thermal_root = sysfs_root_ + "/class/thermal";
+    for (const std::string& zone : ListEntries(thermal_root, "thermal_zone")) {
+        std::string zone_path = thermal_root + "/" + zone;
+        std::string type = ReadFirstLine(zone_path + "/type");
+        AddSensor(zone_path + "/temp", zone + " (" + type + ")", ClassifySensor(type));
+    }
+
+    return readings_.size();
+}
+
+bool SensorProvider::Sample() {
+    bool any = false;
+    char buffer[32];
+    for (size_t i = 0; i < fds_.size(); i++) {
+        // sysfs属性每次从偏移0读取即可得到最新值，不需要重新打开
+        ssize_t length = pread(fds_[i], buffer, sizeof(buffer) - 1, 0);
+        if (length <= 0) {
+            readings_[i].celsius = kNoReading;
+            continue;
+        }
+        buffer[length] = '\0';
+        char* end = nullptr;
+        long millidegrees = std::strtol(buffer, &end, 10);
+        if (end == buffer) {
+            readings_[i].celsius = kNoReading;
+            continue;
+        }
+        readings_[i].celsius = static_cast<double>(millidegrees) / 1000.0;
+        any = true;
+    }
+    return any;
+}
+
+#endif
+
+double SensorProvider::GetMaxTemperature(SensorKind kind) const {
+    double max_celsius = kNoReading;
+    for (const auto& reading : readings_) {
+        if (reading.kind != kind || std::isnan(reading.celsius)) {
+            continue;
+        }
+        if (std::isnan(max_celsius) || reading.celsius > max_celsius) {
+            max_celsius = reading.celsius;
+        }
+    }
+    return max_celsius;
+}
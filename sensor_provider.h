@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * 传感器所属硬件
+ */
+enum class SensorKind {
+    CPU,
+    GPU,
+    OTHER
+};
+
+/**
+ * 单个温度传感器
+ */
+struct SensorReading {
+    std::string label;      // 例如 "coretemp/temp1"、"thermal_zone0 (x86_pkg_temp)"
+    SensorKind kind;
+    double celsius;         // 最近一次读数（摄氏度），读取失败时为NaN
+};
+
+/**
+ * 硬件温度传感器提供者
+ * 启动时在sysfs根目录下发现hwmon（class/hwmon下各设备的temp<N>_input）和
+ * 热区（class/thermal下各thermal_zone<N>的temp）传感器，并保持文件打开；
+ * 每次采样只对每个传感器执行一次pread，不再打开、查找或分配内存。
+ * sysfs根目录可配置，便于用伪造的目录树测试。
+ */
+class SensorProvider {
+public:
+    /**
+     * @param sysfs_root sysfs根目录（默认 "/sys"）
+     */
+    explicit SensorProvider(const std::string& sysfs_root = "/sys");
+    ~SensorProvider();
+
+    SensorProvider(const SensorProvider&) = delete;
+    SensorProvider& operator=(const SensorProvider&) = delete;
+
+    /**
+     * 重新发现传感器（关闭之前打开的文件）
+     * @return 发现的传感器数
+     */
+    size_t Discover();
+
+    /**
+     * 读取所有传感器
+     * @return 是否至少有一个传感器读取成功
+     */
+    bool Sample();
+
+    /**
+     * 某类硬件所有传感器中的最高温度
+     * @param kind 硬件类型
+     * @return 摄氏度，没有可用读数时返回NaN
+     */
+    double GetMaxTemperature(SensorKind kind) const;
+
+    const std::vector<SensorReading>& GetReadings() const { return readings_; }
+    size_t GetSensorCount() const { return readings_.size(); }
+
+    /**
+     * 根据hwmon的name或热区的type判断硬件类型
+     */
+    static SensorKind ClassifySensor(const std::string& name);
+
+private:
+    std::string sysfs_root_;
+    std::vector<int> fds_;                  // 与readings_一一对应
+    std::vector<SensorReading> readings_;
+
+    void CloseAll();
+    void AddSensor(const std::string& path, const std::string& label, SensorKind kind);
+};
@@ -0,0 +1,257 @@
+#include "session_aggregator.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace {
+
+const char kMagic[4] = {'S', 'S', 'E', 'S'};
+const uint32_t kVersion = 1;
+const size_t kMaxNameLength = 255;
+
+/**
+ * 快照文件头，之后是当前会话的进程名和各应用的累计（长度前缀的名称 + 秒数）
+ */
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t day;
+    uint32_t session_count;
+    uint64_t category_seconds[kAppCategoryCount];
+    uint64_t mode_seconds[kLightModeCount];
+    int64_t last_tick;
+    int64_t session_start;
+    int64_t session_last_seen;
+    uint64_t session_seconds;
+    uint8_t has_last_tick;
+    uint8_t last_mode;
+    uint8_t has_session;
+    uint8_t session_category;
+    uint32_t app_count;
+};
+
+static_assert(sizeof(SnapshotHeader) == 176, "SnapshotHeader必须为176字节");
+
+void WriteName(std::ofstream& file, const std::string& name) {
+    uint8_t length = static_cast<uint8_t>(std::min(name.size(), kMaxNameLength));
+    file.write(reinterpret_cast<const char*>(&length), 1);
+    file.write(name.data(), length);
+}
+
+bool ReadName(std::ifstream& file, std::string& name) {
+    uint8_t length = 0;
+    if (!file.read(reinterpret_cast<char*>(&length), 1)) {
+        return false;
+    }
+    name.resize(length);
+    return length == 0 || static_cast<bool>(file.read(&name[0], length));
+}
+
+}  // namespace
+
+SessionAggregator::SessionAggregator(uint32_t max_gap_seconds)
+    : max_gap_seconds_(max_gap_seconds), has_last_tick_(false), last_tick_(0), last_mode_(LightMode::DEFAULT),
+      has_session_(false), session_(), session_app_seconds_(nullptr) {
+}
+
+void SessionAggregator::Update(int64_t timestamp, int32_t day, const std::string& process_name,
+                               AppCategory category, LightMode mode) {
+    // 类别和模式用作累计数组的下标，超出枚举范围的值按未知类别/默认模式计
+    if (static_cast<size_t>(category) > static_cast<size_t>(AppCategory::UNKNOWN)) {
+        category = AppCategory::UNKNOWN;
+    }
+    if (static_cast<size_t>(mode) > static_cast<size_t>(LightMode::DEFAULT)) {
+        mode = LightMode::DEFAULT;
+    }
+    // 上一个tick到现在的时长计入上一个tick的状态；间隔过长（程序未运行、系统休眠）时不计入
+    int64_t elapsed = has_last_tick_ ? timestamp - last_tick_ : 0;
+    bool gap = has_last_tick_ && (elapsed < 0 || elapsed > static_cast<int64_t>(max_gap_seconds_));
+    if (has_last_tick_ && !gap && elapsed > 0) {
+        uint64_t seconds = static_cast<uint64_t>(elapsed);
+        usage_.mode_seconds[static_cast<size_t>(last_mode_)] += seconds;
+        if (has_session_) {
+            session_.seconds += seconds;
+            usage_.category_seconds[static_cast<size_t>(session_.category)] += seconds;
+            if (session_app_seconds_ != nullptr) {
+                *session_app_seconds_ += seconds;
+            }
+        }
+    }
+
+    if (day != usage_.day) {
+        // 新的一天：当天的会话在午夜结束，累计从0开始
+        CloseSession();
+        ResetDay(day);
+    } else if (gap) {
+        CloseSession();
+    }
+
+    if (has_session_ && (session_.category != category || session_.process_name != process_name)) {
+        CloseSession();
+    }
+    if (!has_session_) {
+        OpenSession(timestamp, process_name, category);
+    }
+    session_.last_seen = timestamp;
+
+    has_last_tick_ = true;
+    last_tick_ = timestamp;
+    last_mode_ = mode;
+}
+
+void SessionAggregator::OpenSession(int64_t timestamp, const std::string& process_name, AppCategory category) {
+    session_.process_name = process_name;
+    session_.category = category;
+    session_.start = timestamp;
+    session_.last_seen = timestamp;
+    session_.seconds = 0;
+    session_app_seconds_ = process_name.empty() ? nullptr : &app_seconds_[process_name];
+    has_session_ = true;
+    usage_.session_count++;
+    if (event_handler_) {
+        event_handler_(SessionEventType::OPENED, session_);
+    }
+}
+
+void SessionAggregator::CloseSession() {
+    if (!has_session_) {
+        return;
+    }
+    has_session_ = false;
+    session_app_seconds_ = nullptr;
+    if (event_handler_) {
+        event_handler_(SessionEventType::CLOSED, session_);
+    }
+}
+
+void SessionAggregator::ResetDay(int32_t day) {
+    usage_ = DailyUsage();
+    usage_.day = day;
+    app_seconds_.clear();
+    session_app_seconds_ = nullptr;
+}
+
+uint64_t SessionAggregator::GetCategorySeconds(int32_t day, AppCategory category) const {
+    if (day != usage_.day) {
+        return 0;
+    }
+    return usage_.category_seconds[static_cast<size_t>(category)];
+}
+
+uint64_t SessionAggregator::GetAppSeconds(int32_t day, const std::string& process_name) const {
+    if (day != usage_.day) {
+        return 0;
+    }
+    auto it = app_seconds_.find(process_name);
+    return it != app_seconds_.end() ? it->second : 0;
+}
+
+void SessionAggregator::FillSystemState(int32_t day, SystemState& state) const {
+    for (size_t i = 0; i < usage_.category_seconds.size(); i++) {
+        uint64_t seconds = day == usage_.day ? usage_.category_seconds[i] : 0;
+        state.category_seconds_today[i] = static_cast<uint32_t>(std::min<uint64_t>(seconds, UINT32_MAX));
+    }
+}
+
+bool SessionAggregator::SaveSnapshot(const std::string& file_path) const {
+    std::string temp_path = file_path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        SnapshotHeader header = {};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.day = usage_.day;
+        header.session_count = usage_.session_count;
+        std::copy(usage_.category_seconds.begin(), usage_.category_seconds.end(), header.category_seconds);
+        std::copy(usage_.mode_seconds.begin(), usage_.mode_seconds.end(), header.mode_seconds);
+        header.last_tick = last_tick_;
+        header.has_last_tick = has_last_tick_ ? 1 : 0;
+        header.last_mode = static_cast<uint8_t>(last_mode_);
+        header.has_session = has_session_ ? 1 : 0;
+        header.session_category = static_cast<uint8_t>(session_.category);
+        header.session_start = session_.start;
+        header.session_last_seen = session_.last_seen;
+        header.session_seconds = session_.seconds;
+        header.app_count = static_cast<uint32_t>(app_seconds_.size());
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        WriteName(file, has_session_ ? session_.process_name : std::string());
+        for (const auto& pair : app_seconds_) {
+            WriteName(file, pair.first);
+            file.write(reinterpret_cast<const char*>(&pair.second), sizeof(pair.second));
+        }
+        if (!file.good()) {
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    return MoveFileExA(temp_path.c_str(), file_path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(temp_path.c_str(), file_path.c_str()) == 0;
+#endif
+}
+
+bool SessionAggregator::LoadSnapshot(const std::string& file_path, int32_t day) {
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    SnapshotHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.version != kVersion || header.day != day ||
+        header.last_mode > static_cast<uint8_t>(LightMode::DEFAULT) ||
+        header.session_category > static_cast<uint8_t>(AppCategory::UNKNOWN)) {
+        return false;
+    }
+
+    std::string session_process;
+    std::vector<std::pair<std::string, uint64_t>> apps;
+    if (!ReadName(file, session_process)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < header.app_count; i++) {
+        std::string name;
+        uint64_t seconds = 0;
+        if (!ReadName(file, name) || !file.read(reinterpret_cast<char*>(&seconds), sizeof(seconds))) {
+            return false;
+        }
+        apps.emplace_back(std::move(name), seconds);
+    }
+
+    ResetDay(day);
+    usage_.session_count = header.session_count;
+    std::copy(header.category_seconds, header.category_seconds + kAppCategoryCount, usage_.category_seconds.begin());
+    std::copy(header.mode_seconds, header.mode_seconds + kLightModeCount, usage_.mode_seconds.begin());
+    for (auto& app : apps) {
+        app_seconds_[app.first] = app.second;
+    }
+    has_last_tick_ = header.has_last_tick != 0;
+    last_tick_ = header.last_tick;
+    last_mode_ = static_cast<LightMode>(header.last_mode);
+
+    // 恢复当前会话（不发出开始事件）；重启间隔超过上限时，下一个tick会把它结束
+    has_session_ = header.has_session != 0;
+    if (has_session_) {
+        session_.process_name = session_process;
+        session_.category = static_cast<AppCategory>(header.session_category);
+        session_.start = header.session_start;
+        session_.last_seen = header.session_last_seen;
+        session_.seconds = header.session_seconds;
+        session_app_seconds_ = session_process.empty() ? nullptr : &app_seconds_[session_process];
+    }
+    return true;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "rule_engine.h"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * 应用使用会话：同一前台进程（且类别不变）的连续tick
+ */
+struct AppSession {
+    std::string process_name;   // 进程名（没有前台窗口时为空）
+    AppCategory category;
+    int64_t start;              // 开始时间（Unix时间，秒）
+    int64_t last_seen;          // 最后一个tick的时间
+    uint64_t seconds;           // 累计时长（秒，不含超过间隔上限的空档）
+};
+
+/**
+ * 会话事件类型
+ */
+enum class SessionEventType {
+    OPENED,
+    CLOSED
+};
+
+/**
+ * 一天的累计使用时长
+ */
+struct DailyUsage {
+    int32_t day = 0;                                    // 本地日期（yyyymmdd），0表示尚无数据
+    std::array<uint64_t, kAppCategoryCount> category_seconds = {};  // 按AppCategory的取值
+    std::array<uint64_t, kLightModeCount> mode_seconds = {};        // 按LightMode的取值
+    uint32_t session_count = 0;                         // 当天开始的会话数
+};
+
+/**
+ * 应用使用会话统计
+ * 把每个tick的（前台进程、类别、灯光模式）流合并为会话，发出会话开始/结束事件，
+ * 并维护当天各类别、各模式、各应用的累计时长。每个tick的更新为O(1)：
+ * 两个tick之间的时长计入前一个tick的状态，当前会话持有其应用计数器的引用，不需要再查找。
+ * 当天的累计可以保存为快照，重启后恢复。
+ */
+class SessionAggregator {
+public:
+    using EventHandler = std::function<void(SessionEventType, const AppSession&)>;
+
+    /**
+     * @param max_gap_seconds 两个tick的间隔超过它时视为程序未运行：该间隔不计入时长，当前会话结束
+     */
+    explicit SessionAggregator(uint32_t max_gap_seconds = 60);
+
+    /**
+     * 设置会话事件的回调（在Update中同步调用）
+     */
+    void SetEventHandler(EventHandler handler) { event_handler_ = std::move(handler); }
+
+    /**
+     * 处理一个tick
+     * @param timestamp Unix时间（秒）
+     * @param day 本地日期（yyyymmdd）；日期变化时结束当前会话并清零当天的累计
+     * @param process_name 前台进程名（为空表示没有前台窗口）
+     * @param category 应用类别
+     * @param mode 本tick的灯光模式
+     */
+    void Update(int64_t timestamp, int32_t day, const std::string& process_name, AppCategory category, LightMode mode);
+
+    /**
+     * 当天的累计（day与当前统计的日期不同时各项为0）
+     */
+    uint64_t GetCategorySeconds(int32_t day, AppCategory category) const;
+    uint64_t GetAppSeconds(int32_t day, const std::string& process_name) const;
+    const DailyUsage& GetDailyUsage() const { return usage_; }
+
+    /**
+     * 当前会话，没有会话时返回nullptr
+     */
+    const AppSession* GetCurrentSession() const { return has_session_ ? &session_ : nullptr; }
+
+    /**
+     * 把今天的累计填入规则引擎的状态（供CATEGORY_USAGE_TODAY条件使用）
+     */
+    void FillSystemState(int32_t day, SystemState& state) const;
+
+    /**
+     * 保存快照（先写临时文件再替换）
+     * @return 是否成功
+     */
+    bool SaveSnapshot(const std::string& file_path) const;
+
+    /**
+     * 加载快照：只恢复与day同一天的累计和当前会话，其他日期的快照被忽略
+     * @return 是否恢复了快照
+     */
+    bool LoadSnapshot(const std::string& file_path, int32_t day);
+
+private:
+    uint32_t max_gap_seconds_;
+    EventHandler event_handler_;
+
+    DailyUsage usage_;
+    std::unordered_map<std::string, uint64_t> app_seconds_;    // 当天各进程的累计时长
+
+    bool has_last_tick_;
+    int64_t last_tick_;
+    LightMode last_mode_;
+
+    bool has_session_;
+    AppSession session_;
+    uint64_t* session_app_seconds_;     // 当前会话进程在app_seconds_中的计数器（元素引用在rehash后仍有效）
+
+    void OpenSession(int64_t timestamp, const std::string& process_name, AppCategory category);
+    void CloseSession();
+    void ResetDay(int32_t day);
+};
@@ -0,0 +1,71 @@
+#include "signal_window.h"
+#include <algorithm>
+
+SignalWindow::SignalWindow()
+    : has_samples_(false), first_second_(0), current_second_(0), total_sum_(0.0), total_count_(0.0) {
+}
+
+void SignalWindow::Allocate(size_t max_window_seconds) {
+    if (max_window_seconds == 0) {
+        sums_.clear();
+        sums_.shrink_to_fit();
+        counts_.clear();
+        counts_.shrink_to_fit();
+    } else {
+        // 多一个槽位保存窗口起点之前那一秒的累计值
+        sums_.assign(max_window_seconds + 1, 0.0);
+        counts_.assign(max_window_seconds + 1, 0.0);
+    }
+    Reset();
+}
+
+void SignalWindow::Reset() {
+    has_samples_ = false;
+    first_second_ = 0;
+    current_second_ = 0;
+    total_sum_ = 0.0;
+    total_count_ = 0.0;
+}
+
+void SignalWindow::Push(int64_t second, double value) {
+    if (sums_.empty() || second < 0) {
+        return;
+    }
+
+    if (!has_samples_) {
+        has_samples_ = true;
+        first_second_ = second;
+        current_second_ = second;
+    } else if (second > current_second_) {
+        // 中间没有采样的秒沿用之前的累计值；间隔超过容量时只需要写满一圈
+        int64_t capacity = static_cast<int64_t>(sums_.size());
+        int64_t from = std::max(current_second_ + 1, second - capacity + 1);
+        for (int64_t s = from; s < second; s++) {
+            sums_[Slot(s)] = total_sum_;
+            counts_[Slot(s)] = total_count_;
+        }
+        current_second_ = second;
+    }
+    // second < current_second_（时钟回退）时计入当前秒
+
+    total_sum_ += value;
+    total_count_ += 1.0;
+    sums_[Slot(current_second_)] = total_sum_;
+    counts_[Slot(current_second_)] = total_count_;
+}
+
+bool SignalWindow::GetMean(size_t window_seconds, double& mean) const {
+    if (!has_samples_ || window_seconds == 0 || window_seconds >= sums_.size()) {
+        return false;
+    }
+    int64_t start = current_second_ - static_cast<int64_t>(window_seconds);
+    if (start < first_second_) {
+        return false;   // 历史还不足一个窗口
+    }
+    double count = total_count_ - counts_[Slot(start)];
+    if (count <= 0.0) {
+        return false;
+    }
+    mean = (total_sum_ - sums_[Slot(start)]) / count;
+    return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * 单个信号的滑动窗口（按秒分桶的累计和环形缓冲区）
+ * 每个槽位保存截至该秒末尾的累计和与累计采样数，
+ * 任意不超过容量的窗口的均值 = (当前累计 - 窗口起点累计) / (采样数之差)，
+ * 因此同一信号上不同长度的窗口共用一个缓冲区，采样和查询都是常数时间。
+ * 缓冲区只在Allocate时分配。
+ */
+class SignalWindow {
+public:
+    SignalWindow();
+
+    /**
+     * 分配缓冲区并清空历史
+     * @param max_window_seconds 需要支持的最长窗口（秒），0表示释放缓冲区
+     */
+    void Allocate(size_t max_window_seconds);
+
+    /**
+     * 清空历史（保留缓冲区）
+     */
+    void Reset();
+
+    bool IsAllocated() const { return !sums_.empty(); }
+
+    /**
+     * 记录一个采样
+     * @param second 采样时间（单调时钟的整秒数，不应倒退）
+     * @param value 采样值
+     */
+    void Push(int64_t second, double value);
+
+    /**
+     * 最近window_seconds秒内采样的均值
+     * @param window_seconds 窗口长度（秒），不能超过Allocate时的长度
+     * @param mean 输出均值
+     * @return 历史不足一个窗口或窗口内没有采样时返回false
+     */
+    bool GetMean(size_t window_seconds, double& mean) const;
+
+private:
+    std::vector<double> sums_;          // 截至各秒末尾的累计和
+    std::vector<double> counts_;        // 截至各秒末尾的累计采样数
+    bool has_samples_;
+    int64_t first_second_;              // 第一个采样所在的秒
+    int64_t current_second_;            // 最近一个采样所在的秒
+    double total_sum_;
+    double total_count_;
+
+    size_t Slot(int64_t second) const { return static_cast<size_t>(second % static_cast<int64_t>(sums_.size())); }
+};
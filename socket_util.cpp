@@ -0,0 +1,68 @@
+// winsock2.h必须在windows.h之前包含
+#ifdef _WIN32
+#include <winsock2.h>
+#endif
+
+#include "socket_util.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+bool InitSockets() {
+#ifdef _WIN32
+    WSADATA wsa_data;
+    return WSAStartup(MAKEWORD(2, 2), &wsa_data) == 0;
+#else
+    return true;
+#endif
+}
+
+void CleanupSockets() {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void CloseSocketHandle(SocketHandle socket_handle) {
+#ifdef _WIN32
+    closesocket(socket_handle);
+#else
+    close(socket_handle);
+#endif
+}
+
+bool SetNonBlocking(SocketHandle socket_handle) {
+#ifdef _WIN32
+    u_long enabled = 1;
+    return ioctlsocket(socket_handle, FIONBIO, &enabled) == 0;
+#else
+    int flags = fcntl(socket_handle, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket_handle, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+bool WouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+int WaitReadable(SocketHandle socket_handle, int timeout_ms) {
+#ifdef _WIN32
+    WSAPOLLFD fd = {};
+    fd.fd = socket_handle;
+    fd.events = POLLIN;
+    return WSAPoll(&fd, 1, timeout_ms);
+#else
+    pollfd fd = {};
+    fd.fd = socket_handle;
+    fd.events = POLLIN;
+    return poll(&fd, 1, timeout_ms);
+#endif
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+// 套接字句柄（头文件中不包含winsock2.h，避免与windows.h的包含顺序冲突）
+#ifdef _WIN32
+typedef uintptr_t SocketHandle;
+const SocketHandle kInvalidSocket = ~static_cast<SocketHandle>(0);
+#else
+typedef int SocketHandle;
+const SocketHandle kInvalidSocket = -1;
+#endif
+
+/**
+ * 初始化套接字库（Windows下调用WSAStartup，可多次调用，需与CleanupSockets配对）
+ */
+bool InitSockets();
+
+/**
+ * 释放套接字库
+ */
+void CleanupSockets();
+
+/**
+ * 关闭套接字
+ */
+void CloseSocketHandle(SocketHandle socket_handle);
+
+/**
+ * 设为非阻塞模式
+ */
+bool SetNonBlocking(SocketHandle socket_handle);
+
+/**
+ * 最近一次套接字调用是否因非阻塞而未完成
+ */
+bool WouldBlock();
+
+/**
+ * 等待套接字可读
+ * @param timeout_ms 超时（毫秒）
+ * @return 大于0表示可读，0表示超时，小于0表示出错
+ */
+int WaitReadable(SocketHandle socket_handle, int timeout_ms);
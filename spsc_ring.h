@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+/**
+ * 单生产者/单消费者无锁环形队列
+ * 容量固定（必须为2的幂），生产者和消费者各自只写一个原子下标，
+ * 入队和出队都是wait-free的，不会分配内存。
+ * @tparam T 元素类型（必须可平凡复制，以保证定长二进制记录语义）
+ * @tparam Capacity 容量（2的幂）
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity必须是2的幂");
+    static_assert(std::is_trivially_copyable<T>::value, "元素必须可平凡复制");
+
+public:
+    SpscRing() : head_(0), tail_(0) {}
+
+    /**
+     * 入队（仅生产者线程调用）
+     * @return 队列已满时返回false，元素被丢弃
+     */
+    bool TryPush(const T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= Capacity) {
+            return false;
+        }
+        buffer_[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * 出队（仅消费者线程调用）
+     * @return 队列为空时返回false
+     */
+    bool TryPop(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = buffer_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    // 生产者和消费者的下标放在不同缓存行，避免伪共享
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+    alignas(64) T buffer_[Capacity];
+};
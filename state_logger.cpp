@@ -0,0 +1,258 @@
+#include "state_logger.h"
+#include "case_fold.h"
+#include "tick_budget.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+// 队列为空时后台线程的轮询间隔
+const int kConsumerIdleMs = 20;
+
+const char* const kWeekdays[] = {"周日", "周一", "周二", "周三", "周四", "周五", "周六"};
+
+std::string FormatTimestamp(int64_t timestamp_ms) {
+    std::time_t time_t = static_cast<std::time_t>(timestamp_ms / 1000);
+    std::tm tm_buf;
+    localtime_s(&tm_buf, &time_t);
+
+    std::ostringstream oss;
+    oss << std::put_time(&tm_buf, "%Y-%m-%d %H:%M:%S");
+    oss << '.' << std::setfill('0') << std::setw(3) << (timestamp_ms % 1000);
+    return oss.str();
+}
+
+/**
+ * 格式化时长，如 "1h05m"、"3m20s"
+ */
+std::string FormatDuration(uint32_t seconds) {
+    std::ostringstream oss;
+    if (seconds >= 3600) {
+        oss << seconds / 3600 << "h" << std::setfill('0') << std::setw(2) << seconds % 3600 / 60 << "m";
+    } else {
+        oss << seconds / 60 << "m" << std::setfill('0') << std::setw(2) << seconds % 60 << "s";
+    }
+    return oss.str();
+}
+
+}  // namespace
+
+StateLogger::StateLogger(std::ostream& out)
+    : out_(out), running_(false), dropped_(0), debug_mode_(false), log_interval_ms_(0),
+      has_last_(false), last_(), last_log_ms_(0) {
+}
+
+StateLogger::~StateLogger() {
+    Stop();
+}
+
+void StateLogger::Start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    consumer_ = std::thread(&StateLogger::ConsumerLoop, this);
+}
+
+void StateLogger::Stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (consumer_.joinable()) {
+        consumer_.join();
+    }
+}
+
+void StateLogger::LogTick(const StateLogRecord& record) {
+    bool changed = !has_last_ || HasChanged(record, last_);
+    bool interval_elapsed = log_interval_ms_ > 0 &&
+                            record.timestamp_ms - last_log_ms_ >= log_interval_ms_;
+    if (!changed && !interval_elapsed) {
+        return;
+    }
+
+    Push(record);
+    last_ = record;
+    last_log_ms_ = record.timestamp_ms;
+    has_last_ = true;
+}
+
+void StateLogger::LogModeChange(int64_t timestamp_ms, LightMode from, LightMode to, const std::string& reason) {
+    StateLogRecord record = {};
+    record.timestamp_ms = timestamp_ms;
+    record.kind = StateLogKind::MODE_CHANGED;
+    record.light_mode = to;
+    record.previous_mode = from;
+    CopyText(record.decision_reason, sizeof(record.decision_reason), reason);
+    Push(record);
+}
+
+void StateLogger::LogSessionClosed(int64_t timestamp_ms, const std::string& process_name, AppCategory category,
+                                   uint64_t session_seconds, uint64_t category_seconds_today) {
+    if (!debug_mode_) {
+        return;
+    }
+    StateLogRecord record = {};
+    record.timestamp_ms = timestamp_ms;
+    record.kind = StateLogKind::SESSION_CLOSED;
+    record.category = category;
+    record.session_seconds = static_cast<uint32_t>(std::min<uint64_t>(session_seconds, UINT32_MAX));
+    record.category_seconds_today = static_cast<uint32_t>(std::min<uint64_t>(category_seconds_today, UINT32_MAX));
+    CopyText(record.process_name, sizeof(record.process_name), process_name);
+    Push(record);
+}
+
+void StateLogger::Push(const StateLogRecord& record) {
+    if (!ring_.TryPush(record)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool StateLogger::HasChanged(const StateLogRecord& a, const StateLogRecord& b) {
+    return a.kind != b.kind ||
+           a.category != b.category ||
+           a.light_mode != b.light_mode ||
+           a.process_id != b.process_id ||
+           a.has_audio_activity != b.has_audio_activity;
+}
+
+void StateLogger::CopyText(char* dst, size_t capacity, const std::string& src) {
+    if (capacity == 0) {
+        return;
+    }
+    size_t length = std::min(src.size(), capacity - 1);
+    if (length < src.size()) {
+        // 回退到UTF-8字符边界（跳过续字节 10xxxxxx）
+        while (length > 0 && (static_cast<unsigned char>(src[length]) & 0xC0) == 0x80) {
+            length--;
+        }
+    }
+    std::memcpy(dst, src.data(), length);
+    dst[length] = '\0';
+}
+
+void StateLogger::ConsumerLoop() {
+    StateLogRecord record;
+    std::string text;
+    for (;;) {
+        // 先读取运行标志再排空队列，保证Stop之前入队的记录都会被输出
+        bool running = running_.load(std::memory_order_acquire);
+
+        bool wrote = false;
+        while (ring_.TryPop(record)) {
+            text.clear();
+            Format(record, text);
+            out_ << text;
+            wrote = true;
+        }
+        if (wrote) {
+            out_.flush();
+        }
+
+        if (!running) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(kConsumerIdleMs));
+    }
+}
+
+void StateLogger::Format(const StateLogRecord& record, std::string& text) const {
+    std::ostringstream oss;
+
+    if (record.kind == StateLogKind::MODE_CHANGED) {
+        oss << "\n>>> Mode changed to: " << RuleEngine::GetLightModeName(record.light_mode)
+            << " (from " << RuleEngine::GetLightModeName(record.previous_mode) << ")\n";
+        if (record.decision_reason[0] != '\0') {
+            oss << ">>> " << record.decision_reason << "\n";
+        }
+        oss << "\n";
+        text = oss.str();
+        return;
+    }
+
+    if (record.kind == StateLogKind::SESSION_CLOSED) {
+        oss << "[" << FormatTimestamp(record.timestamp_ms) << "] 会话结束: "
+            << (record.process_name[0] != '\0' ? record.process_name : "（无前台窗口）")
+            << " (" << AppClassifier::GetCategoryName(record.category) << ") 持续 "
+            << FormatDuration(record.session_seconds) << "，该类别今日累计 "
+            << FormatDuration(record.category_seconds_today) << "\n";
+        text = oss.str();
+        return;
+    }
+
+    const char* weekday = kWeekdays[record.weekday % 7];
+
+    auto skipped = [&record](StateProbe probe) {
+        return (record.skipped_probes & ProbeBit(probe)) != 0;
+    };
+    const char* const kNotProbed = (record.budget_fallbacks & FallbackBit(BudgetFallback::HELD_MODE)) != 0
+        ? "未采样（超出tick预算）" : "未采样（更高优先级规则已命中）";
+    auto stale = [&record](StateProbe probe) {
+        return (record.stale_probes & ProbeBit(probe)) != 0 ? "（过期）" : "";
+    };
+
+    if (record.kind == StateLogKind::NO_WINDOW) {
+        oss << "[" << FormatTimestamp(record.timestamp_ms) << "] 无法获取窗口信息\n";
+    } else if (skipped(StateProbe::APP_CATEGORY)) {
+        oss << "[" << FormatTimestamp(record.timestamp_ms) << "]\n";
+        oss << "  应用类别: " << kNotProbed << "\n";
+    } else {
+        oss << "[" << FormatTimestamp(record.timestamp_ms) << "]\n";
+        oss << "  应用类别: " << AppClassifier::GetCategoryName(record.category) << stale(StateProbe::APP_CATEGORY) << "\n";
+    }
+
+    oss << "  当前时间: " << std::setfill('0') << std::setw(2) << static_cast<int>(record.hour)
+        << ":" << std::setfill('0') << std::setw(2) << static_cast<int>(record.minute)
+        << " (" << weekday << ")\n";
+    oss << std::fixed << std::setprecision(1);
+    if (skipped(StateProbe::CPU)) {
+        oss << "  CPU使用率: " << kNotProbed << "\n";
+    } else {
+        oss << "  CPU使用率: " << record.cpu_usage << "%" << stale(StateProbe::CPU) << "\n";
+    }
+    if (skipped(StateProbe::IDLE)) {
+        oss << "  Idle时间: " << kNotProbed << "\n";
+    } else if (record.idle_available) {
+        oss << "  Idle时间: " << record.idle_minutes << " 分钟" << stale(StateProbe::IDLE) << "\n";
+    } else {
+        oss << "  Idle时间: 无法获取\n";
+    }
+    if (skipped(StateProbe::AUDIO)) {
+        oss << "  音频活动: " << kNotProbed << "\n";
+    } else {
+        oss << "  音频活动: " << (record.has_audio_activity ? "有" : "无") << stale(StateProbe::AUDIO) << "\n";
+    }
+    if (record.kind == StateLogKind::NO_WINDOW) {
+        oss << "  应用类别: 未知\n";
+    }
+    oss << "  当前判定的灯光模式: " << RuleEngine::GetLightModeName(record.light_mode) << "\n";
+    if (record.decision_reason[0] != '\0') {
+        oss << "  决策依据: " << record.decision_reason << "\n";
+    }
+    if (record.budget_fallbacks != 0) {
+        oss << "  超出tick预算:";
+        for (size_t i = 0; i < static_cast<size_t>(BudgetFallback::COUNT); i++) {
+            BudgetFallback fallback = static_cast<BudgetFallback>(i);
+            if ((record.budget_fallbacks & FallbackBit(fallback)) != 0) {
+                oss << " " << TickBudget::GetFallbackName(fallback);
+            }
+        }
+        oss << "\n";
+    }
+
+    // 调试信息（可选）
+    if (debug_mode_ && record.kind == StateLogKind::TICK && !skipped(StateProbe::APP_CATEGORY)) {
+        oss << "  [调试] 进程名称: " << record.process_name << "\n";
+        oss << "  [调试] 窗口标题: " << record.window_title << "\n";
+        oss << "  [调试] 进程ID: " << record.process_id << "\n";
+        oss << "  [调试] 匹配文本: " << FoldCase(record.process_name) << " "
+            << FoldCase(record.window_title) << "\n";
+    }
+
+    oss << std::string(60, '-') << "\n";
+    text = oss.str();
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "rule_engine.h"
+#include "spsc_ring.h"
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+
+/**
+ * 日志记录类型
+ */
+enum class StateLogKind : uint8_t {
+    TICK,           // 周期性状态（有前台窗口）
+    NO_WINDOW,      // 周期性状态（无法获取窗口信息）
+    MODE_CHANGED,   // 灯光模式变化
+    SESSION_CLOSED  // 应用使用会话结束（仅调试模式输出）
+};
+
+/**
+ * 定长二进制日志记录
+ * 主循环只负责填充并入队，格式化和输出全部在后台线程完成
+ */
+struct StateLogRecord {
+    int64_t timestamp_ms;       // 墙钟时间（自纪元起的毫秒数）
+    StateLogKind kind;          // 记录类型
+    AppCategory category;       // 应用类别
+    LightMode light_mode;       // 当前灯光模式
+    LightMode previous_mode;    // 变化前的灯光模式（仅MODE_CHANGED）
+    uint8_t weekday;            // 星期（0=周日, 1=周一, ..., 6=周六）
+    uint8_t hour;               // 小时 (0-23)
+    uint8_t minute;             // 分钟 (0-59)
+    bool has_audio_activity;    // 是否有音频活动
+    bool idle_available;        // 空闲时间是否获取成功
+    float cpu_usage;            // CPU使用率 (0-100)
+    float idle_minutes;         // 用户空闲时间（分钟）
+    uint32_t process_id;        // 进程ID
+    char process_name[64];      // 进程名（截断到完整的UTF-8字符）
+    char window_title[160];     // 窗口标题（截断到完整的UTF-8字符）
+    char decision_reason[160];  // 决策依据摘要（仅开启决策追踪时填充）
+    uint8_t skipped_probes;     // 本tick未采样的字段（ProbeBit位掩码，对应字段的值无意义）
+    uint8_t stale_probes;       // 本tick采样超时的字段（ProbeBit位掩码，对应字段为上一次采样的值）
+    uint8_t budget_fallbacks;   // 本tick超出预算而使用的降级路径（FallbackBit位掩码）
+    uint32_t session_seconds;   // 会话时长（秒，仅SESSION_CLOSED）
+    uint32_t category_seconds_today;  // 该类别今日累计时长（秒，仅SESSION_CLOSED）
+};
+
+/**
+ * 异步状态日志
+ * 主循环通过无锁SPSC环形队列提交定长记录，后台线程负责格式化和输出。
+ * 只在状态变化（类别、灯光模式、前台进程、音频活动）时输出，
+ * 或按可配置的间隔输出完整状态。
+ */
+class StateLogger {
+public:
+    /**
+     * @param out 输出流（仅由后台线程写入）
+     */
+    explicit StateLogger(std::ostream& out = std::cout);
+    ~StateLogger();
+
+    StateLogger(const StateLogger&) = delete;
+    StateLogger& operator=(const StateLogger&) = delete;
+
+    /**
+     * 设置调试模式（输出进程名、窗口标题等），需在Start之前调用
+     */
+    void SetDebugMode(bool debug_mode) { debug_mode_ = debug_mode; }
+
+    /**
+     * 设置周期输出间隔
+     * @param interval_ms 状态未变化时，每隔多少毫秒输出一次完整状态（0表示只在变化时输出）
+     */
+    void SetLogInterval(int interval_ms) { log_interval_ms_ = interval_ms; }
+
+    /**
+     * 启动后台格式化线程
+     */
+    void Start();
+
+    /**
+     * 停止后台线程（会先输出队列中剩余的记录）
+     */
+    void Stop();
+
+    /**
+     * 提交一次tick的状态（仅主循环线程调用）
+     * 根据变化检测和输出间隔决定是否入队
+     * @param record 状态记录
+     */
+    void LogTick(const StateLogRecord& record);
+
+    /**
+     * 提交一次灯光模式变化（仅主循环线程调用）
+     */
+    void LogModeChange(int64_t timestamp_ms, LightMode from, LightMode to, const std::string& reason = "");
+
+    /**
+     * 提交一次应用使用会话结束（仅主循环线程调用，只在调试模式下输出）
+     * @param session_seconds 会话时长（秒）
+     * @param category_seconds_today 该类别今日累计时长（秒）
+     */
+    void LogSessionClosed(int64_t timestamp_ms, const std::string& process_name, AppCategory category,
+                          uint64_t session_seconds, uint64_t category_seconds_today);
+
+    /**
+     * 因队列已满而丢弃的记录数
+     */
+    uint64_t GetDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+    /**
+     * 复制字符串到定长缓冲区，截断时不会切断多字节UTF-8字符
+     * @param dst 目标缓冲区
+     * @param capacity 缓冲区大小（含结尾的'\0'）
+     * @param src 源字符串
+     */
+    static void CopyText(char* dst, size_t capacity, const std::string& src);
+
+private:
+    SpscRing<StateLogRecord, 256> ring_;
+    std::ostream& out_;
+    std::thread consumer_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> dropped_;
+    bool debug_mode_;
+    int log_interval_ms_;
+
+    // 仅主循环线程访问
+    bool has_last_;
+    StateLogRecord last_;
+    int64_t last_log_ms_;
+
+    void Push(const StateLogRecord& record);
+    void ConsumerLoop();
+    void Format(const StateLogRecord& record, std::string& text) const;
+
+    /**
+     * 判断记录相对上一次输出是否有值得记录的变化
+     */
+    static bool HasChanged(const StateLogRecord& a, const StateLogRecord& b);
+};
@@ -0,0 +1,309 @@
+#include "state_publisher.h"
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * 命名的共享内存段（只在state_publisher.cpp中使用）
+ */
+class SharedMemorySegment {
+public:
+    SharedMemorySegment() = default;
+    ~SharedMemorySegment() { Close(); }
+
+    SharedMemorySegment(const SharedMemorySegment&) = delete;
+    SharedMemorySegment& operator=(const SharedMemorySegment&) = delete;
+
+    /**
+     * 创建（或打开已存在的）段并以读写方式映射，段小于size字节时扩大
+     * 新建的段归本对象所有（Close时删除名字）；已存在的段需要调用方确认可以接管后再调用TakeOwnership
+     * @param existed 输出段是否已存在
+     */
+    bool Create(const std::string& name, size_t size, bool& existed) {
+        Close();
+        existed = false;
+#ifdef _WIN32
+        std::string mapping_name = "Local\\" + name;
+        mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(size),
+                                      mapping_name.c_str());
+        if (mapping_ == nullptr) {
+            return false;
+        }
+        existed = GetLastError() == ERROR_ALREADY_EXISTS;
+        data_ = MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, size);
+#else
+        path_ = "/" + name;
+        int fd = shm_open(path_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd < 0 && errno == EEXIST) {
+            existed = true;
+            fd = shm_open(path_.c_str(), O_RDWR, 0);
+        }
+        if (fd < 0) {
+            return false;
+        }
+        owner_ = !existed;
+        // 已存在且足够大的段不改变大小（可能属于正在运行的实例）
+        struct stat segment_stat;
+        bool large_enough = existed && fstat(fd, &segment_stat) == 0 &&
+                            static_cast<size_t>(segment_stat.st_size) >= size;
+        if (!large_enough && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            close(fd);
+            Close();
+            return false;
+        }
+        void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        data_ = address != MAP_FAILED ? address : nullptr;
+#endif
+        if (data_ == nullptr) {
+            Close();
+            return false;
+        }
+        size_ = size;
+        return true;
+    }
+
+    /**
+     * 以只读方式映射已存在的段
+     * @param min_size 段至少应有的字节数
+     */
+    bool OpenReadOnly(const std::string& name, size_t min_size) {
+        Close();
+#ifdef _WIN32
+        std::string mapping_name = "Local\\" + name;
+        mapping_ = OpenFileMappingA(FILE_MAP_READ, FALSE, mapping_name.c_str());
+        if (mapping_ == nullptr) {
+            return false;
+        }
+        // 文件映射按页分配，不会小于min_size；布局由读取方根据头部校验
+        data_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, min_size);
+        size_t size = min_size;
+#else
+        int fd = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat segment_stat;
+        if (fstat(fd, &segment_stat) != 0 || static_cast<size_t>(segment_stat.st_size) < min_size) {
+            close(fd);
+            return false;
+        }
+        size_t size = static_cast<size_t>(segment_stat.st_size);
+        void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        data_ = address != MAP_FAILED ? address : nullptr;
+#endif
+        if (data_ == nullptr) {
+            Close();
+            return false;
+        }
+        size_ = size;
+        return true;
+    }
+
+    /**
+     * 解除映射；创建者同时删除段的名字（已映射的读取方仍可读到最后的内容）
+     */
+    void Close() {
+#ifdef _WIN32
+        if (data_ != nullptr) {
+            UnmapViewOfFile(data_);
+        }
+        if (mapping_ != nullptr) {
+            CloseHandle(mapping_);
+            mapping_ = nullptr;
+        }
+#else
+        if (data_ != nullptr) {
+            munmap(data_, size_);
+        }
+        if (owner_) {
+            shm_unlink(path_.c_str());
+            owner_ = false;
+        }
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    void* GetData() const { return data_; }
+
+    /**
+     * 接管已存在的段（之后Close时删除名字）
+     */
+    void TakeOwnership() {
+#ifndef _WIN32
+        owner_ = true;
+#endif
+    }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    HANDLE mapping_ = nullptr;
+#else
+    std::string path_;
+    bool owner_ = false;
+#endif
+};
+
+namespace {
+
+uint32_t CurrentProcessId() {
+#ifdef _WIN32
+    return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    return static_cast<uint32_t>(getpid());
+#endif
+}
+
+/**
+ * 进程是否仍在运行
+ */
+bool IsProcessAlive(uint32_t pid) {
+#ifdef _WIN32
+    HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
+    if (process == nullptr) {
+        // 没有权限打开时按仍在运行处理，不接管
+        return GetLastError() == ERROR_ACCESS_DENIED;
+    }
+    bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+    CloseHandle(process);
+    return alive;
+#else
+    return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#endif
+}
+
+}  // namespace
+
+StatePublisher::StatePublisher() : segment_(), block_(nullptr), update_count_(0), other_publisher_pid_(0) {
+}
+
+StatePublisher::~StatePublisher() {
+    Close();
+}
+
+bool StatePublisher::Open(const std::string& name) {
+    Close();
+    other_publisher_pid_ = 0;
+    auto segment = std::make_unique<SharedMemorySegment>();
+    bool existed = false;
+    if (name.empty() || !segment->Create(name, sizeof(PublishedStateBlock), existed)) {
+        return false;
+    }
+    if (existed) {
+        // 另一个仍在运行的实例正在发布：不接管、不删除它的段
+        // （写入方先写publisher_pid再写magic，初始化中的段也能识别出来）
+        const PublishedStateBlock* existing = static_cast<const PublishedStateBlock*>(segment->GetData());
+        uint32_t pid = existing->publisher_pid;
+        if (pid != 0 && pid != CurrentProcessId() && IsProcessAlive(pid)) {
+            other_publisher_pid_ = pid;
+            return false;
+        }
+        segment->TakeOwnership();
+    }
+    // 段可能是上一次异常退出时遗留的：先清除magic，读取方在初始化完成前不会接受这个段
+    PublishedStateBlock* block = new (segment->GetData()) PublishedStateBlock;
+    block->magic.store(0, std::memory_order_relaxed);
+    block->publisher_pid = CurrentProcessId();
+    block->sequence.store(0, std::memory_order_relaxed);
+    block->version = kPublishedStateVersion;
+    block->header_size = static_cast<uint16_t>(offsetof(PublishedStateBlock, state));
+    block->payload_size = static_cast<uint32_t>(sizeof(PublishedState));
+    std::memset(block->reserved, 0, sizeof(block->reserved));
+    std::memset(&block->state, 0, sizeof(block->state));
+    block->magic.store(kPublishedStateMagic, std::memory_order_release);
+
+    segment_ = std::move(segment);
+    block_ = block;
+    update_count_ = 0;
+    return true;
+}
+
+void StatePublisher::Close() {
+    if (block_ != nullptr) {
+        block_->magic.store(0, std::memory_order_release);
+        block_ = nullptr;
+    }
+    segment_.reset();
+}
+
+void StatePublisher::Publish(const PublishedState& state) {
+    if (block_ == nullptr) {
+        return;
+    }
+    // 顺序锁：计数为奇数期间读取方会重试；release栅栏保证计数先于数据可见
+    uint32_t sequence = block_->sequence.load(std::memory_order_relaxed);
+    block_->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&block_->state, &state, sizeof(PublishedState));
+    block_->state.update_count = ++update_count_;
+    block_->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+StateReader::StateReader() : segment_(), block_(nullptr) {
+}
+
+StateReader::~StateReader() {
+    Close();
+}
+
+bool StateReader::Open(const std::string& name) {
+    Close();
+    auto segment = std::make_unique<SharedMemorySegment>();
+    if (name.empty() || !segment->OpenReadOnly(name, sizeof(PublishedStateBlock))) {
+        return false;
+    }
+    const PublishedStateBlock* block = static_cast<const PublishedStateBlock*>(segment->GetData());
+    // 写入方追加字段时payload_size会变大，只读取自己认识的部分
+    if (block->magic.load(std::memory_order_acquire) != kPublishedStateMagic ||
+        block->version != kPublishedStateVersion ||
+        block->header_size != offsetof(PublishedStateBlock, state) ||
+        block->payload_size < sizeof(PublishedState)) {
+        return false;
+    }
+    segment_ = std::move(segment);
+    block_ = block;
+    return true;
+}
+
+void StateReader::Close() {
+    block_ = nullptr;
+    segment_.reset();
+}
+
+bool StateReader::Read(PublishedState& state, int max_attempts) const {
+    // 写入方退出时清除了magic
+    if (block_ == nullptr || block_->magic.load(std::memory_order_acquire) != kPublishedStateMagic) {
+        return false;
+    }
+    for (int attempt = 0; attempt < max_attempts; attempt++) {
+        uint32_t begin = block_->sequence.load(std::memory_order_acquire);
+        if ((begin & 1) != 0) {
+            continue;
+        }
+        std::memcpy(&state, &block_->state, sizeof(PublishedState));
+        // acquire栅栏保证上面的复制先于第二次读取计数完成
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (block_->sequence.load(std::memory_order_relaxed) == begin) {
+            return state.update_count > 0;
+        }
+    }
+    return false;
+}
+
+uint32_t StateReader::GetPublisherPid() const {
+    return block_ != nullptr ? block_->publisher_pid : 0;
+}
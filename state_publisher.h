@@ -0,0 +1,152 @@
+#pragma once
+
+#include "app_classifier.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * 共享内存中发布的状态（布局版本1）
+ * 只包含定长的整数、浮点数和以NUL结尾的UTF-8字符数组，托盘程序、悬浮窗、Stream Deck插件等
+ * 可以用任何语言按偏移读取。兼容的扩展只在末尾追加字段并增大payload_size，不改变版本号；
+ * 改变已有字段的含义或位置时增加kPublishedStateVersion。
+ */
+struct PublishedState {
+    uint64_t update_count;          // 发布次数（每个tick加1，读取方据此判断是否有新状态）
+    int64_t timestamp_ms;           // tick的墙钟时间（自纪元起的毫秒数）
+    double cpu_usage;               // CPU使用率 (0-100)
+    double idle_minutes;            // 用户空闲时间（分钟）
+    double cpu_temperature;         // CPU温度（摄氏度），没有传感器时为NaN
+    double gpu_temperature;         // GPU温度（摄氏度），没有传感器时为NaN
+    uint32_t category_seconds_today[kAppCategoryCount]; // 今天各应用类别的累计时长（秒，按AppCategory的取值）
+    uint32_t process_id;            // 前台进程ID（0表示没有前台窗口）
+    uint32_t led_color;             // 输出线程最近一帧的颜色（0xRRGGBB，未启动输出线程时为0）
+    int32_t winning_rule;           // 命中的规则索引（-1表示没有规则匹配）
+    uint8_t category;               // 应用类别（AppCategory的取值）
+    uint8_t light_mode;             // 灯光模式（LightMode的取值）
+    uint8_t reason;                 // 灯光模式的决策来源（HistoryReason的取值）
+    uint8_t flags;                  // kPublishedAudioActive等标志位
+    uint8_t hour;                   // 小时 (0-23)
+    uint8_t minute;                 // 分钟 (0-59)
+    uint8_t weekday;                // 星期（0=周日, 1=周一, ..., 6=周六）
+    uint8_t skipped_probes;         // 本tick未采样的字段（ProbeBit位掩码，对应字段的值无意义）
+    uint8_t stale_probes;           // 本tick采样超时的字段（ProbeBit位掩码，对应字段为上一次采样的值）
+    uint8_t budget_fallbacks;       // 本tick超出预算而使用的降级路径（FallbackBit位掩码）
+    uint8_t reserved[2];
+    char process_name[64];          // 前台进程名（截断到完整的UTF-8字符）
+    char decision_reason[160];      // 决策依据
+};
+
+static_assert(sizeof(PublishedState) == 328, "PublishedState的布局不能改变");
+
+// PublishedState::flags
+const uint8_t kPublishedAudioActive = 0x01;     // 有音频活动
+const uint8_t kPublishedIdleAvailable = 0x02;   // 空闲时间获取成功
+const uint8_t kPublishedModeHeld = 0x04;        // 超出tick预算，保持了上一次的模式
+
+const uint32_t kPublishedStateMagic = 0x4C444B53;  // 小端序的 "SKDL"
+const uint16_t kPublishedStateVersion = 1;
+
+/**
+ * 共享内存段的布局（32字节头 + 328字节状态）
+ * 写入方用顺序锁（seqlock）保护state：写入前把sequence加1（变为奇数），写完再加1（变为偶数）。
+ * 读取方先读sequence（奇数表示正在写入，重试），复制state，再读一次sequence，两次相同才说明副本一致。
+ * 读取不需要任何系统调用或锁，读取方再多也不会影响写入方。
+ */
+struct PublishedStateBlock {
+    std::atomic<uint32_t> magic;    // kPublishedStateMagic（初始化完成后才写入）
+    uint16_t version;               // kPublishedStateVersion
+    uint16_t header_size;           // 头的大小（state的偏移）
+    uint32_t payload_size;          // sizeof(PublishedState)
+    std::atomic<uint32_t> sequence; // 顺序锁计数
+    uint32_t publisher_pid;         // 写入方的进程ID
+    uint8_t reserved[12];
+    PublishedState state;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "magic和顺序锁计数必须是无锁的原子变量");
+static_assert(offsetof(PublishedStateBlock, state) == 32, "PublishedStateBlock的头必须为32字节");
+
+class SharedMemorySegment;
+
+/**
+ * 状态发布者（写入方，主循环每个tick调用Publish）
+ * 共享内存段的名称在POSIX上为 "/<name>"（shm_open），在Windows上为 "Local\<name>"（命名的文件映射）。
+ * 对象析构时删除共享内存段（POSIX）；Windows上最后一个句柄关闭时自动释放。
+ * 同名的段属于另一个仍在运行的实例（publisher_pid对应的进程存在）时不接管，Open返回false。
+ *
+ * 不是线程安全的：只应在主循环线程中调用。
+ */
+class StatePublisher {
+public:
+    StatePublisher();
+    ~StatePublisher();
+
+    StatePublisher(const StatePublisher&) = delete;
+    StatePublisher& operator=(const StatePublisher&) = delete;
+
+    /**
+     * 创建（或接管上一次异常退出遗留的）共享内存段并初始化
+     * @return 失败时返回false；因另一个实例正在发布而失败时，GetOtherPublisherPid返回该实例的进程ID
+     */
+    bool Open(const std::string& name);
+
+    /**
+     * 最近一次Open因段已被另一个运行中的实例使用而失败时，该实例的进程ID（否则为0）
+     */
+    uint32_t GetOtherPublisherPid() const { return other_publisher_pid_; }
+
+    void Close();
+
+    bool IsOpen() const { return block_ != nullptr; }
+
+    /**
+     * 发布一个状态（update_count由发布者填写）
+     */
+    void Publish(const PublishedState& state);
+
+private:
+    std::unique_ptr<SharedMemorySegment> segment_;
+    PublishedStateBlock* block_;
+    uint64_t update_count_;
+    uint32_t other_publisher_pid_;
+};
+
+/**
+ * 状态读取方（供托盘程序等使用）
+ * Open只映射一次共享内存段；之后每次Read只读取内存，不做系统调用。
+ */
+class StateReader {
+public:
+    StateReader();
+    ~StateReader();
+
+    StateReader(const StateReader&) = delete;
+    StateReader& operator=(const StateReader&) = delete;
+
+    /**
+     * 以只读方式映射共享内存段
+     * @return 段不存在、太小或布局版本不兼容时返回false
+     */
+    bool Open(const std::string& name);
+
+    void Close();
+
+    /**
+     * 读取一致的状态快照
+     * @param max_attempts 写入方正在写入时最多重试的次数
+     * @return 还没有发布过状态，或重试次数用完时返回false
+     */
+    bool Read(PublishedState& state, int max_attempts = 100) const;
+
+    /**
+     * 写入方的进程ID
+     */
+    uint32_t GetPublisherPid() const;
+
+private:
+    std::unique_ptr<SharedMemorySegment> segment_;
+    const PublishedStateBlock* block_;
+};
@@ -0,0 +1,122 @@
+"""
+读取监控程序发布到共享内存的当前状态（布局见 state_publisher.h）
+
+共享内存段在Linux上为 /dev/shm/<名称>，在Windows上为命名的文件映射 Local\\<名称>，
+默认名称为 skydimo_state（监控程序的 --state-shm 参数）。映射一次之后每次读取只访问内存：
+按顺序锁读取，计数为奇数或前后两次不同时重试，不需要系统调用，也不会影响监控程序。
+
+用法：python state_reader.py [名称]
+"""
+import ctypes
+import mmap
+import os
+import sys
+import time
+from typing import Optional
+
+MAGIC = 0x4C444B53
+LAYOUT_VERSION = 1
+
+AUDIO_ACTIVE = 0x01
+IDLE_AVAILABLE = 0x02
+MODE_HELD = 0x04
+
+
+class PublishedState(ctypes.Structure):
+    """与 state_publisher.h 中的 PublishedState 布局相同（328字节）"""
+    _fields_ = [
+        ("update_count", ctypes.c_uint64),
+        ("timestamp_ms", ctypes.c_int64),
+        ("cpu_usage", ctypes.c_double),
+        ("idle_minutes", ctypes.c_double),
+        ("cpu_temperature", ctypes.c_double),
+        ("gpu_temperature", ctypes.c_double),
+        ("category_seconds_today", ctypes.c_uint32 * 8),
+        ("process_id", ctypes.c_uint32),
+        ("led_color", ctypes.c_uint32),
+        ("winning_rule", ctypes.c_int32),
+        ("category", ctypes.c_uint8),
+        ("light_mode", ctypes.c_uint8),
+        ("reason", ctypes.c_uint8),
+        ("flags", ctypes.c_uint8),
+        ("hour", ctypes.c_uint8),
+        ("minute", ctypes.c_uint8),
+        ("weekday", ctypes.c_uint8),
+        ("skipped_probes", ctypes.c_uint8),
+        ("stale_probes", ctypes.c_uint8),
+        ("budget_fallbacks", ctypes.c_uint8),
+        ("reserved", ctypes.c_uint8 * 2),
+        ("process_name", ctypes.c_char * 64),
+        ("decision_reason", ctypes.c_char * 160),
+    ]
+
+
+class BlockHeader(ctypes.Structure):
+    """共享内存段的头（32字节），之后是 PublishedState"""
+    _fields_ = [
+        ("magic", ctypes.c_uint32),
+        ("version", ctypes.c_uint16),
+        ("header_size", ctypes.c_uint16),
+        ("payload_size", ctypes.c_uint32),
+        ("sequence", ctypes.c_uint32),
+        ("publisher_pid", ctypes.c_uint32),
+        ("reserved", ctypes.c_uint8 * 12),
+    ]
+
+
+assert ctypes.sizeof(PublishedState) == 328 and ctypes.sizeof(BlockHeader) == 32
+
+CATEGORY_NAMES = ["游戏类", "电影/视频类", "音乐类", "文档/办公类", "浏览器/上网类", "开发/编程类", "创作类", "未知"]
+MODE_NAMES = ["游戏/屏幕同步", "影视模式", "音乐律动", "办公/写代码", "夜间弱光", "关闭灯光", "默认模式"]
+
+
+class StateReader:
+    def __init__(self, name: str = "skydimo_state"):
+        size = ctypes.sizeof(BlockHeader) + ctypes.sizeof(PublishedState)
+        if sys.platform == "win32":
+            self._map = mmap.mmap(-1, size, tagname="Local\\" + name, access=mmap.ACCESS_READ)
+        else:
+            with open(os.path.join("/dev/shm", name), "rb") as f:
+                self._map = mmap.mmap(f.fileno(), size, access=mmap.ACCESS_READ)
+        header = BlockHeader.from_buffer_copy(self._map, 0)
+        if header.magic != MAGIC or header.version != LAYOUT_VERSION or \
+                header.payload_size < ctypes.sizeof(PublishedState):
+            raise ValueError("共享内存段的布局不兼容或尚未初始化")
+        self._offset = header.header_size
+        self.publisher_pid = header.publisher_pid
+
+    def _sequence(self) -> int:
+        return int.from_bytes(self._map[12:16], "little")
+
+    def read(self, max_attempts: int = 100) -> Optional[PublishedState]:
+        """读取一致的快照；还没有发布过状态、发布者已退出或一直在写入时返回None"""
+        if int.from_bytes(self._map[0:4], "little") != MAGIC:
+            return None
+        for _ in range(max_attempts):
+            begin = self._sequence()
+            if begin & 1:
+                continue
+            state = PublishedState.from_buffer_copy(self._map, self._offset)
+            if self._sequence() == begin:
+                return state if state.update_count > 0 else None
+        return None
+
+
+def describe(state: PublishedState) -> str:
+    category = CATEGORY_NAMES[state.category] if state.category < len(CATEGORY_NAMES) else str(state.category)
+    mode = MODE_NAMES[state.light_mode] if state.light_mode < len(MODE_NAMES) else str(state.light_mode)
+    process = state.process_name.decode("utf-8", "replace") or "（无）"
+    reason = state.decision_reason.decode("utf-8", "replace")
+    return (f"#{state.update_count} {time.strftime('%H:%M:%S', time.localtime(state.timestamp_ms / 1000))} "
+            f"{process} [{category}] -> {mode}（{reason}） 灯带 #{state.led_color & 0xFFFFFF:06X}")
+
+
+if __name__ == "__main__":
+    try:
+        snapshot = StateReader(sys.argv[1] if len(sys.argv) > 1 else "skydimo_state").read()
+    except (OSError, ValueError):
+        snapshot = None
+    if snapshot is None:
+        print("没有读到状态（监控程序是否正在运行？）")
+        sys.exit(1)
+    print(describe(snapshot))
@@ -0,0 +1,93 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t thread_count)
+    : stopping_(false), generation_(0), active_workers_(0),
+      body_(nullptr), count_(0), grain_(1), next_(0) {
+    if (thread_count == 0) {
+        unsigned int hardware = std::thread::hardware_concurrency();
+        thread_count = hardware > 1 ? hardware - 1 : 0;
+    }
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; i++) {
+        workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_ready_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+
+    // 只有一块或没有工作线程时直接在调用线程执行，避免唤醒开销
+    if (workers_.empty() || count <= grain) {
+        body(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        body_ = &body;
+        count_ = count;
+        grain_ = grain;
+        next_.store(0, std::memory_order_relaxed);
+        active_workers_ = workers_.size();
+        generation_++;
+    }
+    work_ready_.notify_all();
+
+    RunChunks();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_done_.wait(lock, [this] { return active_workers_ == 0; });
+    body_ = nullptr;
+}
+
+void ThreadPool::RunChunks() {
+    for (;;) {
+        size_t begin = next_.fetch_add(grain_, std::memory_order_relaxed);
+        if (begin >= count_) {
+            return;
+        }
+        (*body_)(begin, std::min(begin + grain_, count_));
+    }
+}
+
+void ThreadPool::WorkerLoop() {
+    uint64_t seen_generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_ready_.wait(lock, [&] { return stopping_ || generation_ != seen_generation; });
+            if (stopping_) {
+                return;
+            }
+            seen_generation = generation_;
+        }
+
+        RunChunks();
+
+        bool last = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            last = --active_workers_ == 0;
+        }
+        if (last) {
+            work_done_.notify_one();
+        }
+    }
+}
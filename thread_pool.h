@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * 固定大小的工作线程池
+ * 只提供并行for：把[0, count)按固定粒度切块，工作线程和调用线程一起通过原子计数领取块，
+ * 调用线程在所有块完成后返回。线程在构造时创建，多次调用之间复用，不会重复创建线程。
+ */
+class ThreadPool {
+public:
+    /**
+     * @param thread_count 工作线程数（0表示使用硬件并发数减1，调用线程也参与计算）
+     */
+    explicit ThreadPool(size_t thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * 并行执行 body(begin, end)，各块互不重叠且覆盖[0, count)
+     * 同一时刻只能有一个调用者（不可重入）
+     * @param count 元素总数
+     * @param grain 每块的元素数
+     * @param body 块处理函数
+     */
+    void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+    /**
+     * 参与计算的线程数（含调用线程）
+     */
+    size_t GetConcurrency() const { return workers_.size() + 1; }
+
+private:
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable work_done_;
+    bool stopping_;
+    uint64_t generation_;           // 每次ParallelFor加一，工作线程据此判断是否有新任务
+    size_t active_workers_;         // 仍在处理当前任务的工作线程数
+
+    // 当前任务（在mutex_保护下发布，工作线程醒来后只读）
+    const std::function<void(size_t, size_t)>* body_;
+    size_t count_;
+    size_t grain_;
+    std::atomic<size_t> next_;      // 下一个待领取块的起始下标
+
+    void WorkerLoop();
+    void RunChunks();
+};
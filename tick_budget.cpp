@@ -0,0 +1,67 @@
+#include "tick_budget.h"
+#include "metrics.h"
+#include <algorithm>
+
+namespace {
+
+// 保留预算的十分之一给分类、规则评估和输出（降级路径都只需要微秒级的时间）
+const int64_t kReserveDivisor = 10;
+
+}  // namespace
+
+TickBudget::TickBudget(std::chrono::microseconds budget)
+    : budget_(0), reserve_(0), tick_begin_(), probe_deadline_(std::chrono::steady_clock::time_point::max()),
+      tick_fallbacks_(0), fallback_counts_(), tick_count_(0), overrun_count_(0), max_elapsed_(0) {
+    SetBudget(budget);
+}
+
+void TickBudget::SetBudget(std::chrono::microseconds budget) {
+    budget_ = std::max(budget, std::chrono::microseconds(0));
+    reserve_ = budget_ / kReserveDivisor;
+}
+
+void TickBudget::BeginTick() {
+    tick_begin_ = std::chrono::steady_clock::now();
+    probe_deadline_ = IsEnabled() ? tick_begin_ + (budget_ - reserve_) : std::chrono::steady_clock::time_point::max();
+    tick_fallbacks_ = 0;
+}
+
+std::chrono::microseconds TickBudget::EndTick() {
+    std::chrono::microseconds elapsed = GetElapsed();
+    tick_count_++;
+    max_elapsed_ = std::max(max_elapsed_, elapsed);
+    if (IsEnabled() && elapsed > budget_) {
+        overrun_count_++;
+        METRICS_COUNT(MetricCounter::BUDGET_OVERRUNS);
+    }
+    return elapsed;
+}
+
+bool TickBudget::IsExhausted() const {
+    return IsEnabled() && std::chrono::steady_clock::now() >= probe_deadline_;
+}
+
+std::chrono::microseconds TickBudget::GetElapsed() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tick_begin_);
+}
+
+void TickBudget::RecordFallback(BudgetFallback fallback) {
+    fallback_counts_[static_cast<size_t>(fallback)]++;
+    tick_fallbacks_ |= FallbackBit(fallback);
+    METRICS_COUNT(MetricCounter::BUDGET_FALLBACKS);
+}
+
+const char* TickBudget::GetFallbackName(BudgetFallback fallback) {
+    switch (fallback) {
+        case BudgetFallback::CACHED_CLASSIFICATION:
+            return "使用缓存的分类";
+        case BudgetFallback::SKIPPED_KEYWORD_SCAN:
+            return "跳过关键词扫描";
+        case BudgetFallback::HELD_MODE:
+            return "保持上一次的模式";
+        case BudgetFallback::DEFERRED_SNAPSHOT:
+            return "推迟保存快照";
+        default:
+            return "未知";
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * 超出tick预算时使用的降级路径
+ */
+enum class BudgetFallback {
+    CACHED_CLASSIFICATION,  // 使用该进程上一次的完整分类结果
+    SKIPPED_KEYWORD_SCAN,   // 没有缓存时只做精确映射，跳过关键词扫描
+    HELD_MODE,              // 不评估规则，保持上一次的灯光模式
+    DEFERRED_SNAPSHOT,      // 推迟保存今日使用统计快照
+    COUNT
+};
+
+/**
+ * 返回降级路径的位掩码（用于日志记录）
+ */
+inline uint8_t FallbackBit(BudgetFallback fallback) {
+    return static_cast<uint8_t>(1u << static_cast<unsigned>(fallback));
+}
+
+/**
+ * 每个tick的时间预算
+ * tick从开始到输出完成的总耗时不应超过预算。采样（窗口、CPU等）只能等到"采样截止时间"，
+ * 即预算减去为分类、规则评估和输出保留的一段时间；过了采样截止时间视为预算已用完，
+ * 之后的各阶段改走更便宜的路径（见BudgetFallback），由调用方通过RecordFallback记录。
+ * 预算为0时不限制，IsExhausted始终返回false。
+ *
+ * 不是线程安全的：只在主循环线程中使用。
+ */
+class TickBudget {
+public:
+    /**
+     * @param budget 每个tick的预算（0表示不限制）
+     */
+    explicit TickBudget(std::chrono::microseconds budget = std::chrono::microseconds(0));
+
+    void SetBudget(std::chrono::microseconds budget);
+    std::chrono::microseconds GetBudget() const { return budget_; }
+    bool IsEnabled() const { return budget_.count() > 0; }
+
+    /**
+     * 开始新的tick（记录起始时间）
+     */
+    void BeginTick();
+
+    /**
+     * 结束tick：统计耗时和超出预算的次数
+     * @return 本tick的耗时
+     */
+    std::chrono::microseconds EndTick();
+
+    /**
+     * 采样最多等待到的时间点（不限制时为time_point::max()）
+     */
+    std::chrono::steady_clock::time_point GetProbeDeadline() const { return probe_deadline_; }
+
+    /**
+     * 预算是否已用完（已过采样截止时间）
+     */
+    bool IsExhausted() const;
+
+    /**
+     * 本tick已用的时间
+     */
+    std::chrono::microseconds GetElapsed() const;
+
+    /**
+     * 记录一次降级
+     */
+    void RecordFallback(BudgetFallback fallback);
+
+    /**
+     * 本tick使用过的降级路径（FallbackBit位掩码）
+     */
+    uint8_t GetTickFallbacks() const { return tick_fallbacks_; }
+
+    uint64_t GetFallbackCount(BudgetFallback fallback) const {
+        return fallback_counts_[static_cast<size_t>(fallback)];
+    }
+    uint64_t GetTickCount() const { return tick_count_; }
+    uint64_t GetOverrunCount() const { return overrun_count_; }
+    std::chrono::microseconds GetMaxElapsed() const { return max_elapsed_; }
+
+    /**
+     * 降级路径的中文名称
+     */
+    static const char* GetFallbackName(BudgetFallback fallback);
+
+private:
+    std::chrono::microseconds budget_;
+    std::chrono::microseconds reserve_;     // 为分类、规则评估和输出保留的时间
+    std::chrono::steady_clock::time_point tick_begin_;
+    std::chrono::steady_clock::time_point probe_deadline_;
+    uint8_t tick_fallbacks_;
+
+    std::array<uint64_t, static_cast<size_t>(BudgetFallback::COUNT)> fallback_counts_;
+    uint64_t tick_count_;
+    uint64_t overrun_count_;
+    std::chrono::microseconds max_elapsed_;
+};
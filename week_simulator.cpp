@@ -0,0 +1,351 @@
+#include "week_simulator.h"
+#include "app_classifier.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+
+namespace {
+
+const char* const kDayNames[] = {"周一", "周二", "周三", "周四", "周五", "周六", "周日"};
+const char* const kDayKeywords[] = {"mon", "tue", "wed", "thu", "fri", "sat", "sun"};
+
+const uint8_t kAllDays = 0x7F;
+const uint8_t kWeekdays = 0x1F;     // 周一到周五
+const uint8_t kWeekend = 0x60;      // 周六、周日
+
+/**
+ * 由每分钟的值计算每分钟末尾的滑动窗口均值（每分钟内的值视为不变，一周首尾相接）
+ * 窗口不超过60秒时即为该分钟的值；更长的窗口按覆盖的时长对之前各分钟加权平均
+ * @param values 每分钟的值（kMinutesPerWeek项）
+ * @param window_seconds 窗口长度（秒，不超过一天）
+ * @param means 输出，kMinutesPerWeek项
+ */
+template <typename T>
+void ComputeWindowMeans(const std::vector<T>& values, size_t window_seconds, std::vector<double>& means) {
+    const size_t full_minutes = window_seconds / 60;
+    const double partial_seconds = static_cast<double>(window_seconds % 60);
+
+    // prefix[k] = values[0..k) 之和，k取[0, 2周)，用于首尾相接的区间求和
+    std::vector<double> prefix(2 * kMinutesPerWeek + 1, 0.0);
+    for (size_t k = 0; k < 2 * kMinutesPerWeek; k++) {
+        prefix[k + 1] = prefix[k] + static_cast<double>(values[k % kMinutesPerWeek]);
+    }
+
+    for (size_t i = 0; i < kMinutesPerWeek; i++) {
+        // 在第二周中取 [i + 1 - full_minutes, i + 1) 这些完整的分钟，再加上更早一分钟的部分秒数
+        size_t end = kMinutesPerWeek + i + 1;
+        double sum = (prefix[end] - prefix[end - full_minutes]) * 60.0;
+        sum += static_cast<double>(values[(end - full_minutes - 1) % kMinutesPerWeek]) * partial_seconds;
+        means[i] = sum / static_cast<double>(window_seconds);
+    }
+}
+
+std::string ToLower(const std::string& text) {
+    std::string lower;
+    lower.reserve(text.size());
+    for (unsigned char c : text) {
+        lower.push_back(static_cast<char>(std::tolower(c)));
+    }
+    return lower;
+}
+
+/**
+ * 解析日期，如 "weekday"、"mon,wed,fri"
+ */
+bool ParseDays(const std::string& text, uint8_t& days) {
+    days = 0;
+    std::istringstream iss(ToLower(text));
+    std::string token;
+    while (std::getline(iss, token, ',')) {
+        if (token == "all") {
+            days |= kAllDays;
+        } else if (token == "weekday") {
+            days |= kWeekdays;
+        } else if (token == "weekend") {
+            days |= kWeekend;
+        } else {
+            bool found = false;
+            for (int day = 0; day < 7; day++) {
+                if (token == kDayKeywords[day]) {
+                    days |= static_cast<uint8_t>(1u << day);
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                return false;
+            }
+        }
+    }
+    return days != 0;
+}
+
+/**
+ * 解析 "HH:MM"，返回自0点起的分钟数（允许24:00）
+ */
+bool ParseClock(const std::string& text, int& minutes) {
+    int hour = 0;
+    int minute = 0;
+    char extra = 0;
+    if (std::sscanf(text.c_str(), "%d:%d%c", &hour, &minute, &extra) != 2) {
+        return false;
+    }
+    if (hour < 0 || minute < 0 || minute > 59 || hour > 24 || (hour == 24 && minute != 0)) {
+        return false;
+    }
+    minutes = hour * 60 + minute;
+    return true;
+}
+
+/**
+ * 解析 "HH:MM-HH:MM"
+ */
+bool ParseRange(const std::string& text, int& start, int& end) {
+    size_t dash = text.find('-');
+    if (dash == std::string::npos) {
+        return false;
+    }
+    if (!ParseClock(text.substr(0, dash), start) || !ParseClock(text.substr(dash + 1), end)) {
+        return false;
+    }
+    if (start == static_cast<int>(kMinutesPerDay)) {
+        return false;   // 开始时间不能是24:00
+    }
+    return start != end;
+}
+
+/**
+ * 时间段在一天中的长度（分钟），跨过午夜时延续到次日
+ */
+size_t SpanLength(const ScenarioSpan& span) {
+    if (span.end_minute > span.start_minute) {
+        return span.end_minute - span.start_minute;
+    }
+    return kMinutesPerDay - span.start_minute + span.end_minute;
+}
+
+/**
+ * 对时间段覆盖的每一分钟调用 fill(下标, 自时段开始的分钟数)
+ * 一周首尾相接：周日跨过午夜的时间段延续到周一
+ */
+template <typename Fill>
+void ForEachMinute(const ScenarioSpan& span, Fill fill) {
+    size_t length = SpanLength(span);
+    for (size_t day = 0; day < 7; day++) {
+        if ((span.days & (1u << day)) == 0) {
+            continue;
+        }
+        size_t start = day * kMinutesPerDay + span.start_minute;
+        size_t first = std::min(length, kMinutesPerWeek - start);
+        for (size_t k = 0; k < first; k++) {
+            fill(start + k, k);
+        }
+        for (size_t k = first; k < length; k++) {
+            fill(start + k - kMinutesPerWeek, k);
+        }
+    }
+}
+
+std::string FormatClock(size_t minute_of_day) {
+    std::ostringstream oss;
+    oss << std::setw(2) << std::setfill('0') << minute_of_day / 60 << ":"
+        << std::setw(2) << std::setfill('0') << minute_of_day % 60;
+    return oss.str();
+}
+
+}  // namespace
+
+bool SimulationScenario::LoadFromFile(const std::string& file_path, std::string& error) {
+    std::ifstream file(file_path);
+    if (!file.is_open()) {
+        error = "无法打开场景文件 " + file_path;
+        return false;
+    }
+    return Parse(file, error);
+}
+
+bool SimulationScenario::Parse(std::istream& input, std::string& error) {
+    std::string line;
+    int line_number = 0;
+    while (std::getline(input, line)) {
+        line_number++;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        std::istringstream iss(line);
+        std::string signal;
+        if (!(iss >> signal) || signal[0] == '#') {
+            continue;
+        }
+
+        std::string days_text;
+        std::string range_text;
+        std::string value_text;
+        iss >> days_text >> range_text >> value_text;
+
+        std::string prefix = "第" + std::to_string(line_number) + "行: ";
+        ScenarioSpan span = {};
+        int start = 0;
+        int end = 0;
+        if (!ParseDays(days_text, span.days)) {
+            error = prefix + "无效的日期 \"" + days_text + "\"";
+            return false;
+        }
+        if (!ParseRange(range_text, start, end)) {
+            error = prefix + "无效的时间段 \"" + range_text + "\"（格式为 HH:MM-HH:MM）";
+            return false;
+        }
+        span.start_minute = static_cast<uint16_t>(start);
+        span.end_minute = static_cast<uint16_t>(end);
+
+        signal = ToLower(signal);
+        if (signal == "category") {
+            std::optional<AppCategory> category = AppClassifier::ParseCategoryName(value_text);
+            if (!category.has_value()) {
+                error = prefix + "未知类别 \"" + value_text + "\"";
+                return false;
+            }
+            span.value = static_cast<float>(category.value());
+            categories.push_back(span);
+        } else if (signal == "cpu") {
+            char* parse_end = nullptr;
+            double usage = std::strtod(value_text.c_str(), &parse_end);
+            if (value_text.empty() || *parse_end != '\0' || usage < 0.0 || usage > 100.0) {
+                error = prefix + "CPU使用率需要是0-100之间的数";
+                return false;
+            }
+            span.value = static_cast<float>(usage);
+            cpu.push_back(span);
+        } else if (signal == "away") {
+            away.push_back(span);
+        } else if (signal == "audio") {
+            // 省略值时表示有音频
+            if (!value_text.empty() && value_text != "0" && value_text != "1") {
+                error = prefix + "音频活动需要是0或1";
+                return false;
+            }
+            span.value = value_text == "0" ? 0.0f : 1.0f;
+            audio.push_back(span);
+        } else {
+            error = prefix + "未知信号 \"" + signal + "\"（可用 category / cpu / away / audio）";
+            return false;
+        }
+    }
+    return true;
+}
+
+WeekSimulator::WeekSimulator(ThreadPool* pool) : pool_(pool) {
+}
+
+void WeekSimulator::BuildStates(const SimulationScenario& scenario, StateBatch& batch) {
+    batch.Resize(kMinutesPerWeek);
+    for (size_t i = 0; i < kMinutesPerWeek; i++) {
+        batch.minute_of_day[i] = static_cast<uint16_t>(i % kMinutesPerDay);
+        batch.weekday[i] = static_cast<uint8_t>(i < 5 * kMinutesPerDay);
+    }
+    std::fill(batch.category.begin(), batch.category.end(), static_cast<uint8_t>(AppCategory::UNKNOWN));
+    std::fill(batch.cpu_usage.begin(), batch.cpu_usage.end(), 0.0f);
+    std::fill(batch.idle_minutes.begin(), batch.idle_minutes.end(), 0.0f);
+    std::fill(batch.audio.begin(), batch.audio.end(), static_cast<uint8_t>(0));
+
+    // 按时间段的顺序依次写入，后面的覆盖前面的
+    for (const auto& span : scenario.categories) {
+        uint8_t category = static_cast<uint8_t>(span.value);
+        ForEachMinute(span, [&](size_t index, size_t) { batch.category[index] = category; });
+    }
+    for (const auto& span : scenario.cpu) {
+        ForEachMinute(span, [&](size_t index, size_t) { batch.cpu_usage[index] = span.value; });
+    }
+    for (const auto& span : scenario.away) {
+        ForEachMinute(span, [&](size_t index, size_t elapsed) {
+            batch.idle_minutes[index] = static_cast<float>(elapsed);
+        });
+    }
+    for (const auto& span : scenario.audio) {
+        uint8_t audio = span.value != 0.0f ? 1 : 0;
+        ForEachMinute(span, [&](size_t index, size_t) { batch.audio[index] = audio; });
+    }
+}
+
+void WeekSimulator::BuildWindowColumns(const BatchRuleEvaluator& evaluator, StateBatch& batch) {
+    const std::vector<size_t>& cpu_windows = evaluator.GetCpuWindows();
+    const std::vector<size_t>& audio_windows = evaluator.GetAudioWindows();
+    batch.SetWindowCounts(cpu_windows.size(), audio_windows.size());
+    for (size_t w = 0; w < cpu_windows.size(); w++) {
+        ComputeWindowMeans(batch.cpu_usage, cpu_windows[w], batch.cpu_average[w]);
+    }
+    for (size_t w = 0; w < audio_windows.size(); w++) {
+        ComputeWindowMeans(batch.audio, audio_windows[w], batch.audio_ratio[w]);
+    }
+}
+
+SimulationResult WeekSimulator::Run(const std::vector<Rule>& rules, const SimulationScenario& scenario) {
+    auto begin = std::chrono::steady_clock::now();
+
+    SimulationResult result;
+    BuildStates(scenario, batch_);
+    evaluator_.Compile(rules);
+    BuildWindowColumns(evaluator_, batch_);
+    evaluator_.Analyze(batch_, result.timeline, result.coverage, pool_);
+
+    result.mode_minutes.fill(0);
+    for (LightMode mode : result.timeline) {
+        result.mode_minutes[static_cast<size_t>(mode)]++;
+    }
+    result.unsupported_conditions = evaluator_.GetUnsupportedConditionCount();
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    return result;
+}
+
+void WeekSimulator::PrintResult(const SimulationResult& result, const std::vector<Rule>& rules, std::ostream& out) {
+    // 每天的模式时间线：相邻的相同模式合并为一段
+    for (size_t day = 0; day < 7; day++) {
+        out << kDayNames[day] << std::endl;
+        const LightMode* modes = result.timeline.data() + day * kMinutesPerDay;
+        size_t segment_start = 0;
+        for (size_t minute = 1; minute <= kMinutesPerDay; minute++) {
+            if (minute < kMinutesPerDay && modes[minute] == modes[segment_start]) {
+                continue;
+            }
+            out << "  " << FormatClock(segment_start) << "-" << FormatClock(minute - 1)
+                << "  " << RuleEngine::GetLightModeName(modes[segment_start]) << std::endl;
+            segment_start = minute;
+        }
+    }
+
+    out << std::endl << "各模式时长:" << std::endl;
+    for (size_t mode = 0; mode < kLightModeCount; mode++) {
+        uint32_t minutes = result.mode_minutes[mode];
+        if (minutes == 0) {
+            continue;
+        }
+        out << "  " << RuleEngine::GetLightModeName(static_cast<LightMode>(mode)) << ": "
+            << minutes / 60 << "h" << std::setw(2) << std::setfill('0') << minutes % 60 << "m" << std::setfill(' ')
+            << " (" << std::fixed << std::setprecision(1) << 100.0 * minutes / kMinutesPerWeek << "%)"
+            << std::defaultfloat << std::endl;
+    }
+
+    out << std::endl << "规则覆盖（分钟）:" << std::endl;
+    for (size_t i = 0; i < result.coverage.size() && i < rules.size(); i++) {
+        const RuleCoverage& coverage = result.coverage[i];
+        out << "  规则#" << i << " (优先级" << rules[i].priority << ", "
+            << RuleEngine::GetLightModeName(rules[i].target_mode) << "): 决定 " << coverage.decided
+            << "，被遮蔽 " << coverage.shadowed;
+        if (coverage.decided == 0) {
+            out << (coverage.shadowed > 0 ? "  [始终被更高优先级规则遮蔽]" : "  [从未满足]");
+        }
+        out << std::endl;
+    }
+
+    if (result.unsupported_conditions > 0) {
+        out << std::endl << "注意: " << result.unsupported_conditions
+            << " 个温度/持续类别/今日累计时长条件在模拟中视为不满足" << std::endl;
+    }
+    out << std::endl << "模拟耗时: " << result.elapsed_ms << " ms" << std::endl;
+}
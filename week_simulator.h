@@ -0,0 +1,113 @@
+#pragma once
+
+#include "batch_rule_evaluator.h"
+#include "rule_engine.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+/**
+ * 场景中的一个时间段：在days指定的每一天，[start_minute, end_minute)内信号取value
+ */
+struct ScenarioSpan {
+    uint8_t days;               // 适用日期的位掩码（bit0=周一 ... bit6=周日）
+    uint16_t start_minute;      // 开始（自0点起的分钟数，含）
+    uint16_t end_minute;        // 结束（不含，最大1440；小于开始时间表示跨过午夜到次日）
+    float value;                // 类别（AppCategory）、CPU使用率或音频活动（0/1）
+};
+
+/**
+ * 一周的模拟场景
+ * 每个信号由若干时间段描述，后面的时间段覆盖前面的；没有时间段覆盖的分钟取默认值
+ * （类别UNKNOWN、CPU使用率0、没有离开、没有音频）。
+ */
+struct SimulationScenario {
+    std::vector<ScenarioSpan> categories;   // 前台应用类别时间线
+    std::vector<ScenarioSpan> cpu;          // CPU使用率
+    std::vector<ScenarioSpan> away;         // 离开时段：空闲时间从时段开始起逐分钟增长
+    std::vector<ScenarioSpan> audio;        // 音频活动
+
+    /**
+     * 从文本文件加载场景
+     * 每行格式为 "信号 日期 HH:MM-HH:MM [值]"，例如：
+     *   category weekday 09:00-18:00 DEVELOPMENT
+     *   cpu all 00:00-24:00 15
+     *   away weekday 12:00-13:00
+     *   audio fri,sat 20:00-02:00 1
+     * 日期为 all / weekday / weekend / mon ... sun，可用逗号组合。
+     * 以 # 开头的行和空行会被忽略。
+     * @param file_path 场景文件路径
+     * @param error 失败时的错误描述（含行号）
+     * @return 是否加载成功
+     */
+    bool LoadFromFile(const std::string& file_path, std::string& error);
+
+    /**
+     * 从输入流解析场景（追加到已有的时间段之后）
+     */
+    bool Parse(std::istream& input, std::string& error);
+};
+
+const size_t kMinutesPerDay = 24 * 60;
+const size_t kMinutesPerWeek = 7 * kMinutesPerDay;
+
+/**
+ * 一周模拟的结果
+ */
+struct SimulationResult {
+    std::vector<LightMode> timeline;                    // 每分钟的灯光模式（下标 = 星期 * 1440 + 分钟，0为周一00:00）
+    std::array<uint32_t, kLightModeCount> mode_minutes; // 各灯光模式的总分钟数
+    std::vector<RuleCoverage> coverage;                 // 每条规则决定/被遮蔽的分钟数（顺序同规则）
+    size_t unsupported_conditions;                      // 模拟中无法评估的条件数（温度、持续类别等，视为不满足）
+    double elapsed_ms;                                  // 展开场景和评估的耗时
+};
+
+/**
+ * 规则集的一周模拟
+ * 把场景展开为一周10080分钟的状态列，用BatchRuleEvaluator在整列上一次评估，
+ * 得到每分钟的灯光模式、各模式总时长，以及每条规则实际决定和被更高优先级规则遮蔽的分钟数。
+ * 状态列和评估器的缓冲区在多次模拟之间复用，修改规则后可以立即重新模拟。
+ */
+class WeekSimulator {
+public:
+    /**
+     * @param pool 评估用的线程池，nullptr表示在调用线程中执行
+     */
+    explicit WeekSimulator(ThreadPool* pool = nullptr);
+
+    /**
+     * 模拟规则集在场景下一周的灯光模式
+     * @param rules 按优先级从高到低排序的规则（如 RuleEngine::GetRules 的返回值）
+     * @param scenario 场景
+     */
+    SimulationResult Run(const std::vector<Rule>& rules, const SimulationScenario& scenario);
+
+    /**
+     * 把场景展开为一周每分钟的状态
+     */
+    static void BuildStates(const SimulationScenario& scenario, StateBatch& batch);
+
+    /**
+     * 由每分钟的CPU使用率和音频活动计算评估器所需的窗口统计列（在BuildStates和Compile之后调用）
+     * 每分钟内的值视为不变，一周首尾相接（周一00:00之前接周日的数据）：
+     * 不超过60秒的窗口取该分钟的值，更长的窗口按时长对之前各分钟加权平均
+     */
+    static void BuildWindowColumns(const BatchRuleEvaluator& evaluator, StateBatch& batch);
+
+    /**
+     * 输出模拟结果：每天的模式时间线、各模式总时长和每条规则的覆盖情况
+     * @param rules 模拟时使用的规则（用于显示优先级和目标模式）
+     */
+    static void PrintResult(const SimulationResult& result, const std::vector<Rule>& rules, std::ostream& out);
+
+private:
+    ThreadPool* pool_;
+    BatchRuleEvaluator evaluator_;
+    StateBatch batch_;
+};
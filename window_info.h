@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <optional>
+
+/**
+ * 窗口信息结构体
+ */
+struct WindowInfo {
+    std::string process_name;      // 可执行文件名
+    std::string window_title;       // 窗口标题
+    bool is_near_fullscreen;        // 是否接近全屏
+    uint32_t process_id;            // 进程ID
+    uint32_t parent_process_id;     // 父进程ID（获取失败为0）
+    std::optional<std::string> executable_path;  // 可执行文件路径（可选）
+    std::vector<std::string> ancestor_names;     // 祖先进程名（由近及远，可选，由ProcessTreeTracker填充）
+};
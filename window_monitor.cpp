@@ -1,6 +1,7 @@
 #include "window_monitor.h"
+#include "case_fold.h"
+#include "metrics.h"
 #include <psapi.h>
-#include <tlhelp32.h>
 #include <algorithm>
 #include <cctype>
 
@@ -13,6 +14,7 @@ WindowMonitor::WindowMonitor() {
 }
 
 std::optional<WindowInfo> WindowMonitor::GetForegroundWindowInfo() {
+    METRICS_SCOPE(MetricStage::WINDOW_PROBE);
     try {
         // 获取前台窗口句柄
         HWND hwnd = GetForegroundWindow();
@@ -32,15 +34,23 @@ std::optional<WindowInfo> WindowMonitor::GetForegroundWindowInfo() {
             return std::nullopt;
         }
         
-        // 获取进程名
-        std::string process_name = GetProcessName(process_id);
-        if (process_name.empty()) {
+        // 获取进程名、可执行文件路径和父进程ID（同一进程只解析一次）
+        std::string process_name;
+        std::optional<std::string> executable_path;
+        DWORD parent_process_id = 0;
+        const ProcessInfo* process_info = nullptr;
+        {
+            METRICS_SCOPE(MetricStage::PROCESS_RESOLVE);
+            process_info = process_cache_.Lookup(process_id);
+        }
+        if (process_info != nullptr) {
+            process_name = process_info->name;
+            executable_path = process_info->executable_path;
+            parent_process_id = process_info->parent_pid;
+        } else {
             process_name = "Process_" + std::to_string(process_id);
         }
         
-        // 获取可执行文件路径（可选）
-        std::optional<std::string> executable_path = GetExecutablePath(process_id);
-        
         // 检查是否接近全屏
         bool is_near_fullscreen = CheckNearFullscreen(hwnd);
         
@@ -49,6 +59,7 @@ std::optional<WindowInfo> WindowMonitor::GetForegroundWindowInfo() {
         info.window_title = window_title;
         info.is_near_fullscreen = is_near_fullscreen;
         info.process_id = process_id;
+        info.parent_process_id = parent_process_id;
         info.executable_path = executable_path;
         
         return info;
@@ -78,65 +89,6 @@ bool WindowMonitor::CheckNearFullscreen(HWND hwnd) {
     }
 }
 
-std::string WindowMonitor::GetProcessName(DWORD process_id) {
-    // 方法1: 使用QueryFullProcessImageName（Windows Vista+）
-    HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, process_id);
-    if (hProcess != NULL) {
-        wchar_t process_path[MAX_PATH] = {0};
-        DWORD size = MAX_PATH;
-        
-        // 尝试使用QueryFullProcessImageNameW
-        if (QueryFullProcessImageNameW(hProcess, 0, process_path, &size)) {
-            CloseHandle(hProcess);
-            std::string path = WideToUtf8(process_path);
-            // 提取文件名
-            size_t last_slash = path.find_last_of("\\/");
-            if (last_slash != std::string::npos) {
-                return path.substr(last_slash + 1);
-            }
-            return path;
-        }
-        CloseHandle(hProcess);
-    }
-    
-    // 方法2: 使用CreateToolhelp32Snapshot作为后备
-    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-    if (hSnapshot != INVALID_HANDLE_VALUE) {
-        PROCESSENTRY32W pe32;
-        pe32.dwSize = sizeof(PROCESSENTRY32W);
-        
-        if (Process32FirstW(hSnapshot, &pe32)) {
-            do {
-                if (pe32.th32ProcessID == process_id) {
-                    CloseHandle(hSnapshot);
-                    return WideToUtf8(pe32.szExeFile);
-                }
-            } while (Process32NextW(hSnapshot, &pe32));
-        }
-        CloseHandle(hSnapshot);
-    }
-    
-    return "";
-}
-
-std::optional<std::string> WindowMonitor::GetExecutablePath(DWORD process_id) {
-    HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, process_id);
-    if (hProcess == NULL) {
-        return std::nullopt;
-    }
-    
-    wchar_t process_path[MAX_PATH] = {0};
-    DWORD size = MAX_PATH;
-    
-    if (QueryFullProcessImageNameW(hProcess, 0, process_path, &size)) {
-        CloseHandle(hProcess);
-        return WideToUtf8(process_path);
-    }
-    
-    CloseHandle(hProcess);
-    return std::nullopt;
-}
-
 std::string WindowMonitor::WideToUtf8(const std::wstring& wstr) {
     if (wstr.empty()) {
         return "";
@@ -159,9 +111,6 @@ std::string WindowMonitor::WideToUtf8(const std::wstring& wstr) {
 }
 
 std::string WindowMonitor::ToLower(const std::string& str) {
-    std::string result = str;
-    std::transform(result.begin(), result.end(), result.begin(),
-                   [](unsigned char c) { return std::tolower(c); });
-    return result;
+    return FoldCase(str);
 }
 
@@ -1,20 +1,12 @@
 #pragma once
 
+#include "process_cache.h"
+#include "window_info.h"
 #include <windows.h>
 #include <string>
+#include <vector>
 #include <optional>
 
-/**
- * 窗口信息结构体
- */
-struct WindowInfo {
-    std::string process_name;      // 可执行文件名
-    std::string window_title;       // 窗口标题
-    bool is_near_fullscreen;        // 是否接近全屏
-    DWORD process_id;               // 进程ID
-    std::optional<std::string> executable_path;  // 可执行文件路径（可选）
-};
-
 /**
  * 窗口监控器类
  * 负责获取前台窗口信息
@@ -28,11 +20,17 @@ public:
      * @return WindowInfo对象，如果获取失败则返回std::nullopt
      */
     std::optional<WindowInfo> GetForegroundWindowInfo();
+    
+    /**
+     * 获取进程元数据缓存（用于查看命中统计）
+     */
+    const ProcessInfoCache& GetProcessCache() const { return process_cache_; }
 
 private:
     int screen_width_;
     int screen_height_;
     double fullscreen_threshold_;  // 95%以上视为接近全屏
+    ProcessInfoCache process_cache_;  // 进程元数据缓存（每个进程只解析一次）
     
     /**
      * 检查窗口是否接近全屏
@@ -41,27 +39,13 @@ private:
      */
     bool CheckNearFullscreen(HWND hwnd);
     
-    /**
-     * 获取进程的可执行文件名
-     * @param process_id 进程ID
-     * @return 进程名，如果获取失败则返回空字符串
-     */
-    std::string GetProcessName(DWORD process_id);
-    
-    /**
-     * 获取进程的可执行文件路径
-     * @param process_id 进程ID
-     * @return 可执行文件路径，如果获取失败则返回std::nullopt
-     */
-    std::optional<std::string> GetExecutablePath(DWORD process_id);
-    
     /**
      * 将宽字符串转换为UTF-8字符串
      */
     std::string WideToUtf8(const std::wstring& wstr);
     
     /**
-     * 将字符串转换为小写
+     * 将字符串转换为小写（UTF-8大小写折叠，见case_fold.h）
      */
     std::string ToLower(const std::string& str);
 };